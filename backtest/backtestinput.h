@@ -0,0 +1,94 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "journal/journal.h"
+#include "market-orders/marketupdate.h"
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+/// \typedef BacktestRecord
+/// \brief A recorded market update replayed by a backtest.
+typedef JournalRecord<MEMarketUpdate> BacktestRecord;
+
+/// \brief The market updates of a backtest, loaded once and read by every
+/// run of every worker.
+///
+/// The records are either the segments of a journal, mapped read-only and
+/// pre-faulted so that all workers share the page cache instead of each
+/// reading the file, or a vector of records kept in memory. Either way they
+/// are never written once loaded, so the workers read them without any
+/// synchronisation.
+class BacktestInput final {
+   public:
+    /// \brief Constructs an empty input.
+    BacktestInput() = default;
+
+    /// \brief Maps every segment of a journal of MEMarketUpdate.
+    /// \param directory Directory holding the journal.
+    /// \param prefix Journal name shared by all of its segments.
+    /// \return Number of records added, 0 if the journal has no segment.
+    auto openJournal(const std::string &directory, const std::string &prefix)
+        -> size_t {
+        size_t added = 0;
+        for (size_t segment_index = 0;; ++segment_index) {
+            auto reader = std::make_unique<JournalReader<MEMarketUpdate>>();
+            if (!reader->open(
+                    journalSegmentPath(directory, prefix, segment_index))) {
+                break;
+            }
+            added += reader->size();
+            mSegments.emplace_back(reader->begin(), reader->end());
+            mReaders.push_back(std::move(reader));
+        }
+        mRecords += added;
+        return added;
+    }
+
+    /// \brief Takes over records held in memory.
+    /// \param records The records, in replay order.
+    /// \return Number of records added.
+    auto load(std::vector<BacktestRecord> records) -> size_t {
+        const auto added = records.size();
+        mOwned.push_back(std::move(records));
+        const auto &owned = mOwned.back();
+        mSegments.emplace_back(owned.data(), owned.data() + added);
+        mRecords += added;
+        return added;
+    }
+
+    /// \brief Calls a function with every record, in replay order.
+    /// \param function Called with a const reference to every BacktestRecord.
+    template <typename Function>
+    auto forEach(Function &&function) const noexcept -> void {
+        for (const auto &[first, last] : mSegments) {
+            for (auto record = first; record != last; ++record) {
+                function(*record);
+            }
+        }
+    }
+
+    /// \brief Returns the number of records.
+    auto size() const noexcept { return mRecords; }
+
+    // Deleted copy & move constructors and assignment-operators.
+    BacktestInput(const BacktestInput &) = delete;
+    BacktestInput(const BacktestInput &&) = delete;
+    BacktestInput &operator=(const BacktestInput &) = delete;
+    BacktestInput &operator=(const BacktestInput &&) = delete;
+
+   private:
+    /// \brief Readers keeping the journal segments mapped.
+    std::vector<std::unique_ptr<JournalReader<MEMarketUpdate>>> mReaders;
+    /// \brief Records loaded in memory.
+    std::vector<std::vector<BacktestRecord>> mOwned;
+    /// \brief First and one past the last record of every segment, in
+    /// replay order.
+    std::vector<std::pair<const BacktestRecord *, const BacktestRecord *>>
+        mSegments;
+    /// \brief Number of records of all segments.
+    size_t mRecords = 0;
+};
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backtest/backtestinput.h"
+#include "market-orders/clientrequest.h"
+#include "order-book/orderbook.h"
+#include "strategy/orderemitter.h"
+#include "strategy/strategyrunner.h"
+#include "utilities/macros.h"
+#include "utilities/threadplacement.h"
+#include "utilities/types.h"
+
+/// \struct BacktestConfig
+/// \brief Workers of a BacktestRunner and the books each of them keeps.
+struct BacktestConfig {
+    /// Number of worker threads.
+    size_t workers = 1;
+    /// CPU of every worker, in worker order, workers past its end are not
+    /// pinned.
+    std::vector<int> cpus;
+    /// Books are kept for tickers below this, updates of other tickers are
+    /// skipped.
+    TickerId num_tickers = ME_MAX_TICKERS;
+    /// Client the order requests of the strategies are sent for.
+    ClientId client_id = 1;
+};
+
+/// \struct BacktestRunStats
+/// \brief What a backtest run did, besides the result of its strategy.
+struct BacktestRunStats {
+    /// Index of the parameters of the run.
+    size_t run = 0;
+    /// Worker that executed the run.
+    size_t worker = 0;
+    /// Market updates applied to the books.
+    uint64_t updates = 0;
+    /// Order requests sent by the strategy.
+    uint64_t requests = 0;
+    /// Wall clock time of the run, in nanoseconds.
+    uint64_t elapsed_ns = 0;
+};
+
+/// \struct BacktestResult
+/// \brief Outcome of one backtest run.
+/// \tparam S The strategy.
+template <typename S>
+struct BacktestResult {
+    BacktestRunStats stats;
+    typename S::Result result = {};
+};
+
+/// \brief Replays the same market updates through many independent
+/// instances of a strategy, one per parameter set, on a pool of worker
+/// threads.
+///
+/// The input is loaded once and shared read-only. Every worker builds its
+/// own books, and with them their memory pools, on its own thread, so their
+/// pages are local to its core and no cache line is written by two workers.
+/// A run clears the worker's books, constructs the strategy from its
+/// parameters and replays the whole input through a StrategyRunner, draining
+/// the order requests after every update.
+///
+/// Runs are scheduled by work stealing. Each worker starts with a contiguous
+/// range of run indices in one atomic word, which it takes runs from the
+/// front of. A worker whose range is empty steals the back half of the
+/// largest range left, so runs of very different lengths still keep every
+/// worker busy until the end, and the only shared writes are one
+/// compare-and-swap per run.
+///
+/// The results do not depend on the number of workers or the order the runs
+/// were executed in.
+/// \tparam S The strategy, deriving from Strategy<S>, with a type Params it
+/// is constructed from and a result() returning its type Result.
+template <typename S>
+class BacktestRunner final {
+   public:
+    /// \brief Constructs a BacktestRunner.
+    /// \param input The market updates, which must outlive the runner.
+    /// \param config The workers.
+    BacktestRunner(const BacktestInput &input, BacktestConfig config)
+        : mInput(input), mConfig(std::move(config)) {
+        ASSERT(mConfig.workers > 0, "A backtest needs a worker.");
+        ASSERT(mConfig.num_tickers <= ME_MAX_TICKERS,
+               "Backtest for more tickers than ME_MAX_TICKERS.");
+    }
+
+    /// \brief Runs the strategy once per parameter set, in parallel.
+    /// \param params The parameters of every run.
+    /// \return The result of every run, in the order of params.
+    auto run(const std::vector<typename S::Params> &params)
+        -> std::vector<BacktestResult<S>> {
+        std::vector<BacktestResult<S>> results(params.size());
+        const auto workers = mConfig.workers;
+        mRanges = std::make_unique<RunRange[]>(workers);
+        for (size_t worker = 0; worker < workers; ++worker) {
+            mRanges[worker].runs.store(
+                pack(params.size() * worker / workers,
+                     params.size() * (worker + 1) / workers));
+        }
+        mSteals = 0;
+
+        std::vector<std::thread> threads;
+        for (size_t worker = 0; worker < workers; ++worker) {
+            threads.emplace_back([this, worker, &params, &results]() {
+                work(worker, params, results);
+            });
+        }
+        for (auto &thread : threads) thread.join();
+        return results;
+    }
+
+    /// \brief Returns the number of times a worker stole runs during the
+    /// last call to run().
+    auto steals() const noexcept {
+        return mSteals.load(std::memory_order_relaxed);
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    BacktestRunner() = delete;
+    BacktestRunner(const BacktestRunner &) = delete;
+    BacktestRunner(const BacktestRunner &&) = delete;
+    BacktestRunner &operator=(const BacktestRunner &) = delete;
+    BacktestRunner &operator=(const BacktestRunner &&) = delete;
+
+   private:
+    /// \struct RunRange
+    /// \brief Run indices left to a worker, the first in the low half of the
+    /// word and one past the last in the high half, alone in its cache line.
+    struct alignas(64) RunRange {
+        std::atomic<uint64_t> runs;
+    };
+
+    static constexpr auto pack(uint64_t first, uint64_t last) noexcept {
+        return first | last << 32;
+    }
+    static constexpr auto first(uint64_t range) noexcept {
+        return range & 0xFFFFFFFF;
+    }
+    static constexpr auto last(uint64_t range) noexcept {
+        return range >> 32;
+    }
+
+    /// \brief Takes the first run of a worker's own range.
+    /// \return Index of the run, UINT64_MAX if the range is empty.
+    auto pop(size_t worker) noexcept -> uint64_t {
+        auto &range = mRanges[worker].runs;
+        auto current = range.load(std::memory_order_relaxed);
+        while (first(current) < last(current)) {
+            if (range.compare_exchange_weak(
+                    current, pack(first(current) + 1, last(current)),
+                    std::memory_order_relaxed)) {
+                return first(current);
+            }
+        }
+        return UINT64_MAX;
+    }
+
+    /// \brief Moves the back half of the largest range of another worker
+    /// into a worker's empty range.
+    /// \return false if there was nothing left to steal.
+    auto steal(size_t worker) noexcept -> bool {
+        while (true) {
+            size_t victim = worker;
+            uint64_t victim_range = 0;
+            uint64_t largest = 0;
+            for (size_t other = 0; other < mConfig.workers; ++other) {
+                const auto range =
+                    mRanges[other].runs.load(std::memory_order_relaxed);
+                // A single run is left to its owner.
+                if (other != worker && first(range) + 1 < last(range) &&
+                    last(range) - first(range) > largest) {
+                    victim = other;
+                    victim_range = range;
+                    largest = last(range) - first(range);
+                }
+            }
+            if (victim == worker) return false;
+
+            const auto split = last(victim_range) - largest / 2;
+            if (mRanges[victim].runs.compare_exchange_weak(
+                    victim_range, pack(first(victim_range), split),
+                    std::memory_order_relaxed)) {
+                mRanges[worker].runs.store(pack(split, last(victim_range)),
+                                           std::memory_order_relaxed);
+                mSteals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+
+    /// \brief Worker thread, executing runs until none is left anywhere.
+    auto work(size_t worker, const std::vector<typename S::Params> &params,
+              std::vector<BacktestResult<S>> &results) -> void {
+        const auto cpu =
+            worker < mConfig.cpus.size() ? mConfig.cpus[worker] : -1;
+        setThreadName("backtest-" + std::to_string(worker));
+        if (!pinThread(cpu)) [[unlikely]] {
+            FATAL("Unable to pin backtest worker " + std::to_string(worker) +
+                  " to cpu " + std::to_string(cpu));
+        }
+
+        // Built by the worker, so the pools are faulted in on its core.
+        std::vector<std::unique_ptr<MarketOrderBook>> storage;
+        MarketOrderBookHashMap books = {};
+        for (TickerId ticker_id = 0; ticker_id < mConfig.num_tickers;
+             ++ticker_id) {
+            storage.push_back(std::make_unique<MarketOrderBook>(ticker_id));
+            books[ticker_id] = storage.back().get();
+        }
+        ClientRequestLFQueue requests(ME_MAX_CLIENT_UPDATES);
+
+        while (true) {
+            auto run = pop(worker);
+            if (run == UINT64_MAX) {
+                if (!steal(worker)) break;
+                continue;
+            }
+            results[run].stats.run = run;
+            results[run].stats.worker = worker;
+            execute(params[run], books, requests, results[run]);
+        }
+    }
+
+    /// \brief Replays the input through one instance of the strategy.
+    auto execute(const typename S::Params &params,
+                 const MarketOrderBookHashMap &books,
+                 ClientRequestLFQueue &requests,
+                 BacktestResult<S> &result) noexcept -> void {
+        const auto start = std::chrono::steady_clock::now();
+        MEMarketUpdate clear;
+        clear.type = MarketUpdateType::CLEAR;
+        for (TickerId ticker_id = 0; ticker_id < mConfig.num_tickers;
+             ++ticker_id) {
+            clear.ticker_id = ticker_id;
+            books[ticker_id]->onMarketUpdate(&clear);
+        }
+
+        S strategy(params);
+        OrderEmitter orders(mConfig.client_id, &requests);
+        StrategyRunner runner(books, orders, strategy);
+        mInput.forEach([&](const BacktestRecord &record) {
+            if (record.update.ticker_id >= mConfig.num_tickers) [[unlikely]] {
+                return;
+            }
+            runner.onMarketUpdate(record.update);
+            // Nothing executes the requests, they are only counted.
+            while (requests.getNextRead()) requests.updateReadIndex();
+        });
+
+        result.stats.updates = runner.updates();
+        result.stats.requests = orders.requestsSent();
+        result.result = strategy.result();
+        result.stats.elapsed_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+    }
+
+    /// \brief The market updates.
+    const BacktestInput &mInput;
+    /// \brief The workers.
+    const BacktestConfig mConfig;
+    /// \brief Run indices left to every worker.
+    std::unique_ptr<RunRange[]> mRanges;
+    /// \brief Number of successful steals.
+    std::atomic<uint64_t> mSteals = 0;
+};
@@ -0,0 +1,251 @@
+/// \file benchmark_backtest.cpp
+/// \brief Throughput of a parameter sweep on one worker and on many, with
+/// the results of every run compared between the two.
+/// \details Records synthetic order flow into a journal, or uses an existing
+/// one, and maps it once as the input of every run. The strategy trades the
+/// touch whenever the quantity at the best bid and offer is imbalanced
+/// beyond a threshold, assuming it is filled at once, and reports its trades
+/// and its profit marked to the last mid. The sweep over thresholds, order
+/// sizes and position limits runs first on a single worker and then on the
+/// pool, and every run must give the same result on both.
+///
+/// Usage: BacktestBenchmark [--updates N] [--runs N] [--workers N]
+///     [--first-cpu N] [--journal DIRECTORY] [--journal-prefix PREFIX]
+///     [harness options]
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "backtest/backtestrunner.h"
+#include "journal/journal.h"
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowgenerator.h"
+
+/// \struct BenchmarkOptions
+/// \brief Options of the benchmark, beside the shared harness options.
+struct BenchmarkOptions {
+    size_t updates = 1'000'000;
+    size_t runs = 32;
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    int first_cpu = -1;
+    std::string journal_directory;
+    std::string journal_prefix = "market";
+};
+
+/// \brief Takes the touch when the quantities at the best bid and offer are
+/// imbalanced, on the side of the larger quantity.
+class ImbalanceStrategy final : public Strategy<ImbalanceStrategy> {
+   public:
+    /// \struct Params
+    /// \brief Parameters swept by the benchmark.
+    struct Params {
+        /// Share of the touch quantity on one side that triggers an order.
+        double threshold = 0.8;
+        /// Quantity of every order.
+        Qty qty = 100;
+        /// Largest long or short position per ticker.
+        int64_t max_position = 1'000;
+    };
+
+    /// \struct Result
+    /// \brief Outcome of a run.
+    struct Result {
+        uint64_t trades = 0;
+        int64_t volume = 0;
+        double pnl = 0.0;
+
+        auto operator==(const Result &) const -> bool = default;
+    };
+
+    explicit ImbalanceStrategy(const Params &params) : mParams(params) {}
+
+    auto onBestBidOfferUpdate(TickerId ticker_id, const BestBidOffer &bbo,
+                              const MarketOrderBook &,
+                              OrderEmitter &orders) noexcept -> void {
+        if (bbo.mBid_price == Price_INVALID ||
+            bbo.mAsk_price == Price_INVALID) {
+            return;
+        }
+        auto &ticker = mTickers[ticker_id];
+        ticker.mid = (bbo.mBid_price + bbo.mAsk_price) / 2.0;
+        const auto bid_share =
+            static_cast<double>(bbo.mBid_qty) / (bbo.mBid_qty + bbo.mAsk_qty);
+        const auto qty = static_cast<int64_t>(mParams.qty);
+        if (bid_share > mParams.threshold &&
+            ticker.position + qty <= mParams.max_position) {
+            orders.sendNew(ticker_id, Side::BUY, bbo.mAsk_price, mParams.qty);
+            ticker.position += qty;
+            ticker.cash -= static_cast<double>(qty) * bbo.mAsk_price;
+            ++mResult.trades;
+            mResult.volume += qty;
+        } else if (1.0 - bid_share > mParams.threshold &&
+                   ticker.position - qty >= -mParams.max_position) {
+            orders.sendNew(ticker_id, Side::SELL, bbo.mBid_price, mParams.qty);
+            ticker.position -= qty;
+            ticker.cash += static_cast<double>(qty) * bbo.mBid_price;
+            ++mResult.trades;
+            mResult.volume += qty;
+        }
+    }
+
+    /// \brief Returns the result, with open positions marked to the mid.
+    auto result() const noexcept {
+        auto result = mResult;
+        for (const auto &ticker : mTickers) {
+            result.pnl += ticker.cash + ticker.position * ticker.mid;
+        }
+        return result;
+    }
+
+   private:
+    /// \struct TickerState
+    /// \brief Position of the strategy in one ticker.
+    struct TickerState {
+        int64_t position = 0;
+        double cash = 0.0;
+        double mid = 0.0;
+    };
+
+    const Params mParams;
+    std::array<TickerState, ME_MAX_TICKERS> mTickers = {};
+    Result mResult;
+};
+
+/// \brief Builds the sweep, a grid of thresholds, sizes and limits.
+auto sweep(size_t runs) -> std::vector<ImbalanceStrategy::Params> {
+    std::vector<ImbalanceStrategy::Params> params;
+    for (size_t run = 0; run < runs; ++run) {
+        ImbalanceStrategy::Params run_params;
+        run_params.threshold = 0.55 + 0.05 * (run % 8);
+        run_params.qty = 100 * (1 + (run / 8) % 2);
+        run_params.max_position = 500 << (run / 16 % 4);
+        params.push_back(run_params);
+    }
+    return params;
+}
+
+/// \brief Records synthetic order flow into a journal.
+/// \return Number of updates recorded.
+auto recordFlow(const std::string &directory, const std::string &prefix,
+                size_t updates) -> size_t {
+    OrderFlowConfig config;
+    OrderFlowGenerator generator(config);
+    MEMarketUpdateLFQueue queue(ME_MAX_MARKET_UPDATES);
+    JournalWriter<MEMarketUpdate> writer(&queue, directory, prefix,
+                                         1'000'000);
+    writer.start();
+    size_t recorded = 0;
+    while (recorded < updates || generator.hasPending()) {
+        // Back off while the queue is nearly full
+        while (queue.size() >= ME_MAX_MARKET_UPDATES - 1) {
+            std::this_thread::yield();
+        }
+        *queue.getNextWrite() = generator.next()->update;
+        queue.updateWriteIndex();
+        ++recorded;
+    }
+    writer.stop();
+    return recorded;
+}
+
+/// \brief Runs the sweep and prints its throughput.
+auto runSweep(const BacktestInput &input, const BenchmarkOptions &options,
+              size_t workers,
+              const std::vector<ImbalanceStrategy::Params> &params)
+    -> std::vector<BacktestResult<ImbalanceStrategy>> {
+    BacktestConfig config;
+    config.workers = workers;
+    config.num_tickers = OrderFlowConfig().num_tickers;
+    if (options.first_cpu >= 0) {
+        for (size_t worker = 0; worker < workers; ++worker) {
+            config.cpus.push_back(options.first_cpu +
+                                  static_cast<int>(worker));
+        }
+    }
+    BacktestRunner<ImbalanceStrategy> runner(input, config);
+    const auto start = std::chrono::steady_clock::now();
+    auto results = runner.run(params);
+    const auto elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                      start)
+            .count();
+
+    uint64_t updates = 0;
+    for (const auto &result : results) updates += result.stats.updates;
+    std::cout << std::left << std::setw(10) << workers << std::right
+              << std::fixed << std::setprecision(3) << std::setw(12)
+              << elapsed << std::setprecision(1) << std::setw(16)
+              << updates / elapsed / 1e6 << std::setw(10) << runner.steals()
+              << std::endl;
+    return results;
+}
+
+/// \brief Main function running the backtest benchmark.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    BenchmarkOptions options;
+    setUpBenchmarkThread(parseBenchmarkOptions(
+        argc, argv,
+        {{"--updates", options.updates},
+         {"--runs", options.runs, 1},
+         {"--workers", options.workers, 1},
+         {"--first-cpu", options.first_cpu},
+         {"--journal", options.journal_directory, "DIRECTORY"},
+         {"--journal-prefix", options.journal_prefix, "PREFIX"}}));
+
+    BacktestInput input;
+    if (options.journal_directory.empty()) {
+        const auto directory =
+            (std::filesystem::temp_directory_path() / "backtest_benchmark")
+                .string();
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        recordFlow(directory, "market", options.updates);
+        input.openJournal(directory, "market");
+        // The mapping keeps the pages after the files are unlinked.
+        std::filesystem::remove_all(directory);
+    } else {
+        input.openJournal(options.journal_directory, options.journal_prefix);
+    }
+    if (!input.size()) [[unlikely]] {
+        FATAL("The backtest input has no updates.");
+    }
+
+    const auto params = sweep(options.runs);
+    std::cout << "sweep of " << params.size() << " runs over " << input.size()
+              << " updates" << std::endl;
+    std::cout << std::left << std::setw(10) << "workers" << std::right
+              << std::setw(12) << "seconds" << std::setw(16)
+              << "M updates/s" << std::setw(10) << "steals" << std::endl;
+    const auto serial = runSweep(input, options, 1, params);
+    const auto parallel = runSweep(input, options, options.workers, params);
+
+    for (size_t run = 0; run < params.size(); ++run) {
+        if (serial[run].result != parallel[run].result ||
+            serial[run].stats.updates != parallel[run].stats.updates ||
+            serial[run].stats.requests != parallel[run].stats.requests)
+            [[unlikely]] {
+            FATAL("Run " + std::to_string(run) +
+                  " gave different results on one and many workers.");
+        }
+    }
+
+    const auto best = std::max_element(
+        parallel.begin(), parallel.end(), [](const auto &a, const auto &b) {
+            return a.result.pnl < b.result.pnl;
+        });
+    const auto &best_params = params[best->stats.run];
+    std::cout << "identical results, best run " << best->stats.run
+              << ": threshold " << std::setprecision(2)
+              << best_params.threshold << " qty " << best_params.qty
+              << " max position " << best_params.max_position << ", "
+              << best->result.trades << " trades, pnl "
+              << best->result.pnl << std::endl;
+
+    return 0;
+}
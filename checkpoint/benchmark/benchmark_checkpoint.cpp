@@ -0,0 +1,230 @@
+/// \file benchmark_checkpoint.cpp
+/// \brief Cost of taking book checkpoints during a live session, and time
+/// to restart from one compared with replaying the whole session.
+/// \details Replays synthetic order flow, numbered like the market data
+/// publisher does, into the books of four tickers. Halfway through, a
+/// checkpoint of every book begins and advances by one step every few
+/// updates, each step timed, until it is complete and written to a file.
+/// The restart then restores fresh books from the files and replays only the
+/// updates after each checkpoint. The restored books must hold the same
+/// orders, in the same queue order, as the books that saw every update. A
+/// full replay from the first update is timed for comparison.
+///
+/// Usage: CheckpointBenchmark [--updates N] [--step-every N]
+///                            [--ids-per-step N] [harness options]
+
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "checkpoint/bookcheckpoint.h"
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowbooks.h"
+#include "utilities/latencyhistogram.h"
+#include "utilities/tscclock.h"
+
+/// \brief Exits unless two books hold the same orders in the same queue
+/// order and have the same best bid and offer.
+auto compareBooks(const MarketOrderBook &expected,
+                  const MarketOrderBook &restored) -> void {
+    const auto ticker = tickerIdToString(expected.tickerId());
+    if (*expected.getBestBidOffer() != *restored.getBestBidOffer())
+        [[unlikely]] {
+        FATAL("Ticker " + ticker + " restored with best bid and offer " +
+              restored.getBestBidOffer()->toString() + " instead of " +
+              expected.getBestBidOffer()->toString());
+    }
+    for (const auto side : {Side::BUY, Side::SELL}) {
+        auto expected_level = expected.getBestLevel(side);
+        auto restored_level = restored.getBestLevel(side);
+        if (!expected_level || !restored_level) {
+            if (expected_level != restored_level) [[unlikely]] {
+                FATAL("Ticker " + ticker + " restored with a " +
+                      (restored_level ? "non-" : "") + "empty side.");
+            }
+            continue;
+        }
+        do {
+            if (expected_level->mPrice != restored_level->mPrice ||
+                expected_level->mTotal_qty != restored_level->mTotal_qty ||
+                expected_level->mOrder_count != restored_level->mOrder_count)
+                [[unlikely]] {
+                FATAL("Ticker " + ticker + " restored with level " +
+                      restored_level->toString() + " instead of " +
+                      expected_level->toString());
+            }
+            auto expected_order = expected_level->mFirst_market_order;
+            auto restored_order = restored_level->mFirst_market_order;
+            for (uint32_t i = 0; i < expected_level->mOrder_count; ++i) {
+                if (expected_order->mOrder_id != restored_order->mOrder_id ||
+                    expected_order->mQty != restored_order->mQty ||
+                    expected_order->mPriority != restored_order->mPriority)
+                    [[unlikely]] {
+                    FATAL("Ticker " + ticker + " restored with order " +
+                          restored_order->toString() + " instead of " +
+                          expected_order->toString());
+                }
+                expected_order = expected_order->mNext_order;
+                restored_order = restored_order->mNext_order;
+            }
+            expected_level = expected_level->mNext_entry;
+            restored_level = restored_level->mNext_entry;
+        } while (expected_level != expected.getBestLevel(side));
+    }
+}
+
+/// \brief Returns seconds elapsed since a time point.
+auto secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+}
+
+/// \brief Main function running the checkpoint benchmark.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    size_t updates = 2'000'000;
+    size_t step_every = 16;
+    size_t ids_per_step = BOOK_CHECKPOINT_IDS_PER_STEP;
+    setUpBenchmarkThread(
+        parseBenchmarkOptions(argc, argv,
+                              {{"--updates", updates},
+                               {"--step-every", step_every, 1},
+                               {"--ids-per-step", ids_per_step, 1}}));
+
+    OrderFlowConfig config;
+    OrderFlowGenerator generator(config);
+    std::vector<MDPMarketUpdate> flow;
+    for (const auto &update : generateOrderFlow(generator, updates)) {
+        MDPMarketUpdate numbered;
+        numbered.seq_num_ = flow.size() + 1;
+        numbered.me_market_update_ = update;
+        flow.push_back(numbered);
+    }
+    const auto tickers = config.num_tickers;
+    const auto directory =
+        (std::filesystem::temp_directory_path() / "checkpoint_benchmark")
+            .string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    const auto checkpointPath = [&directory](TickerId ticker_id) {
+        return directory + "/book." + std::to_string(ticker_id) +
+               ".checkpoint";
+    };
+
+    // The live session, checkpointing from its middle.
+    OrderFlowBooks live(tickers);
+    std::vector<std::unique_ptr<BookCheckpointer>> checkpointers;
+    for (TickerId ticker_id = 0; ticker_id < tickers; ++ticker_id) {
+        checkpointers.push_back(std::make_unique<BookCheckpointer>(
+            live[ticker_id], ids_per_step));
+    }
+    LatencyHistogram steps;
+    uint64_t track_ticks = 0;
+    double write_seconds = 0.0;
+    size_t written = 0;
+    size_t first_update = 0;
+    size_t last_update = 0;
+    for (size_t i = 0; i < flow.size(); ++i) {
+        const auto &update = flow[i];
+        const auto ticker_id = update.me_market_update_.ticker_id;
+        live.onMarketUpdate(&update.me_market_update_);
+        const auto start = TscClock::now();
+        checkpointers[ticker_id]->onMarketUpdate(update);
+        track_ticks += TscClock::now() - start;
+
+        if (i == flow.size() / 2) {
+            for (auto &checkpointer : checkpointers) checkpointer->begin();
+            first_update = i;
+        }
+        if (i % step_every) continue;
+        for (TickerId ticker = 0; ticker < tickers; ++ticker) {
+            auto &checkpointer = *checkpointers[ticker];
+            if (checkpointer.state() != BookCheckpointState::COPYING) {
+                continue;
+            }
+            const auto step_start = TscClock::now();
+            const auto state = checkpointer.step();
+            steps.record(TscClock::now() - step_start);
+            if (state != BookCheckpointState::COMPLETE) continue;
+
+            // Would be done by another thread while the book carries on.
+            const auto write_start = std::chrono::steady_clock::now();
+            if (!checkpointer.write(checkpointPath(ticker))) [[unlikely]] {
+                FATAL("Unable to write " + checkpointPath(ticker));
+            }
+            write_seconds += secondsSince(write_start);
+            ++written;
+            last_update = i;
+        }
+    }
+    if (written != tickers) [[unlikely]] {
+        FATAL("Only " + std::to_string(written) +
+              " checkpoints completed, use fewer --step-every.");
+    }
+
+    // The restart, from the checkpoints and the tail of the session.
+    OrderFlowBooks restored(tickers);
+    std::vector<uint64_t> seq_nums(tickers);
+    auto start = std::chrono::steady_clock::now();
+    size_t orders = 0;
+    for (TickerId ticker_id = 0; ticker_id < tickers; ++ticker_id) {
+        if (!restoreBookCheckpoint(checkpointPath(ticker_id),
+                                   restored[ticker_id],
+                                   seq_nums[ticker_id])) [[unlikely]] {
+            FATAL("Unable to restore " + checkpointPath(ticker_id));
+        }
+        orders += checkpointers[ticker_id]->orderCount();
+    }
+    const auto restore_seconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    const auto first_seq_num =
+        *std::min_element(seq_nums.begin(), seq_nums.end());
+    size_t tail = 0;
+    for (auto i = first_seq_num; i < flow.size(); ++i) {
+        const auto &update = flow[i];
+        const auto ticker_id = update.me_market_update_.ticker_id;
+        if (update.seq_num_ <= seq_nums[ticker_id]) continue;
+        restored.onMarketUpdate(&update.me_market_update_);
+        ++tail;
+    }
+    const auto tail_seconds = secondsSince(start);
+    for (TickerId ticker_id = 0; ticker_id < tickers; ++ticker_id) {
+        compareBooks(live[ticker_id], restored[ticker_id]);
+    }
+
+    // The restart without a checkpoint.
+    restored.clear();
+    start = std::chrono::steady_clock::now();
+    for (const auto &update : flow) {
+        restored.onMarketUpdate(&update.me_market_update_);
+    }
+    const auto replay_seconds = secondsSince(start);
+    std::filesystem::remove_all(directory);
+
+    std::cout << "checkpointed " << orders << " orders of " << tickers
+              << " books over " << last_update - first_update << " updates, "
+              << steps.count() << " steps of " << ids_per_step
+              << " ids every " << step_every << " updates"
+              << std::endl;
+    std::cout << std::fixed << std::setprecision(2)
+              << "tracking: " << TscClock::ticksToNanos(track_ticks) /
+                                     flow.size()
+              << " ns per update, step p50 "
+              << TscClock::toNanos(steps.percentile(50.0)) << " ns, p99 "
+              << TscClock::toNanos(steps.percentile(99.0)) << " ns, max "
+              << TscClock::toNanos(steps.max()) << " ns, files written in "
+              << write_seconds * 1e3 << " ms" << std::endl;
+    std::cout << "restart: restored in " << restore_seconds * 1e3
+              << " ms and replayed " << tail << " updates in "
+              << tail_seconds * 1e3 << " ms, identical books, against "
+              << flow.size() << " updates replayed in "
+              << replay_seconds * 1e3 << " ms without a checkpoint"
+              << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "market-orders/marketupdate.h"
+#include "order-book/orderbook.h"
+#include "utilities/macros.h"
+#include "utilities/mappedfile.h"
+#include "utilities/types.h"
+
+/// \brief Magic number at the start of every book checkpoint ("BCKP").
+constexpr uint32_t BOOK_CHECKPOINT_MAGIC = 0x504B4342;
+
+/// \brief Version of the book checkpoint layout.
+constexpr uint16_t BOOK_CHECKPOINT_VERSION = 1;
+
+/// \brief Default number of order ids a BookCheckpointer::step() visits.
+constexpr size_t BOOK_CHECKPOINT_IDS_PER_STEP = 1024;
+
+/// \brief Checkpoints are written to disk, so the binary structure is packed
+/// to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+/// \struct BookCheckpointHeader
+/// \brief Header at the start of a book checkpoint, the orders follow
+/// directly after it.
+struct BookCheckpointHeader {
+    /// Always BOOK_CHECKPOINT_MAGIC.
+    uint32_t magic = BOOK_CHECKPOINT_MAGIC;
+    /// Layout version, BOOK_CHECKPOINT_VERSION.
+    uint16_t version = BOOK_CHECKPOINT_VERSION;
+    /// Size of every order record, to reject images of another layout.
+    uint16_t order_size = 0;
+    /// Ticker of the book.
+    TickerId ticker_id = TickerId_INVALID;
+    /// Number of orders.
+    uint64_t order_count = 0;
+    /// Sequence number of the last market update the image includes.
+    uint64_t last_seq_num = 0;
+};
+
+/// \struct BookCheckpointOrder
+/// \brief A live order of the book, everything needed to rebuild it.
+struct BookCheckpointOrder {
+    OrderId order_id = OrderId_INVALID;
+    Side side = Side::INVALID;
+    Price price = Price_INVALID;
+    Qty qty = Qty_INVALID;
+    Priority priority = Priority_INVALID;
+};
+
+/// \brief Undo the packed binary structure directive moving forward.
+#pragma pack(pop)
+
+/// \enum BookCheckpointState
+/// \brief Progress of a BookCheckpointer.
+enum class BookCheckpointState : uint8_t {
+    /// No checkpoint is being taken.
+    IDLE = 0,
+    /// The live orders are being copied.
+    COPYING = 1,
+    /// The image is consistent and can be written.
+    COMPLETE = 2
+};
+
+/// \brief Converts a BookCheckpointState enum to a string.
+/// \param state The BookCheckpointState to convert.
+/// \return String representation of the BookCheckpointState.
+inline auto bookCheckpointStateToString(BookCheckpointState state)
+    -> std::string {
+    switch (state) {
+        case BookCheckpointState::IDLE:
+            return "IDLE";
+        case BookCheckpointState::COPYING:
+            return "COPYING";
+        case BookCheckpointState::COMPLETE:
+            return "COMPLETE";
+    }
+    return "UNKNOWN";
+}
+
+/// \brief Takes consistent checkpoints of a MarketOrderBook in small steps,
+/// on the thread that updates the book, without ever pausing it for long.
+///
+/// A checkpoint walks the order id space of the book, a thousand ids or so per
+/// step(), and copies the live orders it finds into a side buffer. Every
+/// market update is also passed to onMarketUpdate(): an update of an order
+/// whose id the walk has passed is applied to the side buffer, while one
+/// the walk has yet to reach needs nothing, as the walk will copy the order
+/// as it is then. When the walk reaches the end, the side buffer holds
+/// exactly the book as of the last update seen, whose sequence number goes
+/// into the image.
+///
+/// A complete image is frozen until release(), so write() can run on any
+/// thread, away from the book. The side buffer and its order id index are
+/// allocated and faulted in at construction, nothing is allocated while
+/// checkpointing.
+class BookCheckpointer final {
+   public:
+    /// \brief Constructs a BookCheckpointer.
+    /// \param book The book, only read by step().
+    /// \param ids_per_step Number of order ids visited by a step().
+    explicit BookCheckpointer(
+        const MarketOrderBook &book,
+        size_t ids_per_step = BOOK_CHECKPOINT_IDS_PER_STEP)
+        : mBook(book),
+          mIds_per_step(ids_per_step),
+          mSlots(ME_MAX_ORDER_IDS, 0) {
+        // Faults the side buffer in, so that steps do not.
+        mOrders.resize(ME_MAX_ORDER_IDS);
+        mOrders.clear();
+    }
+
+    /// \brief Starts a checkpoint if none is in progress or complete.
+    /// \return false if the previous checkpoint was not released yet.
+    auto begin() noexcept -> bool {
+        if (mState != BookCheckpointState::IDLE) return false;
+        mCursor = 0;
+        mState = BookCheckpointState::COPYING;
+        return true;
+    }
+
+    /// \brief Keeps the side buffer in line with a market update applied to
+    /// the book. Must see every update of the book, before or after it is
+    /// applied.
+    /// \param update The market update and its sequence number.
+    auto onMarketUpdate(const MDPMarketUpdate &update) noexcept -> void {
+        if (mState == BookCheckpointState::COMPLETE) [[unlikely]] return;
+        mLast_seq_num = update.seq_num_;
+        if (mState == BookCheckpointState::IDLE) [[likely]] return;
+
+        const auto &market_update = update.me_market_update_;
+        if (market_update.type == MarketUpdateType::CLEAR) [[unlikely]] {
+            clearOrders();
+            return;
+        }
+        // Orders the walk has yet to reach are copied as they are then.
+        if (market_update.order_id >= mCursor) return;
+
+        auto &slot = mSlots[market_update.order_id];
+        switch (market_update.type) {
+            case MarketUpdateType::ADD:
+                if (!slot) {
+                    mOrders.emplace_back();
+                    slot = static_cast<uint32_t>(mOrders.size());
+                }
+                mOrders[slot - 1] = {market_update.order_id, market_update.side,
+                                     market_update.price, market_update.qty,
+                                     market_update.priority};
+                break;
+            case MarketUpdateType::MODIFY:
+                if (slot) mOrders[slot - 1].qty = market_update.qty;
+                break;
+            case MarketUpdateType::CANCEL:
+                if (slot) {
+                    // Moves the last order into the hole.
+                    const auto &last = mOrders.back();
+                    mSlots[last.order_id] = slot;
+                    mOrders[slot - 1] = last;
+                    mOrders.pop_back();
+                    slot = 0;
+                }
+                break;
+            case MarketUpdateType::TRADE:
+            case MarketUpdateType::CLEAR:
+            case MarketUpdateType::INVALID:
+            case MarketUpdateType::SNAPSHOT_START:
+            case MarketUpdateType::SNAPSHOT_END:
+                break;
+        }
+    }
+
+    /// \brief Copies the live orders of the next ids_per_step order ids.
+    /// Must be called between market updates.
+    /// \return State of the checkpoint after the step.
+    auto step() noexcept -> BookCheckpointState {
+        if (mState != BookCheckpointState::COPYING) return mState;
+        const auto end = std::min<OrderId>(mCursor + mIds_per_step,
+                                           ME_MAX_ORDER_IDS);
+        for (; mCursor < end; ++mCursor) {
+            const auto order = mBook.getOrder(mCursor);
+            if (!order) continue;
+            mOrders.push_back({order->mOrder_id, order->mSide, order->mPrice,
+                               order->mQty, order->mPriority});
+            mSlots[mCursor] = static_cast<uint32_t>(mOrders.size());
+        }
+        if (mCursor == ME_MAX_ORDER_IDS) {
+            mImage_seq_num = mLast_seq_num;
+            mState = BookCheckpointState::COMPLETE;
+        }
+        return mState;
+    }
+
+    /// \brief Writes the complete image to a file.
+    /// \param path Path of the checkpoint file.
+    /// \return false if the checkpoint is not complete or the file cannot be
+    /// written.
+    auto write(const std::string &path) const noexcept -> bool {
+        if (mState != BookCheckpointState::COMPLETE) return false;
+        BookCheckpointHeader header;
+        header.order_size = sizeof(BookCheckpointOrder);
+        header.ticker_id = mBook.tickerId();
+        header.order_count = mOrders.size();
+        header.last_seq_num = mImage_seq_num;
+        const auto orders_size = mOrders.size() * sizeof(BookCheckpointOrder);
+
+        MappedFile file;
+        if (!file.create(path, sizeof(header) + orders_size)) [[unlikely]] {
+            return false;
+        }
+        std::memcpy(file.data(), &header, sizeof(header));
+        std::memcpy(file.data() + sizeof(header), mOrders.data(),
+                    orders_size);
+        file.syncAsync();
+        return true;
+    }
+
+    /// \brief Discards the image so that the next checkpoint can begin.
+    auto release() noexcept -> void {
+        clearOrders();
+        mState = BookCheckpointState::IDLE;
+    }
+
+    /// \brief Returns the state of the checkpoint.
+    auto state() const noexcept { return mState; }
+
+    /// \brief Returns the sequence number of the last update in the complete
+    /// image.
+    auto imageSeqNum() const noexcept { return mImage_seq_num; }
+
+    /// \brief Returns the number of orders in the side buffer.
+    auto orderCount() const noexcept { return mOrders.size(); }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    BookCheckpointer() = delete;
+    BookCheckpointer(const BookCheckpointer &) = delete;
+    BookCheckpointer(const BookCheckpointer &&) = delete;
+    BookCheckpointer &operator=(const BookCheckpointer &) = delete;
+    BookCheckpointer &operator=(const BookCheckpointer &&) = delete;
+
+   private:
+    /// \brief Empties the side buffer and its index.
+    auto clearOrders() noexcept -> void {
+        for (const auto &order : mOrders) mSlots[order.order_id] = 0;
+        mOrders.clear();
+    }
+
+    /// \brief The book.
+    const MarketOrderBook &mBook;
+    /// \brief Number of order ids visited by a step.
+    const size_t mIds_per_step;
+
+    /// \brief State of the checkpoint.
+    BookCheckpointState mState = BookCheckpointState::IDLE;
+    /// \brief Next order id the walk visits.
+    OrderId mCursor = 0;
+    /// \brief Sequence number of the last update seen.
+    uint64_t mLast_seq_num = 0;
+    /// \brief Sequence number of the last update in the complete image.
+    uint64_t mImage_seq_num = 0;
+
+    /// \brief The side buffer, the orders copied so far.
+    std::vector<BookCheckpointOrder> mOrders;
+    /// \brief One plus the index in mOrders of every order id, 0 if absent.
+    std::vector<uint32_t> mSlots;
+};
+
+/// \brief Restores a book from a checkpoint file.
+///
+/// The orders are bulk loaded in priority order, which puts every order
+/// back at its place in the queue of its level, and the best bid and offer
+/// is computed once at the end. The market updates after the returned
+/// sequence number must then be replayed.
+/// \param path Path of the checkpoint file.
+/// \param book The book, cleared before loading.
+/// \param last_seq_num Set to the sequence number of the last market update
+/// in the checkpoint.
+/// \return false, leaving the book untouched, if the file cannot be read or
+/// is not a checkpoint of the book's ticker.
+inline auto restoreBookCheckpoint(const std::string &path,
+                                  MarketOrderBook &book,
+                                  uint64_t &last_seq_num) -> bool {
+    MappedFile file;
+    if (!file.openReadOnly(path, true) ||
+        file.size() < sizeof(BookCheckpointHeader)) [[unlikely]] {
+        return false;
+    }
+    BookCheckpointHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != BOOK_CHECKPOINT_MAGIC ||
+        header.version != BOOK_CHECKPOINT_VERSION ||
+        header.order_size != sizeof(BookCheckpointOrder) ||
+        header.ticker_id != book.tickerId() ||
+        header.order_count > ME_MAX_ORDER_IDS ||
+        file.size() != sizeof(header) + header.order_count *
+                                            sizeof(BookCheckpointOrder))
+        [[unlikely]] {
+        return false;
+    }
+
+    std::vector<BookCheckpointOrder> orders(header.order_count);
+    std::memcpy(orders.data(), file.data() + sizeof(header),
+                orders.size() * sizeof(BookCheckpointOrder));
+    for (const auto &order : orders) {
+        if (order.order_id >= ME_MAX_ORDER_IDS ||
+            (order.side != Side::BUY && order.side != Side::SELL))
+            [[unlikely]] {
+            return false;
+        }
+    }
+    std::sort(orders.begin(), orders.end(),
+              [](const auto &a, const auto &b) {
+                  return a.priority < b.priority;
+              });
+
+    MEMarketUpdate clear;
+    clear.type = MarketUpdateType::CLEAR;
+    clear.ticker_id = book.tickerId();
+    book.onMarketUpdate(&clear);
+    for (const auto &order : orders) {
+        book.loadOrder(order.order_id, order.side, order.price, order.qty,
+                       order.priority);
+    }
+    book.finishLoad();
+    last_seq_num = header.last_seq_num;
+    return true;
+}
@@ -0,0 +1,334 @@
+/// \file benchmark_columnar.cpp
+/// \brief Size and scan speed of a market update journal exported to the
+/// columnar format, against the journal's own rows.
+/// \details Records synthetic order flow into a journal, converts it with
+/// journalToColumnar() and maps both. Every update rebuilt from the columns
+/// must equal the journal record, and books fed from either must agree. Two
+/// queries, the buy orders added to one ticker at or above a price, over the
+/// whole journal and over a tenth of its time range, are then timed as a
+/// loop over the journal rows and as a columnar scan that skips the chunks
+/// its zone maps exclude and decodes only the columns it filters on. Last,
+/// every column is decoded with AVX2 and one value at a time.
+///
+/// Usage: ColumnarBenchmark [--updates N] [--chunk-rows N] [--repeat N]
+///                          [harness options]
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "columnar/columnarreader.h"
+#include "columnar/columnarwriter.h"
+#include "journal/journal.h"
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowgenerator.h"
+
+/// \brief Records at least a number of generated updates into a journal.
+/// \return Number of updates recorded.
+auto recordFlow(const std::string &directory, const std::string &prefix,
+                size_t updates) -> size_t {
+    OrderFlowConfig config;
+    OrderFlowGenerator generator(config);
+    MEMarketUpdateLFQueue queue(ME_MAX_MARKET_UPDATES);
+    JournalWriter<MEMarketUpdate> writer(&queue, directory, prefix,
+                                         1'000'000);
+    writer.start();
+    size_t recorded = 0;
+    while (recorded < updates || generator.hasPending()) {
+        // Back off while the queue is nearly full
+        while (queue.size() >= ME_MAX_MARKET_UPDATES - 1) {
+            std::this_thread::yield();
+        }
+        *queue.getNextWrite() = generator.next()->update;
+        queue.updateWriteIndex();
+        ++recorded;
+    }
+    writer.stop();
+    return recorded;
+}
+
+/// \struct Query
+/// \brief Buy orders added to a ticker at or above a price, over a time
+/// range.
+struct Query {
+    uint64_t from_ns = 0;
+    uint64_t to_ns = 0;
+    TickerId ticker_id = 0;
+    Price min_price = 0;
+};
+
+/// \brief Counts the journal records matching a query.
+auto scanRows(const std::vector<JournalRecord<MEMarketUpdate>> &records,
+              const Query &query) noexcept -> size_t {
+    size_t matches = 0;
+    for (const auto &record : records) {
+        const auto &update = record.update;
+        matches += record.timestamp_ns >= query.from_ns &&
+                   record.timestamp_ns <= query.to_ns &&
+                   update.ticker_id == query.ticker_id &&
+                   update.type == MarketUpdateType::ADD &&
+                   update.side == Side::BUY && update.price >= query.min_price;
+    }
+    return matches;
+}
+
+/// \brief Counts the rows of the columnar file matching a query.
+/// \param skipped Receives the number of chunks the zone maps excluded.
+auto scanColumns(const ColumnarReader &reader, const Query &query,
+                 size_t &skipped) -> size_t {
+    const auto rows = reader.chunkRows();
+    std::vector<uint64_t> timestamps(rows);
+    std::vector<uint64_t> tickers(rows);
+    std::vector<uint64_t> types(rows);
+    std::vector<uint64_t> sides(rows);
+    std::vector<uint64_t> prices(rows);
+    size_t matches = 0;
+    skipped = 0;
+    for (size_t index = 0; index < reader.chunkCount(); ++index) {
+        if (!reader.mayContain(index, ColumnarColumn::TIMESTAMP,
+                               static_cast<int64_t>(query.from_ns),
+                               static_cast<int64_t>(query.to_ns)) ||
+            !reader.mayContain(index, ColumnarColumn::TICKER_ID,
+                               query.ticker_id, query.ticker_id) ||
+            !reader.mayContain(index, ColumnarColumn::PRICE, query.min_price,
+                               std::numeric_limits<int64_t>::max())) {
+            ++skipped;
+            continue;
+        }
+        const auto count = reader.chunk(index).row_count;
+        if (reader.decode(index, ColumnarColumn::TIMESTAMP,
+                          timestamps.data()) != count ||
+            reader.decode(index, ColumnarColumn::TICKER_ID, tickers.data()) !=
+                count ||
+            reader.decode(index, ColumnarColumn::TYPE, types.data()) != count ||
+            reader.decode(index, ColumnarColumn::SIDE, sides.data()) != count ||
+            reader.decode(index, ColumnarColumn::PRICE, prices.data()) !=
+                count) [[unlikely]] {
+            FATAL("Unable to decode chunk " + std::to_string(index));
+        }
+        for (size_t row = 0; row < count; ++row) {
+            matches +=
+                timestamps[row] >= query.from_ns &&
+                timestamps[row] <= query.to_ns &&
+                tickers[row] == query.ticker_id &&
+                types[row] == static_cast<uint64_t>(MarketUpdateType::ADD) &&
+                sides[row] == static_cast<uint64_t>(Side::BUY) &&
+                static_cast<Price>(prices[row]) >= query.min_price;
+        }
+    }
+    return matches;
+}
+
+/// \brief Decodes every column of every chunk.
+/// \return Sum of the values, so the decoding is not optimised away.
+template <bool Simd>
+auto decodeAll(const ColumnarReader &reader) -> uint64_t {
+    std::vector<uint64_t> values(reader.chunkRows());
+    uint64_t sum = 0;
+    for (size_t index = 0; index < reader.chunkCount(); ++index) {
+        for (size_t column = 0; column < COLUMNAR_COLUMN_COUNT; ++column) {
+            const auto count =
+                Simd ? reader.decode(index, static_cast<ColumnarColumn>(column),
+                                     values.data())
+                     : reader.decodeScalar(index,
+                                           static_cast<ColumnarColumn>(column),
+                                           values.data());
+            if (count != reader.chunk(index).row_count) [[unlikely]] {
+                FATAL("Unable to decode chunk " + std::to_string(index));
+            }
+            for (size_t row = 0; row < count; ++row) sum += values[row];
+        }
+    }
+    return sum;
+}
+
+/// \brief Returns the best time of a function over a number of runs.
+template <typename Function>
+auto bestSeconds(size_t repeat, Function &&function) -> double {
+    auto best = std::numeric_limits<double>::max();
+    for (size_t run = 0; run < repeat; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count());
+    }
+    return best;
+}
+
+/// \brief Main function running the columnar benchmark.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    size_t updates = 4'000'000;
+    size_t chunk_rows = COLUMNAR_CHUNK_ROWS;
+    size_t repeat = 5;
+    setUpBenchmarkThread(parseBenchmarkOptions(argc, argv,
+                                               {{"--updates", updates},
+                                                {"--chunk-rows", chunk_rows, 1},
+                                                {"--repeat", repeat, 1}}));
+    const auto directory =
+        (std::filesystem::temp_directory_path() / "columnar_benchmark")
+            .string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    recordFlow(directory, "market", updates);
+
+    // The journal rows, as the row-oriented baseline.
+    std::vector<JournalRecord<MEMarketUpdate>> records;
+    {
+        JournalReader<MEMarketUpdate> reader;
+        for (size_t segment_index = 0; reader.open(
+                 journalSegmentPath(directory, "market", segment_index));
+             ++segment_index) {
+            records.insert(records.end(), reader.begin(), reader.end());
+        }
+    }
+
+    const auto path = directory + "/market.columnar";
+    size_t rows = 0;
+    const auto convert_seconds = bestSeconds(1, [&] {
+        ColumnarWriter writer(chunk_rows);
+        if (!writer.open(path)) [[unlikely]] {
+            FATAL("Unable to create columnar file:" + path);
+        }
+        for (const auto &record : records) {
+            writer.append(record.timestamp_ns, record.update);
+        }
+        writer.close();
+        rows = writer.rowCount();
+    });
+    size_t converted = 0;
+    if (!journalToColumnar(directory, "market", path + ".journal",
+                           converted, chunk_rows) ||
+        converted != rows) [[unlikely]] {
+        FATAL("Unable to convert the journal in " + directory);
+    }
+    const auto columnar_bytes = std::filesystem::file_size(path);
+    if (std::filesystem::file_size(path + ".journal") != columnar_bytes)
+        [[unlikely]] {
+        FATAL("The journal converted to a different file.");
+    }
+
+    ColumnarReader reader;
+    if (!reader.open(path) || reader.rowCount() != records.size())
+        [[unlikely]] {
+        FATAL("Unable to read columnar file:" + path);
+    }
+    // The mapping keeps the pages after the files are unlinked.
+    std::filesystem::remove_all(directory);
+
+    // Every row rebuilt from the columns is the journal record, and replays
+    // into the same books.
+    const auto num_tickers = OrderFlowConfig().num_tickers;
+    std::vector<std::unique_ptr<MarketOrderBook>> journal_books;
+    std::vector<std::unique_ptr<MarketOrderBook>> columnar_books;
+    for (TickerId ticker_id = 0; ticker_id < num_tickers; ++ticker_id) {
+        journal_books.push_back(std::make_unique<MarketOrderBook>(ticker_id));
+        columnar_books.push_back(
+            std::make_unique<MarketOrderBook>(ticker_id));
+    }
+    size_t row = 0;
+    const auto checkRow = [&](uint64_t timestamp_ns,
+                              const MEMarketUpdate &update) {
+        const auto &record = records[row++];
+        if (timestamp_ns != record.timestamp_ns ||
+            std::memcmp(&update, &record.update, sizeof(update)))
+            [[unlikely]] {
+            FATAL("Row " + std::to_string(row - 1) +
+                  " differs from the journal: " + update.toString() +
+                  " instead of " + record.update.toString());
+        }
+        journal_books[record.update.ticker_id]->onMarketUpdate(
+            &record.update);
+        columnar_books[update.ticker_id]->onMarketUpdate(&update);
+        const auto &expected =
+            *journal_books[update.ticker_id]->getBestBidOffer();
+        const auto &actual =
+            *columnar_books[update.ticker_id]->getBestBidOffer();
+        if (std::memcmp(&expected, &actual, sizeof(expected))) [[unlikely]] {
+            FATAL("Books diverged at row " + std::to_string(row - 1));
+        }
+    };
+    if (!reader.forEachUpdate(checkRow) || row != records.size())
+        [[unlikely]] {
+        FATAL("Rebuilt " + std::to_string(row) + " of " +
+              std::to_string(records.size()) + " rows.");
+    }
+
+    const auto journal_bytes =
+        records.size() * sizeof(JournalRecord<MEMarketUpdate>);
+    std::cout << records.size() << " updates in " << reader.chunkCount()
+              << " chunks of " << reader.chunkRows()
+              << " rows, rebuilt rows and books checked" << std::endl;
+    std::cout << std::fixed << std::setprecision(1) << "journal "
+              << journal_bytes / 1e6 << " MB, columnar "
+              << columnar_bytes / 1e6 << " MB, "
+              << static_cast<double>(journal_bytes) / columnar_bytes
+              << "x smaller, "
+              << static_cast<double>(columnar_bytes) * 8 / records.size()
+              << " bits per update, written in "
+              << convert_seconds * 1e9 / records.size() << " ns per update"
+              << std::endl;
+
+    Query query;
+    query.to_ns = records.back().timestamp_ns;
+    query.from_ns = records.front().timestamp_ns;
+    query.min_price = 10'000 + 32;
+    const auto span = query.to_ns - query.from_ns;
+    Query window = query;
+    window.from_ns += span / 2;
+    window.to_ns = window.from_ns + span / 10;
+
+    const auto perRow = [&records](double seconds) {
+        return seconds * 1e9 / records.size();
+    };
+    std::cout << std::setw(10) << "query" << std::setw(10) << "matches"
+              << std::setw(14) << "rows ns/upd" << std::setw(16)
+              << "columns ns/upd" << std::setw(10) << "skipped" << std::endl;
+    for (const auto &[name, scan] :
+         {std::pair{"all", query}, std::pair{"window", window}}) {
+        size_t row_matches = 0;
+        size_t column_matches = 0;
+        size_t skipped = 0;
+        const auto row_seconds = bestSeconds(
+            repeat, [&] { row_matches = scanRows(records, scan); });
+        const auto column_seconds = bestSeconds(repeat, [&] {
+            column_matches = scanColumns(reader, scan, skipped);
+        });
+        if (row_matches != column_matches) [[unlikely]] {
+            FATAL(std::string("Query ") + name + " matched " +
+                  std::to_string(column_matches) + " columnar rows and " +
+                  std::to_string(row_matches) + " journal rows.");
+        }
+        std::cout << std::setw(10) << name << std::setw(10) << row_matches
+                  << std::setprecision(2) << std::setw(14)
+                  << perRow(row_seconds) << std::setw(16)
+                  << perRow(column_seconds) << std::setw(6) << skipped
+                  << " / " << reader.chunkCount() << std::endl;
+    }
+
+    uint64_t simd_sum = 0;
+    uint64_t scalar_sum = 0;
+    const auto simd_seconds = bestSeconds(
+        repeat, [&] { simd_sum = decodeAll<true>(reader); });
+    const auto scalar_seconds = bestSeconds(
+        repeat, [&] { scalar_sum = decodeAll<false>(reader); });
+    if (simd_sum != scalar_sum) [[unlikely]] {
+        FATAL("SIMD and scalar decoding disagree.");
+    }
+    const auto values = static_cast<double>(records.size()) *
+                        COLUMNAR_COLUMN_COUNT;
+    std::cout << std::setprecision(2) << "decode all columns: simd "
+              << simd_seconds * 1e9 / values << " ns per value, scalar "
+              << scalar_seconds * 1e9 / values << " ns per value"
+              << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,418 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+
+#include "market-orders/marketupdate.h"
+#include "utilities/types.h"
+
+static_assert(std::endian::native == std::endian::little,
+              "Column chunks are little-endian bit streams.");
+
+/// \brief Magic number at the start of every columnar file ("COLM").
+constexpr uint32_t COLUMNAR_MAGIC = 0x4D4C4F43;
+
+/// \brief Version of the columnar file layout.
+constexpr uint16_t COLUMNAR_VERSION = 1;
+
+/// \brief Default number of rows of a chunk, the decoded columns of a chunk
+/// stay in the L2 cache.
+constexpr size_t COLUMNAR_CHUNK_ROWS = 16 * 1024;
+
+/// \brief Zero bytes after every packed column, so that decoders can load
+/// eight bytes at any value without reading past the column.
+constexpr size_t COLUMNAR_PADDING = 8;
+
+/// \enum ColumnarColumn
+/// \brief The columns of a market update stream.
+enum class ColumnarColumn : uint8_t {
+    /// Time the update was recorded, delta coded.
+    TIMESTAMP = 0,
+    /// MarketUpdateType, bit-packed.
+    TYPE = 1,
+    /// Side, bit-packed.
+    SIDE = 2,
+    /// TickerId, dictionary coded.
+    TICKER_ID = 3,
+    /// OrderId, delta coded.
+    ORDER_ID = 4,
+    /// Price, delta coded.
+    PRICE = 5,
+    /// Qty, bit-packed.
+    QTY = 6,
+    /// Priority, delta coded.
+    PRIORITY = 7,
+    COUNT = 8
+};
+
+/// \brief Number of columns of a chunk.
+constexpr size_t COLUMNAR_COLUMN_COUNT =
+    static_cast<size_t>(ColumnarColumn::COUNT);
+
+/// \brief Converts a ColumnarColumn enum to a string.
+/// \param column The ColumnarColumn to convert.
+/// \return String representation of the ColumnarColumn.
+inline auto columnarColumnToString(ColumnarColumn column) -> std::string {
+    switch (column) {
+        case ColumnarColumn::TIMESTAMP:
+            return "TIMESTAMP";
+        case ColumnarColumn::TYPE:
+            return "TYPE";
+        case ColumnarColumn::SIDE:
+            return "SIDE";
+        case ColumnarColumn::TICKER_ID:
+            return "TICKER_ID";
+        case ColumnarColumn::ORDER_ID:
+            return "ORDER_ID";
+        case ColumnarColumn::PRICE:
+            return "PRICE";
+        case ColumnarColumn::QTY:
+            return "QTY";
+        case ColumnarColumn::PRIORITY:
+            return "PRIORITY";
+        case ColumnarColumn::COUNT:
+            return "COUNT";
+    }
+    return "UNKNOWN";
+}
+
+/// \enum ColumnarEncoding
+/// \brief How the values of a column chunk are stored. All encodings end in
+/// fixed width codes, bit-packed in a little-endian bit stream.
+enum class ColumnarEncoding : uint8_t {
+    INVALID = 0,
+    /// Values minus the chunk minimum, for small ranges such as enums.
+    FRAME_OF_REFERENCE = 1,
+    /// Zigzag coded differences between consecutive values, the first
+    /// difference is taken from the base, for sorted or slowly moving
+    /// values such as ids, prices and times.
+    DELTA = 2,
+    /// Indexes into a sorted dictionary of the distinct values of the chunk,
+    /// for a few values spread over a large range such as ticker ids.
+    DICTIONARY = 3
+};
+
+/// \brief Converts a ColumnarEncoding enum to a string.
+/// \param encoding The ColumnarEncoding to convert.
+/// \return String representation of the ColumnarEncoding.
+inline auto columnarEncodingToString(ColumnarEncoding encoding)
+    -> std::string {
+    switch (encoding) {
+        case ColumnarEncoding::FRAME_OF_REFERENCE:
+            return "FRAME_OF_REFERENCE";
+        case ColumnarEncoding::DELTA:
+            return "DELTA";
+        case ColumnarEncoding::DICTIONARY:
+            return "DICTIONARY";
+        case ColumnarEncoding::INVALID:
+            return "INVALID";
+    }
+    return "UNKNOWN";
+}
+
+/// \brief Returns the encoding of a column.
+constexpr auto columnarEncodingOf(ColumnarColumn column) noexcept
+    -> ColumnarEncoding {
+    switch (column) {
+        case ColumnarColumn::TIMESTAMP:
+        case ColumnarColumn::ORDER_ID:
+        case ColumnarColumn::PRICE:
+        case ColumnarColumn::PRIORITY:
+            return ColumnarEncoding::DELTA;
+        case ColumnarColumn::TICKER_ID:
+            return ColumnarEncoding::DICTIONARY;
+        case ColumnarColumn::TYPE:
+        case ColumnarColumn::SIDE:
+        case ColumnarColumn::QTY:
+            return ColumnarEncoding::FRAME_OF_REFERENCE;
+        case ColumnarColumn::COUNT:
+            break;
+    }
+    return ColumnarEncoding::INVALID;
+}
+
+/// \brief Returns the value a column uses for a missing field, such as the
+/// price of a CLEAR, which zone maps leave out.
+constexpr auto columnarSentinelOf(ColumnarColumn column) noexcept
+    -> int64_t {
+    switch (column) {
+        case ColumnarColumn::TICKER_ID:
+            return static_cast<int64_t>(TickerId_INVALID);
+        case ColumnarColumn::ORDER_ID:
+            return static_cast<int64_t>(OrderId_INVALID);
+        case ColumnarColumn::PRICE:
+            return Price_INVALID;
+        case ColumnarColumn::QTY:
+            return static_cast<int64_t>(Qty_INVALID);
+        case ColumnarColumn::PRIORITY:
+            return static_cast<int64_t>(Priority_INVALID);
+        case ColumnarColumn::TIMESTAMP:
+        case ColumnarColumn::TYPE:
+        case ColumnarColumn::SIDE:
+        case ColumnarColumn::COUNT:
+            break;
+    }
+    // No sentinel, a value no column holds.
+    return std::numeric_limits<int64_t>::min();
+}
+
+/// \brief Columnar files are written to disk, so the binary structures are
+/// packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+/// \struct ColumnarFileHeader
+/// \brief Header at the start of a columnar file, the chunks follow it.
+struct ColumnarFileHeader {
+    /// Always COLUMNAR_MAGIC.
+    uint32_t magic = COLUMNAR_MAGIC;
+    /// Layout version, COLUMNAR_VERSION.
+    uint16_t version = COLUMNAR_VERSION;
+    /// Number of columns of every chunk, COLUMNAR_COLUMN_COUNT.
+    uint16_t column_count = COLUMNAR_COLUMN_COUNT;
+    /// Largest number of rows of a chunk.
+    uint32_t chunk_rows = 0;
+    /// Number of rows of the file.
+    uint64_t row_count = 0;
+    /// Number of chunks of the file.
+    uint64_t chunk_count = 0;
+};
+
+/// \struct ColumnarColumnHeader
+/// \brief How a column of a chunk is stored, and its zone map.
+struct ColumnarColumnHeader {
+    /// Encoding of the values.
+    ColumnarEncoding encoding = ColumnarEncoding::INVALID;
+    /// Width of the packed codes in bits, 0 if all codes are 0.
+    uint8_t bit_width = 0;
+    /// Number of dictionary entries, before the codes, of a DICTIONARY
+    /// column.
+    uint32_t dictionary_size = 0;
+    /// Minimum of a FRAME_OF_REFERENCE column, value before the first of a
+    /// DELTA column.
+    int64_t base = 0;
+    /// Smallest value of the chunk, sentinels left out. Greater than max if
+    /// the chunk only holds sentinels.
+    int64_t min = std::numeric_limits<int64_t>::max();
+    /// Largest value of the chunk, sentinels left out.
+    int64_t max = std::numeric_limits<int64_t>::min();
+    /// Offset of the column data from the start of the chunk.
+    uint64_t offset = 0;
+    /// Size of the column data, dictionary, codes and padding.
+    uint64_t size = 0;
+};
+
+/// \struct ColumnarChunkHeader
+/// \brief Header at the start of a chunk, the columns follow it.
+struct ColumnarChunkHeader {
+    /// Number of rows of the chunk.
+    uint32_t row_count = 0;
+    /// Size of the chunk, header included.
+    uint64_t size = 0;
+    /// Every column, in ColumnarColumn order.
+    ColumnarColumnHeader columns[COLUMNAR_COLUMN_COUNT];
+};
+
+/// \brief Undo the packed binary structure directive moving forward.
+#pragma pack(pop)
+
+/// \brief Zigzag codes a signed value, small magnitudes get small codes.
+constexpr auto zigzagEncode(int64_t value) noexcept -> uint64_t {
+    return (static_cast<uint64_t>(value) << 1) ^
+           static_cast<uint64_t>(value >> 63);
+}
+
+/// \brief Reverses zigzagEncode().
+constexpr auto zigzagDecode(uint64_t code) noexcept -> int64_t {
+    return static_cast<int64_t>((code >> 1) ^ (~(code & 1) + 1));
+}
+
+/// \brief Returns the size of count codes of a bit width, padding included.
+constexpr auto columnarPackedSize(size_t count, unsigned bit_width) noexcept
+    -> size_t {
+    return (count * bit_width + 7) / 8 + COLUMNAR_PADDING;
+}
+
+/// \brief Packs codes of a bit width into a zeroed little-endian bit stream
+/// of columnarPackedSize() bytes.
+/// \param codes Codes, each below 2^bit_width.
+/// \param count Number of codes.
+/// \param bit_width Width of every code, 0 to 64.
+/// \param packed The bit stream.
+inline auto bitPack(const uint64_t *codes, size_t count, unsigned bit_width,
+                    uint8_t *packed) noexcept -> void {
+    if (!bit_width) return;
+    for (size_t i = 0; i < count; ++i) {
+        const auto bit = i * bit_width;
+        const auto byte = bit / 8;
+        const auto shift = bit % 8;
+        uint64_t low;
+        std::memcpy(&low, packed + byte, sizeof(low));
+        low |= codes[i] << shift;
+        std::memcpy(packed + byte, &low, sizeof(low));
+        // Codes wider than 56 bits may spill past the eight bytes.
+        if (shift + bit_width > 64) {
+            packed[byte + 8] |= static_cast<uint8_t>(codes[i] >> (64 - shift));
+        }
+    }
+}
+
+/// \brief Unpacks codes from a bit stream, one at a time.
+/// \param packed The bit stream, columnarPackedSize() bytes.
+/// \param count Number of codes.
+/// \param bit_width Width of every code, 0 to 64.
+/// \param codes Receives the codes.
+inline auto bitUnpackScalar(const uint8_t *packed, size_t count,
+                            unsigned bit_width, uint64_t *codes) noexcept
+    -> void {
+    if (!bit_width) {
+        std::fill(codes, codes + count, 0);
+        return;
+    }
+    const auto mask =
+        bit_width == 64 ? ~uint64_t{0} : (uint64_t{1} << bit_width) - 1;
+    for (size_t i = 0; i < count; ++i) {
+        const auto bit = i * bit_width;
+        const auto byte = bit / 8;
+        const auto shift = bit % 8;
+        uint64_t low;
+        std::memcpy(&low, packed + byte, sizeof(low));
+        auto code = low >> shift;
+        if (shift + bit_width > 64) {
+            code |= static_cast<uint64_t>(packed[byte + 8]) << (64 - shift);
+        }
+        codes[i] = code & mask;
+    }
+}
+
+/// \brief Unpacks codes from a bit stream, four at a time with AVX2 when
+/// the codes fit the eight bytes loaded at their first byte.
+/// \param packed The bit stream, columnarPackedSize() bytes.
+/// \param count Number of codes.
+/// \param bit_width Width of every code, 0 to 64.
+/// \param codes Receives the codes.
+inline auto bitUnpack(const uint8_t *packed, size_t count, unsigned bit_width,
+                      uint64_t *codes) noexcept -> void {
+#if defined(__AVX2__)
+    if (bit_width && bit_width <= 56) {
+        const auto mask = _mm256_set1_epi64x(
+            static_cast<int64_t>((uint64_t{1} << bit_width) - 1));
+        const auto step = _mm256_set1_epi64x(4 * bit_width);
+        const auto seven = _mm256_set1_epi64x(7);
+        auto bits = _mm256_set_epi64x(3 * bit_width, 2 * bit_width, bit_width,
+                                      0);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const auto words = _mm256_i64gather_epi64(
+                reinterpret_cast<const long long *>(packed),
+                _mm256_srli_epi64(bits, 3), 1);
+            const auto values = _mm256_and_si256(
+                _mm256_srlv_epi64(words, _mm256_and_si256(bits, seven)), mask);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(codes + i),
+                                values);
+            bits = _mm256_add_epi64(bits, step);
+        }
+        for (; i < count; ++i) {
+            const auto bit = i * bit_width;
+            uint64_t low;
+            std::memcpy(&low, packed + bit / 8, sizeof(low));
+            codes[i] = (low >> (bit % 8)) & ((uint64_t{1} << bit_width) - 1);
+        }
+        return;
+    }
+#endif
+    bitUnpackScalar(packed, count, bit_width, codes);
+}
+
+/// \brief Turns zigzag coded differences into values, in place, one at a
+/// time.
+/// \param base Value before the first.
+inline auto deltaDecodeScalar(uint64_t *codes, size_t count,
+                              int64_t base) noexcept -> void {
+    auto value = static_cast<uint64_t>(base);
+    for (size_t i = 0; i < count; ++i) {
+        value += static_cast<uint64_t>(zigzagDecode(codes[i]));
+        codes[i] = value;
+    }
+}
+
+/// \brief Turns zigzag coded differences into values, in place, with an
+/// AVX2 prefix sum over four values at a time.
+/// \param base Value before the first.
+inline auto deltaDecode(uint64_t *codes, size_t count, int64_t base) noexcept
+    -> void {
+#if defined(__AVX2__)
+    const auto one = _mm256_set1_epi64x(1);
+    const auto zero = _mm256_setzero_si256();
+    auto carry = _mm256_set1_epi64x(base);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto values =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(codes + i));
+        // Zigzag decode, (code >> 1) ^ -(code & 1).
+        values = _mm256_xor_si256(
+            _mm256_srli_epi64(values, 1),
+            _mm256_sub_epi64(zero, _mm256_and_si256(values, one)));
+        // Inclusive prefix sum of the four lanes, then the running total.
+        values = _mm256_add_epi64(
+            values, _mm256_blend_epi32(_mm256_permute4x64_epi64(
+                                           values, _MM_SHUFFLE(2, 1, 0, 0)),
+                                       zero, 0x03));
+        values = _mm256_add_epi64(
+            values, _mm256_blend_epi32(_mm256_permute4x64_epi64(
+                                           values, _MM_SHUFFLE(1, 0, 0, 0)),
+                                       zero, 0x0F));
+        values = _mm256_add_epi64(values, carry);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(codes + i), values);
+        carry = _mm256_permute4x64_epi64(values, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    if (i < count) {
+        deltaDecodeScalar(codes + i, count - i,
+                          i ? static_cast<int64_t>(codes[i - 1]) : base);
+    }
+#else
+    deltaDecodeScalar(codes, count, base);
+#endif
+}
+
+/// \brief Adds the base of a frame of reference to codes, in place.
+inline auto frameDecode(uint64_t *codes, size_t count, int64_t base) noexcept
+    -> void {
+    // Plain enough for the compiler to vectorise.
+    for (size_t i = 0; i < count; ++i) {
+        codes[i] += static_cast<uint64_t>(base);
+    }
+}
+
+/// \brief Replaces dictionary codes by their values, in place.
+/// \param dictionary The dictionary, dictionary_size little-endian values.
+inline auto dictionaryDecode(uint64_t *codes, size_t count,
+                             const uint8_t *dictionary) noexcept -> void {
+#if defined(__AVX2__)
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const auto indexes =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(codes + i));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i *>(codes + i),
+            _mm256_i64gather_epi64(
+                reinterpret_cast<const long long *>(dictionary), indexes, 8));
+    }
+    for (; i < count; ++i) {
+        std::memcpy(&codes[i], dictionary + codes[i] * sizeof(uint64_t),
+                    sizeof(uint64_t));
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        std::memcpy(&codes[i], dictionary + codes[i] * sizeof(uint64_t),
+                    sizeof(uint64_t));
+    }
+#endif
+}
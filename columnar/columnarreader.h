@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "columnar/columnarformat.h"
+#include "market-orders/marketupdate.h"
+#include "utilities/mappedfile.h"
+
+/// \struct ColumnarRows
+/// \brief The decoded columns of a chunk, from which MEMarketUpdate rows are
+/// rebuilt.
+struct ColumnarRows {
+    /// Values of every column, in ColumnarColumn order.
+    std::array<std::vector<uint64_t>, COLUMNAR_COLUMN_COUNT> mColumns;
+    /// Number of rows decoded.
+    size_t mRow_count = 0;
+
+    /// \brief Returns the values of a column.
+    auto column(ColumnarColumn column) const noexcept -> const uint64_t * {
+        return mColumns[static_cast<size_t>(column)].data();
+    }
+
+    /// \brief Returns the time a row was recorded.
+    auto timestamp(size_t row) const noexcept {
+        return column(ColumnarColumn::TIMESTAMP)[row];
+    }
+
+    /// \brief Rebuilds the market update of a row.
+    auto update(size_t row) const noexcept {
+        MEMarketUpdate update;
+        update.type =
+            static_cast<MarketUpdateType>(column(ColumnarColumn::TYPE)[row]);
+        update.order_id = column(ColumnarColumn::ORDER_ID)[row];
+        update.ticker_id =
+            static_cast<TickerId>(column(ColumnarColumn::TICKER_ID)[row]);
+        update.side = static_cast<Side>(column(ColumnarColumn::SIDE)[row]);
+        update.price = static_cast<Price>(column(ColumnarColumn::PRICE)[row]);
+        update.qty = static_cast<Qty>(column(ColumnarColumn::QTY)[row]);
+        update.priority = column(ColumnarColumn::PRIORITY)[row];
+        return update;
+    }
+};
+
+/// \brief Maps a columnar file read-only and decodes its columns.
+///
+/// Opening the file walks the chunk headers once, so the zone maps of every
+/// chunk can be checked before any column is decoded. Scans decode only the
+/// columns they filter on, into caller provided arrays of the chunk's row
+/// count. Decoding unpacks the bit-packed codes, then undoes the frame of
+/// reference, delta or dictionary coding, four values at a time with AVX2
+/// when it is available.
+class ColumnarReader final {
+   public:
+    /// \brief Constructs a reader with no file mapped.
+    ColumnarReader() = default;
+
+    /// \brief Maps a columnar file and validates its headers.
+    /// \param path Path of the file.
+    /// \return true on success, false if the file cannot be mapped or is not
+    /// a columnar file of this layout.
+    auto open(const std::string &path) noexcept -> bool {
+        mChunks.clear();
+        if (!mFile.openReadOnly(path, true)) return false;
+        if (mFile.size() < sizeof(ColumnarFileHeader)) [[unlikely]] {
+            return fail();
+        }
+        const auto &header = fileHeader();
+        if (header.magic != COLUMNAR_MAGIC ||
+            header.version != COLUMNAR_VERSION ||
+            header.column_count != COLUMNAR_COLUMN_COUNT) [[unlikely]] {
+            return fail();
+        }
+        size_t offset = sizeof(ColumnarFileHeader);
+        uint64_t rows = 0;
+        for (uint64_t index = 0; index < header.chunk_count; ++index) {
+            if (offset + sizeof(ColumnarChunkHeader) > mFile.size())
+                [[unlikely]] {
+                return fail();
+            }
+            const auto &chunk = *reinterpret_cast<const ColumnarChunkHeader *>(
+                mFile.data() + offset);
+            if (chunk.size < sizeof(ColumnarChunkHeader) ||
+                offset + chunk.size > mFile.size() ||
+                chunk.row_count > header.chunk_rows) [[unlikely]] {
+                return fail();
+            }
+            for (size_t column = 0; column < COLUMNAR_COLUMN_COUNT;
+                 ++column) {
+                if (!validColumn(chunk, static_cast<ColumnarColumn>(column)))
+                    [[unlikely]] {
+                    return fail();
+                }
+            }
+            mChunks.push_back(offset);
+            rows += chunk.row_count;
+            offset += chunk.size;
+        }
+        if (rows != header.row_count) [[unlikely]] return fail();
+        mFile.adviseSequential();
+        return true;
+    }
+
+    /// \brief Returns the number of rows of the file.
+    auto rowCount() const noexcept { return fileHeader().row_count; }
+
+    /// \brief Returns the number of chunks of the file.
+    auto chunkCount() const noexcept { return mChunks.size(); }
+
+    /// \brief Returns the largest number of rows of a chunk.
+    auto chunkRows() const noexcept -> size_t {
+        return fileHeader().chunk_rows;
+    }
+
+    /// \brief Returns the header of a chunk, with its row count and zone
+    /// maps.
+    auto chunk(size_t index) const noexcept -> const ColumnarChunkHeader & {
+        return *reinterpret_cast<const ColumnarChunkHeader *>(mFile.data() +
+                                                              mChunks[index]);
+    }
+
+    /// \brief Returns whether a chunk may hold values of a column in a range,
+    /// from its zone map.
+    /// \param low Smallest value of the range.
+    /// \param high Largest value of the range.
+    auto mayContain(size_t index, ColumnarColumn column, int64_t low,
+                    int64_t high) const noexcept -> bool {
+        const auto &header = chunk(index).columns[static_cast<size_t>(column)];
+        return header.min <= high && header.max >= low;
+    }
+
+    /// \brief Decodes a column of a chunk.
+    /// \param index Index of the chunk.
+    /// \param column The column.
+    /// \param values Receives the chunk's row_count values, as the bits of
+    /// the field's type.
+    /// \return Number of values decoded, 0 if a dictionary code is past the
+    /// end of its dictionary.
+    auto decode(size_t index, ColumnarColumn column,
+                uint64_t *values) const noexcept -> size_t {
+        return decodeColumn<true>(index, column, values);
+    }
+
+    /// \brief Decodes a column of a chunk one value at a time, like decode()
+    /// without SIMD.
+    auto decodeScalar(size_t index, ColumnarColumn column,
+                      uint64_t *values) const noexcept -> size_t {
+        return decodeColumn<false>(index, column, values);
+    }
+
+    /// \brief Decodes every column of a chunk.
+    /// \param index Index of the chunk.
+    /// \param rows Receives the columns.
+    /// \return true on success, false if a column fails to decode, when the
+    /// rows must not be used.
+    auto readRows(size_t index, ColumnarRows &rows) const -> bool {
+        rows.mRow_count = chunk(index).row_count;
+        for (size_t column = 0; column < COLUMNAR_COLUMN_COUNT; ++column) {
+            rows.mColumns[column].resize(rows.mRow_count);
+            if (decode(index, static_cast<ColumnarColumn>(column),
+                       rows.mColumns[column].data()) != rows.mRow_count)
+                [[unlikely]] {
+                rows.mRow_count = 0;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// \brief Calls a function with every row of the file, in order, rebuilt
+    /// as a MEMarketUpdate, to replay it into a MarketOrderBook for
+    /// instance.
+    /// \param function Called with the timestamp and the update of every row.
+    /// \return true on success, false if a chunk fails to decode, when the
+    /// rows of the chunks before it have been replayed and no others.
+    template <typename Function>
+    auto forEachUpdate(Function &&function) const -> bool {
+        ColumnarRows rows;
+        for (size_t index = 0; index < chunkCount(); ++index) {
+            if (!readRows(index, rows)) [[unlikely]] return false;
+            for (size_t row = 0; row < rows.mRow_count; ++row) {
+                function(rows.timestamp(row), rows.update(row));
+            }
+        }
+        return true;
+    }
+
+    // Deleted copy & move constructors and assignment-operators.
+    ColumnarReader(const ColumnarReader &) = delete;
+    ColumnarReader(const ColumnarReader &&) = delete;
+    ColumnarReader &operator=(const ColumnarReader &) = delete;
+    ColumnarReader &operator=(const ColumnarReader &&) = delete;
+
+   private:
+    /// \brief Returns the header of the file.
+    auto fileHeader() const noexcept -> const ColumnarFileHeader & {
+        return *reinterpret_cast<const ColumnarFileHeader *>(mFile.data());
+    }
+
+    /// \brief Unmaps a file that failed validation.
+    auto fail() noexcept -> bool {
+        mFile.close();
+        mChunks.clear();
+        return false;
+    }
+
+    /// \brief Returns whether the header of a column fits its chunk and can
+    /// be decoded: the column's own encoding, codes of at most 64 bits and,
+    /// for a dictionary, no wider than its largest index.
+    static auto validColumn(const ColumnarChunkHeader &chunk,
+                            ColumnarColumn column) noexcept -> bool {
+        const auto &header = chunk.columns[static_cast<size_t>(column)];
+        if (header.encoding != columnarEncodingOf(column) ||
+            header.bit_width > 64) {
+            return false;
+        }
+        if (header.encoding == ColumnarEncoding::DICTIONARY &&
+            chunk.row_count &&
+            (!header.dictionary_size ||
+             header.bit_width >
+                 std::bit_width(uint64_t{header.dictionary_size} - 1))) {
+            return false;
+        }
+        return header.offset <= chunk.size &&
+               header.size <= chunk.size - header.offset &&
+               header.size >=
+                   columnarPackedSize(chunk.row_count, header.bit_width) +
+                       header.dictionary_size * sizeof(uint64_t);
+    }
+
+    /// \brief Decodes a column of a chunk, with or without SIMD.
+    template <bool Simd>
+    auto decodeColumn(size_t index, ColumnarColumn column,
+                      uint64_t *values) const noexcept -> size_t {
+        const auto &chunk_header = chunk(index);
+        const auto &header =
+            chunk_header.columns[static_cast<size_t>(column)];
+        const auto count = static_cast<size_t>(chunk_header.row_count);
+        const auto data = reinterpret_cast<const uint8_t *>(mFile.data()) +
+                          mChunks[index] + header.offset;
+        const auto dictionary_bytes =
+            header.dictionary_size * sizeof(uint64_t);
+        if constexpr (Simd) {
+            bitUnpack(data + dictionary_bytes, count, header.bit_width,
+                      values);
+        } else {
+            bitUnpackScalar(data + dictionary_bytes, count, header.bit_width,
+                            values);
+        }
+        switch (header.encoding) {
+            case ColumnarEncoding::FRAME_OF_REFERENCE:
+                frameDecode(values, count, header.base);
+                break;
+            case ColumnarEncoding::DELTA:
+                if constexpr (Simd) {
+                    deltaDecode(values, count, header.base);
+                } else {
+                    deltaDecodeScalar(values, count, header.base);
+                }
+                break;
+            case ColumnarEncoding::DICTIONARY: {
+                // A code may still be past the end of a dictionary whose
+                // size is not a power of two.
+                uint64_t largest = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    largest = std::max(largest, values[i]);
+                }
+                if (count && largest >= header.dictionary_size) [[unlikely]] {
+                    return 0;
+                }
+                dictionaryDecode(values, count, data);
+            } break;
+            case ColumnarEncoding::INVALID:
+                return 0;
+        }
+        return count;
+    }
+
+    /// \brief The mapped file.
+    MappedFile mFile;
+    /// \brief Offset of every chunk from the start of the file.
+    std::vector<size_t> mChunks;
+};
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "columnar/columnarformat.h"
+#include "journal/journal.h"
+#include "market-orders/marketupdate.h"
+#include "utilities/macros.h"
+
+/// \brief Converts a stream of market updates into a columnar file.
+///
+/// Rows are buffered a chunk at a time, one vector of values per column.
+/// A full chunk is encoded column by column, each column with the encoding
+/// columnarEncodingOf() gives it and its zone map, and appended to the file.
+/// The file header, holding the row and chunk counts, is written again when
+/// the file is closed.
+class ColumnarWriter final {
+   public:
+    /// \brief Constructs a writer with no file open.
+    /// \param chunk_rows Number of rows of every chunk but the last.
+    explicit ColumnarWriter(size_t chunk_rows = COLUMNAR_CHUNK_ROWS)
+        : mChunk_rows(chunk_rows) {
+        ASSERT(chunk_rows > 0, "A chunk must hold at least one row.");
+        for (auto &values : mValues) values.reserve(chunk_rows);
+        mCodes.reserve(chunk_rows);
+    }
+
+    /// \brief Closes the file if it is open.
+    ~ColumnarWriter() { close(); }
+
+    /// \brief Creates (or truncates) a columnar file.
+    /// \param path Path of the file.
+    /// \return true on success, false if the file cannot be created.
+    auto open(const std::string &path) -> bool {
+        close();
+        mFile.open(path, std::ios::binary | std::ios::trunc);
+        mHeader = {};
+        mHeader.chunk_rows = static_cast<uint32_t>(mChunk_rows);
+        mBytes_written = 0;
+        write(&mHeader, sizeof(mHeader));
+        return mFile.good();
+    }
+
+    /// \brief Appends a row.
+    /// \param timestamp_ns Time the update was recorded.
+    /// \param update The market update.
+    auto append(uint64_t timestamp_ns, const MEMarketUpdate &update) -> void {
+        push(ColumnarColumn::TIMESTAMP, static_cast<int64_t>(timestamp_ns));
+        push(ColumnarColumn::TYPE, static_cast<int64_t>(update.type));
+        push(ColumnarColumn::SIDE, static_cast<int64_t>(update.side));
+        push(ColumnarColumn::TICKER_ID, static_cast<int64_t>(update.ticker_id));
+        push(ColumnarColumn::ORDER_ID, static_cast<int64_t>(update.order_id));
+        push(ColumnarColumn::PRICE, update.price);
+        push(ColumnarColumn::QTY, static_cast<int64_t>(update.qty));
+        push(ColumnarColumn::PRIORITY, static_cast<int64_t>(update.priority));
+        if (mValues[0].size() == mChunk_rows) writeChunk();
+    }
+
+    /// \brief Writes the last chunk and the final file header, and closes
+    /// the file.
+    /// \return true if every write succeeded.
+    auto close() -> bool {
+        if (!mFile.is_open()) return false;
+        if (!mValues[0].empty()) writeChunk();
+        mFile.seekp(0);
+        mFile.write(reinterpret_cast<const char *>(&mHeader),
+                    sizeof(mHeader));
+        const auto good = mFile.good();
+        mFile.close();
+        return good;
+    }
+
+    /// \brief Returns the number of rows written so far.
+    auto rowCount() const noexcept { return mHeader.row_count; }
+
+    /// \brief Returns the number of bytes written so far.
+    auto bytesWritten() const noexcept { return mBytes_written; }
+
+    // Deleted copy & move constructors and assignment-operators.
+    ColumnarWriter(const ColumnarWriter &) = delete;
+    ColumnarWriter(const ColumnarWriter &&) = delete;
+    ColumnarWriter &operator=(const ColumnarWriter &) = delete;
+    ColumnarWriter &operator=(const ColumnarWriter &&) = delete;
+
+   private:
+    /// \brief Appends a value to a column of the current chunk.
+    auto push(ColumnarColumn column, int64_t value) -> void {
+        mValues[static_cast<size_t>(column)].push_back(value);
+    }
+
+    /// \brief Writes bytes to the file.
+    auto write(const void *data, size_t size) -> void {
+        mFile.write(static_cast<const char *>(data),
+                    static_cast<std::streamsize>(size));
+        mBytes_written += size;
+    }
+
+    /// \brief Encodes the buffered rows as a chunk and writes it.
+    auto writeChunk() -> void {
+        ColumnarChunkHeader chunk;
+        chunk.row_count = static_cast<uint32_t>(mValues[0].size());
+        mChunk.clear();
+        for (size_t index = 0; index < COLUMNAR_COLUMN_COUNT; ++index) {
+            auto &header = chunk.columns[index];
+            header.offset = sizeof(ColumnarChunkHeader) + mChunk.size();
+            encodeColumn(static_cast<ColumnarColumn>(index), mValues[index],
+                         header);
+            header.size =
+                sizeof(ColumnarChunkHeader) + mChunk.size() - header.offset;
+            mValues[index].clear();
+        }
+        chunk.size = sizeof(ColumnarChunkHeader) + mChunk.size();
+        write(&chunk, sizeof(chunk));
+        write(mChunk.data(), mChunk.size());
+        mHeader.row_count += chunk.row_count;
+        ++mHeader.chunk_count;
+    }
+
+    /// \brief Encodes a column of the chunk and appends it to mChunk.
+    auto encodeColumn(ColumnarColumn column,
+                      const std::vector<int64_t> &values,
+                      ColumnarColumnHeader &header) -> void {
+        const auto sentinel = columnarSentinelOf(column);
+        for (const auto value : values) {
+            if (value == sentinel) continue;
+            header.min = std::min(header.min, value);
+            header.max = std::max(header.max, value);
+        }
+
+        header.encoding = columnarEncodingOf(column);
+        mCodes.resize(values.size());
+        switch (header.encoding) {
+            case ColumnarEncoding::FRAME_OF_REFERENCE: {
+                header.base = *std::min_element(values.begin(), values.end());
+                for (size_t i = 0; i < values.size(); ++i) {
+                    mCodes[i] = static_cast<uint64_t>(values[i]) -
+                                static_cast<uint64_t>(header.base);
+                }
+            } break;
+            case ColumnarEncoding::DELTA: {
+                header.base = values.front();
+                auto previous = static_cast<uint64_t>(header.base);
+                for (size_t i = 0; i < values.size(); ++i) {
+                    const auto value = static_cast<uint64_t>(values[i]);
+                    mCodes[i] =
+                        zigzagEncode(static_cast<int64_t>(value - previous));
+                    previous = value;
+                }
+            } break;
+            case ColumnarEncoding::DICTIONARY: {
+                mDictionary.assign(values.begin(), values.end());
+                std::sort(mDictionary.begin(), mDictionary.end());
+                mDictionary.erase(
+                    std::unique(mDictionary.begin(), mDictionary.end()),
+                    mDictionary.end());
+                for (size_t i = 0; i < values.size(); ++i) {
+                    mCodes[i] = static_cast<uint64_t>(
+                        std::lower_bound(mDictionary.begin(),
+                                         mDictionary.end(), values[i]) -
+                        mDictionary.begin());
+                }
+                header.dictionary_size =
+                    static_cast<uint32_t>(mDictionary.size());
+                const auto size = mDictionary.size() * sizeof(int64_t);
+                mChunk.resize(mChunk.size() + size);
+                std::memcpy(mChunk.data() + mChunk.size() - size,
+                            mDictionary.data(), size);
+            } break;
+            case ColumnarEncoding::INVALID:
+                FATAL("Column " + columnarColumnToString(column) +
+                      " has no encoding.");
+        }
+
+        uint64_t largest = 0;
+        for (const auto code : mCodes) largest |= code;
+        header.bit_width = static_cast<uint8_t>(std::bit_width(largest));
+        const auto packed = columnarPackedSize(mCodes.size(), header.bit_width);
+        mChunk.resize(mChunk.size() + packed, 0);
+        bitPack(mCodes.data(), mCodes.size(), header.bit_width,
+                mChunk.data() + mChunk.size() - packed);
+    }
+
+    /// \brief Number of rows of a full chunk.
+    const size_t mChunk_rows;
+    /// \brief The output file.
+    std::ofstream mFile;
+    /// \brief Header of the file, written again on close().
+    ColumnarFileHeader mHeader;
+    /// \brief Bytes written to the file.
+    uint64_t mBytes_written = 0;
+
+    /// \brief Values of the buffered rows, one vector per column.
+    std::array<std::vector<int64_t>, COLUMNAR_COLUMN_COUNT> mValues;
+    /// \brief Codes of the column being encoded.
+    std::vector<uint64_t> mCodes;
+    /// \brief Dictionary of the column being encoded.
+    std::vector<int64_t> mDictionary;
+    /// \brief Encoded columns of the chunk being written.
+    std::vector<uint8_t> mChunk;
+};
+
+/// \brief Converts every segment of a journal of MEMarketUpdate into a
+/// columnar file.
+/// \param directory Directory holding the journal.
+/// \param prefix Journal name shared by all of its segments.
+/// \param path Path of the columnar file.
+/// \param rows Receives the number of rows converted.
+/// \param chunk_rows Number of rows of every chunk but the last.
+/// \return true on success, false if the file cannot be written.
+inline auto journalToColumnar(const std::string &directory,
+                              const std::string &prefix,
+                              const std::string &path, size_t &rows,
+                              size_t chunk_rows = COLUMNAR_CHUNK_ROWS)
+    -> bool {
+    ColumnarWriter writer(chunk_rows);
+    if (!writer.open(path)) return false;
+    JournalReader<MEMarketUpdate> reader;
+    for (size_t segment_index = 0;
+         reader.open(journalSegmentPath(directory, prefix, segment_index));
+         ++segment_index) {
+        for (auto record = reader.begin(); record != reader.end(); ++record) {
+            writer.append(record->timestamp_ns, record->update);
+        }
+    }
+    const auto closed = writer.close();
+    rows = writer.rowCount();
+    return closed;
+}
@@ -0,0 +1,123 @@
+/// \file benchmark_conflatingqueue.cpp
+/// \brief Publishing cost of the ConflatingQueue against the reader speed.
+/// \details Measures a publish without readers, with readers that never
+/// consume, and while a slow reader thread sweeps the dirty tickers, showing
+/// that the writer cost does not depend on the readers. The slow reader checks
+/// that it never sees a torn BestBidOffer or a value older than one it has
+/// already seen, and that it ends with the latest value of every ticker.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "conflating-queue/conflatingqueue.h"
+#include "market-orders/marketorder.h"
+#include "micro-benchmark/microbenchmark.h"
+
+/// \brief Number of publishes per repetition.
+constexpr size_t NUM_OPERATIONS = 1'000'000;
+
+/// \brief A BestBidOffer whose fields can be checked for torn reads.
+auto makeBestBidOffer(size_t sequence) noexcept -> BestBidOffer {
+    const auto price = static_cast<Price>(sequence);
+    return {price, price + 1, static_cast<Qty>(sequence),
+            static_cast<Qty>(sequence + 1)};
+}
+
+/// \brief Main function running the conflating queue benchmarks.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    MicroBenchmark benchmark(argc, argv);
+    const auto peer_cpu = benchmark.options().peer_cpu;
+
+    {
+        ConflatingQueue<BestBidOffer> queue;
+        benchmark.run("publish no reader", NUM_OPERATIONS, [&]() {
+            for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+                queue.publish(i % ME_MAX_TICKERS, makeBestBidOffer(i));
+            }
+        });
+    }
+
+    {
+        // Readers that never sweep must not slow the writer down.
+        ConflatingQueue<BestBidOffer> queue;
+        for (size_t reader = 0; reader < CONFLATING_QUEUE_MAX_READERS;
+             ++reader) {
+            queue.addReader();
+        }
+        benchmark.run("publish 4 stalled readers", NUM_OPERATIONS, [&]() {
+            for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+                queue.publish(i % ME_MAX_TICKERS, makeBestBidOffer(i));
+            }
+        });
+    }
+
+    {
+        ConflatingQueue<BestBidOffer> queue;
+        const auto reader = queue.addReader();
+        size_t sequence = 0;
+        benchmark.run("publish+sweep all tickers", ME_MAX_TICKERS, [&]() {
+            for (TickerId ticker_id = 0; ticker_id < ME_MAX_TICKERS;
+                 ++ticker_id) {
+                queue.publish(ticker_id, makeBestBidOffer(++sequence));
+            }
+            queue.consume(reader, [](TickerId, const BestBidOffer &bbo) {
+                doNotOptimize(bbo.mBid_price);
+            });
+        });
+    }
+
+    {
+        // A GUI-like reader sweeping every millisecond while the book
+        // publishes as fast as it can.
+        ConflatingQueue<BestBidOffer> queue;
+        const auto reader = queue.addReader();
+        std::array<Price, ME_MAX_TICKERS> latest;
+        latest.fill(-1);
+        std::atomic<bool> running = {true};
+        std::thread slow_reader([&]() {
+            pinThread(peer_cpu);
+            const auto check = [&](TickerId ticker_id,
+                                   const BestBidOffer &bbo) {
+                if (bbo.mAsk_price != bbo.mBid_price + 1 ||
+                    bbo.mBid_qty != static_cast<Qty>(bbo.mBid_price) ||
+                    bbo.mAsk_qty != bbo.mBid_qty + 1 ||
+                    bbo.mBid_price <= latest[ticker_id]) [[unlikely]] {
+                    FATAL("Torn or stale value for ticker " +
+                          std::to_string(ticker_id) + ": " + bbo.toString());
+                }
+                latest[ticker_id] = bbo.mBid_price;
+            };
+            while (running.load(std::memory_order_acquire)) {
+                queue.consume(reader, check);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            queue.consume(reader, check);
+        });
+
+        size_t sequence = 0;
+        benchmark.run("publish slow reader thread", NUM_OPERATIONS, [&]() {
+            for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+                ++sequence;
+                queue.publish(sequence % ME_MAX_TICKERS,
+                              makeBestBidOffer(sequence));
+            }
+        });
+
+        running.store(false, std::memory_order_release);
+        slow_reader.join();
+
+        for (size_t last = sequence - ME_MAX_TICKERS + 1; last <= sequence;
+             ++last) {
+            ASSERT(latest[last % ME_MAX_TICKERS] == static_cast<Price>(last),
+                   "Reader did not end with the latest value of ticker " +
+                       std::to_string(last % ME_MAX_TICKERS));
+        }
+        std::cout << "slow reader consumed " << queue.consumed(reader)
+                  << " of " << queue.published() << " published values"
+                  << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+/// \brief Default maximum number of readers of a ConflatingQueue.
+constexpr size_t CONFLATING_QUEUE_MAX_READERS = 4;
+
+/// \brief A lock-free, latest-value channel with one slot per TickerId, for
+/// publishing BestBidOffer or depth snapshots to consumers slower than the
+/// book.
+///
+/// The single writer overwrites the slot of a ticker and marks the ticker
+/// dirty for every reader. A reader sweeps its dirty tickers and receives only
+/// their latest values, every intermediate value is conflated away. Publishing
+/// costs one slot write and one atomic OR per reader, however far behind the
+/// readers are, and never blocks or fails.
+///
+/// Slots are sequence locks: the writer makes the sequence odd while it
+/// copies the value, and readers retry a copy that overlapped a write. Each
+/// slot has its own cache lines, so publishing one ticker does not disturb
+/// readers of another. A reader also remembers the sequence of the last value
+/// it was handed for every ticker, so a value published after the dirty bit
+/// was cleared but read in the same sweep is not handed out again by the next
+/// one.
+/// \tparam T The value, trivially copyable, e.g. BestBidOffer.
+/// \tparam MAX_READERS Maximum number of readers.
+template <typename T, size_t MAX_READERS = CONFLATING_QUEUE_MAX_READERS>
+class ConflatingQueue final {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "ConflatingQueue values are copied while being written.");
+
+   public:
+    /// \brief Constructs a ConflatingQueue with empty slots and no readers.
+    ConflatingQueue() = default;
+
+    /// \brief Registers a reader, before the writer starts publishing.
+    /// \return Id of the reader, passed to consume().
+    auto addReader() noexcept -> size_t {
+        ASSERT(mReader_count < MAX_READERS,
+               "ConflatingQueue supports at most " +
+                   std::to_string(MAX_READERS) + " readers");
+        return mReader_count++;
+    }
+
+    /// \brief Overwrites the latest value of a ticker and marks it dirty for
+    /// every reader. Must only be called by the writer.
+    /// \param ticker_id The ticker, below ME_MAX_TICKERS.
+    /// \param value The latest value.
+    auto publish(TickerId ticker_id, const T &value) noexcept -> void {
+        auto &slot = mSlots[ticker_id];
+        const auto sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&slot.value, &value, sizeof(T));
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+
+        const auto bit = uint64_t{1} << (ticker_id % 64);
+        for (size_t reader = 0; reader < mReader_count; ++reader) {
+            mReaders[reader].dirty[ticker_id / 64].fetch_or(
+                bit, std::memory_order_release);
+        }
+        ++mPublished;
+    }
+
+    /// \brief Hands the latest value of every ticker published since the
+    /// reader's previous sweep to a consumer, and clears them.
+    /// \param reader Id of the reader returned by addReader(). Every reader
+    /// must only be used by one thread.
+    /// \param consumer Called with the TickerId and a const reference to the
+    /// value of each dirty ticker, in TickerId order.
+    /// \return Number of tickers consumed.
+    template <typename Consumer>
+    auto consume(size_t reader, Consumer &&consumer) noexcept -> size_t {
+        auto &state = mReaders[reader];
+        size_t consumed = 0;
+        for (size_t word = 0; word < DIRTY_WORDS; ++word) {
+            if (!state.dirty[word].load(std::memory_order_relaxed)) continue;
+
+            auto dirty =
+                state.dirty[word].exchange(0, std::memory_order_acquire);
+            while (dirty) {
+                const auto ticker_id =
+                    static_cast<TickerId>(word * 64 + std::countr_zero(dirty));
+                dirty &= dirty - 1;
+
+                T value;
+                const auto sequence = readSequence(ticker_id, value);
+                if (sequence == state.delivered[ticker_id]) continue;
+                state.delivered[ticker_id] = sequence;
+                consumer(ticker_id, static_cast<const T &>(value));
+                ++consumed;
+            }
+        }
+        state.consumed += consumed;
+        return consumed;
+    }
+
+    /// \brief Reads the latest value of a ticker, dirty or not. Safe to call
+    /// from any thread.
+    /// \param ticker_id The ticker, below ME_MAX_TICKERS.
+    /// \param value Receives the latest value.
+    /// \return false if nothing was ever published for the ticker.
+    auto read(TickerId ticker_id, T &value) const noexcept -> bool {
+        return readSequence(ticker_id, value) != 0;
+    }
+
+    /// \brief Returns the number of values published by the writer. Must only
+    /// be called by the writer.
+    auto published() const noexcept { return mPublished; }
+
+    /// \brief Returns the number of values consumed by a reader. Together
+    /// with published() it gives the number of values conflated away. Must
+    /// only be called by the reader.
+    auto consumed(size_t reader) const noexcept {
+        return mReaders[reader].consumed;
+    }
+
+    // Deleted copy & move constructors and assignment-operators.
+    ConflatingQueue(const ConflatingQueue &) = delete;
+    ConflatingQueue(const ConflatingQueue &&) = delete;
+    ConflatingQueue &operator=(const ConflatingQueue &) = delete;
+    ConflatingQueue &operator=(const ConflatingQueue &&) = delete;
+
+   private:
+    /// \brief Reads the latest value of a ticker.
+    /// \return Sequence number of the value, 0 if nothing was ever published.
+    auto readSequence(TickerId ticker_id, T &value) const noexcept
+        -> uint64_t {
+        const auto &slot = mSlots[ticker_id];
+        uint64_t before, after;
+        do {
+            before = slot.sequence.load(std::memory_order_acquire);
+            std::memcpy(&value, &slot.value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = slot.sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        return before;
+    }
+
+    /// \brief Number of 64 bit words of a dirty set covering every ticker.
+    static constexpr size_t DIRTY_WORDS = (ME_MAX_TICKERS + 63) / 64;
+
+    /// \struct Slot
+    /// \brief Latest value of a ticker, guarded by its sequence number.
+    struct alignas(64) Slot {
+        /// Even when the value is stable, odd while it is being written.
+        std::atomic<uint64_t> sequence = {0};
+        /// The latest value.
+        T value = {};
+    };
+
+    /// \struct Reader
+    /// \brief Dirty tickers of a reader and its statistics.
+    struct alignas(64) Reader {
+        /// One bit per ticker published since the reader's previous sweep.
+        std::array<std::atomic<uint64_t>, DIRTY_WORDS> dirty = {};
+        /// Sequence of the last value handed out per ticker, written by the
+        /// reader only.
+        alignas(64) std::array<uint64_t, ME_MAX_TICKERS> delivered = {};
+        /// Number of values consumed, written by the reader only.
+        uint64_t consumed = 0;
+    };
+
+    /// \brief Latest value of every ticker.
+    std::array<Slot, ME_MAX_TICKERS> mSlots;
+    /// \brief State of every reader.
+    std::array<Reader, MAX_READERS> mReaders;
+    /// \brief Number of registered readers.
+    size_t mReader_count = 0;
+    /// \brief Number of values published, written by the writer only.
+    alignas(64) uint64_t mPublished = 0;
+};
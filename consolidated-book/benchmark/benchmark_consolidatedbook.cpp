@@ -0,0 +1,291 @@
+/// \file benchmark_consolidatedbook.cpp
+/// \brief Cost of keeping the best bid and offer and the depth of a ticker
+/// consolidated over several venues.
+/// \details Generates independent synthetic order flow for every venue of
+/// one ticker and merges the flows by time. A first pass checks the
+/// consolidated best bid and offer against a scan of the venue books after
+/// every update, and the consolidated depth against a merge of all their
+/// levels every few updates, then clears the venues one by one. The timed
+/// passes then replay the flow into the venue books alone, into the books
+/// followed by a scan of every venue top, and into a ConsolidatedBook, then
+/// time reads of its depth.
+///
+/// Usage: ConsolidatedBookBenchmark [--updates N] [--venues N]
+///     [--check-every N] [harness options]
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "consolidated-book/consolidatedbook.h"
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowgenerator.h"
+#include "utilities/latencyhistogram.h"
+#include "utilities/tscclock.h"
+
+/// Number of consolidated levels per side checked and timed.
+constexpr size_t DEPTH_LEVELS = 10;
+
+/// \struct BenchmarkOptions
+/// \brief Options of the benchmark, beside the shared harness options.
+struct BenchmarkOptions {
+    size_t updates = 2'000'000;
+    VenueId venues = 4;
+    size_t check_every = 1'000;
+};
+
+/// \struct VenueUpdate
+/// \brief A market update and the venue it comes from.
+struct VenueUpdate {
+    VenueId venue_id = VenueId_INVALID;
+    MEMarketUpdate update;
+};
+
+/// \brief Generates the flow of every venue, a different seed each, and
+/// merges them by time.
+auto mergedFlow(const BenchmarkOptions &options) -> std::vector<VenueUpdate> {
+    std::vector<std::unique_ptr<OrderFlowGenerator>> generators;
+    std::vector<OrderFlowEvent> heads;
+    for (VenueId venue_id = 0; venue_id < options.venues; ++venue_id) {
+        OrderFlowConfig config;
+        config.seed = 42 + venue_id;
+        config.num_tickers = 1;
+        generators.push_back(std::make_unique<OrderFlowGenerator>(config));
+        heads.push_back(*generators.back()->next());
+    }
+    std::vector<VenueUpdate> flow;
+    flow.reserve(options.updates);
+    while (flow.size() < options.updates) {
+        VenueId earliest = 0;
+        for (VenueId venue_id = 1; venue_id < options.venues; ++venue_id) {
+            if (heads[venue_id].timestamp_ns < heads[earliest].timestamp_ns) {
+                earliest = venue_id;
+            }
+        }
+        flow.push_back({earliest, heads[earliest].update});
+        heads[earliest] = *generators[earliest]->next();
+    }
+    return flow;
+}
+
+/// \brief Returns the consolidated best bid and offer found by scanning the
+/// top of every venue.
+auto scanBestBidOffer(const ConsolidatedBook &consolidated)
+    -> ConsolidatedBestBidOffer {
+    ConsolidatedBestBidOffer best;
+    for (VenueId venue_id = 0; venue_id < consolidated.numVenues();
+         ++venue_id) {
+        const auto &top = *consolidated.getBook(venue_id).getBestBidOffer();
+        const auto venue = 1u << venue_id;
+        if (top.mBid_price != Price_INVALID) {
+            if (best.mBid.mPrice == Price_INVALID ||
+                top.mBid_price > best.mBid.mPrice) {
+                best.mBid = {top.mBid_price, top.mBid_qty, venue};
+            } else if (top.mBid_price == best.mBid.mPrice) {
+                best.mBid.mQty += top.mBid_qty;
+                best.mBid.mVenues |= venue;
+            }
+        }
+        if (top.mAsk_price != Price_INVALID) {
+            if (best.mAsk.mPrice == Price_INVALID ||
+                top.mAsk_price < best.mAsk.mPrice) {
+                best.mAsk = {top.mAsk_price, top.mAsk_qty, venue};
+            } else if (top.mAsk_price == best.mAsk.mPrice) {
+                best.mAsk.mQty += top.mAsk_qty;
+                best.mAsk.mVenues |= venue;
+            }
+        }
+    }
+    return best;
+}
+
+/// \brief Exits unless the consolidated depth of both sides matches a merge
+/// of every level of every venue.
+auto checkDepth(const ConsolidatedBook &consolidated) -> void {
+    for (const auto side : {Side::BUY, Side::SELL}) {
+        std::map<Price, ConsolidatedLevel> merged;
+        for (VenueId venue_id = 0; venue_id < consolidated.numVenues();
+             ++venue_id) {
+            const auto best =
+                consolidated.getBook(venue_id).getBestLevel(side);
+            if (!best) continue;
+            auto level = best;
+            do {
+                auto &entry = merged[level->mPrice];
+                entry.mPrice = level->mPrice;
+                entry.mQty += level->mTotal_qty;
+                entry.mVenues |= 1u << venue_id;
+                level = level->mNext_entry;
+            } while (level != best);
+        }
+        std::vector<ConsolidatedLevel> expected;
+        for (const auto &[price, level] : merged) expected.push_back(level);
+        if (side == Side::BUY) std::reverse(expected.begin(), expected.end());
+        expected.resize(std::min(expected.size(), DEPTH_LEVELS));
+
+        std::array<ConsolidatedLevel, DEPTH_LEVELS> levels;
+        const auto count =
+            consolidated.depth(side, levels.data(), levels.size());
+        if (count != expected.size() ||
+            !std::equal(expected.begin(), expected.end(), levels.begin()))
+            [[unlikely]] {
+            FATAL("Consolidated " + sideToString(side) + " depth of " +
+                  std::to_string(count) + " levels, best " +
+                  (count ? levels[0].toString() : "none") + ", instead of " +
+                  std::to_string(expected.size()) + ", best " +
+                  (expected.empty() ? "none" : expected[0].toString()));
+        }
+    }
+}
+
+/// \brief Exits unless the consolidated best bid and offer matches a scan
+/// of the venue tops.
+auto checkBestBidOffer(const ConsolidatedBook &consolidated) -> void {
+    const auto expected = scanBestBidOffer(consolidated);
+    if (consolidated.getBestBidOffer() != expected) [[unlikely]] {
+        FATAL(consolidated.getBestBidOffer().toString() + " instead of " +
+              expected.toString());
+    }
+}
+
+/// \brief Replays the flow into a ConsolidatedBook, checking it against the
+/// venue books, then clears the venues one by one.
+auto checkConsolidation(const std::vector<VenueUpdate> &flow,
+                        const BenchmarkOptions &options) -> void {
+    auto consolidated =
+        std::make_unique<ConsolidatedBook>(0, options.venues);
+    for (size_t i = 0; i < flow.size(); ++i) {
+        consolidated->onMarketUpdate(flow[i].venue_id, flow[i].update);
+        checkBestBidOffer(*consolidated);
+        if (!(i % options.check_every)) checkDepth(*consolidated);
+    }
+    checkDepth(*consolidated);
+    MEMarketUpdate clear;
+    clear.type = MarketUpdateType::CLEAR;
+    for (VenueId venue_id = 0; venue_id < options.venues; ++venue_id) {
+        consolidated->onMarketUpdate(venue_id, clear);
+        checkBestBidOffer(*consolidated);
+        checkDepth(*consolidated);
+    }
+}
+
+/// \brief Main function running the consolidated book benchmark.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    BenchmarkOptions options;
+    setUpBenchmarkThread(parseBenchmarkOptions(
+        argc, argv,
+        {{"--updates", options.updates},
+         {"--venues", options.venues, 1, ME_MAX_VENUES},
+         {"--check-every", options.check_every, 1}}));
+    const auto flow = mergedFlow(options);
+    checkConsolidation(flow, options);
+
+    // The venue books alone.
+    uint64_t books_ticks = 0;
+    {
+        std::vector<std::unique_ptr<MarketOrderBook>> books;
+        for (VenueId venue_id = 0; venue_id < options.venues; ++venue_id) {
+            books.push_back(std::make_unique<MarketOrderBook>(0));
+        }
+        const auto start = TscClock::now();
+        for (const auto &[venue_id, update] : flow) {
+            books[venue_id]->onMarketUpdate(&update);
+        }
+        books_ticks = TscClock::now() - start;
+    }
+
+    // The venue books and a scan of every venue top after each update.
+    uint64_t scan_ticks = 0;
+    uint64_t scan_changes = 0;
+    {
+        std::vector<std::unique_ptr<MarketOrderBook>> books;
+        for (VenueId venue_id = 0; venue_id < options.venues; ++venue_id) {
+            books.push_back(std::make_unique<MarketOrderBook>(0));
+        }
+        ConsolidatedBestBidOffer last;
+        const auto start = TscClock::now();
+        for (const auto &[venue_id, update] : flow) {
+            books[venue_id]->onMarketUpdate(&update);
+            ConsolidatedBestBidOffer best;
+            for (VenueId venue = 0; venue < options.venues; ++venue) {
+                const auto &top = *books[venue]->getBestBidOffer();
+                if (top.mBid_price != Price_INVALID &&
+                    (best.mBid.mPrice == Price_INVALID ||
+                     top.mBid_price >= best.mBid.mPrice)) {
+                    best.mBid.mQty = top.mBid_price == best.mBid.mPrice
+                                         ? best.mBid.mQty + top.mBid_qty
+                                         : top.mBid_qty;
+                    best.mBid.mPrice = top.mBid_price;
+                }
+                if (top.mAsk_price != Price_INVALID &&
+                    (best.mAsk.mPrice == Price_INVALID ||
+                     top.mAsk_price <= best.mAsk.mPrice)) {
+                    best.mAsk.mQty = top.mAsk_price == best.mAsk.mPrice
+                                         ? best.mAsk.mQty + top.mAsk_qty
+                                         : top.mAsk_qty;
+                    best.mAsk.mPrice = top.mAsk_price;
+                }
+            }
+            scan_changes += best != last;
+            last = best;
+        }
+        scan_ticks = TscClock::now() - start;
+    }
+
+    // The ConsolidatedBook.
+    uint64_t consolidated_ticks = 0;
+    uint64_t consolidated_changes = 0;
+    {
+        auto consolidated =
+            std::make_unique<ConsolidatedBook>(0, options.venues);
+        const auto start = TscClock::now();
+        for (const auto &[venue_id, update] : flow) {
+            consolidated_changes +=
+                consolidated->onMarketUpdate(venue_id, update);
+        }
+        consolidated_ticks = TscClock::now() - start;
+    }
+
+    // The ConsolidatedBook again, with the depth read every few updates.
+    LatencyHistogram depth_reads;
+    {
+        auto consolidated =
+            std::make_unique<ConsolidatedBook>(0, options.venues);
+        std::array<ConsolidatedLevel, DEPTH_LEVELS> levels;
+        for (size_t i = 0; i < flow.size(); ++i) {
+            consolidated->onMarketUpdate(flow[i].venue_id, flow[i].update);
+            if (i % 64) continue;
+            const auto start = TscClock::now();
+            consolidated->depth(Side::BUY, levels.data(), levels.size());
+            consolidated->depth(Side::SELL, levels.data(), levels.size());
+            depth_reads.record(TscClock::now() - start);
+        }
+    }
+
+    const auto perUpdate = [&flow](uint64_t ticks) {
+        return TscClock::ticksToNanos(ticks) / flow.size();
+    };
+    std::cout << flow.size() << " updates over " << options.venues
+              << " venues, best bid and offer checked after every update and "
+              << DEPTH_LEVELS << " levels of depth every "
+              << options.check_every << std::endl;
+    std::cout << std::fixed << std::setprecision(1) << "books only: "
+              << perUpdate(books_ticks) << " ns per update" << std::endl;
+    std::cout << "books and scan of venue tops: " << perUpdate(scan_ticks)
+              << " ns per update, " << scan_changes
+              << " best bid and offer changes" << std::endl;
+    std::cout << "consolidated book: " << perUpdate(consolidated_ticks)
+              << " ns per update, " << consolidated_changes
+              << " best bid and offer changes" << std::endl;
+    std::cout << "depth of " << DEPTH_LEVELS << " levels on both sides: p50 "
+              << TscClock::toNanos(depth_reads.percentile(50.0)) << " ns, p99 "
+              << TscClock::toNanos(depth_reads.percentile(99.0)) << " ns"
+              << std::endl;
+
+    return 0;
+}
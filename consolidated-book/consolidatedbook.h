@@ -0,0 +1,298 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "market-orders/marketupdate.h"
+#include "order-book/orderbook.h"
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+static_assert(ME_MAX_VENUES <= 32, "Venue masks are 32 bits wide.");
+
+/// \struct ConsolidatedLevel
+/// \brief Quantity at a price summed over the venues.
+struct ConsolidatedLevel {
+    /// Price of the level.
+    Price mPrice = Price_INVALID;
+    /// Quantity at the price on all venues.
+    uint64_t mQty = 0;
+    /// Bit i is set if venue i has orders at the price.
+    uint32_t mVenues = 0;
+
+    /// \brief Compares the price, quantity and venues.
+    auto operator==(const ConsolidatedLevel &) const -> bool = default;
+
+    /// \brief Returns a string representation of the ConsolidatedLevel.
+    auto toString() const {
+        std::stringstream ss;
+        ss << mQty << "@" << priceToString(mPrice) << " venues:0x" << std::hex
+           << mVenues;
+        return ss.str();
+    }
+};
+
+/// \struct ConsolidatedBestBidOffer
+/// \brief The best bid and offer over all venues of a ticker, with the
+/// quantity of every venue at the best price.
+struct ConsolidatedBestBidOffer {
+    /// Best bid, price Price_INVALID if no venue has bids.
+    ConsolidatedLevel mBid;
+    /// Best offer, price Price_INVALID if no venue has offers.
+    ConsolidatedLevel mAsk;
+
+    /// \brief Compares both sides.
+    auto operator==(const ConsolidatedBestBidOffer &) const
+        -> bool = default;
+
+    /// \brief Returns a string representation of the
+    /// ConsolidatedBestBidOffer.
+    auto toString() const {
+        return "Consolidated Best Bid Offer {" + mBid.toString() + " X " +
+               mAsk.toString() + "}";
+    }
+};
+
+/// \brief The books of one ticker on every venue it trades on, with the
+/// best bid and offer and the depth consolidated over the venues.
+///
+/// Each venue has its own MarketOrderBook. The consolidated best bid and
+/// offer of each side is the root of a tournament tree whose leaves are the
+/// tops of the venues: a node holds the better of its children, or their
+/// summed quantity when they are at the same price. An update re-evaluates
+/// only the path from the leaf of its venue to the root, log2(ME_MAX_VENUES)
+/// nodes, and only when the top of that venue changed.
+///
+/// The consolidated depth is a ladder per side, indexed by price like the
+/// levels of a book, holding the quantity of all venues at every price. An
+/// update moves the quantity of one slot by the change of its level, so the
+/// ladder costs a constant per update and depth() reads the best levels
+/// outward from the consolidated best price. Like the book, the ladder
+/// expects the prices of a side on all venues to span fewer than
+/// ME_MAX_PRICE_LEVELS ticks.
+class ConsolidatedBook final {
+   public:
+    /// \brief Constructs a ConsolidatedBook with a book per venue.
+    /// \param ticker_id The ticker of the books.
+    /// \param num_venues Number of venues, VenueIds range from 0 to
+    /// num_venues - 1.
+    ConsolidatedBook(TickerId ticker_id, VenueId num_venues)
+        : mTicker_id(ticker_id), mNum_venues(num_venues) {
+        ASSERT(num_venues > 0 && num_venues <= ME_MAX_VENUES,
+               "Number of venues must be between 1 and ME_MAX_VENUES.");
+        for (VenueId venue_id = 0; venue_id < num_venues; ++venue_id) {
+            mBooks[venue_id] = std::make_unique<MarketOrderBook>(ticker_id);
+        }
+        for (auto &side : mLadders) side.fill({});
+        for (auto &tree : mTrees) tree.fill({});
+    }
+
+    /// \brief Applies a market update of a venue to its book and to the
+    /// consolidated views.
+    /// \param venue_id The venue the update comes from.
+    /// \param update The market update.
+    /// \return true if the consolidated best bid or offer changed.
+    auto onMarketUpdate(VenueId venue_id, const MEMarketUpdate &update) noexcept
+        -> bool {
+        if (venue_id >= mNum_venues) [[unlikely]] {
+            FATAL("Update for unknown venue " + venueIdToString(venue_id) +
+                  " " + update.toString());
+        }
+        auto &book = *mBooks[venue_id];
+
+        // The level the update changes, MODIFY and CANCEL find it through
+        // their order.
+        auto side = update.side;
+        auto price = update.price;
+        switch (update.type) {
+            case MarketUpdateType::ADD:
+                break;
+            case MarketUpdateType::MODIFY:
+            case MarketUpdateType::CANCEL: {
+                const auto order = book.getOrder(update.order_id);
+                if (!order) [[unlikely]] return false;
+                side = order->mSide;
+                price = order->mPrice;
+            } break;
+            case MarketUpdateType::CLEAR:
+                return clearVenue(venue_id);
+            case MarketUpdateType::TRADE:
+            case MarketUpdateType::INVALID:
+            case MarketUpdateType::SNAPSHOT_START:
+            case MarketUpdateType::SNAPSHOT_END:
+                return false;
+        }
+
+        const auto before = book.getLevel(side, price);
+        const Qty qty_before = before ? before->mTotal_qty : 0;
+        const auto top_before = *book.getBestBidOffer();
+        book.onMarketUpdate(&update);
+        const auto after = book.getLevel(side, price);
+        const Qty qty_after = after ? after->mTotal_qty : 0;
+        addToLadder(venue_id, side, price, qty_before, qty_after);
+
+        const auto &top = *book.getBestBidOffer();
+        if (top == top_before) return false;
+        return replay(venue_id, top);
+    }
+
+    /// \brief Returns the consolidated best bid and offer.
+    auto getBestBidOffer() const noexcept
+        -> const ConsolidatedBestBidOffer & {
+        return mBest_bid_offer;
+    }
+
+    /// \brief Writes the best consolidated levels of a side, best first.
+    /// \param side Side of the levels.
+    /// \param levels Array receiving the levels.
+    /// \param max_levels Size of the array.
+    /// \return Number of levels written.
+    auto depth(Side side, ConsolidatedLevel *levels,
+               size_t max_levels) const noexcept -> size_t {
+        const auto &best = side == Side::BUY ? mBest_bid_offer.mBid
+                                             : mBest_bid_offer.mAsk;
+        if (best.mPrice == Price_INVALID) return 0;
+        const auto &ladder = mLadders[ladderIndex(side)];
+        // Away from the best price, down for bids and up for offers.
+        const Price away = side == Side::BUY ? -1 : 1;
+        size_t written = 0;
+        auto price = best.mPrice;
+        for (size_t i = 0; i < ME_MAX_PRICE_LEVELS && written < max_levels;
+             ++i, price += away) {
+            const auto &level = ladder[priceToIndex(price)];
+            if (level.mQty && level.mPrice == price) levels[written++] = level;
+        }
+        return written;
+    }
+
+    /// \brief Returns the book of a venue.
+    auto getBook(VenueId venue_id) const noexcept -> const MarketOrderBook & {
+        return *mBooks[venue_id];
+    }
+
+    /// \brief Returns the number of venues.
+    auto numVenues() const noexcept { return mNum_venues; }
+
+    /// \brief Returns the ticker id of the books.
+    auto tickerId() const noexcept { return mTicker_id; }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    ConsolidatedBook() = delete;
+    ConsolidatedBook(const ConsolidatedBook &) = delete;
+    ConsolidatedBook(const ConsolidatedBook &&) = delete;
+    ConsolidatedBook &operator=(const ConsolidatedBook &) = delete;
+    ConsolidatedBook &operator=(const ConsolidatedBook &&) = delete;
+
+   private:
+    /// \brief A tournament tree of one side, the root at index 1 and the
+    /// leaf of venue i at index ME_MAX_VENUES + i.
+    typedef std::array<ConsolidatedLevel, 2 * ME_MAX_VENUES> TournamentTree;
+
+    static constexpr auto ladderIndex(Side side) noexcept -> size_t {
+        return side == Side::BUY ? 0 : 1;
+    }
+
+    static constexpr auto priceToIndex(Price price) noexcept -> size_t {
+        return price % ME_MAX_PRICE_LEVELS;
+    }
+
+    /// \brief Returns the better of two nodes of a side, summing them when
+    /// they are at the same price.
+    static auto play(Side side, const ConsolidatedLevel &a,
+                     const ConsolidatedLevel &b) noexcept
+        -> ConsolidatedLevel {
+        if (a.mPrice == b.mPrice) {
+            return {a.mPrice, a.mQty + b.mQty, a.mVenues | b.mVenues};
+        }
+        if (a.mPrice == Price_INVALID) return b;
+        if (b.mPrice == Price_INVALID) return a;
+        const auto a_wins =
+            side == Side::BUY ? a.mPrice > b.mPrice : a.mPrice < b.mPrice;
+        return a_wins ? a : b;
+    }
+
+    /// \brief Sets the leaves of a venue to its new top and replays the
+    /// matches up to the roots.
+    /// \return true if the consolidated best bid or offer changed.
+    auto replay(VenueId venue_id, const BestBidOffer &top) noexcept -> bool {
+        const auto before = mBest_bid_offer;
+        const auto venue = 1u << venue_id;
+        setLeaf(Side::BUY, venue_id,
+                {top.mBid_price,
+                 top.mBid_price == Price_INVALID ? 0 : top.mBid_qty, venue});
+        setLeaf(Side::SELL, venue_id,
+                {top.mAsk_price,
+                 top.mAsk_price == Price_INVALID ? 0 : top.mAsk_qty, venue});
+        mBest_bid_offer.mBid = mTrees[ladderIndex(Side::BUY)][1];
+        mBest_bid_offer.mAsk = mTrees[ladderIndex(Side::SELL)][1];
+        return mBest_bid_offer != before;
+    }
+
+    /// \brief Sets a leaf of a tree and replays its path to the root.
+    auto setLeaf(Side side, VenueId venue_id,
+                 const ConsolidatedLevel &leaf) noexcept -> void {
+        auto &tree = mTrees[ladderIndex(side)];
+        auto node = ME_MAX_VENUES + venue_id;
+        // An empty side has no venues.
+        tree[node] = leaf.mPrice == Price_INVALID ? ConsolidatedLevel{}
+                                                  : leaf;
+        for (node /= 2; node; node /= 2) {
+            tree[node] = play(side, tree[2 * node], tree[2 * node + 1]);
+        }
+    }
+
+    /// \brief Moves the quantity of a venue at a price on the ladder.
+    auto addToLadder(VenueId venue_id, Side side, Price price, Qty before,
+                     Qty after) noexcept -> void {
+        if (before == after) return;
+        auto &level = mLadders[ladderIndex(side)][priceToIndex(price)];
+        level.mPrice = price;
+        level.mQty = level.mQty + after - before;
+        const auto venue = 1u << venue_id;
+        level.mVenues = after ? level.mVenues | venue : level.mVenues & ~venue;
+    }
+
+    /// \brief Clears the book of a venue and removes it from the
+    /// consolidated views.
+    /// \return true if the consolidated best bid or offer changed.
+    auto clearVenue(VenueId venue_id) noexcept -> bool {
+        auto &book = *mBooks[venue_id];
+        for (const auto side : {Side::BUY, Side::SELL}) {
+            const auto best = book.getBestLevel(side);
+            if (!best) continue;
+            auto level = best;
+            do {
+                addToLadder(venue_id, side, level->mPrice, level->mTotal_qty,
+                            0);
+                level = level->mNext_entry;
+            } while (level != best);
+        }
+        MEMarketUpdate clear;
+        clear.type = MarketUpdateType::CLEAR;
+        clear.ticker_id = mTicker_id;
+        book.onMarketUpdate(&clear);
+        return replay(venue_id, *book.getBestBidOffer());
+    }
+
+    /// \brief The ticker of the books.
+    const TickerId mTicker_id;
+    /// \brief Number of venues.
+    const VenueId mNum_venues;
+    /// \brief The book of every venue.
+    std::array<std::unique_ptr<MarketOrderBook>, ME_MAX_VENUES> mBooks;
+
+    /// \brief Tournament trees of the venue tops, bids then offers.
+    std::array<TournamentTree, 2> mTrees;
+    /// \brief Quantity of all venues per price, bids then offers.
+    std::array<std::array<ConsolidatedLevel, ME_MAX_PRICE_LEVELS>, 2>
+        mLadders;
+    /// \brief The roots of the trees.
+    ConsolidatedBestBidOffer mBest_bid_offer;
+};
+
+/// \typedef ConsolidatedBookHashMap
+/// \brief Hash map from TickerId to ConsolidatedBook.
+typedef std::array<ConsolidatedBook *, ME_MAX_TICKERS> ConsolidatedBookHashMap;
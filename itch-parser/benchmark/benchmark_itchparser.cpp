@@ -0,0 +1,89 @@
+/// \file benchmark_itchparser.cpp
+/// \brief Parsing throughput of the ITCH parser over a synthetic capture.
+/// \details Generates an ITCH 5.0 file, maps it and parses it into
+/// MEMarketUpdates several times, reporting the best run in GB/s and million
+/// messages per second.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+#include "itch-parser/itchgenerator.h"
+#include "itch-parser/itchparser.h"
+
+/// \brief Number of order messages in the generated capture.
+constexpr size_t NUM_MESSAGES = 4'000'000;
+
+/// \brief Number of timed repetitions, the fastest one is reported.
+constexpr size_t NUM_REPETITIONS = 5;
+
+/// \struct ChecksumSink
+/// \brief Parser sink folding every update into a checksum so that the
+/// parsing work cannot be optimised away.
+struct ChecksumSink {
+    uint64_t *checksum = nullptr;
+
+    auto operator()(const MEMarketUpdate &update) const noexcept {
+        *checksum += update.order_id + update.price + update.qty +
+                     update.ticker_id + static_cast<uint64_t>(update.type);
+    }
+};
+
+/// \brief Main function running the parser benchmark.
+/// \return Exit status code (0 for success)
+int main(int, char **) {
+    const auto path =
+        (std::filesystem::temp_directory_path() / "benchmark_itchparser.itch")
+            .string();
+
+    ItchGenerator generator(42, {"AAPL", "MSFT", "AMZN", "NVDA"});
+    ASSERT(generator.writeFile(path, NUM_MESSAGES),
+           "Unable to write the synthetic ITCH file:" + path);
+    const auto file_size = std::filesystem::file_size(path);
+
+    // Map the file once up front so that the first repetition is not charged
+    // for reading it from disk.
+    MappedFile file;
+    ASSERT(file.openReadOnly(path, true), "Unable to map " + path);
+
+    auto best_seconds = std::numeric_limits<double>::max();
+    uint64_t checksum = 0;
+    size_t messages = 0;
+    size_t updates = 0;
+    for (size_t rep = 0; rep < NUM_REPETITIONS; ++rep) {
+        uint64_t run_checksum = 0;
+        ItchParser<ChecksumSink> parser(ChecksumSink{&run_checksum});
+        parser.mapSymbol("AAPL", 0);
+        parser.mapSymbol("MSFT", 1);
+        parser.mapSymbol("AMZN", 2);
+        parser.mapSymbol("NVDA", 3);
+
+        const auto start = std::chrono::steady_clock::now();
+        ASSERT(parser.parseFile(path), "Unable to parse " + path);
+        const auto end = std::chrono::steady_clock::now();
+        best_seconds = std::min(
+            best_seconds, std::chrono::duration<double>(end - start).count());
+
+        ASSERT(parser.unknownOrders() == 0 && parser.messagesMalformed() == 0,
+               "Synthetic capture should parse without unknown orders.");
+        ASSERT(rep == 0 || run_checksum == checksum,
+               "Parser output differs between repetitions.");
+        checksum = run_checksum;
+        messages = parser.messagesParsed();
+        updates = parser.updatesProduced();
+    }
+
+    std::cout << std::fixed << std::setprecision(2) << "parsed " << messages
+              << " messages (" << file_size / 1e6 << " MB) into " << updates
+              << " updates, best of " << NUM_REPETITIONS << std::endl;
+    std::cout << "throughput " << file_size / best_seconds / 1e9 << " GB/s "
+              << messages / best_seconds / 1e6 << " Mmsg/s "
+              << best_seconds * 1e9 / messages << " ns/msg" << std::endl;
+
+    file.close();
+    std::filesystem::remove(path);
+
+    return 0;
+}
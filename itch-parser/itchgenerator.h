@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "itch-parser/itchparser.h"
+#include "utilities/byteorder.h"
+#include "utilities/macros.h"
+
+/// \brief Generates a synthetic, internally consistent ITCH 5.0 message
+/// stream for tests and benchmarks.
+///
+/// The stream starts with one Stock Directory message per symbol, followed by
+/// a random mix of Add Order, Order Executed, Order Cancel, Order Delete and
+/// Order Replace messages. Every message refers to an order that is live at
+/// that point, so a parser that starts from the beginning of the stream never
+/// meets an unknown order. The same seed always produces the same stream.
+class ItchGenerator final {
+   public:
+    /// \brief Constructs an ItchGenerator.
+    /// \param seed Seed of the random number generator.
+    /// \param symbols Stock symbols, their index is used as the locate code.
+    /// \param target_live_orders Number of resting orders the stream hovers
+    /// around.
+    ItchGenerator(uint64_t seed, std::vector<std::string> symbols,
+                  size_t target_live_orders = 10'000)
+        : mRng(seed),
+          mSymbols(std::move(symbols)),
+          mTarget_live_orders(target_live_orders) {
+        ASSERT(!mSymbols.empty(), "ItchGenerator needs at least one symbol.");
+        mLive_orders.reserve(target_live_orders * 2);
+    }
+
+    /// \brief Generates a stream of length prefixed messages.
+    /// \param num_messages Number of order messages after the directory.
+    /// \return The generated stream.
+    auto generate(size_t num_messages) -> std::vector<char> {
+        std::vector<char> stream;
+        stream.reserve(num_messages * 40);
+
+        for (size_t locate = 0; locate < mSymbols.size(); ++locate) {
+            stockDirectory(stream, static_cast<uint16_t>(locate));
+        }
+
+        std::uniform_int_distribution<int> roll(0, 99);
+        for (size_t i = 0; i < num_messages; ++i) {
+            // Keep the book around its target size by adding more often when
+            // it is small and removing more often when it is large.
+            const auto add_threshold =
+                mLive_orders.size() < mTarget_live_orders ? 60 : 30;
+            const auto action = roll(mRng);
+
+            if (mLive_orders.empty() || action < add_threshold) {
+                addOrder(stream);
+            } else if (action < add_threshold + 8) {
+                orderExecuted(stream, false);
+            } else if (action < add_threshold + 10) {
+                orderExecuted(stream, true);
+            } else if (action < add_threshold + 20) {
+                orderCancel(stream);
+            } else if (action < add_threshold + 32) {
+                orderReplace(stream);
+            } else {
+                orderDelete(stream);
+            }
+        }
+
+        return stream;
+    }
+
+    /// \brief Generates a stream and writes it to a file.
+    /// \param path Path of the file to write.
+    /// \param num_messages Number of order messages after the directory.
+    /// \return true if the file was written.
+    auto writeFile(const std::string &path, size_t num_messages) -> bool {
+        const auto stream = generate(num_messages);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(stream.data(), static_cast<std::streamsize>(stream.size()));
+        return static_cast<bool>(file);
+    }
+
+   private:
+    /// \struct LiveOrder
+    /// \brief An order resting in the generated book.
+    struct LiveOrder {
+        /// ITCH order reference number.
+        uint64_t reference = 0;
+        /// Stock locate code.
+        uint16_t locate = 0;
+        /// 'B' or 'S'.
+        char side = 'B';
+        /// Price with four implied decimals.
+        uint32_t price = 0;
+        /// Shares still resting.
+        uint32_t shares = 0;
+    };
+
+    /// \brief Appends the length prefix and the common message header.
+    /// \return Pointer to the start of the message body.
+    auto beginMessage(std::vector<char> &stream, char type, size_t length,
+                      uint16_t locate) -> char * {
+        const auto offset = stream.size();
+        stream.resize(offset + ITCH_LENGTH_PREFIX_SIZE + length);
+        auto prefix = stream.data() + offset;
+        storeBigEndian<uint16_t>(prefix, static_cast<uint16_t>(length));
+
+        auto message = prefix + ITCH_LENGTH_PREFIX_SIZE;
+        message[ItchMessage::TYPE] = type;
+        storeBigEndian<uint16_t>(message + ItchMessage::STOCK_LOCATE, locate);
+        storeBigEndian<uint16_t>(message + ItchMessage::TRACKING_NUMBER, 0);
+        // 48 bit nanoseconds since midnight
+        mTimestamp_ns += 1 + mRng() % 2'000;
+        storeBigEndian<uint16_t>(message + ItchMessage::TIMESTAMP,
+                                 static_cast<uint16_t>(mTimestamp_ns >> 32));
+        storeBigEndian<uint32_t>(message + ItchMessage::TIMESTAMP + 2,
+                                 static_cast<uint32_t>(mTimestamp_ns));
+        return message;
+    }
+
+    /// \brief Picks a random live order.
+    auto pickOrder() -> size_t { return mRng() % mLive_orders.size(); }
+
+    /// \brief Removes a live order, swapping the last one into its place.
+    auto dropOrder(size_t index) {
+        mLive_orders[index] = mLive_orders.back();
+        mLive_orders.pop_back();
+    }
+
+    /// \brief Draws a price around 100.0000, on a one cent grid.
+    auto drawPrice(char side) -> uint32_t {
+        const auto distance = static_cast<uint32_t>(mRng() % 50);
+        return side == 'B' ? 1'000'000 - 100 * (1 + distance)
+                           : 1'000'000 + 100 * (1 + distance);
+    }
+
+    /// \brief Appends a Stock Directory message for a locate code.
+    auto stockDirectory(std::vector<char> &stream, uint16_t locate) -> void {
+        auto message =
+            beginMessage(stream, ItchMessage::STOCK_DIRECTORY,
+                         ItchMessage::STOCK_DIRECTORY_LENGTH, locate);
+        std::memset(message + ItchMessage::STOCK_DIRECTORY_STOCK, ' ',
+                    ItchMessage::STOCK_DIRECTORY_LENGTH -
+                        ItchMessage::STOCK_DIRECTORY_STOCK);
+        std::memcpy(message + ItchMessage::STOCK_DIRECTORY_STOCK,
+                    mSymbols[locate].data(),
+                    std::min(mSymbols[locate].size(), ITCH_SYMBOL_SIZE));
+    }
+
+    /// \brief Appends an Add Order, with or without MPID attribution.
+    auto addOrder(std::vector<char> &stream) -> void {
+        LiveOrder order;
+        order.reference = ++mNext_reference;
+        order.locate = static_cast<uint16_t>(mRng() % mSymbols.size());
+        order.side = (mRng() & 1) ? 'B' : 'S';
+        order.price = drawPrice(order.side);
+        order.shares = 100 * (1 + static_cast<uint32_t>(mRng() % 10));
+
+        const auto with_mpid = mRng() % 5 == 0;
+        auto message = beginMessage(
+            stream,
+            with_mpid ? ItchMessage::ADD_ORDER_MPID : ItchMessage::ADD_ORDER,
+            with_mpid ? ItchMessage::ADD_ORDER_MPID_LENGTH
+                      : ItchMessage::ADD_ORDER_LENGTH,
+            order.locate);
+        storeBigEndian<uint64_t>(message + ItchMessage::ORDER_REFERENCE,
+                                 order.reference);
+        message[ItchMessage::ADD_ORDER_SIDE] = order.side;
+        storeBigEndian<uint32_t>(message + ItchMessage::ADD_ORDER_SHARES,
+                                 order.shares);
+        std::memset(message + ItchMessage::ADD_ORDER_STOCK, ' ',
+                    ITCH_SYMBOL_SIZE);
+        std::memcpy(message + ItchMessage::ADD_ORDER_STOCK,
+                    mSymbols[order.locate].data(),
+                    std::min(mSymbols[order.locate].size(), ITCH_SYMBOL_SIZE));
+        storeBigEndian<uint32_t>(message + ItchMessage::ADD_ORDER_PRICE,
+                                 order.price);
+        if (with_mpid) {
+            std::memcpy(message + ItchMessage::ADD_ORDER_ATTRIBUTION, "SOLO",
+                        4);
+        }
+
+        mLive_orders.push_back(order);
+    }
+
+    /// \brief Appends a partial or full execution of a live order.
+    auto orderExecuted(std::vector<char> &stream, bool with_price) -> void {
+        const auto index = pickOrder();
+        auto &order = mLive_orders[index];
+        const auto shares = std::min<uint32_t>(order.shares, 100);
+
+        auto message = beginMessage(
+            stream,
+            with_price ? ItchMessage::ORDER_EXECUTED_WITH_PRICE
+                       : ItchMessage::ORDER_EXECUTED,
+            with_price ? ItchMessage::ORDER_EXECUTED_WITH_PRICE_LENGTH
+                       : ItchMessage::ORDER_EXECUTED_LENGTH,
+            order.locate);
+        storeBigEndian<uint64_t>(message + ItchMessage::ORDER_REFERENCE,
+                                 order.reference);
+        storeBigEndian<uint32_t>(message + ItchMessage::ORDER_EXECUTED_SHARES,
+                                 shares);
+        storeBigEndian<uint64_t>(
+            message + ItchMessage::ORDER_EXECUTED_MATCH_NUMBER, ++mNext_match);
+        if (with_price) {
+            message[ItchMessage::ORDER_EXECUTED_WITH_PRICE_PRINTABLE] = 'Y';
+            storeBigEndian<uint32_t>(
+                message + ItchMessage::ORDER_EXECUTED_WITH_PRICE_PRICE,
+                order.price);
+        }
+
+        order.shares -= shares;
+        if (!order.shares) dropOrder(index);
+    }
+
+    /// \brief Appends a partial cancel of a live order.
+    auto orderCancel(std::vector<char> &stream) -> void {
+        const auto index = pickOrder();
+        auto &order = mLive_orders[index];
+        const auto shares = std::min<uint32_t>(order.shares, 100);
+
+        auto message = beginMessage(stream, ItchMessage::ORDER_CANCEL,
+                                    ItchMessage::ORDER_CANCEL_LENGTH,
+                                    order.locate);
+        storeBigEndian<uint64_t>(message + ItchMessage::ORDER_REFERENCE,
+                                 order.reference);
+        storeBigEndian<uint32_t>(message + ItchMessage::ORDER_CANCEL_SHARES,
+                                 shares);
+
+        order.shares -= shares;
+        if (!order.shares) dropOrder(index);
+    }
+
+    /// \brief Appends the deletion of a live order.
+    auto orderDelete(std::vector<char> &stream) -> void {
+        const auto index = pickOrder();
+        const auto &order = mLive_orders[index];
+
+        auto message = beginMessage(stream, ItchMessage::ORDER_DELETE,
+                                    ItchMessage::ORDER_DELETE_LENGTH,
+                                    order.locate);
+        storeBigEndian<uint64_t>(message + ItchMessage::ORDER_REFERENCE,
+                                 order.reference);
+
+        dropOrder(index);
+    }
+
+    /// \brief Appends the replacement of a live order at a new price.
+    auto orderReplace(std::vector<char> &stream) -> void {
+        auto &order = mLive_orders[pickOrder()];
+
+        auto message = beginMessage(stream, ItchMessage::ORDER_REPLACE,
+                                    ItchMessage::ORDER_REPLACE_LENGTH,
+                                    order.locate);
+        storeBigEndian<uint64_t>(message + ItchMessage::ORDER_REFERENCE,
+                                 order.reference);
+        order.reference = ++mNext_reference;
+        order.price = drawPrice(order.side);
+        order.shares = 100 * (1 + static_cast<uint32_t>(mRng() % 10));
+        storeBigEndian<uint64_t>(
+            message + ItchMessage::ORDER_REPLACE_NEW_REFERENCE,
+            order.reference);
+        storeBigEndian<uint32_t>(message + ItchMessage::ORDER_REPLACE_SHARES,
+                                 order.shares);
+        storeBigEndian<uint32_t>(message + ItchMessage::ORDER_REPLACE_PRICE,
+                                 order.price);
+    }
+
+    /// \brief Random number generator driving the stream.
+    std::mt19937_64 mRng;
+    /// \brief Stock symbols indexed by locate code.
+    const std::vector<std::string> mSymbols;
+    /// \brief Number of resting orders the stream hovers around.
+    const size_t mTarget_live_orders;
+    /// \brief Orders currently resting in the generated book.
+    std::vector<LiveOrder> mLive_orders;
+    /// \brief Last order reference number handed out.
+    uint64_t mNext_reference = 0;
+    /// \brief Last match number handed out.
+    uint64_t mNext_match = 0;
+    /// \brief Timestamp of the last message in nanoseconds since midnight.
+    uint64_t mTimestamp_ns = 34'200'000'000'000;  // 09:30
+};
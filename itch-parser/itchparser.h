@@ -0,0 +1,592 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "market-orders/marketupdate.h"
+#include "utilities/byteorder.h"
+#include "utilities/macros.h"
+#include "utilities/mappedfile.h"
+#include "utilities/types.h"
+
+/// \brief Size of the big-endian length prefix in front of every message of
+/// an ITCH 5.0 binary file.
+constexpr size_t ITCH_LENGTH_PREFIX_SIZE = 2;
+
+/// \brief Number of characters in an ITCH stock symbol, padded with spaces.
+constexpr size_t ITCH_SYMBOL_SIZE = 8;
+
+/// \brief Number of stock locate codes in the ITCH protocol.
+constexpr size_t ITCH_MAX_LOCATES = 65536;
+
+/// \struct ItchMessage
+/// \brief Message types, lengths and field offsets of the ITCH 5.0 order
+/// messages the parser handles. All fields are big-endian.
+struct ItchMessage {
+    /// Offsets shared by all messages.
+    static constexpr size_t TYPE = 0;
+    static constexpr size_t STOCK_LOCATE = 1;
+    static constexpr size_t TRACKING_NUMBER = 3;
+    static constexpr size_t TIMESTAMP = 5;
+    static constexpr size_t ORDER_REFERENCE = 11;
+
+    /// 'R' Stock Directory.
+    static constexpr char STOCK_DIRECTORY = 'R';
+    static constexpr size_t STOCK_DIRECTORY_LENGTH = 39;
+    static constexpr size_t STOCK_DIRECTORY_STOCK = 11;
+
+    /// 'A' Add Order and 'F' Add Order with MPID attribution.
+    static constexpr char ADD_ORDER = 'A';
+    static constexpr char ADD_ORDER_MPID = 'F';
+    static constexpr size_t ADD_ORDER_LENGTH = 36;
+    static constexpr size_t ADD_ORDER_MPID_LENGTH = 40;
+    static constexpr size_t ADD_ORDER_SIDE = 19;
+    static constexpr size_t ADD_ORDER_SHARES = 20;
+    static constexpr size_t ADD_ORDER_STOCK = 24;
+    static constexpr size_t ADD_ORDER_PRICE = 32;
+    static constexpr size_t ADD_ORDER_ATTRIBUTION = 36;
+
+    /// 'E' Order Executed.
+    static constexpr char ORDER_EXECUTED = 'E';
+    static constexpr size_t ORDER_EXECUTED_LENGTH = 31;
+    static constexpr size_t ORDER_EXECUTED_SHARES = 19;
+    static constexpr size_t ORDER_EXECUTED_MATCH_NUMBER = 23;
+
+    /// 'C' Order Executed With Price.
+    static constexpr char ORDER_EXECUTED_WITH_PRICE = 'C';
+    static constexpr size_t ORDER_EXECUTED_WITH_PRICE_LENGTH = 36;
+    static constexpr size_t ORDER_EXECUTED_WITH_PRICE_PRINTABLE = 31;
+    static constexpr size_t ORDER_EXECUTED_WITH_PRICE_PRICE = 32;
+
+    /// 'X' Order Cancel.
+    static constexpr char ORDER_CANCEL = 'X';
+    static constexpr size_t ORDER_CANCEL_LENGTH = 23;
+    static constexpr size_t ORDER_CANCEL_SHARES = 19;
+
+    /// 'D' Order Delete.
+    static constexpr char ORDER_DELETE = 'D';
+    static constexpr size_t ORDER_DELETE_LENGTH = 19;
+
+    /// 'U' Order Replace.
+    static constexpr char ORDER_REPLACE = 'U';
+    static constexpr size_t ORDER_REPLACE_LENGTH = 35;
+    static constexpr size_t ORDER_REPLACE_NEW_REFERENCE = 19;
+    static constexpr size_t ORDER_REPLACE_SHARES = 27;
+    static constexpr size_t ORDER_REPLACE_PRICE = 31;
+};
+
+/// \brief Tracks the resting state of ITCH orders and maps their 64 bit
+/// order reference numbers onto compact OrderIds.
+///
+/// ITCH reference numbers grow throughout the day and cannot index the
+/// OrderArray of a MarketOrderBook directly. Every live order is given a slot
+/// in a fixed size table and the slot index is used as its OrderId, slots are
+/// recycled once the order leaves the book. Lookups go through an open
+/// addressing hash table with linear probing. All storage is allocated up
+/// front, nothing is allocated while parsing.
+class ItchOrderTable final {
+   public:
+    /// \struct Order
+    /// \brief Resting state of a single order.
+    struct Order {
+        /// ITCH order reference number.
+        uint64_t reference = 0;
+        /// Ticker the order belongs to.
+        TickerId ticker_id = TickerId_INVALID;
+        /// Side of the order.
+        Side side = Side::INVALID;
+        /// Limit price of the order.
+        Price price = Price_INVALID;
+        /// Shares still resting in the book.
+        Qty qty = 0;
+    };
+
+    /// \brief Constructs an order table.
+    /// \param max_orders Maximum number of simultaneously live orders, at
+    /// most ME_MAX_ORDER_IDS so that the OrderIds fit every order book.
+    explicit ItchOrderTable(size_t max_orders)
+        : mOrders(max_orders),
+          mBuckets(std::bit_ceil(max_orders * 2), EMPTY_BUCKET),
+          mBucket_mask(mBuckets.size() - 1) {
+        ASSERT(max_orders <= ME_MAX_ORDER_IDS,
+               "ItchOrderTable larger than the order book OrderArray.");
+        mFree_slots.reserve(max_orders);
+        for (size_t slot = max_orders; slot > 0; --slot) {
+            mFree_slots.push_back(static_cast<uint32_t>(slot - 1));
+        }
+    }
+
+    /// \brief Inserts a new live order.
+    /// \param reference ITCH order reference number.
+    /// \return The OrderId assigned to the order, or OrderId_INVALID if the
+    /// table is full or the reference is already live.
+    auto insert(uint64_t reference) noexcept -> OrderId {
+        if (mFree_slots.empty()) [[unlikely]] {
+            return OrderId_INVALID;
+        }
+
+        auto bucket = bucketOf(reference);
+        while (mBuckets[bucket] != EMPTY_BUCKET) {
+            if (mOrders[mBuckets[bucket]].reference == reference) [[unlikely]] {
+                return OrderId_INVALID;
+            }
+            bucket = (bucket + 1) & mBucket_mask;
+        }
+
+        const auto slot = mFree_slots.back();
+        mFree_slots.pop_back();
+        mBuckets[bucket] = slot;
+        mOrders[slot].reference = reference;
+
+        return slot;
+    }
+
+    /// \brief Looks up a live order by its reference number.
+    /// \param reference ITCH order reference number.
+    /// \return The OrderId of the order, or OrderId_INVALID if not live.
+    auto find(uint64_t reference) const noexcept -> OrderId {
+        auto bucket = bucketOf(reference);
+        while (mBuckets[bucket] != EMPTY_BUCKET) {
+            if (mOrders[mBuckets[bucket]].reference == reference) [[likely]] {
+                return mBuckets[bucket];
+            }
+            bucket = (bucket + 1) & mBucket_mask;
+        }
+        return OrderId_INVALID;
+    }
+
+    /// \brief Removes a live order and recycles its OrderId.
+    ///
+    /// Uses backward shift deletion so that no tombstones are left behind and
+    /// probe sequences stay short over a full trading day.
+    /// \param order_id OrderId returned by insert() or find().
+    auto erase(OrderId order_id) noexcept -> void {
+        auto bucket = bucketOf(mOrders[order_id].reference);
+        while (mBuckets[bucket] != order_id) {
+            bucket = (bucket + 1) & mBucket_mask;
+        }
+
+        auto next = (bucket + 1) & mBucket_mask;
+        while (mBuckets[next] != EMPTY_BUCKET) {
+            const auto home = bucketOf(mOrders[mBuckets[next]].reference);
+            // Move the entry back if its home bucket is not in (bucket, next]
+            if (((next - home) & mBucket_mask) >=
+                ((next - bucket) & mBucket_mask)) {
+                mBuckets[bucket] = mBuckets[next];
+                bucket = next;
+            }
+            next = (next + 1) & mBucket_mask;
+        }
+        mBuckets[bucket] = EMPTY_BUCKET;
+
+        mFree_slots.push_back(static_cast<uint32_t>(order_id));
+    }
+
+    /// \brief Returns the state of a live order.
+    /// \param order_id OrderId returned by insert() or find().
+    auto at(OrderId order_id) noexcept -> Order & { return mOrders[order_id]; }
+
+    /// \brief Returns the number of live orders.
+    auto size() const noexcept { return mOrders.size() - mFree_slots.size(); }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    ItchOrderTable() = delete;
+    ItchOrderTable(const ItchOrderTable &) = delete;
+    ItchOrderTable(const ItchOrderTable &&) = delete;
+    ItchOrderTable &operator=(const ItchOrderTable &) = delete;
+    ItchOrderTable &operator=(const ItchOrderTable &&) = delete;
+
+   private:
+    /// \brief Marks an unused hash bucket.
+    static constexpr uint32_t EMPTY_BUCKET =
+        std::numeric_limits<uint32_t>::max();
+
+    /// \brief Maps a reference number to its home bucket (Fibonacci hashing).
+    auto bucketOf(uint64_t reference) const noexcept -> size_t {
+        return static_cast<size_t>((reference * 0x9E3779B97F4A7C15ull) >> 32) &
+               mBucket_mask;
+    }
+
+    /// \brief Order state indexed by OrderId.
+    std::vector<Order> mOrders;
+    /// \brief Hash buckets holding OrderIds, EMPTY_BUCKET when unused.
+    std::vector<uint32_t> mBuckets;
+    /// \brief Number of buckets minus one, the bucket count is a power of two.
+    const size_t mBucket_mask;
+    /// \brief Stack of unused OrderIds.
+    std::vector<uint32_t> mFree_slots;
+};
+
+/// \struct MarketUpdateQueueSink
+/// \brief Parser sink that writes every market update into a lock-free queue.
+struct MarketUpdateQueueSink {
+    /// Queue receiving the updates, its consumer must keep up with the parser.
+    MEMarketUpdateLFQueue *queue = nullptr;
+
+    /// \brief Writes a market update into the queue.
+    auto operator()(const MEMarketUpdate &update) const noexcept {
+        *queue->getNextWrite() = update;
+        queue->updateWriteIndex();
+    }
+};
+
+/// \brief Parses a NASDAQ ITCH 5.0 style binary message stream into
+/// MEMarketUpdates.
+///
+/// The stream is read in place, usually from a memory mapped file, and every
+/// message is dispatched through a 256 entry jump table indexed by its type
+/// byte. Big-endian fields are converted while they are loaded, no message is
+/// copied. Order messages are translated as follows:
+/// - Add Order (A, F): ADD.
+/// - Order Executed (E, C): TRADE, then MODIFY with the remaining shares, or
+/// CANCEL once the order is fully filled.
+/// - Order Cancel (X): MODIFY with the remaining shares, or CANCEL.
+/// - Order Delete (D): CANCEL.
+/// - Order Replace (U): CANCEL of the original order, then ADD of the new one.
+///
+/// Stock locate codes are mapped onto TickerIds either directly with
+/// mapLocate(), or by symbol with mapSymbol() which is resolved from the Stock
+/// Directory messages. Messages for unmapped locates are skipped. ITCH prices
+/// carry four implied decimals and are passed through unchanged.
+/// \tparam Sink Callable invoked with a const MEMarketUpdate & for every
+/// update produced.
+template <typename Sink>
+class ItchParser final {
+   public:
+    /// \brief Constructs an ItchParser.
+    /// \param sink Receives the produced market updates.
+    /// \param max_orders Maximum number of simultaneously live orders.
+    explicit ItchParser(Sink sink, size_t max_orders = ME_MAX_ORDER_IDS)
+        : mSink(std::move(sink)), mOrders(max_orders) {
+        mLocate_to_ticker.fill(TickerId_INVALID);
+    }
+
+    /// \brief Maps a stock locate code directly onto a TickerId.
+    /// \param locate ITCH stock locate code.
+    /// \param ticker_id TickerId used in the produced updates.
+    auto mapLocate(uint16_t locate, TickerId ticker_id) noexcept {
+        mLocate_to_ticker[locate] = ticker_id;
+    }
+
+    /// \brief Maps a stock symbol onto a TickerId, resolved to a locate code
+    /// when its Stock Directory message is parsed.
+    /// \param symbol Stock symbol, at most ITCH_SYMBOL_SIZE characters.
+    /// \param ticker_id TickerId used in the produced updates.
+    auto mapSymbol(std::string_view symbol, TickerId ticker_id) {
+        ASSERT(symbol.size() <= ITCH_SYMBOL_SIZE,
+               "ITCH symbols have at most 8 characters:" + std::string(symbol));
+        std::array<char, ITCH_SYMBOL_SIZE> padded;
+        padded.fill(' ');
+        std::memcpy(padded.data(), symbol.data(), symbol.size());
+        mSymbols.push_back({padded, ticker_id});
+    }
+
+    /// \brief Parses a buffer of length prefixed messages.
+    /// \param data Start of the buffer.
+    /// \param length Size of the buffer in bytes.
+    /// \return Number of bytes consumed, a trailing partial message is left
+    /// for the next call.
+    auto parse(const char *data, size_t length) noexcept -> size_t {
+        size_t offset = 0;
+        while (offset + ITCH_LENGTH_PREFIX_SIZE <= length) {
+            const auto message_length = loadBigEndian<uint16_t>(data + offset);
+            if (offset + ITCH_LENGTH_PREFIX_SIZE + message_length > length)
+                [[unlikely]] {
+                break;
+            }
+
+            parseMessage(data + offset + ITCH_LENGTH_PREFIX_SIZE,
+                         message_length);
+            offset += ITCH_LENGTH_PREFIX_SIZE + message_length;
+        }
+        return offset;
+    }
+
+    /// \brief Maps a file and parses all of its messages.
+    /// \param path Path of the ITCH file.
+    /// \return true if the file was mapped and parsed to its end.
+    auto parseFile(const std::string &path) noexcept -> bool {
+        MappedFile file;
+        if (!file.openReadOnly(path)) return false;
+
+        file.adviseSequential();
+        return parse(file.data(), file.size()) == file.size();
+    }
+
+    /// \brief Parses a single message without its length prefix.
+    /// \param message Start of the message, its first byte is the type.
+    /// \param length Length of the message in bytes.
+    auto parseMessage(const char *message, size_t length) noexcept -> void {
+        ++mMessages_parsed;
+        // A message without even a type byte is malformed.
+        if (!length) [[unlikely]] {
+            ++mMessages_malformed;
+            return;
+        }
+        const auto &entry =
+            DISPATCH_TABLE[static_cast<uint8_t>(message[ItchMessage::TYPE])];
+        if (length < entry.min_length) [[unlikely]] {
+            ++mMessages_malformed;
+            return;
+        }
+        (this->*entry.handler)(message);
+    }
+
+    /// \brief Returns the number of messages parsed.
+    auto messagesParsed() const noexcept { return mMessages_parsed; }
+
+    /// \brief Returns the number of market updates produced.
+    auto updatesProduced() const noexcept { return mUpdates_produced; }
+
+    /// \brief Returns the number of messages that are empty or shorter than
+    /// their type requires.
+    auto messagesMalformed() const noexcept { return mMessages_malformed; }
+
+    /// \brief Returns the number of order messages referring to an order that
+    /// is not live, usually one added before the capture started.
+    auto unknownOrders() const noexcept { return mUnknown_orders; }
+
+    /// \brief Returns the number of orders currently resting.
+    auto liveOrders() const noexcept { return mOrders.size(); }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    ItchParser() = delete;
+    ItchParser(const ItchParser &) = delete;
+    ItchParser(const ItchParser &&) = delete;
+    ItchParser &operator=(const ItchParser &) = delete;
+    ItchParser &operator=(const ItchParser &&) = delete;
+
+   private:
+    /// \brief Member function handling one message type.
+    using Handler = void (ItchParser::*)(const char *) noexcept;
+
+    /// \struct DispatchEntry
+    /// \brief Jump table entry: the handler and the minimum message length.
+    struct DispatchEntry {
+        Handler handler = &ItchParser::onIgnored;
+        size_t min_length = 1;
+    };
+
+    /// \brief Builds the jump table, message types without a handler are
+    /// counted and skipped.
+    static constexpr auto makeDispatchTable() noexcept {
+        std::array<DispatchEntry, 256> table{};
+        table[ItchMessage::STOCK_DIRECTORY] = {
+            &ItchParser::onStockDirectory, ItchMessage::STOCK_DIRECTORY_LENGTH};
+        table[ItchMessage::ADD_ORDER] = {&ItchParser::onAddOrder,
+                                         ItchMessage::ADD_ORDER_LENGTH};
+        table[ItchMessage::ADD_ORDER_MPID] = {
+            &ItchParser::onAddOrder, ItchMessage::ADD_ORDER_MPID_LENGTH};
+        table[ItchMessage::ORDER_EXECUTED] = {
+            &ItchParser::onOrderExecuted, ItchMessage::ORDER_EXECUTED_LENGTH};
+        table[ItchMessage::ORDER_EXECUTED_WITH_PRICE] = {
+            &ItchParser::onOrderExecutedWithPrice,
+            ItchMessage::ORDER_EXECUTED_WITH_PRICE_LENGTH};
+        table[ItchMessage::ORDER_CANCEL] = {&ItchParser::onOrderCancel,
+                                            ItchMessage::ORDER_CANCEL_LENGTH};
+        table[ItchMessage::ORDER_DELETE] = {&ItchParser::onOrderDelete,
+                                            ItchMessage::ORDER_DELETE_LENGTH};
+        table[ItchMessage::ORDER_REPLACE] = {
+            &ItchParser::onOrderReplace, ItchMessage::ORDER_REPLACE_LENGTH};
+        return table;
+    }
+
+    /// \brief Jump table indexed by the message type byte.
+    static constexpr std::array<DispatchEntry, 256> DISPATCH_TABLE =
+        makeDispatchTable();
+
+    /// \brief Returns the TickerId of the message's stock locate code.
+    auto tickerOf(const char *message) const noexcept {
+        return mLocate_to_ticker[loadBigEndian<uint16_t>(
+            message + ItchMessage::STOCK_LOCATE)];
+    }
+
+    /// \brief Hands an update to the sink.
+    auto emit(MarketUpdateType type, OrderId order_id,
+              const ItchOrderTable::Order &order, Price price, Qty qty,
+              Priority priority) noexcept {
+        MEMarketUpdate update;
+        update.type = type;
+        update.order_id = order_id;
+        update.ticker_id = order.ticker_id;
+        update.side = order.side;
+        update.price = price;
+        update.qty = qty;
+        update.priority = priority;
+        mSink(update);
+        ++mUpdates_produced;
+    }
+
+    /// \brief Adds a new resting order and emits its ADD.
+    auto addOrder(uint64_t reference, TickerId ticker_id, Side side,
+                  Price price, Qty qty) noexcept {
+        const auto order_id = mOrders.insert(reference);
+        if (order_id == OrderId_INVALID) [[unlikely]] {
+            ++mUnknown_orders;
+            return;
+        }
+
+        auto &order = mOrders.at(order_id);
+        order.ticker_id = ticker_id;
+        order.side = side;
+        order.price = price;
+        order.qty = qty;
+        emit(MarketUpdateType::ADD, order_id, order, price, qty,
+             ++mNext_priority);
+    }
+
+    /// \brief Takes shares off a resting order, emitting a MODIFY with the
+    /// remaining shares or a CANCEL once none are left.
+    auto reduceOrder(OrderId order_id, Qty qty) noexcept {
+        auto &order = mOrders.at(order_id);
+        order.qty = qty < order.qty ? order.qty - qty : 0;
+        if (order.qty) {
+            emit(MarketUpdateType::MODIFY, order_id, order, order.price,
+                 order.qty, Priority_INVALID);
+        } else {
+            emit(MarketUpdateType::CANCEL, order_id, order, order.price, 0,
+                 Priority_INVALID);
+            mOrders.erase(order_id);
+        }
+    }
+
+    /// \brief Looks up the order referenced by a message.
+    auto findOrder(const char *message) noexcept {
+        const auto order_id = mOrders.find(
+            loadBigEndian<uint64_t>(message + ItchMessage::ORDER_REFERENCE));
+        if (order_id == OrderId_INVALID) [[unlikely]] {
+            ++mUnknown_orders;
+        }
+        return order_id;
+    }
+
+    /// \brief Skips message types that do not affect the order book.
+    auto onIgnored(const char *) noexcept -> void {}
+
+    /// \brief Resolves mapped symbols to their stock locate code.
+    auto onStockDirectory(const char *message) noexcept -> void {
+        for (const auto &[symbol, ticker_id] : mSymbols) {
+            if (!std::memcmp(message + ItchMessage::STOCK_DIRECTORY_STOCK,
+                             symbol.data(), ITCH_SYMBOL_SIZE)) {
+                mapLocate(loadBigEndian<uint16_t>(message +
+                                                  ItchMessage::STOCK_LOCATE),
+                          ticker_id);
+            }
+        }
+    }
+
+    /// \brief Handles Add Order and Add Order with MPID attribution.
+    auto onAddOrder(const char *message) noexcept -> void {
+        const auto ticker_id = tickerOf(message);
+        if (ticker_id == TickerId_INVALID) return;
+
+        addOrder(
+            loadBigEndian<uint64_t>(message + ItchMessage::ORDER_REFERENCE),
+            ticker_id,
+            message[ItchMessage::ADD_ORDER_SIDE] == 'B' ? Side::BUY
+                                                        : Side::SELL,
+            loadBigEndian<uint32_t>(message + ItchMessage::ADD_ORDER_PRICE),
+            loadBigEndian<uint32_t>(message + ItchMessage::ADD_ORDER_SHARES));
+    }
+
+    /// \brief Handles Order Executed, the trade prints at the order's price.
+    auto onOrderExecuted(const char *message) noexcept -> void {
+        if (tickerOf(message) == TickerId_INVALID) return;
+        const auto order_id = findOrder(message);
+        if (order_id == OrderId_INVALID) [[unlikely]] return;
+
+        const auto &order = mOrders.at(order_id);
+        const auto qty = loadBigEndian<uint32_t>(
+            message + ItchMessage::ORDER_EXECUTED_SHARES);
+        emit(MarketUpdateType::TRADE, order_id, order, order.price, qty,
+             Priority_INVALID);
+        reduceOrder(order_id, qty);
+    }
+
+    /// \brief Handles Order Executed With Price, the trade prints at the
+    /// execution price carried by the message.
+    auto onOrderExecutedWithPrice(const char *message) noexcept -> void {
+        if (tickerOf(message) == TickerId_INVALID) return;
+        const auto order_id = findOrder(message);
+        if (order_id == OrderId_INVALID) [[unlikely]] return;
+
+        const auto &order = mOrders.at(order_id);
+        const auto qty = loadBigEndian<uint32_t>(
+            message + ItchMessage::ORDER_EXECUTED_SHARES);
+        emit(MarketUpdateType::TRADE, order_id, order,
+             loadBigEndian<uint32_t>(
+                 message + ItchMessage::ORDER_EXECUTED_WITH_PRICE_PRICE),
+             qty, Priority_INVALID);
+        reduceOrder(order_id, qty);
+    }
+
+    /// \brief Handles a partial Order Cancel.
+    auto onOrderCancel(const char *message) noexcept -> void {
+        if (tickerOf(message) == TickerId_INVALID) return;
+        const auto order_id = findOrder(message);
+        if (order_id == OrderId_INVALID) [[unlikely]] return;
+
+        reduceOrder(order_id, loadBigEndian<uint32_t>(
+                                  message + ItchMessage::ORDER_CANCEL_SHARES));
+    }
+
+    /// \brief Handles Order Delete.
+    auto onOrderDelete(const char *message) noexcept -> void {
+        if (tickerOf(message) == TickerId_INVALID) return;
+        const auto order_id = findOrder(message);
+        if (order_id == OrderId_INVALID) [[unlikely]] return;
+
+        const auto &order = mOrders.at(order_id);
+        emit(MarketUpdateType::CANCEL, order_id, order, order.price, 0,
+             Priority_INVALID);
+        mOrders.erase(order_id);
+    }
+
+    /// \brief Handles Order Replace, the new order loses its queue priority.
+    auto onOrderReplace(const char *message) noexcept -> void {
+        const auto ticker_id = tickerOf(message);
+        if (ticker_id == TickerId_INVALID) return;
+        const auto order_id = findOrder(message);
+        if (order_id == OrderId_INVALID) [[unlikely]] return;
+
+        const auto side = mOrders.at(order_id).side;
+        onOrderDelete(message);
+        addOrder(loadBigEndian<uint64_t>(
+                     message + ItchMessage::ORDER_REPLACE_NEW_REFERENCE),
+                 ticker_id, side,
+                 loadBigEndian<uint32_t>(message +
+                                         ItchMessage::ORDER_REPLACE_PRICE),
+                 loadBigEndian<uint32_t>(message +
+                                         ItchMessage::ORDER_REPLACE_SHARES));
+    }
+
+    /// \brief Receives the produced market updates.
+    Sink mSink;
+    /// \brief Resting order state and reference number mapping.
+    ItchOrderTable mOrders;
+    /// \brief TickerId of every stock locate code, TickerId_INVALID if the
+    /// stock is not subscribed.
+    std::array<TickerId, ITCH_MAX_LOCATES> mLocate_to_ticker;
+    /// \brief Symbols waiting to be resolved by Stock Directory messages.
+    std::vector<std::pair<std::array<char, ITCH_SYMBOL_SIZE>, TickerId>>
+        mSymbols;
+    /// \brief Priority given to the next added order.
+    Priority mNext_priority = 0;
+
+    /// \brief Number of messages parsed.
+    size_t mMessages_parsed = 0;
+    /// \brief Number of market updates produced.
+    size_t mUpdates_produced = 0;
+    /// \brief Number of messages that are empty or shorter than their type
+    /// requires.
+    size_t mMessages_malformed = 0;
+    /// \brief Number of order messages referring to an order that is not live.
+    size_t mUnknown_orders = 0;
+};
@@ -0,0 +1,140 @@
+/// \file example_journal.cpp
+/// \brief Example recording market updates into a journal and replaying them
+/// into order books.
+/// \details A producer thread pushes adds and cancels into a lock-free queue
+/// that the JournalWriter drains into small rotating segments. The journal is
+/// then replayed into a set of order books, once as fast as possible and once
+/// paced to the recorded timestamps.
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+#include "journal/journal.h"
+
+/// \brief Number of market updates to record.
+constexpr size_t NUM_UPDATES = 50'000;
+
+/// \brief Number of live orders kept per ticker, older orders get cancelled.
+constexpr size_t LIVE_ORDERS = 100;
+
+/// \brief Number of tickers the updates are spread over.
+constexpr TickerId NUM_TICKERS = 2;
+
+/// \brief Side of a generated order, alternating between buys and sells.
+auto orderSide(OrderId order_id) {
+    return (order_id & 1) ? Side::SELL : Side::BUY;
+}
+
+/// \brief Price of a generated order, spread over five levels per side.
+auto orderPrice(OrderId order_id) -> Price {
+    return orderSide(order_id) == Side::BUY
+               ? 99 - static_cast<Price>(order_id % 5)
+               : 101 + static_cast<Price>(order_id % 5);
+}
+
+/// \brief Producer function writing adds and cancels into the queue.
+/// \details Each ticker keeps LIVE_ORDERS orders alive, once it is full the
+/// oldest order is cancelled before the next one is added.
+/// \param queue Queue drained by the journal writer.
+auto produceFunction(MEMarketUpdateLFQueue *queue) {
+    OrderId next_order_id[NUM_TICKERS] = {};
+    OrderId oldest_order_id[NUM_TICKERS] = {};
+
+    for (size_t i = 0; i < NUM_UPDATES; ++i) {
+        const auto ticker_id = static_cast<TickerId>(i % NUM_TICKERS);
+
+        MEMarketUpdate update;
+        update.ticker_id = ticker_id;
+        if (next_order_id[ticker_id] - oldest_order_id[ticker_id] ==
+            LIVE_ORDERS) {
+            update.type = MarketUpdateType::CANCEL;
+            update.order_id = oldest_order_id[ticker_id]++;
+        } else {
+            update.type = MarketUpdateType::ADD;
+            update.order_id = next_order_id[ticker_id]++;
+            update.qty = 10 + static_cast<Qty>(update.order_id % 7);
+            update.priority = update.order_id;
+        }
+        update.side = orderSide(update.order_id);
+        update.price = orderPrice(update.order_id);
+
+        // Back off while the queue is nearly full
+        while (queue->size() >= ME_MAX_MARKET_UPDATES - 1) {
+            std::this_thread::yield();
+        }
+        *queue->getNextWrite() = update;
+        queue->updateWriteIndex();
+    }
+}
+
+/// \brief Main function demonstrating journal recording and replay.
+/// \return Exit status code (0 for success)
+int main(int, char **) {
+    const auto directory =
+        (std::filesystem::temp_directory_path() / "journal_example").string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    /// Record the updates, 10'000 records per segment
+    {
+        MEMarketUpdateLFQueue queue(ME_MAX_MARKET_UPDATES);
+        JournalWriter<MEMarketUpdate> writer(&queue, directory, "market",
+                                             10'000);
+        writer.start();
+
+        std::thread producer(produceFunction, &queue);
+        producer.join();
+        writer.stop();
+
+        std::cout << "recorded " << writer.recordsWritten() << " updates into "
+                  << writer.segmentsWritten() << " segments in " << directory
+                  << std::endl;
+    }
+
+    /// Replay as fast as possible straight from the mapped pages
+    MarketOrderBookHashMap books;
+    books.fill(nullptr);
+    for (TickerId ticker_id = 0; ticker_id < NUM_TICKERS; ++ticker_id) {
+        books[ticker_id] = new MarketOrderBook(ticker_id);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto replayed = replayJournal<MEMarketUpdate>(
+        directory, "market", ReplaySpeed::AS_FAST_AS_POSSIBLE, books);
+    auto elapsed = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << "replayed " << replayed << " updates as fast as possible in "
+              << elapsed.count() << " us" << std::endl;
+    for (TickerId ticker_id = 0; ticker_id < NUM_TICKERS; ++ticker_id) {
+        std::cout << "ticker " << ticker_id << " "
+                  << books[ticker_id]->getBestBidOffer()->toString()
+                  << std::endl;
+    }
+
+    /// Replay again, reproducing the recorded gaps between updates
+    for (TickerId ticker_id = 0; ticker_id < NUM_TICKERS; ++ticker_id) {
+        MEMarketUpdate clear;
+        clear.type = MarketUpdateType::CLEAR;
+        books[ticker_id]->onMarketUpdate(&clear);
+    }
+
+    start = std::chrono::steady_clock::now();
+    replayed = replayJournal<MEMarketUpdate>(directory, "market",
+                                             ReplaySpeed::RECORDED, books);
+    elapsed = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << "replayed " << replayed << " updates at recorded pace in "
+              << elapsed.count() << " us" << std::endl;
+    for (TickerId ticker_id = 0; ticker_id < NUM_TICKERS; ++ticker_id) {
+        std::cout << "ticker " << ticker_id << " "
+                  << books[ticker_id]->getBestBidOffer()->toString()
+                  << std::endl;
+        delete books[ticker_id];
+    }
+
+    std::filesystem::remove_all(directory);
+
+    return 0;
+}
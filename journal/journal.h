@@ -0,0 +1,519 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+#endif
+
+#include "lock-free-queue/lockfreequeue.h"
+#include "market-orders/marketupdate.h"
+#include "order-book/orderbook.h"
+#include "utilities/macros.h"
+#include "utilities/mappedfile.h"
+#include "utilities/types.h"
+
+/// \brief Magic number at the start of every journal segment ("JRNL").
+constexpr uint32_t JOURNAL_MAGIC = 0x4C4E524A;
+
+/// \brief Version of the journal segment layout.
+constexpr uint16_t JOURNAL_VERSION = 1;
+
+/// \brief Empty polls of the queue the journal writer spins through, with a
+/// pause instruction each, before it starts sleeping.
+constexpr size_t JOURNAL_IDLE_SPINS = 64;
+
+/// \brief Time the journal writer sleeps between polls of an idle queue.
+constexpr auto JOURNAL_IDLE_SLEEP = std::chrono::microseconds(50);
+
+/// \enum JournalRecordType
+/// \brief Identifies the message structure stored in a journal segment.
+enum class JournalRecordType : uint16_t {
+    INVALID = 0,
+    ME_MARKET_UPDATE = 1,
+    MDP_MARKET_UPDATE = 2
+};
+
+/// \brief Maps a journaled message structure to its JournalRecordType.
+/// \tparam T MEMarketUpdate or MDPMarketUpdate.
+/// \return The record type stored in the segment header.
+template <typename T>
+inline constexpr auto journalRecordType() noexcept {
+    if constexpr (std::is_same_v<T, MEMarketUpdate>) {
+        return JournalRecordType::ME_MARKET_UPDATE;
+    } else if constexpr (std::is_same_v<T, MDPMarketUpdate>) {
+        return JournalRecordType::MDP_MARKET_UPDATE;
+    } else {
+        return JournalRecordType::INVALID;
+    }
+}
+
+/// \struct JournalSegmentHeader
+/// \brief Header at the start of every journal segment file.
+///
+/// The header occupies its own cache line, the records follow directly after
+/// it. The committed record count is published with release semantics after
+/// the records are written, so a reader mapping a live segment never sees a
+/// partially written record.
+struct alignas(64) JournalSegmentHeader {
+    /// Always JOURNAL_MAGIC.
+    uint32_t magic = JOURNAL_MAGIC;
+    /// Layout version, JOURNAL_VERSION.
+    uint16_t version = JOURNAL_VERSION;
+    /// Structure stored in the records.
+    JournalRecordType record_type = JournalRecordType::INVALID;
+    /// Size of a single record in bytes.
+    uint32_t record_size = 0;
+    /// Index of this segment within the journal.
+    uint32_t segment_index = 0;
+    /// Maximum number of records in this segment.
+    uint64_t capacity = 0;
+    /// Number of committed records.
+    std::atomic<uint64_t> count = {0};
+};
+
+static_assert(sizeof(JournalSegmentHeader) == 64,
+              "JournalSegmentHeader should occupy a single cache line.");
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Committed count must be lock-free to live in a shared mapping.");
+
+/// \brief The records are written to disk, so the binary structure is packed
+/// to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+/// \struct JournalRecord
+/// \brief A journaled message with the time it was recorded.
+/// \tparam T MEMarketUpdate or MDPMarketUpdate.
+template <typename T>
+struct JournalRecord {
+    /// Nanoseconds since the epoch when the journal writer took the message
+    /// off its queue.
+    uint64_t timestamp_ns = 0;
+    /// The message exactly as it was read from the queue.
+    T update;
+};
+
+/// \brief Undo the packed binary structure directive moving forward.
+#pragma pack(pop)
+
+/// \brief Builds the file name of a journal segment.
+/// \param directory Directory holding the journal.
+/// \param prefix Journal name shared by all of its segments.
+/// \param segment_index Index of the segment.
+/// \return Path of the form directory/prefix.000000.journal.
+inline auto journalSegmentPath(const std::string &directory,
+                               const std::string &prefix,
+                               size_t segment_index) -> std::string {
+    char index[16];
+    std::snprintf(index, sizeof(index), "%06zu", segment_index);
+    return directory + "/" + prefix + "." + index + ".journal";
+}
+
+/// \brief Returns the current wall clock time in nanoseconds since the epoch.
+inline auto journalTimestampNanos() noexcept -> uint64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+/// \brief Append-only journal writer that records every message read from a
+/// LockFreeQueue into memory mapped, segment-rotated files.
+///
+/// The writer runs on its own thread and is the single consumer of the queue,
+/// so the producer only pays for the queue write. Segments are created at full
+/// size with their pages pre-faulted. The next segment is prepared by a helper
+/// thread as soon as the current one is opened, so rotation is a pointer swap
+/// unless segments fill faster than they can be created. While the queue is
+/// empty the writer spins briefly, then sleeps between polls.
+/// \tparam T MEMarketUpdate or MDPMarketUpdate.
+template <typename T>
+class JournalWriter final {
+   public:
+    /// \brief Constructs a JournalWriter.
+    /// \param queue Queue to drain, the writer must be its only consumer.
+    /// \param directory Existing directory to write the segments into.
+    /// \param prefix Journal name shared by all of its segments.
+    /// \param records_per_segment Capacity of each segment in records.
+    JournalWriter(LockFreeQueue<T> *queue, std::string directory,
+                  std::string prefix, size_t records_per_segment)
+        : mQueue(queue),
+          mDirectory(std::move(directory)),
+          mPrefix(std::move(prefix)),
+          mRecords_per_segment(records_per_segment) {
+        static_assert(journalRecordType<T>() != JournalRecordType::INVALID,
+                      "Unsupported journal record type.");
+        ASSERT(records_per_segment > 0, "Journal segments must hold records.");
+    }
+
+    /// \brief Stops the writer thread, draining the queue first.
+    ~JournalWriter() { stop(); }
+
+    /// \brief Creates the first segment and starts the writer thread.
+    auto start() -> void {
+        ASSERT(!mThread.joinable(), "JournalWriter already started.");
+        openSegment(current(), mSegment_index);
+        prepareNext();
+        mRunning = true;
+        mThread = std::thread([this] { run(); });
+    }
+
+    /// \brief Drains the remaining queued messages and stops the writer
+    /// thread. The spare pre-allocated segment is removed.
+    auto stop() -> void {
+        if (!mThread.joinable()) return;
+
+        mRunning = false;
+        mThread.join();
+        mPreparer.join();
+
+        current().syncAsync();
+        current().close();
+        next().close();
+        std::remove(journalSegmentPath(mDirectory, mPrefix, mSegment_index + 1)
+                        .c_str());
+    }
+
+    /// \brief Returns the number of records written so far.
+    auto recordsWritten() const noexcept {
+        return mRecords_written.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the number of segments in use so far.
+    auto segmentsWritten() const noexcept {
+        return mSegments_written.load(std::memory_order_relaxed);
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    JournalWriter() = delete;
+    JournalWriter(const JournalWriter &) = delete;
+    JournalWriter(const JournalWriter &&) = delete;
+    JournalWriter &operator=(const JournalWriter &) = delete;
+    JournalWriter &operator=(const JournalWriter &&) = delete;
+
+   private:
+    /// \brief Writer thread main loop. Drains the queue in batches and
+    /// commits each batch with a single release store.
+    auto run() noexcept -> void {
+        size_t idle_polls = 0;
+        while (true) {
+            // Read the flag before draining so the final pass sees everything
+            // the producer wrote before stop() was called.
+            const auto running = mRunning.load(std::memory_order_acquire);
+
+            auto drained = false;
+            while (auto update = mQueue->getNextRead()) {
+                append(*update);
+                mQueue->updateReadIndex();
+                drained = true;
+            }
+
+            if (drained) {
+                header(current())->count.store(mCount,
+                                               std::memory_order_release);
+                idle_polls = 0;
+            } else if (!running) {
+                break;
+            } else if (idle_polls < JOURNAL_IDLE_SPINS) {
+                ++idle_polls;
+#if defined(__x86_64__) || defined(__i386__)
+                _mm_pause();
+#endif
+            } else {
+                std::this_thread::sleep_for(JOURNAL_IDLE_SLEEP);
+            }
+        }
+    }
+
+    /// \brief Appends a single record, rotating to the next segment when the
+    /// current one is full.
+    /// \param update The message to record.
+    auto append(const T &update) noexcept -> void {
+        if (mCount == mRecords_per_segment) [[unlikely]] {
+            rotate();
+        }
+
+        auto record = reinterpret_cast<JournalRecord<T> *>(
+                          current().data() + sizeof(JournalSegmentHeader)) +
+                      mCount;
+        record->timestamp_ns = journalTimestampNanos();
+        record->update = update;
+        ++mCount;
+
+        mRecords_written.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// \brief Seals the current segment, switches to the pre-allocated next
+    /// segment and starts preparing a new spare one.
+    auto rotate() noexcept -> void {
+        header(current())->count.store(mCount, std::memory_order_release);
+        current().syncAsync();
+
+        // Only waits if the spare segment is still being created.
+        mPreparer.join();
+        mCurrent_slot ^= 1;
+        ++mSegment_index;
+        mCount = 0;
+        mSegments_written.store(mSegment_index + 1, std::memory_order_relaxed);
+
+        prepareNext();
+    }
+
+    /// \brief Creates the spare segment on the preparer thread, off the
+    /// writer thread's drain loop.
+    auto prepareNext() noexcept -> void {
+        mPreparer = std::thread([this, &file = next(),
+                                 segment_index = mSegment_index + 1] {
+            openSegment(file, segment_index);
+        });
+    }
+
+    /// \brief Creates a segment file and initialises its header.
+    /// \param file The mapping to create the segment in.
+    /// \param segment_index Index of the segment.
+    auto openSegment(MappedFile &file, size_t segment_index) const noexcept
+        -> void {
+        const auto path =
+            journalSegmentPath(mDirectory, mPrefix, segment_index);
+        if (!file.create(path,
+                         sizeof(JournalSegmentHeader) +
+                             mRecords_per_segment * sizeof(JournalRecord<T>)))
+            [[unlikely]] {
+            FATAL("Unable to create journal segment:" + path);
+        }
+
+        auto segment_header = new (file.data()) JournalSegmentHeader();
+        segment_header->record_type = journalRecordType<T>();
+        segment_header->record_size = sizeof(JournalRecord<T>);
+        segment_header->segment_index = static_cast<uint32_t>(segment_index);
+        segment_header->capacity = mRecords_per_segment;
+    }
+
+    /// \brief Returns the header of a mapped segment.
+    static auto header(const MappedFile &file) noexcept {
+        return reinterpret_cast<JournalSegmentHeader *>(file.data());
+    }
+
+    /// \brief Returns the segment currently being written.
+    auto current() noexcept -> MappedFile & {
+        return mSegments[mCurrent_slot];
+    }
+
+    /// \brief Returns the pre-allocated spare segment.
+    auto next() noexcept -> MappedFile & {
+        return mSegments[mCurrent_slot ^ 1];
+    }
+
+    /// \brief Queue drained by the writer thread.
+    LockFreeQueue<T> *mQueue = nullptr;
+    /// \brief Directory holding the segments.
+    const std::string mDirectory;
+    /// \brief Journal name shared by all of its segments.
+    const std::string mPrefix;
+    /// \brief Capacity of each segment in records.
+    const size_t mRecords_per_segment = 0;
+
+    /// \brief The segment being written and the pre-allocated spare segment
+    /// used on the next rotation.
+    MappedFile mSegments[2];
+    /// \brief Slot in mSegments of the segment being written.
+    size_t mCurrent_slot = 0;
+    /// \brief Index of the segment currently being written.
+    size_t mSegment_index = 0;
+    /// \brief Records written to the current segment.
+    size_t mCount = 0;
+
+    /// \brief Records written in total, readable from other threads.
+    std::atomic<size_t> mRecords_written = {0};
+    /// \brief Segments in use, readable from other threads.
+    std::atomic<size_t> mSegments_written = {1};
+
+    /// \brief Cleared to ask the writer thread to drain and exit.
+    std::atomic<bool> mRunning = {false};
+    /// \brief The writer thread.
+    std::thread mThread;
+    /// \brief The thread creating the spare segment, joined before the spare
+    /// segment is used.
+    std::thread mPreparer;
+};
+
+/// \brief Read-only view of a single journal segment.
+///
+/// Records are accessed directly in the mapped pages, nothing is parsed or
+/// copied. A segment that is still being written can be read, size() only
+/// reports records that the writer has committed.
+/// \tparam T MEMarketUpdate or MDPMarketUpdate.
+template <typename T>
+class JournalReader final {
+   public:
+    /// \brief Constructs a reader with no segment mapped.
+    JournalReader() = default;
+
+    /// \brief Maps a segment and validates its header.
+    /// \param path Path of the segment file.
+    /// \return true if the segment was mapped and holds records of type T.
+    auto open(const std::string &path) noexcept -> bool {
+        if (!mFile.openReadOnly(path, true)) return false;
+
+        if (mFile.size() < sizeof(JournalSegmentHeader)) [[unlikely]] {
+            mFile.close();
+            return false;
+        }
+
+        const auto segment_header = header();
+        if (segment_header->magic != JOURNAL_MAGIC ||
+            segment_header->version != JOURNAL_VERSION ||
+            segment_header->record_type != journalRecordType<T>() ||
+            segment_header->record_size != sizeof(JournalRecord<T>) ||
+            sizeof(JournalSegmentHeader) +
+                    segment_header->capacity * sizeof(JournalRecord<T>) >
+                mFile.size()) [[unlikely]] {
+            mFile.close();
+            return false;
+        }
+
+        mFile.adviseSequential();
+        return true;
+    }
+
+    /// \brief Returns the number of committed records in the segment.
+    auto size() const noexcept -> size_t {
+        return header()->count.load(std::memory_order_acquire);
+    }
+
+    /// \brief Returns the index of the segment within its journal.
+    auto segmentIndex() const noexcept -> size_t {
+        return header()->segment_index;
+    }
+
+    /// \brief Returns a record in the mapped segment.
+    /// \param index Index of the record, must be less than size().
+    /// \return Pointer to the record inside the mapping.
+    auto at(size_t index) const noexcept -> const JournalRecord<T> * {
+        return begin() + index;
+    }
+
+    /// \brief Returns a pointer to the first record.
+    auto begin() const noexcept {
+        return reinterpret_cast<const JournalRecord<T> *>(
+            mFile.data() + sizeof(JournalSegmentHeader));
+    }
+
+    /// \brief Returns a pointer one past the last committed record.
+    auto end() const noexcept { return begin() + size(); }
+
+    // Deleted copy & move constructors and assignment-operators.
+    JournalReader(const JournalReader &) = delete;
+    JournalReader(const JournalReader &&) = delete;
+    JournalReader &operator=(const JournalReader &) = delete;
+    JournalReader &operator=(const JournalReader &&) = delete;
+
+   private:
+    /// \brief Returns the header of the mapped segment.
+    auto header() const noexcept {
+        return reinterpret_cast<const JournalSegmentHeader *>(mFile.data());
+    }
+
+    /// \brief The mapped segment.
+    MappedFile mFile;
+};
+
+/// \enum ReplaySpeed
+/// \brief Controls how fast a journal is replayed.
+enum class ReplaySpeed : uint8_t {
+    /// Feed records back to back.
+    AS_FAST_AS_POSSIBLE = 0,
+    /// Reproduce the gaps between the recorded timestamps.
+    RECORDED = 1
+};
+
+/// \brief Returns the matching engine update carried by a journaled message.
+inline auto journalMarketUpdate(const MEMarketUpdate &update) noexcept
+    -> const MEMarketUpdate * {
+    return &update;
+}
+
+/// \brief Returns the matching engine update carried by a journaled message.
+inline auto journalMarketUpdate(const MDPMarketUpdate &update) noexcept
+    -> const MEMarketUpdate * {
+    return &update.me_market_update_;
+}
+
+/// \brief Replays every segment of a journal in order.
+///
+/// Segments are opened one after the other until the next index does not
+/// exist. Each record is handed to the handler as a pointer into the mapped
+/// pages.
+/// \param directory Directory holding the journal.
+/// \param prefix Journal name shared by all of its segments.
+/// \param speed Replay as fast as possible or paced to the timestamps.
+/// \param handler Called with a const JournalRecord<T> * for every record.
+/// \return Number of records replayed.
+template <typename T, typename Handler>
+auto replayJournal(const std::string &directory, const std::string &prefix,
+                   ReplaySpeed speed, Handler &&handler) -> size_t {
+    size_t replayed = 0;
+    uint64_t previous_timestamp_ns = 0;
+    uint64_t elapsed_ns = 0;
+    const auto replay_start = std::chrono::steady_clock::now();
+
+    JournalReader<T> reader;
+    for (size_t segment_index = 0;
+         reader.open(journalSegmentPath(directory, prefix, segment_index));
+         ++segment_index) {
+        for (auto record = reader.begin(); record != reader.end(); ++record) {
+            if (speed == ReplaySpeed::RECORDED) {
+                // The timestamps are wall clock time, a gap where the clock
+                // stepped backwards is replayed as no gap at all.
+                if (replayed && record->timestamp_ns > previous_timestamp_ns) {
+                    elapsed_ns += record->timestamp_ns - previous_timestamp_ns;
+                }
+                previous_timestamp_ns = record->timestamp_ns;
+                const auto due =
+                    replay_start + std::chrono::nanoseconds(elapsed_ns);
+                // Sleep through long gaps, spin through the last millisecond.
+                const auto wait = due - std::chrono::steady_clock::now();
+                if (wait > std::chrono::milliseconds(1)) {
+                    std::this_thread::sleep_for(wait -
+                                                std::chrono::milliseconds(1));
+                }
+                while (std::chrono::steady_clock::now() < due) {
+                }
+            }
+
+            handler(record);
+            ++replayed;
+        }
+    }
+
+    return replayed;
+}
+
+/// \brief Replays every segment of a journal straight into the order books.
+///
+/// Updates are passed to MarketOrderBook::onMarketUpdate as pointers into the
+/// mapped pages. Updates for tickers without a book are skipped.
+/// \param directory Directory holding the journal.
+/// \param prefix Journal name shared by all of its segments.
+/// \param speed Replay as fast as possible or paced to the timestamps.
+/// \param books Order books indexed by TickerId.
+/// \return Number of records replayed.
+template <typename T>
+auto replayJournal(const std::string &directory, const std::string &prefix,
+                   ReplaySpeed speed, MarketOrderBookHashMap &books)
+    -> size_t {
+    return replayJournal<T>(
+        directory, prefix, speed, [&books](const JournalRecord<T> *record) {
+            const auto market_update = journalMarketUpdate(record->update);
+            if (market_update->ticker_id < books.size() &&
+                books[market_update->ticker_id]) [[likely]] {
+                books[market_update->ticker_id]->onMarketUpdate(market_update);
+            }
+        });
+}
@@ -0,0 +1,82 @@
+/// \file example_latencytracer.cpp
+/// \brief Traces market updates through a queue hop and the order book.
+/// \details A feed thread stamps synthetic updates as they are received and
+/// written to a LockFreeQueue. A book thread stamps them as they are read and
+/// applied to the books, then records the stage deltas. A monitor thread dumps
+/// the per-stage percentiles while the pipeline runs.
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "latency-tracer/latencytracer.h"
+#include "lock-free-queue/lockfreequeue.h"
+#include "order-flow/orderflowbooks.h"
+
+/// \brief Number of updates sent through the pipeline.
+constexpr size_t NUM_UPDATES = 1'000'000;
+
+/// \brief Main function running the traced pipeline.
+/// \return Exit status code (0 for success)
+int main(int, char **) {
+    TscClock::calibrate();
+    std::cout << "invariant tsc: " << std::boolalpha
+              << TscClock::hasInvariantTsc() << ", " << std::fixed
+              << std::setprecision(3) << TscClock::ticksPerNano()
+              << " ticks/ns" << std::endl;
+
+    OrderFlowConfig config;
+    OrderFlowGenerator generator(config);
+
+    OrderFlowBooks books(config.num_tickers);
+
+    // A short queue keeps the measured hop from being dominated by backlog.
+    LockFreeQueue<Traced<MEMarketUpdate>> queue(1024);
+    LatencyTracer tracer;
+    std::atomic<bool> done = {false};
+
+    std::thread feed([&]() {
+        for (size_t i = 0; i < NUM_UPDATES; ++i) {
+            while (queue.size() == queue.capacity()) std::this_thread::yield();
+
+            auto traced = queue.getNextWrite();
+            traced->stamps.clear();
+            traced->stamps.stamp(TraceStage::FEED_RECEIVE);
+            traced->message = generator.next()->update;
+            traced->stamps.stamp(TraceStage::QUEUE_WRITE);
+            queue.updateWriteIndex();
+        }
+    });
+
+    std::thread book([&]() {
+        for (size_t i = 0; i < NUM_UPDATES;) {
+            const auto next = queue.getNextRead();
+            if (!next) {
+                std::this_thread::yield();
+                continue;
+            }
+            auto traced = *next;
+            queue.updateReadIndex();
+            traced.stamps.stamp(TraceStage::QUEUE_READ);
+            tracedMarketUpdate(&books[traced.message.ticker_id], traced);
+            tracer.record(traced.stamps);
+            ++i;
+        }
+        done = true;
+    });
+
+    // The monitor only reads the histograms, the pipeline never pauses.
+    while (!done) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        tracer.dump(std::cout);
+        std::cout << std::endl;
+    }
+
+    feed.join();
+    book.join();
+    std::cout << "final" << std::endl;
+    tracer.dump(std::cout);
+
+    return 0;
+}
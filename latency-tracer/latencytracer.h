@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+#include "order-book/orderbook.h"
+#include "utilities/latencyhistogram.h"
+#include "utilities/macros.h"
+#include "utilities/tscclock.h"
+
+/// \enum TraceStage
+/// \brief Points of the market data pipeline an update is stamped at.
+enum class TraceStage : uint8_t {
+    FEED_RECEIVE = 0,
+    QUEUE_WRITE = 1,
+    QUEUE_READ = 2,
+    BOOK_UPDATE_START = 3,
+    BOOK_UPDATE_END = 4,
+    STRATEGY = 5,
+    MAX = 6
+};
+
+/// \brief Number of stages an update can be stamped at.
+constexpr size_t TRACE_STAGE_COUNT = static_cast<size_t>(TraceStage::MAX);
+
+/// \brief Converts a TraceStage enum to a string.
+/// \param stage The TraceStage to convert.
+/// \return String representation of the TraceStage.
+inline auto traceStageToString(TraceStage stage) -> std::string {
+    switch (stage) {
+        case TraceStage::FEED_RECEIVE:
+            return "FEED_RECEIVE";
+        case TraceStage::QUEUE_WRITE:
+            return "QUEUE_WRITE";
+        case TraceStage::QUEUE_READ:
+            return "QUEUE_READ";
+        case TraceStage::BOOK_UPDATE_START:
+            return "BOOK_UPDATE_START";
+        case TraceStage::BOOK_UPDATE_END:
+            return "BOOK_UPDATE_END";
+        case TraceStage::STRATEGY:
+            return "STRATEGY";
+        case TraceStage::MAX:
+            return "MAX";
+    }
+    return "UNKNOWN";
+}
+
+/// \struct TraceStamps
+/// \brief Time stamp counter readings taken as an update passes each stage of
+/// the pipeline. A stage that was not passed keeps the reading 0.
+struct TraceStamps {
+    /// Ticks per stage, indexed by TraceStage.
+    std::array<uint64_t, TRACE_STAGE_COUNT> ticks = {};
+
+    /// \brief Stamps a stage with the current time stamp counter.
+    auto stamp(TraceStage stage) noexcept -> void {
+        ticks[static_cast<size_t>(stage)] = TscClock::now();
+    }
+
+    /// \brief Clears all stamps, for reusing a queue slot.
+    auto clear() noexcept -> void { ticks.fill(0); }
+};
+
+/// \struct Traced
+/// \brief A message carrying its trace stamps, so they travel with it through
+/// LockFreeQueue hops without changing the message layout itself.
+/// \tparam T The message, usually MEMarketUpdate.
+template <typename T>
+struct Traced {
+    /// The message.
+    T message;
+    /// Trace stamps of the message.
+    TraceStamps stamps;
+};
+
+/// \brief Applies a traced market update to a book, stamping the start and
+/// end of MarketOrderBook::onMarketUpdate.
+/// \param book The book of the update's ticker.
+/// \param update The traced update.
+inline auto tracedMarketUpdate(MarketOrderBook *book,
+                               Traced<MEMarketUpdate> &update) noexcept
+    -> void {
+    update.stamps.stamp(TraceStage::BOOK_UPDATE_START);
+    book->onMarketUpdate(&update.message);
+    update.stamps.stamp(TraceStage::BOOK_UPDATE_END);
+}
+
+/// \brief Aggregates the per-stage latency of traced updates.
+///
+/// Every stamped stage is attributed the time since the previous stamped
+/// stage, and the whole path from the first to the last stamped stage is
+/// recorded as well. The histograms have a single writer, the thread that
+/// consumes the updates at the end of the pipeline. A monitoring thread can
+/// read and dump them at any time without pausing that thread.
+class LatencyTracer final {
+   public:
+    /// \brief Constructs a LatencyTracer with empty histograms.
+    LatencyTracer() = default;
+
+    /// \brief Records the stage deltas of an update. Must only be called by
+    /// the single writer.
+    /// \param stamps The stamps of an update at the end of the pipeline.
+    auto record(const TraceStamps &stamps) noexcept -> void {
+        uint64_t first = 0;
+        uint64_t previous = 0;
+        for (size_t stage = 0; stage < TRACE_STAGE_COUNT; ++stage) {
+            const auto ticks = stamps.ticks[stage];
+            if (!ticks) continue;
+
+            if (previous) {
+                mStage_latency[stage].record(ticks > previous ? ticks - previous
+                                                              : 0);
+            } else {
+                first = ticks;
+            }
+            previous = ticks;
+        }
+        if (previous != first) mTotal_latency.record(previous - first);
+    }
+
+    /// \brief Returns the histogram of the time spent reaching a stage from
+    /// the previous stamped stage, in ticks.
+    auto stageLatency(TraceStage stage) const noexcept
+        -> const LatencyHistogram & {
+        return mStage_latency[static_cast<size_t>(stage)];
+    }
+
+    /// \brief Returns the histogram of the time from the first to the last
+    /// stamped stage, in ticks.
+    auto totalLatency() const noexcept -> const LatencyHistogram & {
+        return mTotal_latency;
+    }
+
+    /// \brief Writes a table of the per-stage percentiles in nanoseconds.
+    /// Safe to call from any thread while updates are being recorded.
+    /// \param os The stream to write to.
+    auto dump(std::ostream &os) const -> void {
+        os << std::left << std::setw(20) << "stage" << std::right
+           << std::setw(12) << "count" << std::setw(10) << "p50 ns"
+           << std::setw(10) << "p99 ns" << std::setw(10) << "p99.9 ns"
+           << std::setw(12) << "max ns" << "\n";
+        for (size_t stage = 0; stage < TRACE_STAGE_COUNT; ++stage) {
+            if (mStage_latency[stage].count()) {
+                dumpRow(os,
+                        traceStageToString(static_cast<TraceStage>(stage)),
+                        mStage_latency[stage]);
+            }
+        }
+        dumpRow(os, "TOTAL", mTotal_latency);
+    }
+
+    // Deleted copy & move constructors and assignment-operators.
+    LatencyTracer(const LatencyTracer &) = delete;
+    LatencyTracer(const LatencyTracer &&) = delete;
+    LatencyTracer &operator=(const LatencyTracer &) = delete;
+    LatencyTracer &operator=(const LatencyTracer &&) = delete;
+
+   private:
+    /// \brief Writes one row of the dump.
+    static auto dumpRow(std::ostream &os, const std::string &name,
+                        const LatencyHistogram &histogram) -> void {
+        os << std::left << std::setw(20) << name << std::right
+           << std::setw(12) << histogram.count() << std::setw(10)
+           << TscClock::toNanos(histogram.percentile(50.0)) << std::setw(10)
+           << TscClock::toNanos(histogram.percentile(99.0)) << std::setw(10)
+           << TscClock::toNanos(histogram.percentile(99.9)) << std::setw(12)
+           << TscClock::toNanos(histogram.max()) << "\n";
+    }
+
+    /// \brief Time to reach every stage from the previous stamped stage.
+    std::array<LatencyHistogram, TRACE_STAGE_COUNT> mStage_latency;
+    /// \brief Time from the first to the last stamped stage.
+    LatencyHistogram mTotal_latency;
+};
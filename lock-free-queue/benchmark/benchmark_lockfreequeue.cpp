@@ -0,0 +1,119 @@
+/// \file benchmark_lockfreequeue.cpp
+/// \brief Latency and throughput of the LockFreeQueue.
+/// \details Measures the cost of a write and read on the same thread, the
+/// throughput of a producer streaming to a consumer thread, and the round trip
+/// latency of a ping-pong between two threads over a pair of queues. Pin the
+/// threads to two cores of the same socket with --cpu and --peer-cpu for
+/// stable cross-thread numbers.
+
+#include <atomic>
+#include <thread>
+
+#include "lock-free-queue/lockfreequeue.h"
+#include "market-orders/marketupdate.h"
+#include "micro-benchmark/microbenchmark.h"
+
+/// \brief Number of operations per repetition.
+constexpr size_t NUM_OPERATIONS = 1'000'000;
+
+/// \brief Number of round trips per ping-pong repetition.
+constexpr size_t NUM_ROUND_TRIPS = 100'000;
+
+/// \brief Waits for an element to become readable. Spins briefly, then yields
+/// so that the benchmark still completes when both threads share a core.
+template <typename T>
+auto waitForRead(const LockFreeQueue<T> &queue) noexcept -> const T * {
+    for (size_t spins = 0;; ++spins) {
+        if (const auto element = queue.getNextRead()) return element;
+        if (spins > 1'000) std::this_thread::yield();
+    }
+}
+
+/// \brief Main function running the lock free queue benchmarks.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    MicroBenchmark benchmark(argc, argv);
+    const auto peer_cpu = benchmark.options().peer_cpu;
+
+    {
+        LockFreeQueue<MEMarketUpdate> queue(ME_MAX_MARKET_UPDATES);
+        benchmark.run("write+read same thread", NUM_OPERATIONS, [&]() {
+            for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+                auto update = queue.getNextWrite();
+                update->order_id = i;
+                queue.updateWriteIndex();
+                doNotOptimize(queue.getNextRead()->order_id);
+                queue.updateReadIndex();
+            }
+        });
+    }
+
+    {
+        // The consumer drains the queue for as long as the producer streams.
+        LockFreeQueue<MEMarketUpdate> queue(ME_MAX_MARKET_UPDATES);
+        std::atomic<bool> running = {true};
+        std::thread consumer([&]() {
+            pinThread(peer_cpu);
+            uint64_t checksum = 0;
+            while (running.load(std::memory_order_acquire) || queue.size()) {
+                if (const auto update = queue.getNextRead()) {
+                    checksum += update->order_id;
+                    queue.updateReadIndex();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            doNotOptimize(checksum);
+        });
+
+        benchmark.run("stream to consumer thread", NUM_OPERATIONS, [&]() {
+            for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+                while (queue.size() == ME_MAX_MARKET_UPDATES) {
+                    std::this_thread::yield();
+                }
+                queue.getNextWrite()->order_id = i;
+                queue.updateWriteIndex();
+            }
+            while (queue.size()) std::this_thread::yield();
+        });
+
+        running.store(false, std::memory_order_release);
+        consumer.join();
+    }
+
+    {
+        // Every ping is echoed back by the peer, one round trip per operation.
+        LockFreeQueue<MEMarketUpdate> pings(1024);
+        LockFreeQueue<MEMarketUpdate> pongs(1024);
+        std::atomic<bool> running = {true};
+        std::thread peer([&]() {
+            pinThread(peer_cpu);
+            size_t spins = 0;
+            while (running.load(std::memory_order_acquire)) {
+                const auto ping = pings.getNextRead();
+                if (!ping) {
+                    if (++spins > 1'000) std::this_thread::yield();
+                    continue;
+                }
+                spins = 0;
+                *pongs.getNextWrite() = *ping;
+                pings.updateReadIndex();
+                pongs.updateWriteIndex();
+            }
+        });
+
+        benchmark.run("ping-pong round trip", NUM_ROUND_TRIPS, [&]() {
+            for (size_t i = 0; i < NUM_ROUND_TRIPS; ++i) {
+                pings.getNextWrite()->order_id = i;
+                pings.updateWriteIndex();
+                doNotOptimize(waitForRead(pongs)->order_id);
+                pongs.updateReadIndex();
+            }
+        });
+
+        running.store(false, std::memory_order_release);
+        peer.join();
+    }
+
+    return 0;
+}
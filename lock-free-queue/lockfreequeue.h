@@ -56,6 +56,10 @@ class LockFreeQueue final {
         return mSize.load();
     }
 
+    /// \brief Returns the maximum number of elements the queue can hold.
+    /// \return The capacity the queue was constructed with.
+    auto capacity() const noexcept { return mStore.size(); }
+
     // Deleted default, copy & move constructors and assignment-operators.
     LockFreeQueue() = delete;
     LockFreeQueue(const LockFreeQueue &) = delete;
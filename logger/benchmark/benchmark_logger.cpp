@@ -0,0 +1,68 @@
+/// \file benchmark_logger.cpp
+/// \brief Hot thread cost of the asynchronous Logger.
+/// \details Measures what the hot thread pays per statement when logging a
+/// market update through the Logger, and the same statement formatted with
+/// MEMarketUpdate::toString and written to an std::ofstream on the hot thread.
+
+#include <filesystem>
+#include <fstream>
+
+#include "logger/logger.h"
+#include "micro-benchmark/microbenchmark.h"
+
+/// \brief Number of statements logged per repetition.
+constexpr size_t NUM_OPERATIONS = 10'000;
+
+/// \brief Main function running the logger benchmarks.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    MicroBenchmark benchmark(argc, argv);
+    const auto directory = std::filesystem::temp_directory_path();
+
+    MEMarketUpdate update;
+    update.type = MarketUpdateType::ADD;
+    update.order_id = 1234;
+    update.ticker_id = 3;
+    update.side = Side::BUY;
+    update.price = 100'25;
+    update.qty = 500;
+    update.priority = 42;
+
+    {
+        const auto path = (directory / "benchmark_logger.log").string();
+        // Room for every statement of every repetition, so the measurement
+        // never depends on how quickly the logger thread drains the queue.
+        const auto &options = benchmark.options();
+        Logger logger(path, LogFullPolicy::DROP,
+                      (options.warmup + options.repetitions) * NUM_OPERATIONS);
+        benchmark.run("Logger::log market update", NUM_OPERATIONS, [&]() {
+            for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+                update.order_id = i;
+                logger.log("% ticker:% oid:% side:% qty:% price:% priority:%",
+                           update.type, update.ticker_id, update.order_id,
+                           update.side, update.qty, update.price,
+                           update.priority);
+            }
+        });
+        logger.stop();
+        std::cout << "logger wrote " << logger.recordsWritten()
+                  << " records, dropped " << logger.recordsDropped()
+                  << std::endl;
+        std::filesystem::remove(path);
+    }
+
+    {
+        const auto path = (directory / "benchmark_logger.txt").string();
+        std::ofstream file(path, std::ios::trunc);
+        benchmark.run("toString to ofstream", NUM_OPERATIONS, [&]() {
+            for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+                update.order_id = i;
+                file << update.toString() << '\n';
+            }
+        });
+        file.close();
+        std::filesystem::remove(path);
+    }
+
+    return 0;
+}
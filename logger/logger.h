@@ -0,0 +1,431 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#include "lock-free-queue/lockfreequeue.h"
+#include "market-orders/marketupdate.h"
+#include "utilities/macros.h"
+#include "utilities/tscclock.h"
+#include "utilities/types.h"
+
+/// \brief Maximum number of arguments of a single log record.
+constexpr size_t LOG_MAX_ARGS = 8;
+
+/// \brief Bytes of a log record the string arguments are copied into, longer
+/// strings are truncated.
+constexpr size_t LOG_MAX_TEXT = 64;
+
+/// \brief Default capacity of the queue between the hot thread and the
+/// logger thread, in records.
+constexpr size_t LOG_QUEUE_SIZE = 64 * 1024;
+
+/// \brief Size of the buffer formatted records are collected in before they
+/// are written to the file with a single system call.
+constexpr size_t LOG_WRITE_BUFFER_SIZE = 64 * 1024;
+
+/// \enum LogArgType
+/// \brief Type of a raw argument stored in a LogRecord.
+enum class LogArgType : uint8_t {
+    NONE = 0,
+    CHAR = 1,
+    BOOL = 2,
+    INTEGER = 3,
+    UNSIGNED = 4,
+    DOUBLE = 5,
+    STRING = 6,
+    SIDE = 7,
+    MARKET_UPDATE_TYPE = 8
+};
+
+/// \enum LogFullPolicy
+/// \brief What the hot thread does when the logger queue is full.
+enum class LogFullPolicy : uint8_t {
+    /// The record is dropped and counted, the hot thread never waits.
+    DROP = 0,
+    /// The hot thread spins until the logger thread frees a slot.
+    BLOCK = 1
+};
+
+/// \struct LogRecord
+/// \brief A log statement as pushed by the hot thread, unformatted.
+///
+/// The format string is identified by its address, so it must be a string
+/// literal or otherwise outlive the logger. Arguments are kept in their raw
+/// binary form together with their type and are only turned into text by the
+/// logger thread. String arguments are copied into the record, so they only
+/// need to live until log() returns.
+struct LogRecord {
+    /// Time stamp counter when the statement was logged.
+    uint64_t ticks = 0;
+    /// Format string, every '%' is replaced by the next argument.
+    const char *format = nullptr;
+    /// Number of arguments.
+    uint8_t arg_count = 0;
+    /// Type of every argument.
+    std::array<LogArgType, LOG_MAX_ARGS> arg_types = {};
+    /// Raw value of every argument, the offset and length in text of a
+    /// string argument.
+    std::array<uint64_t, LOG_MAX_ARGS> args = {};
+    /// Number of bytes of text used.
+    uint8_t text_length = 0;
+    /// Bytes of the string arguments.
+    std::array<char, LOG_MAX_TEXT> text;
+};
+
+/// \brief Low latency logger that moves formatting and file I/O off the hot
+/// thread.
+///
+/// log() stamps the statement with the time stamp counter and copies the
+/// format string address and the raw arguments into a LockFreeQueue, which
+/// costs tens of nanoseconds and never allocates. A background thread drains
+/// the queue, formats the records into a buffer and writes the buffer to the
+/// file in large batches.
+///
+/// The queue has a single producer, every hot thread needs its own Logger.
+/// When the queue is full the record is either dropped and counted, or the
+/// hot thread waits for the logger thread, depending on the LogFullPolicy.
+///
+/// Formats use '%' as the placeholder for the next argument and "%%" for a
+/// literal '%'. Supported arguments are characters, bools, integers, floating
+/// point numbers, Side, MarketUpdateType and strings, which are copied into
+/// the record up to LOG_MAX_TEXT bytes in total.
+///
+/// Time stamps are converted with the TscClock rate, TscClock::calibrate()
+/// must be called at process start up before the first Logger is created.
+class Logger final {
+   public:
+    /// \brief Opens the log file and starts the logger thread.
+    /// \param file_name Path of the log file, appended to if it exists.
+    /// \param policy What log() does when the queue is full.
+    /// \param queue_size Capacity of the queue in records.
+    explicit Logger(const std::string &file_name,
+                    LogFullPolicy policy = LogFullPolicy::DROP,
+                    size_t queue_size = LOG_QUEUE_SIZE)
+        : mFile_name(file_name), mPolicy(policy), mQueue(queue_size) {
+        mFd = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        ASSERT(mFd >= 0, "Unable to open log file:" + file_name);
+
+        // Time stamps are rendered as wall clock time relative to this point.
+        mStart_ticks = TscClock::now();
+        mStart_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+
+        mRunning = true;
+        mThread = std::thread([this] { run(); });
+    }
+
+    /// \brief Writes the remaining records and closes the file.
+    ~Logger() { stop(); }
+
+    /// \brief Logs a statement from the hot thread.
+    /// \param format Format string literal, '%' is replaced by the next
+    /// argument.
+    /// \param args Raw arguments, at most LOG_MAX_ARGS.
+    /// \return false if the record was dropped because the queue was full.
+    template <typename... Args>
+    auto log(const char *format, const Args &...args) noexcept -> bool {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS,
+                      "Too many arguments for a single log record.");
+
+        if (mQueue.size() == mQueue.capacity()) [[unlikely]] {
+            if (mPolicy == LogFullPolicy::DROP) {
+                mRecords_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            while (mQueue.size() == mQueue.capacity()) {
+            }
+        }
+
+        auto record = mQueue.getNextWrite();
+        record->ticks = TscClock::now();
+        record->format = format;
+        record->arg_count = static_cast<uint8_t>(sizeof...(Args));
+        record->text_length = 0;
+        size_t index = 0;
+        (encode(*record, index++, args), ...);
+        mQueue.updateWriteIndex();
+        return true;
+    }
+
+    /// \brief Writes the remaining records, stops the logger thread and closes
+    /// the file. Must not race with log().
+    auto stop() -> void {
+        if (!mThread.joinable()) return;
+
+        mRunning = false;
+        mThread.join();
+        ::close(mFd);
+        mFd = -1;
+    }
+
+    /// \brief Returns the number of records dropped because the queue was
+    /// full.
+    auto recordsDropped() const noexcept {
+        return mRecords_dropped.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the number of records written to the file.
+    auto recordsWritten() const noexcept {
+        return mRecords_written.load(std::memory_order_relaxed);
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    Logger() = delete;
+    Logger(const Logger &) = delete;
+    Logger(const Logger &&) = delete;
+    Logger &operator=(const Logger &) = delete;
+    Logger &operator=(const Logger &&) = delete;
+
+   private:
+    /// \brief Stores one argument in its raw form.
+    template <typename T>
+    static auto encode(LogRecord &record, size_t index,
+                       const T &value) noexcept -> void {
+        auto &type = record.arg_types[index];
+        auto &raw = record.args[index];
+
+        if constexpr (std::is_same_v<T, char>) {
+            type = LogArgType::CHAR;
+            raw = static_cast<unsigned char>(value);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            type = LogArgType::BOOL;
+            raw = value;
+        } else if constexpr (std::is_same_v<T, Side>) {
+            type = LogArgType::SIDE;
+            raw = static_cast<uint64_t>(static_cast<int8_t>(value));
+        } else if constexpr (std::is_same_v<T, MarketUpdateType>) {
+            type = LogArgType::MARKET_UPDATE_TYPE;
+            raw = static_cast<uint64_t>(value);
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            type = LogArgType::INTEGER;
+            raw = static_cast<uint64_t>(static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral_v<T>) {
+            type = LogArgType::UNSIGNED;
+            raw = static_cast<uint64_t>(value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            type = LogArgType::DOUBLE;
+            const auto as_double = static_cast<double>(value);
+            std::memcpy(&raw, &as_double, sizeof(raw));
+        } else if constexpr (std::is_convertible_v<T, const char *>) {
+            const auto text = static_cast<const char *>(value);
+            encodeText(record, type, raw, text ? text : "(null)");
+        } else if constexpr (std::is_convertible_v<T, std::string_view>) {
+            encodeText(record, type, raw, std::string_view(value));
+        } else {
+            static_assert(!sizeof(T), "Unsupported log argument type.");
+        }
+    }
+
+    /// \brief Copies a string argument into the text of the record.
+    static auto encodeText(LogRecord &record, LogArgType &type, uint64_t &raw,
+                           std::string_view text) noexcept -> void {
+        const auto offset = record.text_length;
+        const auto length = std::min(text.size(), LOG_MAX_TEXT - offset);
+        std::memcpy(record.text.data() + offset, text.data(), length);
+        record.text_length = static_cast<uint8_t>(offset + length);
+        type = LogArgType::STRING;
+        raw = offset | static_cast<uint64_t>(length) << 32;
+    }
+
+    /// \brief Logger thread main loop. Formats everything queued into the
+    /// write buffer and writes it out once the queue is drained or the buffer
+    /// is nearly full.
+    auto run() noexcept -> void {
+        while (true) {
+            // Read the flag before draining so the final pass sees everything
+            // logged before stop() was called.
+            const auto running = mRunning.load(std::memory_order_acquire);
+
+            size_t formatted = 0;
+            while (auto record = mQueue.getNextRead()) {
+                format(*record);
+                mQueue.updateReadIndex();
+                ++formatted;
+                if (mBuffer_length > LOG_WRITE_BUFFER_SIZE - MAX_LINE_LENGTH)
+                    flush();
+            }
+            flush();
+            mRecords_written.fetch_add(formatted, std::memory_order_relaxed);
+
+            if (!formatted) {
+                if (!running) break;
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    /// \brief Formats a record as one line at the end of the write buffer,
+    /// truncating it at MAX_LINE_LENGTH.
+    auto format(const LogRecord &record) noexcept -> void {
+        auto out = mBuffer.data() + mBuffer_length;
+        const auto end = out + MAX_LINE_LENGTH - 1;
+
+        out = formatTimestamp(out, record.ticks);
+        *out++ = ' ';
+
+        size_t arg = 0;
+        for (auto in = record.format; *in && out < end; ++in) {
+            if (*in != '%') {
+                *out++ = *in;
+            } else if (in[1] == '%') {
+                *out++ = '%';
+                ++in;
+            } else if (arg < record.arg_count) {
+                out = formatArg(out, end, record, arg);
+                ++arg;
+            } else {
+                *out++ = '?';
+            }
+        }
+        *out++ = '\n';
+        mBuffer_length = out - mBuffer.data();
+    }
+
+    /// \brief Renders a time stamp counter reading as local wall clock time
+    /// with nanoseconds, "YYYY-MM-DD HH:MM:SS.nnnnnnnnn".
+    auto formatTimestamp(char *out, uint64_t ticks) noexcept -> char * {
+        const auto elapsed_ns = static_cast<int64_t>(
+            TscClock::ticksToNanos(ticks - mStart_ticks));
+        const auto ns = mStart_ns + elapsed_ns;
+        const auto seconds = static_cast<time_t>(ns / 1'000'000'000);
+
+        // The date and time only change once a second, cache their text.
+        if (seconds != mCached_second) {
+            tm local_time;
+            localtime_r(&seconds, &local_time);
+            std::strftime(mCached_time, sizeof(mCached_time),
+                          "%Y-%m-%d %H:%M:%S", &local_time);
+            mCached_second = seconds;
+        }
+        constexpr size_t TIME_LENGTH = 19;
+        std::memcpy(out, mCached_time, TIME_LENGTH);
+        out += TIME_LENGTH;
+
+        *out++ = '.';
+        auto fraction = static_cast<uint64_t>(ns % 1'000'000'000);
+        for (int digit = 8; digit >= 0; --digit) {
+            out[digit] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        return out + 9;
+    }
+
+    /// \brief Renders a single argument.
+    static auto formatArg(char *out, char *end, const LogRecord &record,
+                          size_t arg) noexcept -> char * {
+        const auto raw = record.args[arg];
+        switch (record.arg_types[arg]) {
+            case LogArgType::CHAR:
+                *out++ = static_cast<char>(raw);
+                return out;
+            case LogArgType::BOOL:
+                return copy(out, end, raw ? "true" : "false");
+            case LogArgType::INTEGER:
+                return number(out, end, static_cast<int64_t>(raw));
+            case LogArgType::UNSIGNED:
+                return number(out, end, raw);
+            case LogArgType::DOUBLE: {
+                double value;
+                std::memcpy(&value, &raw, sizeof(value));
+                return number(out, end, value);
+            }
+            case LogArgType::STRING: {
+                const auto length = std::min<size_t>(raw >> 32, end - out);
+                std::memcpy(out, record.text.data() + (raw & UINT32_MAX),
+                            length);
+                return out + length;
+            }
+            case LogArgType::SIDE:
+                return out + sideToChars(out, end,
+                                         static_cast<Side>(
+                                             static_cast<int8_t>(raw)));
+            case LogArgType::MARKET_UPDATE_TYPE:
+                return out + marketUpdateTypeToChars(
+                                 out, end, static_cast<MarketUpdateType>(raw));
+            case LogArgType::NONE:
+                break;
+        }
+        return out;
+    }
+
+    /// \brief Renders a number, or a '~' if it does not fit before end, as
+    /// a cut number would read as a different value.
+    template <typename T>
+    static auto number(char *out, char *end, T value) noexcept -> char * {
+        const auto [ptr, ec] = std::to_chars(out, end, value);
+        if (ec != std::errc()) [[unlikely]] {
+            *out = '~';
+            return out + 1;
+        }
+        return ptr;
+    }
+
+    /// \brief Copies a string, stopping at end.
+    static auto copy(char *out, char *end, const char *text) noexcept
+        -> char * {
+        while (*text && out < end) *out++ = *text++;
+        return out;
+    }
+
+    /// \brief Writes the buffer to the file.
+    auto flush() noexcept -> void {
+        size_t offset = 0;
+        while (offset < mBuffer_length) {
+            const auto written = ::write(mFd, mBuffer.data() + offset,
+                                         mBuffer_length - offset);
+            if (written <= 0) [[unlikely]] break;
+            offset += static_cast<size_t>(written);
+        }
+        mBuffer_length = 0;
+    }
+
+    /// \brief Longest line written, longer lines are truncated.
+    static constexpr size_t MAX_LINE_LENGTH = 1024;
+
+    /// \brief Path of the log file.
+    const std::string mFile_name;
+    /// \brief What log() does when the queue is full.
+    const LogFullPolicy mPolicy;
+    /// \brief Records pushed by the hot thread, drained by the logger thread.
+    LockFreeQueue<LogRecord> mQueue;
+    /// \brief The log file.
+    int mFd = -1;
+
+    /// \brief Time stamp counter and wall clock time in nanoseconds since the
+    /// epoch when the logger started.
+    uint64_t mStart_ticks = 0;
+    int64_t mStart_ns = 0;
+    /// \brief Second and text of the last formatted date and time.
+    time_t mCached_second = -1;
+    char mCached_time[32] = {};
+
+    /// \brief Formatted lines waiting to be written.
+    std::array<char, LOG_WRITE_BUFFER_SIZE> mBuffer;
+    /// \brief Number of bytes in mBuffer.
+    size_t mBuffer_length = 0;
+
+    /// \brief Records dropped because the queue was full.
+    std::atomic<size_t> mRecords_dropped = {0};
+    /// \brief Records written to the file.
+    std::atomic<size_t> mRecords_written = {0};
+
+    /// \brief Cleared to ask the logger thread to drain and exit.
+    std::atomic<bool> mRunning = {false};
+    /// \brief The logger thread.
+    std::thread mThread;
+};
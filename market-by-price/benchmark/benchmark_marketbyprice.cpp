@@ -0,0 +1,195 @@
+/// \file benchmark_marketbyprice.cpp
+/// \brief Fan-out bandwidth and consumer cost of the market-by-price feed
+/// against the raw market-by-order updates.
+/// \details Replays synthetic L3 order flow in batches through the books and
+/// the MarketByPriceBuilder. A consumer applies the emitted L2 updates to its
+/// MarketByPriceBooks, which are checked against the top levels of the L3
+/// books after every batch. A consumer losing one L2 update in 997 and one
+/// joining halfway must match the books again within the refresh bound after
+/// the flow. Then reports the messages and bytes sent both
+/// ways, the cost of deriving the feed, and what a consumer spends applying
+/// the L2 feed compared to rebuilding the L3 books.
+///
+/// Usage: MarketByPriceBenchmark [--updates N] [--tickers N] [--batch N]
+///                               [--depth N] [--seed N] [harness options]
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "market-by-price/marketbypricebuilder.h"
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowbooks.h"
+
+/// \brief Exits if a consumer's levels differ from the top of the L3 book.
+auto checkLevels(const MarketOrderBook &book, const MarketByPriceBook &levels,
+                 size_t depth) {
+    for (const auto side : {Side::BUY, Side::SELL}) {
+        size_t index = 0;
+        const auto best = book.getBestLevel(side);
+        for (auto level = best; level && index < depth; ++index) {
+            if (index >= levels.depth(side) ||
+                levels.level(side, index).price != level->mPrice ||
+                levels.level(side, index).qty != level->mTotal_qty ||
+                levels.level(side, index).order_count != level->mOrder_count)
+                [[unlikely]] {
+                FATAL("Ticker " + std::to_string(book.tickerId()) + " " +
+                      sideToString(side) + " level " + std::to_string(index) +
+                      " differs from the book " + level->toString());
+            }
+            level = level->mNext_entry;
+            if (level == best) level = nullptr;
+        }
+        if (index != levels.depth(side)) [[unlikely]] {
+            FATAL("Ticker " + std::to_string(book.tickerId()) + " " +
+                  sideToString(side) + " has extra levels");
+        }
+    }
+}
+
+/// \brief Main function running the market-by-price benchmark.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    size_t updates = 2'000'000;
+    TickerId tickers = 4;
+    size_t batch = 256;
+    size_t depth = 10;
+    uint64_t seed = 42;
+    setUpBenchmarkThread(parseBenchmarkOptions(argc, argv,
+                                               {{"--updates", updates},
+                                                {"--tickers", tickers},
+                                                {"--batch", batch, 1},
+                                                {"--depth", depth},
+                                                {"--seed", seed}}));
+
+    OrderFlowConfig config;
+    config.seed = seed;
+    config.num_tickers = tickers;
+    OrderFlowGenerator generator(config);
+    const auto flow = generateOrderFlow(generator, updates);
+    OrderFlowBooks books(tickers);
+
+    MarketByPriceConfig mbp_config;
+    mbp_config.depth = depth;
+
+    // Derives the feed once, checking the consumer's view after every batch
+    // and keeping the L2 stream for the consumer timing.
+    std::vector<MBPUpdate> mbp_flow;
+    {
+        auto builder =
+            std::make_unique<MarketByPriceBuilder>(books.books(), mbp_config);
+        std::array<MarketByPriceBook, ME_MAX_TICKERS> consumer;
+        std::array<MarketByPriceBook, ME_MAX_TICKERS> lossy;
+        std::array<MarketByPriceBook, ME_MAX_TICKERS> late;
+        for (auto &book : late) {
+            book.markStale(Side::BUY);
+            book.markStale(Side::SELL);
+        }
+        for (size_t start = 0; start < flow.size(); start += batch) {
+            const auto end = std::min(flow.size(), start + batch);
+            for (auto i = start; i < end; ++i) {
+                books.onMarketUpdate(&flow[i]);
+                builder->onMarketUpdate(&flow[i]);
+            }
+            builder->flush([&](const MBPUpdate &update) {
+                consumer[update.ticker_id].onUpdate(update);
+                if (mbp_flow.size() % 997) {
+                    lossy[update.ticker_id].onUpdate(update);
+                }
+                if (start >= flow.size() / 2) {
+                    late[update.ticker_id].onUpdate(update);
+                }
+                mbp_flow.push_back(update);
+            });
+            for (TickerId ticker_id = 0; ticker_id < tickers;
+                 ++ticker_id) {
+                checkLevels(books[ticker_id], consumer[ticker_id],
+                            depth);
+            }
+        }
+
+        // Every ticker is refreshed within refresh_interval flushes per
+        // ticker, after which the lossy and late consumers match the books.
+        for (size_t flush = 0; flush < mbp_config.refresh_interval * tickers;
+             ++flush) {
+            builder->flush([&](const MBPUpdate &update) {
+                lossy[update.ticker_id].onUpdate(update);
+                late[update.ticker_id].onUpdate(update);
+            });
+        }
+        for (TickerId ticker_id = 0; ticker_id < tickers; ++ticker_id) {
+            ASSERT(!consumer[ticker_id].gaps(),
+                   "Ticker " + std::to_string(ticker_id) +
+                       " has gaps in an unbroken feed.");
+            checkLevels(books[ticker_id], lossy[ticker_id], depth);
+            checkLevels(books[ticker_id], late[ticker_id], depth);
+        }
+        books.clear();
+    }
+
+    const auto time = [](auto &&pass) {
+        const auto start = std::chrono::steady_clock::now();
+        pass();
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    };
+
+    // Producer side: the books alone, then the books deriving the feed.
+    const auto books_ns = time([&]() {
+        for (const auto &update : flow) {
+            books.onMarketUpdate(&update);
+        }
+    });
+    books.clear();
+
+    size_t sink_checksum = 0;
+    const auto builder_ns = time([&]() {
+        auto builder =
+            std::make_unique<MarketByPriceBuilder>(books.books(), mbp_config);
+        for (size_t start = 0; start < flow.size(); start += batch) {
+            const auto end = std::min(flow.size(), start + batch);
+            for (auto i = start; i < end; ++i) {
+                books.onMarketUpdate(&flow[i]);
+                builder->onMarketUpdate(&flow[i]);
+            }
+            builder->flush([&](const MBPUpdate &update) {
+                sink_checksum += update.qty;
+            });
+        }
+    });
+    books.clear();
+
+    // Consumer side: the L2 stream against rebuilding the books, which is
+    // what the L3 stream costs every consumer.
+    std::array<MarketByPriceBook, ME_MAX_TICKERS> consumer;
+    const auto consumer_ns = time([&]() {
+        for (const auto &update : mbp_flow) {
+            consumer[update.ticker_id].onUpdate(update);
+        }
+    });
+    ASSERT(sink_checksum, "The feed emitted nothing.");
+
+    const auto l3_bytes = flow.size() * sizeof(MEMarketUpdate);
+    const auto l2_bytes = mbp_flow.size() * sizeof(MBPUpdate);
+    std::cout << std::fixed << std::setprecision(2) << "replayed "
+              << flow.size() << " L3 updates over " << tickers
+              << " tickers in batches of " << batch << ", depth "
+              << depth << std::endl;
+    std::cout << "L3 " << flow.size() << " msgs " << l3_bytes << " bytes, L2 "
+              << mbp_flow.size() << " msgs " << l2_bytes << " bytes, "
+              << static_cast<double>(flow.size()) / mbp_flow.size()
+              << "x fewer msgs "
+              << static_cast<double>(l3_bytes) / l2_bytes << "x fewer bytes"
+              << std::endl;
+    std::cout << "producer books " << books_ns / flow.size()
+              << " ns/L3 msg, books+builder " << builder_ns / flow.size()
+              << " ns/L3 msg" << std::endl;
+    std::cout << "consumer L3 rebuild " << books_ns / flow.size()
+              << " ns/L3 msg, L2 apply " << consumer_ns / flow.size()
+              << " ns/L3 msg (" << consumer_ns / mbp_flow.size()
+              << " ns/L2 msg)" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+
+#include "market-by-price/mbpupdate.h"
+#include "market-orders/marketorder.h"
+#include "utilities/types.h"
+
+/// \struct MBPLevel
+/// \brief An aggregated price level of a market-by-price book.
+struct MBPLevel {
+    /// Price of the level.
+    Price price = Price_INVALID;
+    /// Total quantity of the orders at the level.
+    Qty qty = 0;
+    /// Number of orders at the level.
+    uint32_t order_count = 0;
+};
+
+/// \brief Aggregated price levels of a single ticker, as maintained by a
+/// consumer of the market-by-price feed.
+///
+/// Each side is a small array of at most MBP_MAX_DEPTH levels ordered from
+/// the best price, updated by index as the incremental updates describe. The
+/// whole book fits a few cache lines, and applying an update is at most one
+/// short memmove, far cheaper than rebuilding a MarketOrderBook from every
+/// order event.
+///
+/// An update whose level index or price does not match the book, as after a
+/// lost update, marks its side stale and counts a gap. A stale side drops
+/// its updates until the next full depth refresh of the ticker rebuilds it.
+class MarketByPriceBook final {
+   public:
+    /// \brief Constructs an empty MarketByPriceBook.
+    MarketByPriceBook() = default;
+
+    /// \brief Applies an update of this book's ticker.
+    /// \param update The update. One inconsistent with the book marks its
+    /// side stale, which it never is for an unbroken feed.
+    auto onUpdate(const MBPUpdate &update) noexcept -> void {
+        switch (update.type) {
+            case MBPUpdateType::NEW_LEVEL: {
+                const auto slot = sideSlot(update.side);
+                auto &levels = mLevels[slot];
+                auto &depth = mDepth[slot];
+                if (mStale[slot]) [[unlikely]] break;
+                if (update.level > depth || update.level >= MBP_MAX_DEPTH)
+                    [[unlikely]] {
+                    markStale(update.side);
+                    break;
+                }
+                // The worst level falls off a full book.
+                const auto moved =
+                    std::min(depth, MBP_MAX_DEPTH - 1) - update.level;
+                std::memmove(&levels[update.level + 1], &levels[update.level],
+                             moved * sizeof(MBPLevel));
+                levels[update.level] = {update.price, update.qty,
+                                        update.order_count};
+                depth = std::min(depth + 1, MBP_MAX_DEPTH);
+            } break;
+            case MBPUpdateType::CHANGE_LEVEL: {
+                const auto slot = sideSlot(update.side);
+                if (mStale[slot]) [[unlikely]] break;
+                if (update.level >= mDepth[slot] ||
+                    mLevels[slot][update.level].price != update.price)
+                    [[unlikely]] {
+                    markStale(update.side);
+                    break;
+                }
+                auto &level = mLevels[slot][update.level];
+                level.qty = update.qty;
+                level.order_count = update.order_count;
+            } break;
+            case MBPUpdateType::DELETE_LEVEL: {
+                const auto slot = sideSlot(update.side);
+                auto &levels = mLevels[slot];
+                auto &depth = mDepth[slot];
+                if (mStale[slot]) [[unlikely]] break;
+                if (update.level >= depth ||
+                    levels[update.level].price != update.price) [[unlikely]] {
+                    markStale(update.side);
+                    break;
+                }
+                std::memmove(&levels[update.level], &levels[update.level + 1],
+                             (depth - update.level - 1) * sizeof(MBPLevel));
+                --depth;
+            } break;
+            case MBPUpdateType::REFRESH_START:
+                // The levels of the refresh rebuild both sides.
+                clear();
+                mStale = {false, false};
+                break;
+            case MBPUpdateType::REFRESH_END:
+            case MBPUpdateType::INVALID:
+                // These update types require no processing
+                break;
+        }
+    }
+
+    /// \brief Empties a side and drops its updates until the next refresh,
+    /// e.g. for a consumer joining a running feed.
+    auto markStale(Side side) noexcept -> void {
+        mStale[sideSlot(side)] = true;
+        mDepth[sideSlot(side)] = 0;
+        ++mGaps;
+    }
+
+    /// \brief Returns whether a side waits for a refresh.
+    auto stale(Side side) const noexcept { return mStale[sideSlot(side)]; }
+
+    /// \brief Returns the number of times a side was marked stale.
+    auto gaps() const noexcept { return mGaps; }
+
+    /// \brief Removes every level of both sides.
+    auto clear() noexcept -> void { mDepth = {0, 0}; }
+
+    /// \brief Returns the number of levels of a side.
+    auto depth(Side side) const noexcept { return mDepth[sideSlot(side)]; }
+
+    /// \brief Returns a level of a side, 0 being the best price.
+    /// \param side Side of the level.
+    /// \param index Index of the level, below depth(side).
+    auto level(Side side, size_t index) const noexcept -> const MBPLevel & {
+        return mLevels[sideSlot(side)][index];
+    }
+
+    /// \brief Returns the best bid and offer, in the form of the order book.
+    auto getBestBidOffer() const noexcept -> BestBidOffer {
+        BestBidOffer bbo;
+        if (depth(Side::BUY)) {
+            bbo.mBid_price = level(Side::BUY, 0).price;
+            bbo.mBid_qty = level(Side::BUY, 0).qty;
+        }
+        if (depth(Side::SELL)) {
+            bbo.mAsk_price = level(Side::SELL, 0).price;
+            bbo.mAsk_qty = level(Side::SELL, 0).qty;
+        }
+        return bbo;
+    }
+
+   private:
+    /// \brief Maps a side to its index in the level arrays.
+    static auto sideSlot(Side side) noexcept -> size_t {
+        return side == Side::BUY ? 0 : 1;
+    }
+
+    /// \brief Levels of the bid and ask side, from the best price.
+    std::array<std::array<MBPLevel, MBP_MAX_DEPTH>, 2> mLevels;
+    /// \brief Number of levels of the bid and ask side.
+    std::array<size_t, 2> mDepth = {0, 0};
+    /// \brief Whether the bid and ask side wait for a refresh.
+    std::array<bool, 2> mStale = {false, false};
+    /// \brief Number of times a side was marked stale.
+    uint64_t mGaps = 0;
+};
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "market-by-price/marketbypricebook.h"
+#include "market-by-price/mbpupdate.h"
+#include "order-book/orderbook.h"
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+/// \struct MarketByPriceConfig
+/// \brief Parameters of the market-by-price feed.
+struct MarketByPriceConfig {
+    /// Number of price levels published per side, at most MBP_MAX_DEPTH.
+    size_t depth = 10;
+    /// Number of flushes between two full depth refreshes, each refreshing
+    /// the next active ticker in turn, 0 disables the refreshes.
+    size_t refresh_interval = 1'000;
+};
+
+/// \brief Derives an incremental market-by-price (L2) feed from the order
+/// books built from the market-by-order (L3) updates.
+///
+/// The owner of the books applies every MEMarketUpdate to its book and then
+/// passes it to onMarketUpdate(), which marks the ticker dirty if the update
+/// can have changed one of the published levels, an update behind the
+/// published depth cannot. At the end of a batch, flush() compares the
+/// current top levels of every dirty book with the levels published so far
+/// and emits the difference as DELETE_LEVEL, NEW_LEVEL and CHANGE_LEVEL
+/// updates by level index. However many order events hit a level within the
+/// batch, consumers receive at most one update for it.
+///
+/// Every refresh_interval flushes the full depth of one ticker is sent again
+/// between REFRESH_START and REFRESH_END, so that late joiners and consumers
+/// that lost updates recover without a request. The refreshes cycle over the
+/// active tickers, those with at least one update observed, so a consumer
+/// recovers within refresh_interval times the number of active tickers
+/// flushes.
+class MarketByPriceBuilder final {
+   public:
+    /// \brief Constructs a MarketByPriceBuilder with nothing published yet.
+    /// \param books The books of the tickers, indexed by TickerId, nullptr
+    /// for tickers that are not traded.
+    /// \param config Parameters of the feed.
+    MarketByPriceBuilder(const MarketOrderBookHashMap &books,
+                         MarketByPriceConfig config)
+        : mBooks(books), mConfig(config) {
+        ASSERT(mConfig.depth && mConfig.depth <= MBP_MAX_DEPTH,
+               "Market-by-price depth must be within [1, " +
+                   std::to_string(MBP_MAX_DEPTH) + "]");
+    }
+
+    /// \brief Observes an update the book of its ticker has just applied.
+    /// \param update The market-by-order update.
+    auto onMarketUpdate(const MEMarketUpdate *update) noexcept -> void {
+        ++mUpdates_in;
+        mActive |= uint64_t{1} << update->ticker_id;
+        switch (update->type) {
+            case MarketUpdateType::ADD:
+            case MarketUpdateType::MODIFY:
+            case MarketUpdateType::CANCEL: {
+                // A published side that is full only changes for updates at
+                // or better than its worst level.
+                const auto &published = mPublished[update->ticker_id];
+                const auto depth = published.depth(update->side);
+                if (depth < mConfig.depth ||
+                    !isBetter(update->side,
+                              published.level(update->side, depth - 1).price,
+                              update->price)) {
+                    mDirty |= uint64_t{1} << update->ticker_id;
+                }
+            } break;
+            case MarketUpdateType::CLEAR:
+                mDirty |= uint64_t{1} << update->ticker_id;
+                break;
+            case MarketUpdateType::TRADE:
+            case MarketUpdateType::INVALID:
+            case MarketUpdateType::SNAPSHOT_START:
+            case MarketUpdateType::SNAPSHOT_END:
+                // These update types do not change the book
+                break;
+        }
+    }
+
+    /// \brief Ends a batch: emits the level changes of every dirty ticker
+    /// and, when due, a full depth refresh.
+    /// \param sink Called with a const reference to every MBPUpdate, e.g. to
+    /// write it into a MBPUpdateLFQueue.
+    /// \return Number of updates emitted.
+    template <typename Sink>
+    auto flush(Sink &&sink) noexcept -> size_t {
+        size_t emitted = 0;
+        for (auto dirty = mDirty; dirty; dirty &= dirty - 1) {
+            const auto ticker_id =
+                static_cast<TickerId>(std::countr_zero(dirty));
+            emitted += diffSide(ticker_id, Side::BUY, sink);
+            emitted += diffSide(ticker_id, Side::SELL, sink);
+        }
+        mDirty = 0;
+
+        if (mConfig.refresh_interval && mActive &&
+            ++mFlushes % mConfig.refresh_interval == 0) {
+            // The first active ticker from the next one in turn, wrapping
+            // around.
+            const auto later = mActive & (~uint64_t{0} << mNext_refresh);
+            const auto next = later ? later : mActive;
+            const auto ticker_id =
+                static_cast<TickerId>(std::countr_zero(next));
+            mNext_refresh = (ticker_id + 1) % ME_MAX_TICKERS;
+            emitted += refresh(ticker_id, sink);
+        }
+        return emitted;
+    }
+
+    /// \brief Sends the full published depth of a ticker.
+    /// \param ticker_id The ticker to refresh.
+    /// \param sink Called with a const reference to every MBPUpdate.
+    /// \return Number of updates emitted.
+    template <typename Sink>
+    auto refresh(TickerId ticker_id, Sink &&sink) noexcept -> size_t {
+        const auto &published = mPublished[ticker_id];
+        MBPUpdate update;
+        update.type = MBPUpdateType::REFRESH_START;
+        update.ticker_id = ticker_id;
+        sink(static_cast<const MBPUpdate &>(update));
+        size_t emitted = 1;
+
+        update.type = MBPUpdateType::NEW_LEVEL;
+        for (const auto side : {Side::BUY, Side::SELL}) {
+            update.side = side;
+            for (size_t index = 0; index < published.depth(side); ++index) {
+                const auto &level = published.level(side, index);
+                update.level = static_cast<uint8_t>(index);
+                update.price = level.price;
+                update.qty = level.qty;
+                update.order_count = level.order_count;
+                sink(static_cast<const MBPUpdate &>(update));
+                ++emitted;
+            }
+        }
+
+        update = {};
+        update.type = MBPUpdateType::REFRESH_END;
+        update.ticker_id = ticker_id;
+        sink(static_cast<const MBPUpdate &>(update));
+        ++emitted;
+
+        mUpdates_out += emitted;
+        return emitted;
+    }
+
+    /// \brief Returns the levels of a ticker as last published, which is
+    /// what every consumer of an unbroken feed holds.
+    auto published(TickerId ticker_id) const noexcept
+        -> const MarketByPriceBook & {
+        return mPublished[ticker_id];
+    }
+
+    /// \brief Returns the number of market-by-order updates observed.
+    auto updatesIn() const noexcept { return mUpdates_in; }
+
+    /// \brief Returns the number of market-by-price updates emitted.
+    auto updatesOut() const noexcept { return mUpdates_out; }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    MarketByPriceBuilder() = delete;
+    MarketByPriceBuilder(const MarketByPriceBuilder &) = delete;
+    MarketByPriceBuilder(const MarketByPriceBuilder &&) = delete;
+    MarketByPriceBuilder &operator=(const MarketByPriceBuilder &) = delete;
+    MarketByPriceBuilder &operator=(const MarketByPriceBuilder &&) = delete;
+
+   private:
+    static_assert(ME_MAX_TICKERS <= 64, "Dirty tickers are a 64 bit mask.");
+
+    /// \brief Returns true if price a is better than price b on a side.
+    static auto isBetter(Side side, Price a, Price b) noexcept -> bool {
+        return side == Side::BUY ? a > b : a < b;
+    }
+
+    /// \brief Emits the updates turning the published levels of one side
+    /// into the current top levels of the book, applying them to the
+    /// published levels as it goes.
+    template <typename Sink>
+    auto diffSide(TickerId ticker_id, Side side, Sink &sink) noexcept
+        -> size_t {
+        // Current top levels of the book.
+        std::array<MBPLevel, MBP_MAX_DEPTH> current;
+        size_t count = 0;
+        const auto best = mBooks[ticker_id]->getBestLevel(side);
+        for (auto level = best; level && count < mConfig.depth;) {
+            current[count++] = {level->mPrice, level->mTotal_qty,
+                                level->mOrder_count};
+            level = level->mNext_entry;
+            if (level == best) break;
+        }
+
+        auto &published = mPublished[ticker_id];
+        size_t emitted = 0;
+
+        // Deletes first, so that the published levels become a subsequence
+        // of the current ones and no index ever exceeds the depth.
+        for (size_t index = 0, next = 0; index < published.depth(side);) {
+            const auto price = published.level(side, index).price;
+            while (next < count && isBetter(side, current[next].price, price))
+                ++next;
+            if (next < count && current[next].price == price) {
+                ++index;
+                ++next;
+            } else {
+                emit(MBPUpdateType::DELETE_LEVEL, ticker_id, side, index,
+                     published.level(side, index), sink);
+                ++emitted;
+            }
+        }
+
+        // Then inserts and changes from the best price down.
+        for (size_t index = 0; index < count; ++index) {
+            if (index < published.depth(side) &&
+                published.level(side, index).price == current[index].price) {
+                const auto &level = published.level(side, index);
+                if (level.qty != current[index].qty ||
+                    level.order_count != current[index].order_count) {
+                    emit(MBPUpdateType::CHANGE_LEVEL, ticker_id, side, index,
+                         current[index], sink);
+                    ++emitted;
+                }
+            } else {
+                emit(MBPUpdateType::NEW_LEVEL, ticker_id, side, index,
+                     current[index], sink);
+                ++emitted;
+            }
+        }
+        return emitted;
+    }
+
+    /// \brief Applies an update to the published levels and sends it.
+    template <typename Sink>
+    auto emit(MBPUpdateType type, TickerId ticker_id, Side side, size_t index,
+              const MBPLevel &level, Sink &sink) noexcept -> void {
+        MBPUpdate update;
+        update.type = type;
+        update.ticker_id = ticker_id;
+        update.side = side;
+        update.level = static_cast<uint8_t>(index);
+        update.price = level.price;
+        update.qty = level.qty;
+        update.order_count = level.order_count;
+        mPublished[ticker_id].onUpdate(update);
+        sink(static_cast<const MBPUpdate &>(update));
+        ++mUpdates_out;
+    }
+
+    /// \brief The books of the tickers, indexed by TickerId.
+    const MarketOrderBookHashMap mBooks;
+    /// \brief Parameters of the feed.
+    const MarketByPriceConfig mConfig;
+
+    /// \brief Levels of every ticker as last published.
+    std::array<MarketByPriceBook, ME_MAX_TICKERS> mPublished;
+    /// \brief One bit per ticker whose levels may have changed in the batch.
+    uint64_t mDirty = 0;
+    /// \brief One bit per ticker with at least one update observed.
+    uint64_t mActive = 0;
+
+    /// \brief Number of flushes, to schedule the refreshes.
+    size_t mFlushes = 0;
+    /// \brief Next ticker to refresh.
+    TickerId mNext_refresh = 0;
+
+    /// \brief Number of market-by-order updates observed.
+    uint64_t mUpdates_in = 0;
+    /// \brief Number of market-by-price updates emitted.
+    uint64_t mUpdates_out = 0;
+};
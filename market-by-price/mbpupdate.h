@@ -0,0 +1,138 @@
+#pragma once
+
+#include <sstream>
+#include <string_view>
+
+#include "lock-free-queue/lockfreequeue.h"
+#include "utilities/tochars.h"
+#include "utilities/types.h"
+
+/// \brief Maximum number of price levels per side of a market-by-price feed.
+constexpr size_t MBP_MAX_DEPTH = 32;
+
+/// \enum MBPUpdateType
+/// \brief Represents the action of a market-by-price update message.
+enum class MBPUpdateType : uint8_t {
+    INVALID = 0,
+    /// A level is inserted at the index, the levels from there on move down.
+    NEW_LEVEL = 1,
+    /// The quantity or order count of the level at the index changed.
+    CHANGE_LEVEL = 2,
+    /// The level at the index is removed, the levels after it move up.
+    DELETE_LEVEL = 3,
+    /// Both sides of the ticker are cleared, NEW_LEVEL updates of the full
+    /// depth follow.
+    REFRESH_START = 4,
+    /// The full depth refresh of the ticker is complete.
+    REFRESH_END = 5
+};
+
+/// \brief Converts a MBPUpdateType enum to a string.
+/// \param type The MBPUpdateType to convert.
+/// \return String representation of the MBPUpdateType.
+inline auto mbpUpdateTypeToString(MBPUpdateType type) -> std::string {
+    switch (type) {
+        case MBPUpdateType::NEW_LEVEL:
+            return "NEW_LEVEL";
+        case MBPUpdateType::CHANGE_LEVEL:
+            return "CHANGE_LEVEL";
+        case MBPUpdateType::DELETE_LEVEL:
+            return "DELETE_LEVEL";
+        case MBPUpdateType::REFRESH_START:
+            return "REFRESH_START";
+        case MBPUpdateType::REFRESH_END:
+            return "REFRESH_END";
+        case MBPUpdateType::INVALID:
+            return "INVALID";
+    }
+    return "UNKNOWN";
+}
+
+/// \brief Names of the MBPUpdateType values, indexed by their value.
+constexpr std::string_view MBP_UPDATE_TYPE_NAMES[] = {
+    "INVALID",      "NEW_LEVEL",     "CHANGE_LEVEL",
+    "DELETE_LEVEL", "REFRESH_START", "REFRESH_END"};
+
+/// \brief Renders a MBPUpdateType into a caller provided buffer, without
+/// allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param type The MBPUpdateType to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto mbpUpdateTypeToChars(char *first, char *last,
+                                 MBPUpdateType type) noexcept -> size_t {
+    const auto index = static_cast<size_t>(type);
+    return copyChars(first, last,
+                     index < std::size(MBP_UPDATE_TYPE_NAMES)
+                         ? MBP_UPDATE_TYPE_NAMES[index]
+                         : "UNKNOWN");
+}
+
+/// \brief These structures go over the wire / network, so the binary structures
+/// are packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+/// \struct MBPUpdate
+/// \brief Incremental market-by-price update of one aggregated price level.
+struct MBPUpdate {
+    MBPUpdateType type = MBPUpdateType::INVALID;
+    TickerId ticker_id = TickerId_INVALID;
+    Side side = Side::INVALID;
+    /// Index of the level from the best price of its side, 0 is the best.
+    uint8_t level = 0;
+    Price price = Price_INVALID;
+    /// Total quantity of the orders at the level.
+    Qty qty = Qty_INVALID;
+    /// Number of orders at the level.
+    uint32_t order_count = 0;
+
+    /// \brief Converts the MBPUpdate to a string representation.
+    /// \return String representation of the MBPUpdate.
+    auto toString() const {
+        std::stringstream ss;
+        ss << "MBPUpdate"
+           << " ["
+           << " type:" << mbpUpdateTypeToString(type)
+           << " ticker:" << tickerIdToString(ticker_id)
+           << " side:" << sideToString(side)
+           << " level:" << static_cast<unsigned>(level)
+           << " price:" << priceToString(price) << " qty:" << qtyToString(qty)
+           << " orders:" << order_count << "]";
+        return ss.str();
+    }
+
+    /// \brief Renders the MBPUpdate like toString() into a caller provided
+    /// buffer, without allocating.
+    /// \param first Start of the buffer.
+    /// \param last One past the end of the buffer.
+    /// \return Number of characters written, 0 if the buffer is too small.
+    auto toChars(char *first, char *last) const noexcept -> size_t {
+        CharsWriter out(first, last);
+        out.text("MBPUpdate [ type:")
+            .field(mbpUpdateTypeToChars, type)
+            .text(" ticker:")
+            .field(tickerIdToChars, ticker_id)
+            .text(" side:")
+            .field(sideToChars, side)
+            .text(" level:")
+            .field(integerToChars<unsigned>, static_cast<unsigned>(level))
+            .text(" price:")
+            .field(priceToChars, price, 0u)
+            .text(" qty:")
+            .field(qtyToChars, qty)
+            .text(" orders:")
+            .field(integerToChars<uint32_t>, order_count)
+            .text("]");
+        return out.length();
+    }
+};
+
+/// \brief Undo the packed binary structure directive moving forward.
+#pragma pack(pop)
+
+static_assert(MBP_MAX_DEPTH <= UINT8_MAX,
+              "Level indices must fit MBPUpdate::level.");
+
+/// \typedef MBPUpdateLFQueue
+/// \brief Lock free queue of market-by-price update messages.
+typedef LockFreeQueue<MBPUpdate> MBPUpdateLFQueue;
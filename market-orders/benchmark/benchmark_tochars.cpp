@@ -0,0 +1,110 @@
+/// \file benchmark_tochars.cpp
+/// \brief Formatting cost of toString() against the allocation-free toChars().
+/// \details Checks that both renderings of every domain type are identical,
+/// then measures each of them on a drop-copy style workload.
+
+#include <string_view>
+
+#include "market-orders/marketorder.h"
+#include "market-orders/marketupdate.h"
+#include "micro-benchmark/microbenchmark.h"
+
+/// \brief Number of renderings per repetition.
+constexpr size_t NUM_OPERATIONS = 100'000;
+
+/// \brief Exits if the toChars() rendering differs from toString().
+auto checkSame(const std::string &expected, const char *buffer,
+               size_t length) {
+    ASSERT(std::string_view(buffer, length) == expected,
+           "toChars rendered '" + std::string(buffer, length) +
+               "' instead of '" + expected + "'");
+}
+
+/// \brief Main function running the formatting benchmarks.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    MicroBenchmark benchmark(argc, argv);
+    char buffer[TO_CHARS_BUFFER_SIZE];
+    const auto last = buffer + sizeof(buffer);
+
+    MEMarketUpdate update;
+    update.type = MarketUpdateType::ADD;
+    update.order_id = 123'456;
+    update.ticker_id = 3;
+    update.side = Side::SELL;
+    update.price = -100'25;
+    update.qty = 500;
+
+    MarketOrder order(42, Side::BUY, 100'25, 300, 7, nullptr, nullptr);
+    MarketOrderAtPrice level(Side::BUY, 100'25, &order, nullptr, nullptr);
+    BestBidOffer bbo{100'25, 100'26, 300, Qty_INVALID};
+
+    checkSame(update.toString(), buffer, update.toChars(buffer, last));
+    checkSame(order.toString(), buffer, order.toChars(buffer, last));
+    checkSame(level.toString(), buffer, level.toChars(buffer, last));
+    checkSame(bbo.toString(), buffer, bbo.toChars(buffer, last));
+    checkSame(priceToString(update.price), buffer,
+              priceToChars(buffer, last, update.price));
+    checkSame("-100.25", buffer, priceToChars(buffer, last, update.price, 2));
+    ASSERT(update.toChars(buffer, buffer + 16) == 0,
+           "toChars must fail on a buffer that is too small.");
+
+    benchmark.run("priceToString", NUM_OPERATIONS, [&]() {
+        for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+            doNotOptimize(priceToString(static_cast<Price>(i)));
+        }
+    });
+    benchmark.run("priceToChars", NUM_OPERATIONS, [&]() {
+        for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+            doNotOptimize(priceToChars(buffer, last, static_cast<Price>(i)));
+            doNotOptimize(buffer);
+        }
+    });
+    benchmark.run("priceToChars 4 decimals", NUM_OPERATIONS, [&]() {
+        for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+            doNotOptimize(
+                priceToChars(buffer, last, static_cast<Price>(i), 4));
+            doNotOptimize(buffer);
+        }
+    });
+    benchmark.run("sideToString", NUM_OPERATIONS, [&]() {
+        for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+            doNotOptimize(sideToString((i & 1) ? Side::BUY : Side::SELL));
+        }
+    });
+    benchmark.run("sideToChars", NUM_OPERATIONS, [&]() {
+        for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+            doNotOptimize(
+                sideToChars(buffer, last, (i & 1) ? Side::BUY : Side::SELL));
+            doNotOptimize(buffer);
+        }
+    });
+    benchmark.run("MEMarketUpdate::toString", NUM_OPERATIONS, [&]() {
+        for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+            update.order_id = i;
+            doNotOptimize(update.toString());
+        }
+    });
+    benchmark.run("MEMarketUpdate::toChars", NUM_OPERATIONS, [&]() {
+        for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+            update.order_id = i;
+            doNotOptimize(update.toChars(buffer, last));
+            doNotOptimize(buffer);
+        }
+    });
+    benchmark.run("MarketOrder::toString", NUM_OPERATIONS, [&]() {
+        for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+            order.mOrder_id = i;
+            doNotOptimize(order.toString());
+        }
+    });
+    benchmark.run("MarketOrder::toChars", NUM_OPERATIONS, [&]() {
+        for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+            order.mOrder_id = i;
+            doNotOptimize(order.toChars(buffer, last));
+            doNotOptimize(buffer);
+        }
+    });
+
+    return 0;
+}
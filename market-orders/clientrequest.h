@@ -0,0 +1,109 @@
+#pragma once
+
+#include <sstream>
+#include <string_view>
+
+#include "lock-free-queue/lockfreequeue.h"
+#include "utilities/types.h"
+
+/// \enum ClientRequestType
+/// \brief Represents the type / action in the client request message.
+enum class ClientRequestType : uint8_t { INVALID = 0, NEW = 1, CANCEL = 2 };
+
+/// \brief Converts a ClientRequestType enum to a string.
+/// \param type The ClientRequestType to convert.
+/// \return String representation of the ClientRequestType.
+inline std::string clientRequestTypeToString(ClientRequestType type) {
+    switch (type) {
+        case ClientRequestType::NEW:
+            return "NEW";
+        case ClientRequestType::CANCEL:
+            return "CANCEL";
+        case ClientRequestType::INVALID:
+            return "INVALID";
+    }
+    return "UNKNOWN";
+}
+
+/// \brief Names of the ClientRequestType values, indexed by their value.
+constexpr std::string_view CLIENT_REQUEST_TYPE_NAMES[] = {"INVALID", "NEW",
+                                                          "CANCEL"};
+
+/// \brief Renders a ClientRequestType into a caller provided buffer, without
+/// allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param type The ClientRequestType to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto clientRequestTypeToChars(char *first, char *last,
+                                     ClientRequestType type) noexcept
+    -> size_t {
+    const auto index = static_cast<size_t>(type);
+    return copyChars(first, last,
+                     index < std::size(CLIENT_REQUEST_TYPE_NAMES)
+                         ? CLIENT_REQUEST_TYPE_NAMES[index]
+                         : "UNKNOWN");
+}
+
+/// \brief These structures go over the wire / network, so the binary structures
+/// are packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+/// \struct MEClientRequest
+/// \brief Order request sent by a trading client to the matching engine.
+struct MEClientRequest {
+    ClientRequestType type = ClientRequestType::INVALID;
+    ClientId client_id = ClientId_INVALID;
+    TickerId ticker_id = TickerId_INVALID;
+    OrderId order_id = OrderId_INVALID;
+    Side side = Side::INVALID;
+    Price price = Price_INVALID;
+    Qty qty = Qty_INVALID;
+
+    /// \brief Converts the MEClientRequest to a string representation.
+    /// \return String representation of the MEClientRequest.
+    auto toString() const {
+        std::stringstream ss;
+        ss << "MEClientRequest"
+           << " ["
+           << " type:" << clientRequestTypeToString(type)
+           << " client:" << clientIdToString(client_id)
+           << " ticker:" << tickerIdToString(ticker_id)
+           << " oid:" << orderIdToString(order_id)
+           << " side:" << sideToString(side) << " qty:" << qtyToString(qty)
+           << " price:" << priceToString(price) << "]";
+        return ss.str();
+    }
+
+    /// \brief Renders the MEClientRequest like toString() into a caller
+    /// provided buffer, without allocating.
+    /// \param first Start of the buffer.
+    /// \param last One past the end of the buffer.
+    /// \return Number of characters written, 0 if the buffer is too small.
+    auto toChars(char *first, char *last) const noexcept -> size_t {
+        CharsWriter out(first, last);
+        out.text("MEClientRequest [ type:")
+            .field(clientRequestTypeToChars, type)
+            .text(" client:")
+            .field(clientIdToChars, client_id)
+            .text(" ticker:")
+            .field(tickerIdToChars, ticker_id)
+            .text(" oid:")
+            .field(orderIdToChars, order_id)
+            .text(" side:")
+            .field(sideToChars, side)
+            .text(" qty:")
+            .field(qtyToChars, qty)
+            .text(" price:")
+            .field(priceToChars, price, 0u)
+            .text("]");
+        return out.length();
+    }
+};
+
+/// \brief Undo the packed binary structure directive moving forward.
+#pragma pack(pop)
+
+/// \typedef ClientRequestLFQueue
+/// \brief Lock free queue of client order requests.
+typedef LockFreeQueue<MEClientRequest> ClientRequestLFQueue;
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <sstream>
+#include <string_view>
+
+#include "lock-free-queue/lockfreequeue.h"
+#include "utilities/types.h"
+
+/// \enum ClientResponseType
+/// \brief Represents the type / action in the client response message.
+enum class ClientResponseType : uint8_t {
+    INVALID = 0,
+    ACCEPTED = 1,
+    CANCELED = 2,
+    FILLED = 3,
+    CANCEL_REJECTED = 4
+};
+
+/// \brief Converts a ClientResponseType enum to a string.
+/// \param type The ClientResponseType to convert.
+/// \return String representation of the ClientResponseType.
+inline std::string clientResponseTypeToString(ClientResponseType type) {
+    switch (type) {
+        case ClientResponseType::ACCEPTED:
+            return "ACCEPTED";
+        case ClientResponseType::CANCELED:
+            return "CANCELED";
+        case ClientResponseType::FILLED:
+            return "FILLED";
+        case ClientResponseType::CANCEL_REJECTED:
+            return "CANCEL_REJECTED";
+        case ClientResponseType::INVALID:
+            return "INVALID";
+    }
+    return "UNKNOWN";
+}
+
+/// \brief Names of the ClientResponseType values, indexed by their value.
+constexpr std::string_view CLIENT_RESPONSE_TYPE_NAMES[] = {
+    "INVALID", "ACCEPTED", "CANCELED", "FILLED", "CANCEL_REJECTED"};
+
+/// \brief Renders a ClientResponseType into a caller provided buffer, without
+/// allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param type The ClientResponseType to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto clientResponseTypeToChars(char *first, char *last,
+                                      ClientResponseType type) noexcept
+    -> size_t {
+    const auto index = static_cast<size_t>(type);
+    return copyChars(first, last,
+                     index < std::size(CLIENT_RESPONSE_TYPE_NAMES)
+                         ? CLIENT_RESPONSE_TYPE_NAMES[index]
+                         : "UNKNOWN");
+}
+
+/// \brief These structures go over the wire / network, so the binary structures
+/// are packed to remove system dependent extra padding.
+#pragma pack(push, 1)
+
+/// \struct MEClientResponse
+/// \brief Response of the matching engine to a client's order request.
+struct MEClientResponse {
+    ClientResponseType type = ClientResponseType::INVALID;
+    ClientId client_id = ClientId_INVALID;
+    TickerId ticker_id = TickerId_INVALID;
+    OrderId order_id = OrderId_INVALID;
+    /// Id of the order in the market data, known once it is ACCEPTED.
+    OrderId market_order_id = OrderId_INVALID;
+    Side side = Side::INVALID;
+    /// Limit price of the order.
+    Price price = Price_INVALID;
+    /// Price of the execution, for FILLED.
+    Price exec_price = Price_INVALID;
+    /// Quantity executed, for FILLED.
+    Qty exec_qty = Qty_INVALID;
+    /// Quantity of the order still open, or cancelled for CANCELED.
+    Qty leaves_qty = Qty_INVALID;
+
+    /// \brief Converts the MEClientResponse to a string representation.
+    /// \return String representation of the MEClientResponse.
+    auto toString() const {
+        std::stringstream ss;
+        ss << "MEClientResponse"
+           << " ["
+           << " type:" << clientResponseTypeToString(type)
+           << " client:" << clientIdToString(client_id)
+           << " ticker:" << tickerIdToString(ticker_id)
+           << " oid:" << orderIdToString(order_id)
+           << " moid:" << orderIdToString(market_order_id)
+           << " side:" << sideToString(side)
+           << " price:" << priceToString(price)
+           << " exec_price:" << priceToString(exec_price)
+           << " exec_qty:" << qtyToString(exec_qty)
+           << " leaves_qty:" << qtyToString(leaves_qty) << "]";
+        return ss.str();
+    }
+
+    /// \brief Renders the MEClientResponse like toString() into a caller
+    /// provided buffer, without allocating.
+    /// \param first Start of the buffer.
+    /// \param last One past the end of the buffer.
+    /// \return Number of characters written, 0 if the buffer is too small.
+    auto toChars(char *first, char *last) const noexcept -> size_t {
+        CharsWriter out(first, last);
+        out.text("MEClientResponse [ type:")
+            .field(clientResponseTypeToChars, type)
+            .text(" client:")
+            .field(clientIdToChars, client_id)
+            .text(" ticker:")
+            .field(tickerIdToChars, ticker_id)
+            .text(" oid:")
+            .field(orderIdToChars, order_id)
+            .text(" moid:")
+            .field(orderIdToChars, market_order_id)
+            .text(" side:")
+            .field(sideToChars, side)
+            .text(" price:")
+            .field(priceToChars, price, 0u)
+            .text(" exec_price:")
+            .field(priceToChars, exec_price, 0u)
+            .text(" exec_qty:")
+            .field(qtyToChars, exec_qty)
+            .text(" leaves_qty:")
+            .field(qtyToChars, leaves_qty)
+            .text("]");
+        return out.length();
+    }
+};
+
+/// \brief Undo the packed binary structure directive moving forward.
+#pragma pack(pop)
+
+/// \typedef ClientResponseLFQueue
+/// \brief Lock free queue of client order responses.
+typedef LockFreeQueue<MEClientResponse> ClientResponseLFQueue;
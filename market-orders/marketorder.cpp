@@ -2,6 +2,17 @@
 
 #include <string>
 
+MarketOrder::MarketOrder(OrderId order_id, Side side, Price price, Qty qty,
+                         Priority priority, MarketOrder *prev_order,
+                         MarketOrder *next_order) noexcept
+    : mOrder_id(order_id),
+      mSide(side),
+      mPrice(price),
+      mQty(qty),
+      mPriority(priority),
+      mPrev_order(prev_order),
+      mNext_order(next_order) {}
+
 auto MarketOrder::toString() const -> std::string {
     std::stringstream ss;
 
@@ -22,6 +33,38 @@ auto MarketOrder::toString() const -> std::string {
     return ss.str();
 }
 
+auto MarketOrder::toChars(char *first, char *last) const noexcept -> size_t {
+    CharsWriter out(first, last);
+    out.text("MarketOrder[oid:")
+        .field(orderIdToChars, mOrder_id)
+        .text(" side:")
+        .field(sideToChars, mSide)
+        .text(" price:")
+        .field(priceToChars, mPrice, 0u)
+        .text(" qty:")
+        .field(qtyToChars, mQty)
+        .text(" prio:")
+        .field(priorityToChars, mPriority)
+        .text(" prev:")
+        .field(orderIdToChars,
+               mPrev_order ? mPrev_order->mOrder_id : OrderId_INVALID)
+        .text(" next:")
+        .field(orderIdToChars,
+               mNext_order ? mNext_order->mOrder_id : OrderId_INVALID)
+        .text("]");
+    return out.length();
+}
+
+MarketOrderAtPrice::MarketOrderAtPrice(Side side, Price price,
+                                       MarketOrder *first_market_order,
+                                       MarketOrderAtPrice *prev_entry,
+                                       MarketOrderAtPrice *next_entry) noexcept
+    : mSide(side),
+      mPrice(price),
+      mFirst_market_order(first_market_order),
+      mPrev_entry(prev_entry),
+      mNext_entry(next_entry) {}
+
 auto MarketOrderAtPrice::toString() const -> std::string {
     std::stringstream ss;
     ss << "MarketOrdersAtPrice["
@@ -40,6 +83,31 @@ auto MarketOrderAtPrice::toString() const -> std::string {
     return ss.str();
 }
 
+auto MarketOrderAtPrice::toChars(char *first, char *last) const noexcept
+    -> size_t {
+    CharsWriter out(first, last);
+    out.text("MarketOrdersAtPrice[side:")
+        .field(sideToChars, mSide)
+        .text(" price:")
+        .field(priceToChars, mPrice, 0u)
+        .text(" first_mkt_order:");
+    if (mFirst_market_order) {
+        out.field([this](char *begin, char *end) {
+            return mFirst_market_order->toChars(begin, end);
+        });
+    } else {
+        out.text("null");
+    }
+    out.text(" prev:")
+        .field(priceToChars, mPrev_entry ? mPrev_entry->mPrice : Price_INVALID,
+               0u)
+        .text(" next:")
+        .field(priceToChars, mNext_entry ? mNext_entry->mPrice : Price_INVALID,
+               0u)
+        .text("]");
+    return out.length();
+}
+
 auto BestBidOffer::toString() const -> std::string {
     std::stringstream ss;
     ss << "Best Bid Offer\t{" << qtyToString(mBid_qty) << "@"
@@ -47,4 +115,18 @@ auto BestBidOffer::toString() const -> std::string {
        << qtyToString(mAsk_qty) << "}";
 
     return ss.str();
+}
+
+auto BestBidOffer::toChars(char *first, char *last) const noexcept -> size_t {
+    CharsWriter out(first, last);
+    out.text("Best Bid Offer\t{")
+        .field(qtyToChars, mBid_qty)
+        .text("@")
+        .field(priceToChars, mBid_price, 0u)
+        .text("X")
+        .field(priceToChars, mAsk_price, 0u)
+        .text("@")
+        .field(qtyToChars, mAsk_qty)
+        .text("}");
+    return out.length();
 }
\ No newline at end of file
@@ -42,6 +42,13 @@ struct MarketOrder {
     /// \brief Returns a string representation of the MarketOrder.
     /// \return String representation.
     auto toString() const -> std::string;
+
+    /// \brief Renders the MarketOrder like toString() into a caller provided
+    /// buffer, without allocating.
+    /// \param first Start of the buffer.
+    /// \param last One past the end of the buffer.
+    /// \return Number of characters written, 0 if the buffer is too small.
+    auto toChars(char *first, char *last) const noexcept -> size_t;
 };
 
 /// \typedef OrderArray
@@ -55,6 +62,10 @@ struct MarketOrderAtPrice {
     Side mSide = Side::INVALID;
     /// Price level.
     Price mPrice = Price_INVALID;
+    /// Total quantity of the orders at this price, maintained by the book.
+    Qty mTotal_qty = 0;
+    /// Number of orders at this price, maintained by the book.
+    uint32_t mOrder_count = 0;
 
     /// Pointer to the first market order at this price.
     MarketOrder *mFirst_market_order = nullptr;
@@ -79,6 +90,13 @@ struct MarketOrderAtPrice {
     /// \brief Returns a string representation of the MarketOrderAtPrice.
     /// \return String representation.
     auto toString() const -> std::string;
+
+    /// \brief Renders the MarketOrderAtPrice like toString() into a caller
+    /// provided buffer, without allocating.
+    /// \param first Start of the buffer.
+    /// \param last One past the end of the buffer.
+    /// \return Number of characters written, 0 if the buffer is too small.
+    auto toChars(char *first, char *last) const noexcept -> size_t;
 };
 
 /// \typedef OrdersAtPriceArray
@@ -99,7 +117,17 @@ struct BestBidOffer {
     /// Quantity at best ask.
     Qty mAsk_qty = Qty_INVALID;
 
+    /// \brief Compares the prices and quantities of both sides.
+    auto operator==(const BestBidOffer &) const -> bool = default;
+
     /// \brief Returns a string representation of the BestBidOffer.
     /// \return String representation.
     auto toString() const -> std::string;
+
+    /// \brief Renders the BestBidOffer like toString() into a caller provided
+    /// buffer, without allocating.
+    /// \param first Start of the buffer.
+    /// \param last One past the end of the buffer.
+    /// \return Number of characters written, 0 if the buffer is too small.
+    auto toChars(char *first, char *last) const noexcept -> size_t;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <sstream>
+#include <string_view>
 
 #include "lock-free-queue/lockfreequeue.h"
 #include "utilities/types.h"
@@ -43,6 +44,27 @@ inline std::string marketUpdateTypeToString(MarketUpdateType type) {
     return "UNKNOWN";
 }
 
+/// \brief Names of the MarketUpdateType values, indexed by their value.
+constexpr std::string_view MARKET_UPDATE_TYPE_NAMES[] = {
+    "INVALID", "CLEAR", "ADD", "MODIFY", "CANCEL", "TRADE", "SNAPSHOT_START",
+    "SNAPSHOT_END"};
+
+/// \brief Renders a MarketUpdateType into a caller provided buffer, without
+/// allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param type The MarketUpdateType to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto marketUpdateTypeToChars(char *first, char *last,
+                                    MarketUpdateType type) noexcept
+    -> size_t {
+    const auto index = static_cast<size_t>(type);
+    return copyChars(first, last,
+                     index < std::size(MARKET_UPDATE_TYPE_NAMES)
+                         ? MARKET_UPDATE_TYPE_NAMES[index]
+                         : "UNKNOWN");
+}
+
 /// \brief These structures go over the wire / network, so the binary structures
 /// are packed to remove system dependent extra padding.
 #pragma pack(push, 1)
@@ -72,6 +94,31 @@ struct MEMarketUpdate {
            << " priority:" << priorityToString(priority) << "]";
         return ss.str();
     }
+
+    /// \brief Renders the MEMarketUpdate like toString() into a caller
+    /// provided buffer, without allocating.
+    /// \param first Start of the buffer.
+    /// \param last One past the end of the buffer.
+    /// \return Number of characters written, 0 if the buffer is too small.
+    auto toChars(char *first, char *last) const noexcept -> size_t {
+        CharsWriter out(first, last);
+        out.text("MEMarketUpdate [ type:")
+            .field(marketUpdateTypeToChars, type)
+            .text(" ticker:")
+            .field(tickerIdToChars, ticker_id)
+            .text(" oid:")
+            .field(orderIdToChars, order_id)
+            .text(" side:")
+            .field(sideToChars, side)
+            .text(" qty:")
+            .field(qtyToChars, qty)
+            .text(" price:")
+            .field(priceToChars, price, 0u)
+            .text(" priority:")
+            .field(priorityToChars, priority)
+            .text("]");
+        return out.length();
+    }
 };
 
 /// \struct MDPMarketUpdate
@@ -90,6 +137,23 @@ struct MDPMarketUpdate {
            << " seq:" << seq_num_ << " " << me_market_update_.toString() << "]";
         return ss.str();
     }
+
+    /// \brief Renders the MDPMarketUpdate like toString() into a caller
+    /// provided buffer, without allocating.
+    /// \param first Start of the buffer.
+    /// \param last One past the end of the buffer.
+    /// \return Number of characters written, 0 if the buffer is too small.
+    auto toChars(char *first, char *last) const noexcept -> size_t {
+        CharsWriter out(first, last);
+        out.text("MDPMarketUpdate [ seq:")
+            .field(integerToChars<size_t>, seq_num_)
+            .text(" ")
+            .field([this](char *begin, char *end) {
+                return me_market_update_.toChars(begin, end);
+            })
+            .text("]");
+        return out.length();
+    }
 };
 
 /// \brief Undo the packed binary structure directive moving forward.
@@ -0,0 +1,68 @@
+/// \file benchmark_memorypool.cpp
+/// \brief Allocation churn of the MemoryPool at several occupancies.
+/// \details Keeps a pool filled to a fixed occupancy and repeatedly allocates
+/// one MarketOrder while deallocating a random live one, which is the pattern
+/// of an order book under steady state flow. The same churn through new and
+/// delete is measured for comparison.
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "market-orders/marketorder.h"
+#include "memory-pool/memorypool.h"
+#include "micro-benchmark/microbenchmark.h"
+
+/// \brief Number of objects in the pool.
+constexpr size_t POOL_SIZE = 64 * 1024;
+
+/// \brief Number of allocate / deallocate pairs per repetition.
+constexpr size_t NUM_OPERATIONS = 1'000'000;
+
+/// \brief Main function running the memory pool benchmarks.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    MicroBenchmark benchmark(argc, argv);
+
+    // Victims are drawn up front so the random number generator is not timed.
+    std::mt19937_64 rng(42);
+    for (const auto occupancy_percent : {0, 50, 90, 99}) {
+        const auto live_count =
+            std::max<size_t>(1, POOL_SIZE * occupancy_percent / 100);
+        std::vector<size_t> victims(NUM_OPERATIONS);
+        for (auto &victim : victims) victim = rng() % live_count;
+
+        auto pool = std::make_unique<MemoryPool<MarketOrder>>(POOL_SIZE);
+        std::vector<MarketOrder *> live(live_count);
+        for (auto &order : live) order = pool->allocate();
+
+        benchmark.run(
+            "pool churn " + std::to_string(occupancy_percent) + "% full",
+            NUM_OPERATIONS, [&]() {
+                for (const auto victim : victims) {
+                    auto order = pool->allocate();
+                    pool->deallocate(live[victim]);
+                    live[victim] = order;
+                }
+                doNotOptimize(live.front());
+            });
+
+        std::vector<MarketOrder *> heap_live(live_count);
+        for (auto &order : heap_live) order = new MarketOrder();
+
+        benchmark.run(
+            "new/delete churn " + std::to_string(occupancy_percent) + "% full",
+            NUM_OPERATIONS, [&]() {
+                for (const auto victim : victims) {
+                    auto order = new MarketOrder();
+                    delete heap_live[victim];
+                    heap_live[victim] = order;
+                }
+                doNotOptimize(heap_live.front());
+            });
+
+        for (auto order : heap_live) delete order;
+    }
+
+    return 0;
+}
@@ -35,14 +35,18 @@ class MemoryPool final {
     /// \return Pointer to the allocated object.
     template <typename... Args>
     T *allocate(Args... args) noexcept {
+        ASSERT(mAllocated < mStore.size(), "Memory Pool out of space.");
         auto obj_block = &(mStore[mNext_free_index]);
         ASSERT(obj_block->is_free, "Expected free ObjectBlock at index:" +
                                        std::to_string(mNext_free_index));
         T *ret = &(obj_block->element);
         ret = new (ret) T(args...);  // placement new.
         obj_block->is_free = false;
+        ++mAllocated;
 
-        updateNextFreeIndex();
+        // A full pool has no free element to move to, the next deallocate
+        // provides one.
+        if (mAllocated < mStore.size()) [[likely]] updateNextFreeIndex();
 
         return ret;
     }
@@ -59,8 +63,19 @@ class MemoryPool final {
                "Expected in-use ObjectBlock at index:" +
                    std::to_string(elem_index));
         mStore[elem_index].is_free = true;
+        if (mAllocated == mStore.size()) [[unlikely]] {
+            mNext_free_index = static_cast<size_t>(elem_index);
+        }
+        --mAllocated;
     }
 
+    /// \brief Returns the number of objects currently allocated.
+    auto allocated() const noexcept { return mAllocated; }
+
+    /// \brief Returns the number of elements the pool was constructed with,
+    /// all of which can be allocated at once.
+    auto capacity() const noexcept { return mStore.size(); }
+
     // Deleted default, copy & move constructors and assignment-operators.
     MemoryPool() = delete;
     MemoryPool(const MemoryPool &) = delete;
@@ -70,9 +85,9 @@ class MemoryPool final {
 
    private:
     /// \brief Updates the next free index to be written over with new
-    /// information.
+    /// information. Only called while an element is free, so the search
+    /// always ends.
     auto updateNextFreeIndex() noexcept {
-        const auto initial_free_index = mNext_free_index;
         while (!mStore[mNext_free_index].is_free) {
             ++mNext_free_index;
             if (mNext_free_index == mStore.size())
@@ -81,10 +96,6 @@ class MemoryPool final {
                                 // this to be false any ways.
                 mNext_free_index = 0;
             }
-            if (initial_free_index == mNext_free_index) [[unlikely]] {
-                ASSERT(initial_free_index != mNext_free_index,
-                       "Memory Pool out of space.");
-            }
         }
     }
 
@@ -99,6 +110,9 @@ class MemoryPool final {
     /// \brief Index to track the next free element.
     size_t mNext_free_index = 0;
 
+    /// \brief Number of objects currently allocated.
+    size_t mAllocated = 0;
+
     /// \brief Underlying storage for the pool elements.
     std::vector<ElementBlock> mStore;
 };
\ No newline at end of file
@@ -0,0 +1,240 @@
+/// \file benchmark_metrics.cpp
+/// \brief Cost to a book builder of publishing its metrics to shared memory,
+/// with and without a reader sampling them.
+/// \details Feeds synthetic order flow through a LockFreeQueue in batches
+/// into the books of four tickers. The plain pass only applies the updates.
+/// The metrics pass also samples the queue depth on every read and publishes
+/// the message count and pool occupancy of every book, and the latency of
+/// one update in --latency-every, each timed with two time stamp counter
+/// reads. The last pass adds a thread that maps the segment read-only, like
+/// the reader tool in another process, and samples every metric at a high
+/// rate. The published values must match the books and the flow exactly.
+///
+/// Usage: MetricsBenchmark [--updates N] [--batch N] [--sample-us N]
+///     [--latency-every N] [harness options]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "market-orders/marketupdate.h"
+#include "metrics/pipelinemetrics.h"
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowbooks.h"
+#include "utilities/latencyhistogram.h"
+#include "utilities/tscclock.h"
+
+/// \brief Name of the metrics segment of the benchmark.
+const std::string SEGMENT_NAME = "/metrics_benchmark";
+
+/// \brief The queue and books of a pass, and their metrics if any.
+struct Pipeline {
+    Pipeline(TickerId tickers, MetricsRegistry *registry)
+        : queue(ME_MAX_MARKET_UPDATES), books(tickers) {
+        if (!registry) return;
+        queue_metrics = std::make_unique<QueueMetrics<MEMarketUpdate>>(
+            *registry, "feed", queue);
+        for (TickerId ticker_id = 0; ticker_id < tickers; ++ticker_id) {
+            book_metrics.push_back(
+                std::make_unique<BookMetrics>(*registry, books[ticker_id]));
+        }
+    }
+
+    /// \brief Feeds the flow through the queue into the books.
+    /// \param latency_every Times one update in latency_every.
+    /// \return Seconds taken.
+    template <bool WithMetrics>
+    auto run(const std::vector<MEMarketUpdate> &flow, size_t batch,
+             size_t latency_every = 1) -> double {
+        const auto start = std::chrono::steady_clock::now();
+        size_t until_timed = 0;
+        for (size_t first = 0; first < flow.size(); first += batch) {
+            const auto last = std::min(flow.size(), first + batch);
+            for (auto i = first; i < last; ++i) {
+                *queue.getNextWrite() = flow[i];
+                queue.updateWriteIndex();
+            }
+            while (const auto update = queue.getNextRead()) {
+                const auto ticker_id = update->ticker_id;
+                if constexpr (WithMetrics) {
+                    queue_metrics->sample();
+                    if (!until_timed) {
+                        until_timed = latency_every;
+                        const auto update_start = TscClock::now();
+                        books.onMarketUpdate(update);
+                        book_metrics[ticker_id]->recordLatency(
+                            TscClock::now() - update_start);
+                    } else {
+                        books.onMarketUpdate(update);
+                    }
+                    --until_timed;
+                    book_metrics[ticker_id]->onMarketUpdate();
+                } else {
+                    books.onMarketUpdate(update);
+                }
+                queue.updateReadIndex();
+            }
+        }
+        return std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+            .count();
+    }
+
+    MEMarketUpdateLFQueue queue;
+    OrderFlowBooks books;
+    std::unique_ptr<QueueMetrics<MEMarketUpdate>> queue_metrics;
+    std::vector<std::unique_ptr<BookMetrics>> book_metrics;
+};
+
+/// \brief Exits unless the segment holds exactly the counts of the pass.
+auto checkMetrics(const Pipeline &pipeline, size_t updates, size_t batch,
+                  size_t latency_every) -> void {
+    MetricsReader reader;
+    if (!reader.open(SEGMENT_NAME)) [[unlikely]] {
+        FATAL("Unable to open metrics segment:" + SEGMENT_NAME);
+    }
+    uint64_t published = 0;
+    uint64_t timed = 0;
+    for (size_t index = 0; index < reader.metricCount(); ++index) {
+        const auto &slot = reader.metric(index);
+        const std::string name = slot.name;
+        const auto value = slot.value.load(std::memory_order_relaxed);
+        if (name == "feed.depth") {
+            if (slot.high_water != batch) [[unlikely]] {
+                FATAL("Queue high-water mark " +
+                      std::to_string(slot.high_water) + " instead of " +
+                      std::to_string(batch));
+            }
+            continue;
+        }
+        const auto ticker_id = static_cast<TickerId>(
+            std::stoul(name.substr(name.find('.') + 1)));
+        const auto &book = pipeline.books[ticker_id];
+        const auto metric = name.substr(name.rfind('.') + 1);
+        auto expected = value;
+        if (metric == "updates") {
+            published += value;
+        } else if (metric == "orders") {
+            expected = book.orderPool().allocated();
+        } else if (metric == "levels") {
+            expected = book.levelPool().allocated();
+        } else if (metric == "latency") {
+            timed += reader.histogram(slot).count();
+        }
+        if (value != expected) [[unlikely]] {
+            FATAL("Metric " + name + " is " + std::to_string(value) +
+                  " instead of " + std::to_string(expected));
+        }
+    }
+    if (timed != (updates + latency_every - 1) / latency_every)
+        [[unlikely]] {
+        FATAL("Books timed " + std::to_string(timed) + " of " +
+              std::to_string(updates) + " updates.");
+    }
+    if (published != updates) [[unlikely]] {
+        FATAL("Books published " + std::to_string(published) +
+              " updates instead of " + std::to_string(updates));
+    }
+}
+
+/// \brief Main function running the metrics benchmark.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    size_t updates = 2'000'000;
+    size_t batch = 32;
+    uint64_t sample_us = 100;
+    size_t latency_every = 1;
+    setUpBenchmarkThread(parseBenchmarkOptions(
+        argc, argv,
+        {{"--updates", updates},
+         {"--batch", batch, 1, ME_MAX_MARKET_UPDATES - 1},
+         {"--sample-us", sample_us, 1},
+         {"--latency-every", latency_every, 1}}));
+
+    OrderFlowConfig config;
+    OrderFlowGenerator generator(config);
+    const auto flow = generateOrderFlow(generator, updates);
+
+    // Only the books.
+    double plain_seconds = 0.0;
+    {
+        Pipeline pipeline(config.num_tickers, nullptr);
+        plain_seconds = pipeline.run<false>(flow, batch);
+    }
+
+    // The books publishing their metrics.
+    double metrics_seconds = 0.0;
+    {
+        MetricsRegistry registry(SEGMENT_NAME);
+        Pipeline pipeline(config.num_tickers, &registry);
+        metrics_seconds = pipeline.run<true>(flow, batch, latency_every);
+        checkMetrics(pipeline, flow.size(), batch, latency_every);
+    }
+
+    // The books publishing their metrics, sampled by a reader.
+    double sampled_seconds = 0.0;
+    LatencyHistogram samples;
+    {
+        MetricsRegistry registry(SEGMENT_NAME);
+        Pipeline pipeline(config.num_tickers, &registry);
+        std::atomic<bool> done = {false};
+        std::thread sampler([&] {
+            MetricsReader reader;
+            if (!reader.open(SEGMENT_NAME)) [[unlikely]] {
+                FATAL("Unable to open metrics segment:" + SEGMENT_NAME);
+            }
+            std::vector<uint64_t> last(reader.metricCount(), 0);
+            while (!done.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(
+                    std::chrono::microseconds(sample_us));
+                const auto start = TscClock::now();
+                for (size_t index = 0; index < last.size(); ++index) {
+                    const auto &slot = reader.metric(index);
+                    uint64_t value =
+                        slot.value.load(std::memory_order_relaxed);
+                    if (slot.type == MetricType::HISTOGRAM) {
+                        value = reader.histogram(slot).percentile(99.0);
+                    } else if (slot.type == MetricType::COUNTER &&
+                               value < last[index]) [[unlikely]] {
+                        FATAL(std::string("Counter ") + slot.name +
+                              " went backwards.");
+                    }
+                    last[index] = value;
+                }
+                samples.record(TscClock::now() - start);
+            }
+        });
+        sampled_seconds = pipeline.run<true>(flow, batch, latency_every);
+        done.store(true, std::memory_order_release);
+        sampler.join();
+        checkMetrics(pipeline, flow.size(), batch, latency_every);
+    }
+
+    const auto perUpdate = [&flow](double seconds) {
+        return seconds * 1e9 / flow.size();
+    };
+    std::cout << flow.size() << " updates into " << config.num_tickers
+              << " books through a queue in batches of " << batch
+              << ", published metrics checked" << std::endl;
+    std::cout << std::fixed << std::setprecision(1)
+              << "books only: " << perUpdate(plain_seconds)
+              << " ns per update" << std::endl;
+    std::cout << "with metrics, latency of 1 in " << latency_every
+              << " updates timed: " << perUpdate(metrics_seconds)
+              << " ns per update" << std::endl;
+    std::cout << "with metrics sampled every " << sample_us
+              << " us: " << perUpdate(sampled_seconds) << " ns per update, "
+              << samples.count() << " samples of "
+              << 1 + 4 * config.num_tickers << " metrics, p50 "
+              << TscClock::toNanos(samples.percentile(50.0)) << " ns, p99 "
+              << TscClock::toNanos(samples.percentile(99.0)) << " ns"
+              << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,419 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include "utilities/latencyhistogram.h"
+#include "utilities/macros.h"
+#include "utilities/sharedmemory.h"
+#include "utilities/tscclock.h"
+
+/// \brief Magic number at the start of every metrics segment ("METR").
+constexpr uint32_t METRICS_MAGIC = 0x5254454D;
+
+/// \brief Version of the metrics segment layout.
+constexpr uint16_t METRICS_VERSION = 1;
+
+/// \brief Size of a metric name, including its terminating null.
+constexpr size_t METRICS_NAME_SIZE = 32;
+
+/// \brief Default number of counters and gauges of a segment.
+constexpr size_t METRICS_MAX_METRICS = 256;
+
+/// \brief Default number of histograms of a segment.
+constexpr size_t METRICS_MAX_HISTOGRAMS = 16;
+
+/// \brief Size of a cache line, every slot of the segment owns whole lines.
+constexpr size_t METRICS_CACHE_LINE_SIZE = 64;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "Metrics shared between processes must be lock-free atomics.");
+
+/// \enum MetricType
+/// \brief Kind of value a metric slot holds.
+enum class MetricType : uint32_t {
+    INVALID = 0,
+    /// A total that only grows, such as messages processed.
+    COUNTER = 1,
+    /// A level, such as a queue depth, with its high-water mark and limit.
+    GAUGE = 2,
+    /// A LatencyHistogram of time stamp counter ticks.
+    HISTOGRAM = 3
+};
+
+/// \brief Converts a MetricType enum to a string.
+/// \param type The MetricType to convert.
+/// \return String representation of the MetricType.
+inline auto metricTypeToString(MetricType type) -> std::string {
+    switch (type) {
+        case MetricType::COUNTER:
+            return "COUNTER";
+        case MetricType::GAUGE:
+            return "GAUGE";
+        case MetricType::HISTOGRAM:
+            return "HISTOGRAM";
+        case MetricType::INVALID:
+            return "INVALID";
+    }
+    return "UNKNOWN";
+}
+
+/// \struct MetricsHeader
+/// \brief Header at the start of a metrics segment. The metric slots follow
+/// it, then the histograms.
+struct alignas(METRICS_CACHE_LINE_SIZE) MetricsHeader {
+    /// METRICS_MAGIC once the segment is initialised, stored last.
+    std::atomic<uint32_t> magic = {0};
+    /// Layout version, METRICS_VERSION.
+    uint16_t version = METRICS_VERSION;
+    /// Size of a metric slot, to reject segments of another layout.
+    uint16_t slot_size = 0;
+    /// Number of metric slots of the segment.
+    uint32_t max_metrics = 0;
+    /// Number of histograms of the segment.
+    uint32_t max_histograms = 0;
+    /// Number of metric slots registered, stored after the slot is filled.
+    std::atomic<uint32_t> metric_count = {0};
+    /// Number of histograms registered.
+    uint32_t histogram_count = 0;
+    /// Process id of the writer.
+    uint64_t pid = 0;
+    /// Time stamp counter rate of the writer, to turn histogram ticks into
+    /// nanoseconds.
+    double ticks_per_nano = 1.0;
+};
+
+/// \struct MetricSlot
+/// \brief A counter, gauge or histogram of a metrics segment, one cache line
+/// written by a single thread.
+struct alignas(METRICS_CACHE_LINE_SIZE) MetricSlot {
+    /// Total of a counter, current level of a gauge.
+    std::atomic<uint64_t> value = {0};
+    /// Highest level a gauge reached.
+    std::atomic<uint64_t> high_water = {0};
+    /// Largest possible level of a gauge, such as a capacity, 0 if none.
+    uint64_t limit = 0;
+    /// Kind of metric.
+    MetricType type = MetricType::INVALID;
+    /// Index of the histogram of a HISTOGRAM slot.
+    uint32_t histogram = 0;
+    /// Null terminated name of the metric.
+    char name[METRICS_NAME_SIZE] = {};
+};
+
+static_assert(sizeof(MetricsHeader) == METRICS_CACHE_LINE_SIZE,
+              "The metrics header must fill one cache line.");
+static_assert(sizeof(MetricSlot) == METRICS_CACHE_LINE_SIZE,
+              "A metric slot must fill one cache line.");
+
+/// \brief Space taken by each histogram of a segment, whole cache lines.
+constexpr size_t METRICS_HISTOGRAM_STRIDE =
+    (sizeof(LatencyHistogram) + METRICS_CACHE_LINE_SIZE - 1) /
+    METRICS_CACHE_LINE_SIZE * METRICS_CACHE_LINE_SIZE;
+
+/// \brief Returns the size of a metrics segment.
+/// \param max_metrics Number of metric slots.
+/// \param max_histograms Number of histograms.
+constexpr auto metricsSegmentSize(size_t max_metrics,
+                                  size_t max_histograms) noexcept -> size_t {
+    return sizeof(MetricsHeader) + max_metrics * sizeof(MetricSlot) +
+           max_histograms * METRICS_HISTOGRAM_STRIDE;
+}
+
+/// \brief Adds to a value owned by a single writer. A relaxed load and store
+/// avoids the locked instruction of fetch_add.
+inline auto metricAdd(std::atomic<uint64_t> &value, uint64_t delta) noexcept
+    -> void {
+    value.store(value.load(std::memory_order_relaxed) + delta,
+                std::memory_order_relaxed);
+}
+
+/// \brief Handle to a counter of a metrics segment.
+///
+/// Handles are small and copyable, but every copy must be used by the one
+/// thread that writes the metric.
+class MetricCounter final {
+   public:
+    /// \brief Constructs a handle to a COUNTER slot.
+    explicit MetricCounter(MetricSlot *slot) noexcept : mSlot(slot) {}
+
+    /// \brief Adds to the counter.
+    auto add(uint64_t delta = 1) noexcept -> void {
+        metricAdd(mSlot->value, delta);
+    }
+
+    /// \brief Returns the total of the counter.
+    auto value() const noexcept {
+        return mSlot->value.load(std::memory_order_relaxed);
+    }
+
+   private:
+    /// \brief The slot in the segment.
+    MetricSlot *mSlot;
+};
+
+/// \brief Handle to a gauge of a metrics segment, tracking its high-water
+/// mark.
+///
+/// Handles are small and copyable, but every copy must be used by the one
+/// thread that writes the metric.
+class MetricGauge final {
+   public:
+    /// \brief Constructs a handle to a GAUGE slot.
+    explicit MetricGauge(MetricSlot *slot) noexcept : mSlot(slot) {}
+
+    /// \brief Sets the level of the gauge.
+    auto set(uint64_t level) noexcept -> void {
+        mSlot->value.store(level, std::memory_order_relaxed);
+        if (level > mSlot->high_water.load(std::memory_order_relaxed)) {
+            mSlot->high_water.store(level, std::memory_order_relaxed);
+        }
+    }
+
+    /// \brief Returns the level of the gauge.
+    auto value() const noexcept {
+        return mSlot->value.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the highest level of the gauge.
+    auto highWater() const noexcept {
+        return mSlot->high_water.load(std::memory_order_relaxed);
+    }
+
+   private:
+    /// \brief The slot in the segment.
+    MetricSlot *mSlot;
+};
+
+/// \brief Handle to a latency histogram of a metrics segment.
+///
+/// Handles are small and copyable, but every copy must be used by the one
+/// thread that writes the metric.
+class MetricHistogram final {
+   public:
+    /// \brief Constructs a handle to a histogram of the segment.
+    explicit MetricHistogram(LatencyHistogram *histogram) noexcept
+        : mHistogram(histogram) {}
+
+    /// \brief Records a latency in time stamp counter ticks.
+    auto record(uint64_t ticks) noexcept -> void {
+        mHistogram->record(ticks);
+    }
+
+    /// \brief Returns the histogram.
+    auto histogram() const noexcept -> const LatencyHistogram & {
+        return *mHistogram;
+    }
+
+   private:
+    /// \brief The histogram in the segment.
+    LatencyHistogram *mHistogram;
+};
+
+/// \brief Creates a metrics segment in shared memory and registers its
+/// counters, gauges and histograms.
+///
+/// Every metric owns whole cache lines of the segment and has a single
+/// writer, so writers never share a line with each other and update their
+/// metrics with plain relaxed stores. Readers in other processes map the
+/// segment read-only with MetricsReader and only ever load, so the writers
+/// pay at most a cache line transfer when a reader has just sampled their
+/// line.
+///
+/// Metrics are registered at startup, by the thread that owns the registry,
+/// and live as long as it. The segment is unlinked when the registry is
+/// destroyed, readers keep their mapping until they close it.
+class MetricsRegistry final {
+   public:
+    /// \brief Creates the segment.
+    /// \param name Name of the shared memory object, "/name".
+    /// \param max_metrics Number of counters and gauges.
+    /// \param max_histograms Number of histograms.
+    explicit MetricsRegistry(const std::string &name,
+                             size_t max_metrics = METRICS_MAX_METRICS,
+                             size_t max_histograms = METRICS_MAX_HISTOGRAMS) {
+        if (!mSegment.create(name,
+                             metricsSegmentSize(max_metrics, max_histograms)))
+            [[unlikely]] {
+            FATAL("Unable to create metrics segment:" + name);
+        }
+        mHeader = new (mSegment.data()) MetricsHeader();
+        mHeader->slot_size = sizeof(MetricSlot);
+        mHeader->max_metrics = static_cast<uint32_t>(max_metrics);
+        mHeader->max_histograms = static_cast<uint32_t>(max_histograms);
+        mHeader->pid = static_cast<uint64_t>(::getpid());
+        mHeader->ticks_per_nano = TscClock::ticksPerNano();
+        mHeader->magic.store(METRICS_MAGIC, std::memory_order_release);
+    }
+
+    /// \brief Registers a counter.
+    /// \param name Name of the counter, shorter than METRICS_NAME_SIZE.
+    auto addCounter(const std::string &name) -> MetricCounter {
+        return MetricCounter(addSlot(name, MetricType::COUNTER, 0));
+    }
+
+    /// \brief Registers a gauge.
+    /// \param name Name of the gauge, shorter than METRICS_NAME_SIZE.
+    /// \param limit Largest possible level, such as a capacity, 0 if none.
+    auto addGauge(const std::string &name, uint64_t limit = 0)
+        -> MetricGauge {
+        return MetricGauge(addSlot(name, MetricType::GAUGE, limit));
+    }
+
+    /// \brief Registers a histogram of time stamp counter ticks.
+    /// \param name Name of the histogram, shorter than METRICS_NAME_SIZE.
+    auto addHistogram(const std::string &name) -> MetricHistogram {
+        if (mHeader->histogram_count == mHeader->max_histograms)
+            [[unlikely]] {
+            FATAL("Metrics segment out of histograms registering " + name);
+        }
+        const auto index = mHeader->histogram_count++;
+        auto histogram =
+            new (mSegment.data() + histogramOffset(*mHeader, index))
+                LatencyHistogram();
+        auto slot = fillSlot(name, MetricType::HISTOGRAM, 0);
+        slot->histogram = index;
+        publishSlot();
+        return MetricHistogram(histogram);
+    }
+
+    /// \brief Returns the name of the segment.
+    auto name() const noexcept -> const std::string & {
+        return mSegment.name();
+    }
+
+    /// \brief Returns the offset of a histogram from the start of a segment.
+    static auto histogramOffset(const MetricsHeader &header,
+                                uint32_t index) noexcept -> size_t {
+        return sizeof(MetricsHeader) +
+               header.max_metrics * sizeof(MetricSlot) +
+               index * METRICS_HISTOGRAM_STRIDE;
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    MetricsRegistry() = delete;
+    MetricsRegistry(const MetricsRegistry &) = delete;
+    MetricsRegistry(const MetricsRegistry &&) = delete;
+    MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+    MetricsRegistry &operator=(const MetricsRegistry &&) = delete;
+
+   private:
+    /// \brief Returns the slots of the segment.
+    auto slots() noexcept {
+        return reinterpret_cast<MetricSlot *>(mSegment.data() +
+                                              sizeof(MetricsHeader));
+    }
+
+    /// \brief Fills the next slot, without publishing it to readers.
+    auto fillSlot(const std::string &name, MetricType type, uint64_t limit)
+        -> MetricSlot * {
+        if (name.size() >= METRICS_NAME_SIZE) [[unlikely]] {
+            FATAL("Metric name too long:" + name);
+        }
+        const auto index =
+            mHeader->metric_count.load(std::memory_order_relaxed);
+        if (index == mHeader->max_metrics) [[unlikely]] {
+            FATAL("Metrics segment out of slots registering " + name);
+        }
+        auto slot = new (&slots()[index]) MetricSlot();
+        slot->limit = limit;
+        slot->type = type;
+        std::memcpy(slot->name, name.c_str(), name.size() + 1);
+        return slot;
+    }
+
+    /// \brief Makes the last filled slot visible to readers.
+    auto publishSlot() noexcept -> void {
+        mHeader->metric_count.store(
+            mHeader->metric_count.load(std::memory_order_relaxed) + 1,
+            std::memory_order_release);
+    }
+
+    /// \brief Fills and publishes the next slot.
+    auto addSlot(const std::string &name, MetricType type, uint64_t limit)
+        -> MetricSlot * {
+        auto slot = fillSlot(name, type, limit);
+        publishSlot();
+        return slot;
+    }
+
+    /// \brief The shared memory segment.
+    SharedMemory mSegment;
+    /// \brief Header at the start of the segment.
+    MetricsHeader *mHeader = nullptr;
+};
+
+/// \brief Maps a metrics segment created by another process read-only and
+/// reads its metrics without ever writing to it.
+class MetricsReader final {
+   public:
+    /// \brief Constructs a reader with no segment mapped.
+    MetricsReader() = default;
+
+    /// \brief Maps a metrics segment.
+    /// \param name Name of the shared memory object, "/name".
+    /// \return true on success, false if the segment does not exist, is not
+    /// initialised yet or has another layout.
+    auto open(const std::string &name) noexcept -> bool {
+        if (!mSegment.openReadOnly(name)) return false;
+        mHeader = reinterpret_cast<const MetricsHeader *>(mSegment.data());
+        if (mSegment.size() < sizeof(MetricsHeader) ||
+            mHeader->magic.load(std::memory_order_acquire) != METRICS_MAGIC ||
+            mHeader->version != METRICS_VERSION ||
+            mHeader->slot_size != sizeof(MetricSlot) ||
+            mSegment.size() != metricsSegmentSize(mHeader->max_metrics,
+                                                  mHeader->max_histograms))
+            [[unlikely]] {
+            mSegment.close();
+            mHeader = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    /// \brief Returns the number of metrics registered so far.
+    auto metricCount() const noexcept -> size_t {
+        return mHeader->metric_count.load(std::memory_order_acquire);
+    }
+
+    /// \brief Returns a registered metric.
+    /// \param index Index in the range [0, metricCount()).
+    auto metric(size_t index) const noexcept -> const MetricSlot & {
+        return reinterpret_cast<const MetricSlot *>(
+            mSegment.data() + sizeof(MetricsHeader))[index];
+    }
+
+    /// \brief Returns the histogram of a HISTOGRAM metric.
+    auto histogram(const MetricSlot &slot) const noexcept
+        -> const LatencyHistogram & {
+        return *reinterpret_cast<const LatencyHistogram *>(
+            mSegment.data() +
+            MetricsRegistry::histogramOffset(*mHeader, slot.histogram));
+    }
+
+    /// \brief Converts histogram ticks to nanoseconds at the writer's rate.
+    auto ticksToNanos(uint64_t ticks) const noexcept -> double {
+        return static_cast<double>(ticks) / mHeader->ticks_per_nano;
+    }
+
+    /// \brief Returns the process id of the writer.
+    auto writerPid() const noexcept { return mHeader->pid; }
+
+    // Deleted copy & move constructors and assignment-operators.
+    MetricsReader(const MetricsReader &) = delete;
+    MetricsReader(const MetricsReader &&) = delete;
+    MetricsReader &operator=(const MetricsReader &) = delete;
+    MetricsReader &operator=(const MetricsReader &&) = delete;
+
+   private:
+    /// \brief The mapped segment.
+    SharedMemory mSegment;
+    /// \brief Header at the start of the segment.
+    const MetricsHeader *mHeader = nullptr;
+};
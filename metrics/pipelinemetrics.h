@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+
+#include "lock-free-queue/lockfreequeue.h"
+#include "metrics/metricsregistry.h"
+#include "order-book/orderbook.h"
+#include "utilities/types.h"
+
+/// \brief Depth and high-water mark of a LockFreeQueue, published as a gauge
+/// named "<name>.depth" with the capacity of the queue as its limit.
+///
+/// The consumer of the queue samples it, usually once per poll, and is the
+/// single writer of the gauge.
+/// \tparam T The type of elements stored in the queue.
+template <typename T>
+class QueueMetrics final {
+   public:
+    /// \brief Registers the gauge of a queue.
+    /// \param registry The registry of the process.
+    /// \param name Name of the queue.
+    /// \param queue The queue.
+    QueueMetrics(MetricsRegistry &registry, const std::string &name,
+                 const LockFreeQueue<T> &queue)
+        : mQueue(queue),
+          mDepth(registry.addGauge(name + ".depth", queue.capacity())) {}
+
+    /// \brief Publishes the current depth of the queue.
+    auto sample() noexcept -> void { mDepth.set(mQueue.size()); }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    QueueMetrics() = delete;
+    QueueMetrics(const QueueMetrics &) = delete;
+    QueueMetrics(const QueueMetrics &&) = delete;
+    QueueMetrics &operator=(const QueueMetrics &) = delete;
+    QueueMetrics &operator=(const QueueMetrics &&) = delete;
+
+   private:
+    /// \brief The queue sampled.
+    const LockFreeQueue<T> &mQueue;
+    /// \brief Depth of the queue.
+    MetricGauge mDepth;
+};
+
+/// \brief Messages, pool occupancy and update latency of a MarketOrderBook.
+///
+/// Registers, for the book of ticker N:
+/// - book.N.updates: market updates applied.
+/// - book.N.orders: orders allocated from the order pool.
+/// - book.N.levels: price levels allocated from the level pool.
+/// - book.N.latency: time to apply the updates timed, in ticks.
+///
+/// The book builder thread is the single writer of all four.
+class BookMetrics final {
+   public:
+    /// \brief Registers the metrics of a book.
+    /// \param registry The registry of the process.
+    /// \param book The book.
+    BookMetrics(MetricsRegistry &registry, const MarketOrderBook &book)
+        : mBook(book),
+          mUpdates(registry.addCounter(prefix(book) + ".updates")),
+          mOrders(registry.addGauge(prefix(book) + ".orders",
+                                    book.orderPool().capacity())),
+          mLevels(registry.addGauge(prefix(book) + ".levels",
+                                    book.levelPool().capacity())),
+          mLatency(registry.addHistogram(prefix(book) + ".latency")) {}
+
+    /// \brief Publishes an update applied to the book.
+    auto onMarketUpdate() noexcept -> void {
+        mUpdates.add();
+        mOrders.set(mBook.orderPool().allocated());
+        mLevels.set(mBook.levelPool().allocated());
+    }
+
+    /// \brief Records the time taken to apply an update. Timing every update
+    /// costs two time stamp counter reads, the book builder may time only a
+    /// sample of them.
+    /// \param ticks Time taken, in time stamp counter ticks.
+    auto recordLatency(uint64_t ticks) noexcept -> void {
+        mLatency.record(ticks);
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    BookMetrics() = delete;
+    BookMetrics(const BookMetrics &) = delete;
+    BookMetrics(const BookMetrics &&) = delete;
+    BookMetrics &operator=(const BookMetrics &) = delete;
+    BookMetrics &operator=(const BookMetrics &&) = delete;
+
+   private:
+    /// \brief Returns the prefix of the metric names of a book.
+    static auto prefix(const MarketOrderBook &book) -> std::string {
+        return "book." + tickerIdToString(book.tickerId());
+    }
+
+    /// \brief The book published.
+    const MarketOrderBook &mBook;
+    /// \brief Market updates applied.
+    MetricCounter mUpdates;
+    /// \brief Orders allocated.
+    MetricGauge mOrders;
+    /// \brief Price levels allocated.
+    MetricGauge mLevels;
+    /// \brief Time to apply an update.
+    MetricHistogram mLatency;
+};
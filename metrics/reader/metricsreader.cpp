@@ -0,0 +1,125 @@
+/// \file metricsreader.cpp
+/// \brief Samples the metrics segment of another process and prints it.
+/// \details Maps the segment read-only, waiting for it to be created, and
+/// prints every metric at a fixed interval: the total and rate of counters,
+/// the level, high-water mark and limit of gauges, and the percentiles of
+/// histograms in nanoseconds. The writers are never paused or signalled.
+/// Exits after the requested number of samples, or once the writer process
+/// is gone.
+///
+/// Usage: MetricsReaderTool NAME [--interval-us N] [--samples N]
+
+#include <signal.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics/metricsregistry.h"
+
+/// \struct ReaderOptions
+/// \brief Command line options of the reader.
+struct ReaderOptions {
+    std::string name;
+    uint64_t interval_us = 1'000'000;
+    /// Number of samples printed, 0 until the writer exits.
+    uint64_t samples = 0;
+};
+
+/// \brief Parses the command line, exiting with the usage on any error.
+auto parseOptions(int argc, char **argv) -> ReaderOptions {
+    ReaderOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const auto has_value = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--interval-us") && has_value) {
+            options.interval_us = std::max<uint64_t>(1, std::stoull(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--samples") && has_value) {
+            options.samples = std::stoull(argv[++i]);
+        } else if (options.name.empty() && argv[i][0] != '-') {
+            options.name = argv[i];
+        } else {
+            options.name.clear();
+            break;
+        }
+    }
+    if (options.name.empty()) {
+        FATAL(std::string("Usage: ") + argv[0] +
+              " NAME [--interval-us N] [--samples N]");
+    }
+    if (options.name[0] != '/') options.name = "/" + options.name;
+    return options;
+}
+
+/// \brief Prints one sample of every metric.
+/// \param previous Counter totals of the previous sample, updated.
+/// \param seconds Time since the previous sample.
+auto printSample(const MetricsReader &reader, std::vector<uint64_t> &previous,
+                 double seconds) -> void {
+    const auto count = reader.metricCount();
+    previous.resize(count, 0);
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t index = 0; index < count; ++index) {
+        const auto &slot = reader.metric(index);
+        const auto value = slot.value.load(std::memory_order_relaxed);
+        std::cout << std::left << std::setw(METRICS_NAME_SIZE) << slot.name
+                  << std::right;
+        switch (slot.type) {
+            case MetricType::COUNTER:
+                std::cout << std::setw(14) << value << std::setw(14)
+                          << (value - previous[index]) / seconds << "/s";
+                previous[index] = value;
+                break;
+            case MetricType::GAUGE:
+                std::cout << std::setw(14) << value << "  high "
+                          << slot.high_water.load(std::memory_order_relaxed);
+                if (slot.limit) std::cout << "  limit " << slot.limit;
+                break;
+            case MetricType::HISTOGRAM: {
+                const auto &histogram = reader.histogram(slot);
+                std::cout << std::setw(14) << histogram.count() << "  p50 "
+                          << reader.ticksToNanos(histogram.percentile(50.0))
+                          << " p99 "
+                          << reader.ticksToNanos(histogram.percentile(99.0))
+                          << " p99.9 "
+                          << reader.ticksToNanos(histogram.percentile(99.9))
+                          << " max " << reader.ticksToNanos(histogram.max())
+                          << " ns";
+            } break;
+            case MetricType::INVALID:
+                break;
+        }
+        std::cout << '\n';
+    }
+    std::cout << std::endl;
+}
+
+/// \brief Main function running the metrics reader.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    const auto options = parseOptions(argc, argv);
+    const auto interval = std::chrono::microseconds(options.interval_us);
+
+    MetricsReader reader;
+    while (!reader.open(options.name)) std::this_thread::sleep_for(interval);
+    std::cout << "metrics " << options.name << " of process "
+              << reader.writerPid() << std::endl;
+
+    std::vector<uint64_t> previous;
+    auto last = std::chrono::steady_clock::now();
+    for (uint64_t sample = 0;
+         !options.samples || sample < options.samples; ++sample) {
+        std::this_thread::sleep_until(last + interval);
+        const auto now = std::chrono::steady_clock::now();
+        printSample(reader, previous,
+                    std::chrono::duration<double>(now - last).count());
+        last = now;
+        if (::kill(static_cast<pid_t>(reader.writerPid()), 0) != 0) break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "micro-benchmark/perfcounters.h"
+#include "utilities/macros.h"
+#include "utilities/threadplacement.h"
+#include "utilities/tscclock.h"
+
+/// \brief Forces the compiler to materialise a value, so that the work
+/// producing it cannot be optimised away.
+template <typename T>
+inline auto doNotOptimize(const T &value) noexcept -> void {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// \struct MicroBenchmarkOptions
+/// \brief Command line options shared by all micro benchmarks.
+struct MicroBenchmarkOptions {
+    /// CPU the benchmark thread is pinned to, -1 for none.
+    int cpu = -1;
+    /// CPU helper threads, like the other end of a ping-pong, are pinned to.
+    int peer_cpu = -1;
+    /// Untimed runs before the measured repetitions.
+    size_t warmup = 2;
+    /// Measured repetitions of every benchmark.
+    size_t repetitions = 10;
+    /// Whether to count hardware events with perf_event_open.
+    bool perf_counters = false;
+    /// Only benchmarks whose name contains this string are run.
+    std::string filter;
+};
+
+/// \brief A command line option of a single benchmark, parsed together with
+/// the MicroBenchmarkOptions shared by all of them.
+class BenchmarkOption final {
+   public:
+    /// \brief An option taking a number.
+    /// \param name The option, e.g. "--updates".
+    /// \param value Receives the number, keeps its default if the option is
+    /// not given. A value that is not a number of its type, like a negative
+    /// one for an unsigned type, is an error.
+    /// \param min Smaller numbers are raised to min.
+    /// \param max Larger numbers are lowered to max.
+    template <typename T>
+        requires(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+    BenchmarkOption(const char *name, T &value,
+                    std::type_identity_t<T> min =
+                        std::numeric_limits<T>::lowest(),
+                    std::type_identity_t<T> max =
+                        std::numeric_limits<T>::max())
+        : mName(name),
+          mValue_name("N"),
+          mParse([&value, min, max](const char *text) {
+              return parseNumber<T>(text, min, max, value);
+          }) {}
+
+    /// \brief An option without value, setting a flag.
+    /// \param name The option, e.g. "--perf".
+    /// \param value Set to true if the option is given.
+    BenchmarkOption(const char *name, bool &value)
+        : mName(name), mParse([&value](const char *) {
+              value = true;
+              return true;
+          }) {}
+
+    /// \brief An option taking a string.
+    /// \param name The option, e.g. "--filter".
+    /// \param value Receives the string.
+    /// \param value_name What the string is, shown in the usage.
+    BenchmarkOption(const char *name, std::string &value,
+                    const char *value_name)
+        : mName(name),
+          mValue_name(value_name),
+          mParse([&value](const char *text) {
+              value = text;
+              return true;
+          }) {}
+
+    /// \brief Returns the option, e.g. "--updates".
+    auto name() const noexcept { return mName; }
+
+    /// \brief Returns what the value of the option is, nullptr for a flag.
+    auto valueName() const noexcept { return mValue_name; }
+
+    /// \brief Sets the variable of the option from its value.
+    /// \param text The value, ignored by a flag.
+    /// \return false if the value is invalid.
+    auto parse(const char *text) const -> bool { return mParse(text); }
+
+   private:
+    /// \brief Parses a number and clamps it to [min, max].
+    /// \return false, leaving value unchanged, unless the whole text is a
+    /// finite number that fits T. Unsigned types take no '-', which the
+    /// std::stoull family would wrap around.
+    template <typename T>
+    static auto parseNumber(const char *text, T min, T max, T &value) -> bool {
+        const auto end = text + std::strlen(text);
+        T number{};
+        const auto [ptr, ec] = std::from_chars(text, end, number);
+        if (ec != std::errc() || ptr != end) return false;
+        if constexpr (std::is_floating_point_v<T>) {
+            if (!std::isfinite(number)) return false;
+        }
+        value = std::clamp<T>(number, min, max);
+        return true;
+    }
+
+    /// \brief The option.
+    const char *mName;
+    /// \brief What the value of the option is, nullptr for a flag.
+    const char *mValue_name = nullptr;
+    /// \brief Sets the variable of the option.
+    std::function<bool(const char *)> mParse;
+};
+
+/// \brief Parses the command line of a benchmark, exiting with the usage on
+/// any error, an unknown option, a missing value or an invalid number.
+///
+/// Every benchmark accepts the shared options:
+/// --cpu N --peer-cpu N --warmup N --reps N --perf --filter NAME
+/// \param options The options of this benchmark.
+/// \return The shared options.
+inline auto parseBenchmarkOptions(
+    int argc, char **argv, std::initializer_list<BenchmarkOption> options = {})
+    -> MicroBenchmarkOptions {
+    MicroBenchmarkOptions shared;
+    const std::initializer_list<BenchmarkOption> shared_options = {
+        {"--cpu", shared.cpu},
+        {"--peer-cpu", shared.peer_cpu},
+        {"--warmup", shared.warmup},
+        {"--reps", shared.repetitions, 1},
+        {"--perf", shared.perf_counters},
+        {"--filter", shared.filter, "NAME"}};
+
+    const auto find = [&](const char *name) -> const BenchmarkOption * {
+        for (const auto list : {shared_options, options}) {
+            for (const auto &option : list) {
+                if (!std::strcmp(option.name(), name)) return &option;
+            }
+        }
+        return nullptr;
+    };
+    for (int i = 1; i < argc; ++i) {
+        const auto option = find(argv[i]);
+        auto valid = option != nullptr;
+        if (valid && !option->valueName()) {
+            option->parse(nullptr);
+        } else if (valid) {
+            valid = i + 1 < argc && option->parse(argv[++i]);
+        }
+        if (!valid) {
+            auto usage = std::string("Usage: ") + argv[0];
+            for (const auto list : {shared_options, options}) {
+                for (const auto &known : list) {
+                    usage += std::string(" [") + known.name();
+                    if (known.valueName()) {
+                        usage += std::string(" ") + known.valueName();
+                    }
+                    usage += "]";
+                }
+            }
+            FATAL(usage);
+        }
+    }
+    return shared;
+}
+
+/// \brief Pins the benchmark thread to --cpu and calibrates the clock.
+inline auto setUpBenchmarkThread(const MicroBenchmarkOptions &options)
+    -> void {
+    ASSERT(pinThread(options.cpu),
+           "Unable to pin the benchmark thread to cpu " +
+               std::to_string(options.cpu));
+    TscClock::calibrate();
+}
+
+/// \brief Minimal harness for micro benchmarks of the low level primitives.
+///
+/// Each benchmark is a callable performing a fixed number of operations. The
+/// harness runs it a few times untimed to warm up the caches, branch
+/// predictors and memory pools, then times every repetition with the time
+/// stamp counter and reports the fastest, median and slowest repetition per
+/// operation. Optionally, hardware events of the benchmark thread are counted
+/// around every repetition and reported per operation.
+///
+/// Options are parsed from the command line by parseBenchmarkOptions().
+class MicroBenchmark final {
+   public:
+    /// \brief Parses the command line, pins the benchmark thread and
+    /// calibrates the clock.
+    /// \param options Options of this benchmark, beside the shared ones.
+    MicroBenchmark(int argc, char **argv,
+                   std::initializer_list<BenchmarkOption> options = {})
+        : mOptions(parseBenchmarkOptions(argc, argv, options)) {
+        setUpBenchmarkThread(mOptions);
+
+        if (mOptions.perf_counters && !mCounters.isAvailable()) {
+            std::cout << "perf_event_open is not available, hardware counters "
+                         "are disabled (see kernel.perf_event_paranoid)"
+                      << std::endl;
+            mOptions.perf_counters = false;
+        }
+
+        std::cout << std::left << std::setw(NAME_WIDTH) << "benchmark"
+                  << std::right << std::setw(12) << "ns/op min"
+                  << std::setw(12) << "ns/op med" << std::setw(12)
+                  << "ns/op max" << std::setw(12) << "ticks/op";
+        if (mOptions.perf_counters) {
+            for (size_t index = 0; index < PERF_COUNTER_COUNT; ++index) {
+                std::cout << std::setw(15)
+                          << perfCounterToString(
+                                 static_cast<PerfCounter>(index));
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    /// \brief Returns the parsed options.
+    auto options() const noexcept -> const MicroBenchmarkOptions & {
+        return mOptions;
+    }
+
+    /// \brief Returns true if a benchmark is selected by --filter.
+    auto selected(const std::string &name) const noexcept {
+        return mOptions.filter.empty() ||
+               name.find(mOptions.filter) != std::string::npos;
+    }
+
+    /// \brief Runs and reports a benchmark.
+    /// \param name Name of the benchmark, printed and matched by --filter.
+    /// \param operations Number of operations one call of function performs.
+    /// \param function Callable performing the operations, it must leave the
+    /// state it works on ready for the next call.
+    template <typename Function>
+    auto run(const std::string &name, size_t operations, Function &&function)
+        -> void {
+        if (!selected(name)) return;
+
+        for (size_t rep = 0; rep < mOptions.warmup; ++rep) function();
+
+        std::vector<uint64_t> ticks(mOptions.repetitions);
+        PerfCounterValues totals;
+        for (size_t rep = 0; rep < mOptions.repetitions; ++rep) {
+            if (mOptions.perf_counters) mCounters.start();
+            const auto start = TscClock::now();
+            function();
+            const auto end = TscClock::nowSerialized();
+            if (mOptions.perf_counters) {
+                const auto values = mCounters.stop();
+                for (size_t index = 0; index < PERF_COUNTER_COUNT; ++index) {
+                    totals.counts[index] += values.counts[index];
+                    totals.valid[index] = values.valid[index];
+                }
+            }
+            ticks[rep] = end - start;
+        }
+        std::sort(ticks.begin(), ticks.end());
+
+        const auto per_op = [operations](uint64_t value) {
+            return static_cast<double>(value) / operations;
+        };
+        std::cout << std::fixed << std::setprecision(2) << std::left
+                  << std::setw(NAME_WIDTH) << name << std::right
+                  << std::setw(12)
+                  << TscClock::ticksToNanos(ticks.front()) / operations
+                  << std::setw(12)
+                  << TscClock::ticksToNanos(ticks[ticks.size() / 2]) /
+                         operations
+                  << std::setw(12)
+                  << TscClock::ticksToNanos(ticks.back()) / operations
+                  << std::setw(12) << per_op(ticks[ticks.size() / 2]);
+        if (mOptions.perf_counters) {
+            for (size_t index = 0; index < PERF_COUNTER_COUNT; ++index) {
+                std::cout << std::setw(15);
+                if (totals.valid[index]) {
+                    std::cout << per_op(totals.counts[index]) /
+                                     mOptions.repetitions;
+                } else {
+                    std::cout << "n/a";
+                }
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    MicroBenchmark() = delete;
+    MicroBenchmark(const MicroBenchmark &) = delete;
+    MicroBenchmark(const MicroBenchmark &&) = delete;
+    MicroBenchmark &operator=(const MicroBenchmark &) = delete;
+    MicroBenchmark &operator=(const MicroBenchmark &&) = delete;
+
+   private:
+    /// \brief Width of the name column.
+    static constexpr int NAME_WIDTH = 40;
+
+    /// \brief Parsed command line options.
+    MicroBenchmarkOptions mOptions;
+    /// \brief Hardware event counters of the benchmark thread.
+    PerfCounters mCounters;
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+/// \enum PerfCounter
+/// \brief Hardware events counted around every benchmark repetition.
+enum class PerfCounter : uint8_t {
+    CYCLES = 0,
+    INSTRUCTIONS = 1,
+    CACHE_MISSES = 2,
+    BRANCH_MISSES = 3,
+    MAX = 4
+};
+
+/// \brief Number of hardware events counted.
+constexpr size_t PERF_COUNTER_COUNT = static_cast<size_t>(PerfCounter::MAX);
+
+/// \brief Converts a PerfCounter enum to a string.
+/// \param counter The PerfCounter to convert.
+/// \return String representation of the PerfCounter.
+inline auto perfCounterToString(PerfCounter counter) -> std::string {
+    switch (counter) {
+        case PerfCounter::CYCLES:
+            return "cycles";
+        case PerfCounter::INSTRUCTIONS:
+            return "instructions";
+        case PerfCounter::CACHE_MISSES:
+            return "cache-misses";
+        case PerfCounter::BRANCH_MISSES:
+            return "branch-misses";
+        case PerfCounter::MAX:
+            return "MAX";
+    }
+    return "UNKNOWN";
+}
+
+/// \struct PerfCounterValues
+/// \brief Event counts read over one measured region.
+struct PerfCounterValues {
+    /// Count of every event, indexed by PerfCounter.
+    std::array<uint64_t, PERF_COUNTER_COUNT> counts = {};
+    /// Whether the event could be counted on this machine.
+    std::array<bool, PERF_COUNTER_COUNT> valid = {};
+};
+
+/// \brief Counts hardware events of the calling thread with perf_event_open.
+///
+/// All events are opened as a single group so that they are scheduled onto
+/// the PMU together and describe exactly the same instructions. Counters are
+/// optional: inside containers and virtual machines, or with a restrictive
+/// kernel.perf_event_paranoid, the events cannot be opened and isAvailable()
+/// returns false. Events the CPU does not support are reported as invalid
+/// while the others are still counted.
+class PerfCounters final {
+   public:
+    /// \brief Opens the event group for the calling thread.
+    PerfCounters() noexcept {
+        mFds.fill(-1);
+#if defined(__linux__)
+        constexpr std::array<uint64_t, PERF_COUNTER_COUNT> CONFIGS = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+        for (size_t index = 0; index < PERF_COUNTER_COUNT; ++index) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = CONFIGS[index];
+            attr.disabled = mLeader_fd < 0 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP |
+                               PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            const auto fd = static_cast<int>(
+                syscall(SYS_perf_event_open, &attr, 0, -1, mLeader_fd, 0));
+            if (fd < 0) continue;
+
+            if (mLeader_fd < 0) mLeader_fd = fd;
+            mFds[index] = fd;
+            mGroup_position[index] = mGroup_size++;
+        }
+#endif
+    }
+
+    /// \brief Closes the event group.
+    ~PerfCounters() noexcept {
+#if defined(__linux__)
+        for (const auto fd : mFds) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    /// \brief Returns true if at least one event can be counted.
+    auto isAvailable() const noexcept { return mLeader_fd >= 0; }
+
+    /// \brief Resets and starts all counters.
+    auto start() noexcept -> void {
+#if defined(__linux__)
+        if (!isAvailable()) return;
+        ioctl(mLeader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(mLeader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    /// \brief Stops all counters and reads them.
+    /// \return Event counts since start(), scaled up if the kernel had to
+    /// multiplex the group with other events.
+    auto stop() noexcept -> PerfCounterValues {
+        PerfCounterValues values;
+#if defined(__linux__)
+        if (!isAvailable()) return values;
+        ioctl(mLeader_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // nr, time_enabled, time_running, then one value per event.
+        std::array<uint64_t, 3 + PERF_COUNTER_COUNT> buffer = {};
+        if (read(mLeader_fd, buffer.data(), sizeof(buffer)) <= 0) {
+            return values;
+        }
+        const auto time_enabled = buffer[1];
+        const auto time_running = buffer[2];
+        const auto scale =
+            time_running ? static_cast<double>(time_enabled) / time_running
+                         : 0.0;
+
+        for (size_t index = 0; index < PERF_COUNTER_COUNT; ++index) {
+            if (mFds[index] < 0) continue;
+            values.counts[index] = static_cast<uint64_t>(
+                buffer[3 + mGroup_position[index]] * scale);
+            values.valid[index] = time_running != 0;
+        }
+#endif
+        return values;
+    }
+
+    // Deleted copy & move constructors and assignment-operators.
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters(const PerfCounters &&) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &&) = delete;
+
+   private:
+    /// \brief File descriptor of every event, -1 if it could not be opened.
+    std::array<int, PERF_COUNTER_COUNT> mFds;
+    /// \brief Position of every event within the group read.
+    std::array<size_t, PERF_COUNTER_COUNT> mGroup_position = {};
+    /// \brief Number of events in the group.
+    size_t mGroup_size = 0;
+    /// \brief File descriptor of the group leader, -1 if none could be opened.
+    int mLeader_fd = -1;
+};
@@ -0,0 +1,88 @@
+/// \file benchmark_orderbook.cpp
+/// \brief Cost of adding and cancelling orders in a MarketOrderBook.
+/// \details Builds books with an increasing number of price levels per side
+/// and measures an add followed by a cancel of the same order at three places:
+/// joining the queue at the touch, opening a new best price level, and opening
+/// a new level behind all the others. Every pair leaves the book unchanged, so
+/// each repetition sees the same depth.
+
+#include <memory>
+
+#include "micro-benchmark/microbenchmark.h"
+#include "order-book/orderbook.h"
+
+/// \brief Number of add / cancel pairs per repetition.
+constexpr size_t NUM_OPERATIONS = 200'000;
+
+/// \brief Resting orders on every price level of the prepared book.
+constexpr size_t ORDERS_PER_LEVEL = 4;
+
+/// \brief Price between the two sides of the prepared book.
+constexpr Price MID_PRICE = 1'000;
+
+/// \brief Main function running the order book benchmarks.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    MicroBenchmark benchmark(argc, argv);
+
+    // Books are far too large for the stack.
+    auto book = std::make_unique<MarketOrderBook>(0);
+
+    for (const Price depth : {1, 8, 32, 64, 120}) {
+        MEMarketUpdate update;
+        update.type = MarketUpdateType::CLEAR;
+        book->onMarketUpdate(&update);
+
+        // Prepare depth levels on each side around MID_PRICE.
+        OrderId order_id = 0;
+        update.type = MarketUpdateType::ADD;
+        update.ticker_id = 0;
+        update.qty = 100;
+        for (Price level = 0; level < depth; ++level) {
+            for (size_t i = 0; i < ORDERS_PER_LEVEL; ++i) {
+                update.order_id = order_id++;
+                update.priority = update.order_id;
+                update.side = Side::BUY;
+                update.price = MID_PRICE - 1 - level;
+                book->onMarketUpdate(&update);
+
+                update.order_id = order_id++;
+                update.priority = update.order_id;
+                update.side = Side::SELL;
+                update.price = MID_PRICE + 1 + level;
+                book->onMarketUpdate(&update);
+            }
+        }
+
+        const auto add_cancel = [&](Price price) {
+            MEMarketUpdate add;
+            add.type = MarketUpdateType::ADD;
+            add.order_id = order_id;
+            add.ticker_id = 0;
+            add.side = Side::BUY;
+            add.price = price;
+            add.qty = 100;
+            add.priority = order_id;
+            MEMarketUpdate cancel = add;
+            cancel.type = MarketUpdateType::CANCEL;
+
+            return [&book, add, cancel]() {
+                for (size_t i = 0; i < NUM_OPERATIONS; ++i) {
+                    book->onMarketUpdate(&add);
+                    book->onMarketUpdate(&cancel);
+                }
+                doNotOptimize(book->getBestBidOffer()->mBid_qty);
+            };
+        };
+
+        const auto suffix = " depth " + std::to_string(depth);
+        benchmark.run("add+cancel at touch" + suffix, NUM_OPERATIONS,
+                      add_cancel(MID_PRICE - 1));
+        benchmark.run("add+cancel new best level" + suffix, NUM_OPERATIONS,
+                      add_cancel(MID_PRICE));
+        benchmark.run("add+cancel new last level" + suffix, NUM_OPERATIONS,
+                      add_cancel(MID_PRICE - 1 - depth));
+    }
+
+    return 0;
+}
@@ -3,7 +3,11 @@
 MarketOrderBook::MarketOrderBook(TickerId ticker_id)
     : mTicker_id(ticker_id),
       mOrders_at_price_pool(ME_MAX_PRICE_LEVELS),
-      mOrder_pool(ME_MAX_ORDER_IDS) {};
+      mOrder_pool(ME_MAX_ORDER_IDS) {
+    // std::array members of pointers are not value initialised
+    mOrder_id_to_oder.fill(nullptr);
+    mPrice_orders_at_price.fill(nullptr);
+}
 
 MarketOrderBook::~MarketOrderBook() {
     // reset the internal data members
@@ -14,14 +18,15 @@ MarketOrderBook::~MarketOrderBook() {
 
 auto MarketOrderBook::onMarketUpdate(
     const MEMarketUpdate *market_update) noexcept -> void {
-    // Check if the bid price level was updated by comparing side and price
-    const auto bid_updated =
-        (mBids_by_price && market_update->side == Side::BUY &&
-         market_update->price >= mBids_by_price->mPrice);
+    // Check if the bid price level was updated by comparing side and price,
+    // an update on an empty side always creates the best level
+    auto bid_updated = (market_update->side == Side::BUY &&
+                        (!mBids_by_price ||
+                         market_update->price >= mBids_by_price->mPrice));
     // Check if the ask price level was updated by comparing side and price
-    const auto ask_updated =
-        (mAsks_by_price && market_update->side == Side::SELL &&
-         market_update->price <= mAsks_by_price->mPrice);
+    auto ask_updated = (market_update->side == Side::SELL &&
+                        (!mAsks_by_price ||
+                         market_update->price <= mAsks_by_price->mPrice));
 
     // Process the market update based on its type
     switch (market_update->type) {
@@ -37,8 +42,11 @@ auto MarketOrderBook::onMarketUpdate(
         case MarketUpdateType::MODIFY: {
             // Retrieve the existing order by its ID
             auto order = mOrder_id_to_oder.at(market_update->order_id);
-            // Update the order quantity with the new quantity from the update
-            order->mOrder_id = market_update->qty;
+            // Update the order and level quantity with the new quantity from
+            // the update
+            auto orders_at_price = getOrdersAtPrice(order->mPrice);
+            orders_at_price->mTotal_qty += market_update->qty - order->mQty;
+            order->mQty = market_update->qty;
         } break;
         case MarketUpdateType::CANCEL: {
             // Retrieve the order to be cancelled by its ID
@@ -76,8 +84,12 @@ auto MarketOrderBook::onMarketUpdate(
                 mOrders_at_price_pool.deallocate(mAsks_by_price);
             }
 
-            // Reset bid and ask pointers
+            // Reset bid and ask pointers and the price level mapping
             mBids_by_price = mAsks_by_price = nullptr;
+            mPrice_orders_at_price.fill(nullptr);
+
+            // Both sides of the book are now empty
+            bid_updated = ask_updated = true;
         } break;
         case MarketUpdateType::INVALID:
         case MarketUpdateType::SNAPSHOT_START:
@@ -36,37 +36,26 @@ class MarketOrderBook final {
 
     /// \brief Update the BestBidOffer abstraction, the two boolean parameters
     /// represent if the buy or the sekk (or both) sides or both need to be
-    /// updated.
+    /// updated. The quantity at a level is maintained as orders come and go,
+    /// so this is constant time.
     /// \param update_bid flag to update the bid parameters
     /// \param update_ask flag to update the ask parameters
     auto updateBestBidOffer(bool update_bid, bool update_ask) noexcept {
         if (update_bid) {
             if (mBids_by_price) {
                 mBest_bid_offer.mBid_price = mBids_by_price->mPrice;
-                mBest_bid_offer.mBid_qty =
-                    mBids_by_price->mFirst_market_order->mQty;
-                for (auto order =
-                         mBids_by_price->mFirst_market_order->mNext_order;
-                     order != mBids_by_price->mFirst_market_order;
-                     order = order->mNext_order)
-                    mBest_bid_offer.mBid_qty += order->mQty;
+                mBest_bid_offer.mBid_qty = mBids_by_price->mTotal_qty;
             } else {
                 // There is no head the the mBids_by_price is nullptr
                 mBest_bid_offer.mBid_price = Price_INVALID;
-                mBest_bid_offer.mAsk_qty = Qty_INVALID;
+                mBest_bid_offer.mBid_qty = Qty_INVALID;
             }
         }
 
         if (update_ask) {
             if (mAsks_by_price) {
                 mBest_bid_offer.mAsk_price = mAsks_by_price->mPrice;
-                mBest_bid_offer.mAsk_qty =
-                    mAsks_by_price->mFirst_market_order->mQty;
-                for (auto order =
-                         mAsks_by_price->mFirst_market_order->mNext_order;
-                     order != mAsks_by_price->mFirst_market_order;
-                     order = order->mNext_order)
-                    mBest_bid_offer.mAsk_qty += order->mQty;
+                mBest_bid_offer.mAsk_qty = mAsks_by_price->mTotal_qty;
             } else {
                 // There is no head the the mAsks_by_price is nullptr
                 mBest_bid_offer.mAsk_price = Price_INVALID;
@@ -79,6 +68,69 @@ class MarketOrderBook final {
         return &mBest_bid_offer;
     }
 
+    /// \brief Returns the best price level of a side, the head of its
+    /// circular linked list of levels. Following mNext_entry visits the levels
+    /// from the best to the worst price and wraps around to the head.
+    /// \param side Side of the levels.
+    /// \return The best level, nullptr if the side is empty.
+    auto getBestLevel(Side side) const noexcept -> const MarketOrderAtPrice * {
+        return side == Side::BUY ? mBids_by_price : mAsks_by_price;
+    }
+
+    /// \brief Returns a resting order by its id.
+    /// \param order_id The id of the order.
+    /// \return The order, nullptr if it is not in the book.
+    auto getOrder(OrderId order_id) const noexcept -> const MarketOrder * {
+        return order_id < mOrder_id_to_oder.size()
+                   ? mOrder_id_to_oder[order_id]
+                   : nullptr;
+    }
+
+    /// \brief Returns the price level of a side at a price.
+    /// \param side Side of the level.
+    /// \param price Price of the level.
+    /// \return The level, nullptr if the side has no orders at the price.
+    auto getLevel(Side side, Price price) const noexcept
+        -> const MarketOrderAtPrice * {
+        const auto level = getOrdersAtPrice(price);
+        return level && level->mSide == side && level->mPrice == price
+                   ? level
+                   : nullptr;
+    }
+
+    /// \brief Appends an order to the end of the queue at its price, without
+    /// updating the best bid and offer. Bulk loads an empty book, from a
+    /// checkpoint for instance, and must be followed by finishLoad().
+    /// \param order_id Order identifier.
+    /// \param side Side of the order.
+    /// \param price Price of the order.
+    /// \param qty Quantity of the order.
+    /// \param priority Priority of the order.
+    auto loadOrder(OrderId order_id, Side side, Price price, Qty qty,
+                   Priority priority) noexcept -> void {
+        addOrder(mOrder_pool.allocate(order_id, side, price, qty, priority,
+                                      nullptr, nullptr));
+    }
+
+    /// \brief Updates the best bid and offer after orders were loaded with
+    /// loadOrder().
+    auto finishLoad() noexcept -> void { updateBestBidOffer(true, true); }
+
+    /// \brief Returns the ticker id of the book.
+    auto tickerId() const noexcept { return mTicker_id; }
+
+    /// \brief Returns the memory pool of the orders, for its occupancy.
+    auto orderPool() const noexcept -> const MemoryPool<MarketOrder> & {
+        return mOrder_pool;
+    }
+
+    /// \brief Returns the memory pool of the price levels, for its
+    /// occupancy.
+    auto levelPool() const noexcept
+        -> const MemoryPool<MarketOrderAtPrice> & {
+        return mOrders_at_price_pool;
+    }
+
    private:
     /// \brief The ticker id for the instrument.
     const TickerId mTicker_id;
@@ -98,8 +150,6 @@ class MarketOrderBook final {
 
     /// \brief Best bid and offer for the order book.
     BestBidOffer mBest_bid_offer;
-    /// \brief Time string for the order book.
-    std::string mtime_str;
 
    private:
     /// \brief Maps a price to an index for O(1) lookup in the price-level
@@ -250,6 +300,8 @@ class MarketOrderBook final {
                 order->mSide, order->mPrice, order, nullptr, nullptr);
             // Add the new price level to the price-level linked list
             addOrdersAtPrice(new_orders_at_price);
+            new_orders_at_price->mTotal_qty = order->mQty;
+            new_orders_at_price->mOrder_count = 1;
         } else {
             // Price level already exists, append order to the FIFO queue at
             // this price
@@ -262,17 +314,86 @@ class MarketOrderBook final {
             order->mPrev_order = first_order->mPrev_order;
             order->mNext_order = first_order;
             first_order->mPrev_order = order;
+
+            orders_at_price->mTotal_qty += order->mQty;
+            ++orders_at_price->mOrder_count;
         }
 
         // Track the order in the order ID array for fast lookup
         mOrder_id_to_oder.at(order->mOrder_id) = order;
     }
 
-    /// Remove the MarketOrdersAtPrice from the containers - the hash map and
-    /// the doubly linked list of price levels.
-    auto removeOrdersAtPrice(Side side, Price price) noexcept {}
+    /// \brief Remove the MarketOrdersAtPrice from the containers - the hash
+    /// map and the doubly linked list of price levels.
+    ///
+    /// If the price level is the best one for its side, the head of the
+    /// linked list moves on to the next level. The MarketOrderAtPrice is
+    /// returned to its memory pool.
+    /// \param side Side of the price level.
+    /// \param price Price of the level to remove.
+    /// \return void
+    auto removeOrdersAtPrice(Side side, Price price) noexcept {
+        const auto best_orders_by_price =
+            (side == Side::BUY ? mBids_by_price : mAsks_by_price);
+        auto orders_at_price = getOrdersAtPrice(price);
 
-    auto removeOrder(MarketOrder *order) noexcept -> void {}
+        if (orders_at_price->mNext_entry == orders_at_price) [[unlikely]] {
+            // Only price level on this side, the side becomes empty
+            (side == Side::BUY ? mBids_by_price : mAsks_by_price) = nullptr;
+        } else {
+            // Unlink the price level from the circular linked list
+            orders_at_price->mPrev_entry->mNext_entry =
+                orders_at_price->mNext_entry;
+            orders_at_price->mNext_entry->mPrev_entry =
+                orders_at_price->mPrev_entry;
+
+            if (orders_at_price == best_orders_by_price) {
+                (side == Side::BUY ? mBids_by_price : mAsks_by_price) =
+                    orders_at_price->mNext_entry;
+            }
+
+            orders_at_price->mPrev_entry = orders_at_price->mNext_entry =
+                nullptr;
+        }
+
+        mPrice_orders_at_price.at(priceToIndex(price)) = nullptr;
+
+        mOrders_at_price_pool.deallocate(orders_at_price);
+    }
+
+    /// \brief Remove a single order from the FIFO queue at its price level.
+    ///
+    /// If the order is the only one at its price level, the whole price level
+    /// is removed as well. The order is dropped from the order id array and
+    /// returned to its memory pool.
+    /// \param order Pointer to the MarketOrder to remove.
+    /// \return void
+    auto removeOrder(MarketOrder *order) noexcept -> void {
+        auto orders_at_price = getOrdersAtPrice(order->mPrice);
+
+        if (order->mPrev_order == order) {
+            // Only order at this price level
+            removeOrdersAtPrice(order->mSide, order->mPrice);
+        } else {
+            // Unlink the order from the circular linked list of orders
+            const auto order_before = order->mPrev_order;
+            const auto order_after = order->mNext_order;
+            order_before->mNext_order = order_after;
+            order_after->mPrev_order = order_before;
+
+            if (orders_at_price->mFirst_market_order == order) {
+                orders_at_price->mFirst_market_order = order_after;
+            }
+
+            orders_at_price->mTotal_qty -= order->mQty;
+            --orders_at_price->mOrder_count;
+
+            order->mPrev_order = order->mNext_order = nullptr;
+        }
+
+        mOrder_id_to_oder.at(order->mOrder_id) = nullptr;
+        mOrder_pool.deallocate(order);
+    }
 };
 
 /// \typedef MarketOrderBookHashMap
@@ -0,0 +1,162 @@
+/// \file benchmark_orderflow.cpp
+/// \brief End-to-end order book benchmark over synthetic order flow.
+/// \details Generates realistic L3 order flow, replays it through
+/// MarketOrderBook::onMarketUpdate and reports the throughput together with
+/// the distribution of the per-message latency, measured with the time stamp
+/// counter. Results are printed for humans and, with --json, written as a JSON
+/// object for scripts comparing runs.
+///
+/// Usage: OrderFlowBenchmark [--updates N] [--tickers N] [--seed N]
+///                           [--json PATH] [harness options]
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowbooks.h"
+#include "utilities/latencyhistogram.h"
+#include "utilities/tscclock.h"
+
+/// \brief Replays the whole flow into the books.
+auto replay(const std::vector<OrderFlowEvent> &flow, OrderFlowBooks &books) {
+    for (const auto &event : flow) books.onMarketUpdate(&event.update);
+}
+
+/// \brief Measures the smallest cost of the timing instructions themselves,
+/// which is subtracted from every latency sample.
+auto timerOverhead() -> uint64_t {
+    auto overhead = std::numeric_limits<uint64_t>::max();
+    for (int i = 0; i < 100'000; ++i) {
+        const auto start = TscClock::now();
+        const auto end = TscClock::nowSerialized();
+        overhead = std::min(overhead, end - start);
+    }
+    return overhead;
+}
+
+/// \brief Main function running the order flow benchmark.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    size_t updates = 2'000'000;
+    TickerId tickers = 4;
+    uint64_t seed = 42;
+    std::string json_path;
+    setUpBenchmarkThread(
+        parseBenchmarkOptions(argc, argv,
+                              {{"--updates", updates},
+                               {"--tickers", tickers},
+                               {"--seed", seed},
+                               {"--json", json_path, "PATH"}}));
+
+    OrderFlowConfig config;
+    config.seed = seed;
+    config.num_tickers = tickers;
+    OrderFlowGenerator generator(config);
+
+    // Generate the whole flow up front so that only the books are measured.
+    // The last arrival is completed so that the final books can be checked.
+    const auto flow = generateOrderFlowEvents(generator, updates);
+    OrderFlowBooks books(tickers);
+
+    const auto overhead = timerOverhead();
+
+    // Warm up the caches, the branch predictors and the memory pools.
+    replay(flow, books);
+    books.clear();
+
+    // Throughput pass, without per-message timing.
+    const auto start = std::chrono::steady_clock::now();
+    replay(flow, books);
+    const auto end = std::chrono::steady_clock::now();
+    const auto seconds = std::chrono::duration<double>(end - start).count();
+
+    // The books must agree with the state implied by the flow.
+    for (TickerId ticker_id = 0; ticker_id < tickers; ++ticker_id) {
+        const auto expected = generator.bestBidOffer(ticker_id);
+        const auto actual = books[ticker_id].getBestBidOffer();
+        ASSERT(expected.mBid_price == actual->mBid_price &&
+                   expected.mBid_qty == actual->mBid_qty &&
+                   expected.mAsk_price == actual->mAsk_price &&
+                   expected.mAsk_qty == actual->mAsk_qty,
+               "Book " + std::to_string(ticker_id) + " " +
+                   actual->toString() + " differs from the flow " +
+                   expected.toString());
+    }
+    books.clear();
+
+    // Latency pass, timing every message.
+    LatencyHistogram histogram;
+    for (const auto &event : flow) {
+        auto &book = books[event.update.ticker_id];
+        const auto begin = TscClock::now();
+        book.onMarketUpdate(&event.update);
+        const auto finish = TscClock::nowSerialized();
+        const auto ticks = finish - begin;
+        histogram.record(ticks > overhead ? ticks - overhead : 0);
+    }
+
+    const auto nanos = [](uint64_t ticks) {
+        return TscClock::ticksToNanos(ticks);
+    };
+    /// Percentiles reported, with their labels.
+    const std::pair<double, const char *> PERCENTILES[] = {
+        {50.0, "p50"}, {90.0, "p90"}, {99.0, "p99"}, {99.9, "p99.9"},
+        {99.99, "p99.99"}};
+
+    std::cout << std::fixed << std::setprecision(2) << "replayed "
+              << flow.size() << " updates over " << tickers
+              << " tickers (add " << generator.eventCount(MarketUpdateType::ADD)
+              << ", modify " << generator.eventCount(MarketUpdateType::MODIFY)
+              << ", cancel " << generator.eventCount(MarketUpdateType::CANCEL)
+              << ", trade " << generator.eventCount(MarketUpdateType::TRADE)
+              << ")" << std::endl;
+    std::cout << "throughput " << flow.size() / seconds / 1e6 << " Mmsg/s "
+              << seconds * 1e9 / flow.size() << " ns/msg" << std::endl;
+    std::cout << "latency ns min " << nanos(histogram.min());
+    for (const auto &[percentile, label] : PERCENTILES) {
+        std::cout << " " << label << " "
+                  << nanos(histogram.percentile(percentile));
+    }
+    std::cout << " max " << nanos(histogram.max()) << " mean "
+              << histogram.mean() / TscClock::ticksPerNano() << std::endl;
+
+    if (!json_path.empty()) {
+        std::ofstream json(json_path, std::ios::trunc);
+        json << std::fixed << std::setprecision(3) << "{\"benchmark\":"
+             << "\"order_flow\",\"updates\":" << flow.size()
+             << ",\"tickers\":" << tickers
+             << ",\"seed\":" << seed
+             << ",\"ticks_per_ns\":" << TscClock::ticksPerNano()
+             << ",\"timer_overhead_ticks\":" << overhead
+             << ",\"throughput_msgs_per_sec\":" << flow.size() / seconds
+             << ",\"latency_ns\":{\"min\":" << nanos(histogram.min());
+        for (const auto &[percentile, label] : PERCENTILES) {
+            json << ",\"" << label << "\":"
+                 << nanos(histogram.percentile(percentile));
+        }
+        json << ",\"max\":" << nanos(histogram.max())
+             << ",\"mean\":" << histogram.mean() / TscClock::ticksPerNano()
+             << "},\"histogram_ticks\":[";
+        // Only the non-empty buckets, as [highest equivalent value, count].
+        auto first = true;
+        for (size_t index = 0; index < LatencyHistogram::BUCKET_COUNT;
+             ++index) {
+            const auto count = histogram.bucketCount(index);
+            if (!count) continue;
+            json << (first ? "" : ",") << "["
+                 << LatencyHistogram::highestEquivalentValue(index) << ","
+                 << count << "]";
+            first = false;
+        }
+        json << "]}" << std::endl;
+        ASSERT(static_cast<bool>(json),
+               "Unable to write the results to " + json_path);
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "order-book/orderbook.h"
+#include "order-flow/orderflowgenerator.h"
+
+/// \brief Generates a flow of at least a number of updates, completing the
+/// last arrival so that books fed the whole flow match the generator.
+/// \param generator The generator.
+/// \param updates Minimum number of updates.
+/// \return The updates with the time they occurred.
+inline auto generateOrderFlowEvents(OrderFlowGenerator &generator,
+                                    size_t updates)
+    -> std::vector<OrderFlowEvent> {
+    std::vector<OrderFlowEvent> flow;
+    flow.reserve(updates + ME_MAX_PRICE_LEVELS);
+    while (flow.size() < updates || generator.hasPending()) {
+        flow.push_back(*generator.next());
+    }
+    return flow;
+}
+
+/// \brief Generates a flow of at least a number of updates, like
+/// generateOrderFlowEvents() without the times.
+/// \param generator The generator.
+/// \param updates Minimum number of updates.
+/// \return The updates.
+inline auto generateOrderFlow(OrderFlowGenerator &generator, size_t updates)
+    -> std::vector<MEMarketUpdate> {
+    std::vector<MEMarketUpdate> flow;
+    flow.reserve(updates + ME_MAX_PRICE_LEVELS);
+    while (flow.size() < updates || generator.hasPending()) {
+        flow.push_back(generator.next()->update);
+    }
+    return flow;
+}
+
+/// \brief A MarketOrderBook for every ticker of an order flow.
+///
+/// Books are far too large for the stack, they are allocated one by one on
+/// the heap and also handed out as a MarketOrderBookHashMap.
+class OrderFlowBooks final {
+   public:
+    /// \brief Creates empty books for tickers 0 to num_tickers - 1.
+    /// \param num_tickers Number of tickers, at most ME_MAX_TICKERS.
+    explicit OrderFlowBooks(TickerId num_tickers) {
+        ASSERT(num_tickers <= ME_MAX_TICKERS,
+               "Too many tickers: " + tickerIdToString(num_tickers));
+        for (TickerId ticker_id = 0; ticker_id < num_tickers; ++ticker_id) {
+            mStorage.push_back(std::make_unique<MarketOrderBook>(ticker_id));
+            mBooks[ticker_id] = mStorage.back().get();
+        }
+    }
+
+    /// \brief Applies an update to the book of its ticker.
+    auto onMarketUpdate(const MEMarketUpdate *update) noexcept -> void {
+        mBooks[update->ticker_id]->onMarketUpdate(update);
+    }
+
+    /// \brief Clears every book, so that the next replay starts from empty.
+    auto clear() noexcept -> void {
+        MEMarketUpdate clear;
+        clear.type = MarketUpdateType::CLEAR;
+        for (TickerId ticker_id = 0; ticker_id < size(); ++ticker_id) {
+            clear.ticker_id = ticker_id;
+            mBooks[ticker_id]->onMarketUpdate(&clear);
+        }
+    }
+
+    /// \brief Returns the book of a ticker.
+    auto operator[](TickerId ticker_id) noexcept -> MarketOrderBook & {
+        return *mBooks[ticker_id];
+    }
+
+    /// \brief Returns the book of a ticker.
+    auto operator[](TickerId ticker_id) const noexcept
+        -> const MarketOrderBook & {
+        return *mBooks[ticker_id];
+    }
+
+    /// \brief Returns the books indexed by TickerId, nullptr past the last
+    /// ticker.
+    auto books() noexcept -> MarketOrderBookHashMap & { return mBooks; }
+
+    /// \brief Returns the number of books.
+    auto size() const noexcept -> size_t { return mStorage.size(); }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    OrderFlowBooks() = delete;
+    OrderFlowBooks(const OrderFlowBooks &) = delete;
+    OrderFlowBooks(const OrderFlowBooks &&) = delete;
+    OrderFlowBooks &operator=(const OrderFlowBooks &) = delete;
+    OrderFlowBooks &operator=(const OrderFlowBooks &&) = delete;
+
+   private:
+    /// \brief The books.
+    std::vector<std::unique_ptr<MarketOrderBook>> mStorage;
+    /// \brief The books indexed by TickerId.
+    MarketOrderBookHashMap mBooks = {};
+};
@@ -0,0 +1,332 @@
+#include "orderflowgenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+OrderFlowGenerator::OrderFlowGenerator(const OrderFlowConfig &config)
+    : mConfig(config),
+      mRng(config.seed),
+      mInter_arrival(config.arrivals_per_second / 1e9),
+      mLifetime(std::log(config.median_lifetime_ns), config.lifetime_sigma) {
+    ASSERT(mConfig.num_tickers > 0 && mConfig.num_tickers <= ME_MAX_TICKERS,
+           "OrderFlowGenerator supports 1 to " +
+               std::to_string(ME_MAX_TICKERS) + " tickers.");
+    ASSERT(mConfig.max_live_orders > 0 &&
+               mConfig.max_live_orders <= ME_MAX_ORDER_IDS,
+           "max_live_orders must fit the OrderArray of a MarketOrderBook.");
+    ASSERT(mConfig.max_depth > 0 &&
+               2 * mConfig.max_depth < static_cast<Price>(ME_MAX_PRICE_LEVELS),
+           "Both sides of the book must fit in ME_MAX_PRICE_LEVELS.");
+    ASSERT(mConfig.modify_probability + mConfig.trade_probability +
+                   mConfig.mid_move_probability <
+               1.0,
+           "Some arrivals must be new orders.");
+
+    double total_weight = 0.0;
+    for (TickerId ticker_id = 0; ticker_id < mConfig.num_tickers;
+         ++ticker_id) {
+        total_weight += 1.0 / std::pow(ticker_id + 1, mConfig.ticker_skew);
+        mTicker_weights.push_back(total_weight);
+    }
+    for (auto &weight : mTicker_weights) weight /= total_weight;
+
+    // All storage is sized up front, generation never allocates.
+    mTickers.resize(mConfig.num_tickers);
+    for (TickerId ticker_id = 0; ticker_id < mConfig.num_tickers;
+         ++ticker_id) {
+        auto &ticker = mTickers[ticker_id];
+        ticker.base = 10'000 + static_cast<Price>(ticker_id) * 1'000;
+        ticker.mid = ticker.base + ME_MAX_PRICE_LEVELS / 2;
+        ticker.slots.resize(mConfig.max_live_orders);
+        ticker.free_slots.reserve(mConfig.max_live_orders);
+        // Hand out the lowest order ids first.
+        for (auto slot = mConfig.max_live_orders; slot > 0; --slot) {
+            ticker.free_slots.push_back(static_cast<uint32_t>(slot - 1));
+        }
+        ticker.live.reserve(mConfig.max_live_orders);
+        ticker.levels.resize(ME_MAX_PRICE_LEVELS);
+    }
+    mMax_expiries = mConfig.num_tickers * mConfig.max_live_orders;
+    mExpiries.reserve(mMax_expiries);
+    // The expiries before an arrival, then the TRADE and CANCEL of every
+    // order a mid move trades out at a time, more than any other arrival.
+    mPending.reserve(MAX_EXPIRIES + 2 * MAX_MID_FILLS);
+}
+
+auto OrderFlowGenerator::next() noexcept -> const OrderFlowEvent * {
+    if (mNext_pending == mPending.size()) {
+        mPending.clear();
+        mNext_pending = 0;
+        if (mMid_ticker != TickerId_INVALID) continueMidMove();
+        while (mPending.empty()) advance();
+    }
+
+    const auto event = &mPending[mNext_pending++];
+    ++mEvent_counts[static_cast<size_t>(event->update.type)];
+    return event;
+}
+
+auto OrderFlowGenerator::bestBidOffer(TickerId ticker_id) const noexcept
+    -> BestBidOffer {
+    const auto &ticker = mTickers[ticker_id];
+    BestBidOffer bbo;
+
+    for (const auto side : {Side::BUY, Side::SELL}) {
+        const auto level = touch(ticker, side);
+        if (!level) continue;
+
+        Qty qty = 0;
+        for (auto slot = level->head; slot != NO_SLOT;
+             slot = ticker.slots[slot].next) {
+            qty += ticker.slots[slot].qty;
+        }
+        const auto price = ticker.slots[level->head].price;
+        if (side == Side::BUY) {
+            bbo.mBid_price = price;
+            bbo.mBid_qty = qty;
+        } else {
+            bbo.mAsk_price = price;
+            bbo.mAsk_qty = qty;
+        }
+    }
+    return bbo;
+}
+
+auto OrderFlowGenerator::advance() noexcept -> void {
+    const auto previous_ns = static_cast<uint64_t>(mNow_ns);
+    mNow_ns += mInter_arrival(mRng);
+    const auto now_ns = static_cast<uint64_t>(mNow_ns);
+
+    // Cancel the orders whose lifetime ended before this arrival. Those left
+    // over by the previous arrival are stamped after its events.
+    size_t expired = 0;
+    while (!mExpiries.empty() && mExpiries.front().timestamp_ns <= now_ns &&
+           expired < MAX_EXPIRIES) {
+        std::pop_heap(mExpiries.begin(), mExpiries.end(),
+                      std::greater<Expiry>());
+        const auto expiry = mExpiries.back();
+        mExpiries.pop_back();
+        if (isStale(expiry)) continue;
+
+        const auto &slot = mTickers[expiry.ticker_id].slots[expiry.slot];
+        emit(MarketUpdateType::CANCEL, expiry.ticker_id, expiry.slot, slot,
+             slot.qty, Priority_INVALID);
+        mPending.back().timestamp_ns =
+            std::max(expiry.timestamp_ns, previous_ns);
+        removeOrder(expiry.ticker_id, expiry.slot);
+        ++expired;
+    }
+
+    const auto ticker_id = drawTicker();
+    const auto action = mUniform(mRng);
+    if (action < mConfig.modify_probability) {
+        modifyOrder(ticker_id);
+    } else if (action <
+               mConfig.modify_probability + mConfig.trade_probability) {
+        tradeAtTouch(ticker_id);
+    } else if (action < mConfig.modify_probability +
+                            mConfig.trade_probability +
+                            mConfig.mid_move_probability) {
+        moveMid(ticker_id);
+    } else {
+        addOrder(ticker_id);
+    }
+}
+
+auto OrderFlowGenerator::drawTicker() noexcept -> TickerId {
+    const auto draw = mUniform(mRng);
+    const auto it =
+        std::upper_bound(mTicker_weights.begin(), mTicker_weights.end(), draw);
+    return static_cast<TickerId>(
+        std::min<size_t>(it - mTicker_weights.begin(), mTickers.size() - 1));
+}
+
+auto OrderFlowGenerator::addOrder(TickerId ticker_id) noexcept -> void {
+    auto &ticker = mTickers[ticker_id];
+    if (ticker.free_slots.empty()) [[unlikely]] return;
+
+    // Inverse transform sampling of a discrete power law, rejecting the rare
+    // draws beyond the deepest level.
+    Price depth;
+    do {
+        depth = static_cast<Price>(
+                    std::floor(std::pow(1.0 - mUniform(mRng),
+                                        -1.0 / mConfig.depth_alpha))) -
+                1;
+    } while (depth >= mConfig.max_depth);
+
+    const auto slot_index = ticker.free_slots.back();
+    ticker.free_slots.pop_back();
+
+    auto &slot = ticker.slots[slot_index];
+    slot.side = (mRng() & 1) ? Side::BUY : Side::SELL;
+    slot.price = slot.side == Side::BUY ? ticker.mid - 1 - depth
+                                        : ticker.mid + 1 + depth;
+    slot.qty = mConfig.lot_size * (1 + mLots(mRng));
+    slot.live_index = static_cast<uint32_t>(ticker.live.size());
+    ticker.live.push_back(slot_index);
+
+    // Join the back of the FIFO queue at the price.
+    auto &level = ticker.levels[slot.price - ticker.base];
+    slot.prev = level.tail;
+    slot.next = NO_SLOT;
+    if (level.tail != NO_SLOT) {
+        ticker.slots[level.tail].next = slot_index;
+    } else {
+        level.head = slot_index;
+    }
+    level.tail = slot_index;
+
+    emit(MarketUpdateType::ADD, ticker_id, slot_index, slot, slot.qty,
+         ticker.next_priority++);
+
+    scheduleExpiry({static_cast<uint64_t>(mNow_ns + mLifetime(mRng)),
+                    ticker_id, slot_index, slot.generation});
+}
+
+auto OrderFlowGenerator::modifyOrder(TickerId ticker_id) noexcept -> void {
+    auto &ticker = mTickers[ticker_id];
+    if (ticker.live.empty()) return;
+
+    const auto slot_index = ticker.live[mRng() % ticker.live.size()];
+    auto &slot = ticker.slots[slot_index];
+    slot.qty = mConfig.lot_size * (1 + mLots(mRng));
+    emit(MarketUpdateType::MODIFY, ticker_id, slot_index, slot, slot.qty,
+         Priority_INVALID);
+}
+
+auto OrderFlowGenerator::tradeAtTouch(TickerId ticker_id) noexcept -> void {
+    auto &ticker = mTickers[ticker_id];
+    const auto level = touch(ticker, (mRng() & 1) ? Side::BUY : Side::SELL);
+    if (!level) return;
+
+    const auto slot_index = level->head;
+    const auto qty = std::min(ticker.slots[slot_index].qty,
+                              mConfig.lot_size * (1 + mLots(mRng)));
+    fillOrder(ticker_id, slot_index, qty);
+}
+
+auto OrderFlowGenerator::moveMid(TickerId ticker_id) noexcept -> void {
+    auto &ticker = mTickers[ticker_id];
+    const auto lowest_mid = ticker.base + mConfig.max_depth;
+    const auto highest_mid =
+        ticker.base + static_cast<Price>(ME_MAX_PRICE_LEVELS) - 1 -
+        mConfig.max_depth;
+
+    // Drift back towards the centre of the window at its edges.
+    auto up = (mRng() & 1) != 0;
+    if (ticker.mid <= lowest_mid) up = true;
+    if (ticker.mid >= highest_mid) up = false;
+    mMid_ticker = ticker_id;
+    mMid_target = ticker.mid + (up ? 1 : -1);
+    continueMidMove();
+}
+
+auto OrderFlowGenerator::continueMidMove() noexcept -> void {
+    // Every order at the new mid is on the losing side and trades out, a
+    // long queue over several calls, before any other arrival.
+    auto &ticker = mTickers[mMid_ticker];
+    const auto &level = ticker.levels[mMid_target - ticker.base];
+    for (size_t fills = 0; level.head != NO_SLOT && fills < MAX_MID_FILLS;
+         ++fills) {
+        fillOrder(mMid_ticker, level.head, ticker.slots[level.head].qty);
+    }
+    if (level.head == NO_SLOT) {
+        ticker.mid = mMid_target;
+        mMid_ticker = TickerId_INVALID;
+    }
+}
+
+auto OrderFlowGenerator::isStale(const Expiry &expiry) const noexcept
+    -> bool {
+    // The order already left the book, or the slot now holds a new order.
+    const auto &slot = mTickers[expiry.ticker_id].slots[expiry.slot];
+    return slot.live_index == NO_SLOT || slot.generation != expiry.generation;
+}
+
+auto OrderFlowGenerator::scheduleExpiry(const Expiry &expiry) noexcept
+    -> void {
+    // Orders that traded out leave their expiries behind. Every live order
+    // has exactly one that is not stale, so dropping the stale ones always
+    // makes room for the new order.
+    if (mExpiries.size() == mMax_expiries) [[unlikely]] {
+        std::erase_if(mExpiries, [this](const Expiry &scheduled) {
+            return isStale(scheduled);
+        });
+        std::make_heap(mExpiries.begin(), mExpiries.end(),
+                       std::greater<Expiry>());
+    }
+    mExpiries.push_back(expiry);
+    std::push_heap(mExpiries.begin(), mExpiries.end(), std::greater<Expiry>());
+}
+
+auto OrderFlowGenerator::removeOrder(TickerId ticker_id,
+                                     uint32_t slot_index) noexcept -> void {
+    auto &ticker = mTickers[ticker_id];
+    auto &slot = ticker.slots[slot_index];
+
+    auto &level = ticker.levels[slot.price - ticker.base];
+    (slot.prev != NO_SLOT ? ticker.slots[slot.prev].next : level.head) =
+        slot.next;
+    (slot.next != NO_SLOT ? ticker.slots[slot.next].prev : level.tail) =
+        slot.prev;
+
+    // Swap the last live order into the vacated position.
+    const auto last = ticker.live.back();
+    ticker.live[slot.live_index] = last;
+    ticker.slots[last].live_index = slot.live_index;
+    ticker.live.pop_back();
+
+    slot.prev = slot.next = slot.live_index = NO_SLOT;
+    ++slot.generation;
+    ticker.free_slots.push_back(slot_index);
+}
+
+auto OrderFlowGenerator::fillOrder(TickerId ticker_id, uint32_t slot_index,
+                                   Qty qty) noexcept -> void {
+    auto &slot = mTickers[ticker_id].slots[slot_index];
+    emit(MarketUpdateType::TRADE, ticker_id, slot_index, slot, qty,
+         Priority_INVALID);
+
+    slot.qty -= qty;
+    if (slot.qty) {
+        emit(MarketUpdateType::MODIFY, ticker_id, slot_index, slot, slot.qty,
+             Priority_INVALID);
+    } else {
+        emit(MarketUpdateType::CANCEL, ticker_id, slot_index, slot, 0,
+             Priority_INVALID);
+        removeOrder(ticker_id, slot_index);
+    }
+}
+
+auto OrderFlowGenerator::touch(const TickerState &ticker,
+                               Side side) const noexcept -> const Level * {
+    if (side == Side::BUY) {
+        for (auto price = ticker.mid - 1; price >= ticker.base; --price) {
+            const auto &level = ticker.levels[price - ticker.base];
+            if (level.head != NO_SLOT) return &level;
+        }
+    } else {
+        const auto end =
+            ticker.base + static_cast<Price>(ME_MAX_PRICE_LEVELS);
+        for (auto price = ticker.mid + 1; price < end; ++price) {
+            const auto &level = ticker.levels[price - ticker.base];
+            if (level.head != NO_SLOT) return &level;
+        }
+    }
+    return nullptr;
+}
+
+auto OrderFlowGenerator::emit(MarketUpdateType type, TickerId ticker_id,
+                              OrderId order_id, const Slot &slot, Qty qty,
+                              Priority priority) noexcept -> void {
+    auto &event = mPending.emplace_back();
+    event.timestamp_ns = static_cast<uint64_t>(mNow_ns);
+    event.update.type = type;
+    event.update.order_id = order_id;
+    event.update.ticker_id = ticker_id;
+    event.update.side = slot.side;
+    event.update.price = slot.price;
+    event.update.qty = qty;
+    event.update.priority = priority;
+}
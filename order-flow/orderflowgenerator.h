@@ -0,0 +1,257 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "market-orders/marketorder.h"
+#include "market-orders/marketupdate.h"
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+/// \struct OrderFlowConfig
+/// \brief Parameters of the synthetic order flow.
+struct OrderFlowConfig {
+    /// Seed of the random number generator, the same seed and parameters
+    /// always produce the same flow.
+    uint64_t seed = 42;
+    /// Number of tickers, at most ME_MAX_TICKERS.
+    TickerId num_tickers = 4;
+    /// Activity of ticker i is proportional to 1 / (i + 1)^ticker_skew.
+    double ticker_skew = 1.0;
+
+    /// Rate of the Poisson arrival process over all tickers, per second.
+    double arrivals_per_second = 1'000'000.0;
+    /// Share of arrivals that modify the quantity of a live order.
+    double modify_probability = 0.10;
+    /// Share of arrivals that are aggressive orders trading against the
+    /// front of the queue at the touch.
+    double trade_probability = 0.02;
+    /// Share of arrivals that move the mid price by a tick, trading out the
+    /// whole level that the mid moves onto.
+    double mid_move_probability = 0.002;
+
+    /// Exponent of the power-law distance of new orders behind the inside
+    /// price, one tick from the mid. Larger values keep more orders near the
+    /// touch.
+    double depth_alpha = 1.5;
+    /// Number of price levels behind the inside price new orders are placed
+    /// over.
+    Price max_depth = 48;
+
+    /// Median time a new order rests before being cancelled, in nanoseconds.
+    double median_lifetime_ns = 2'000'000.0;
+    /// Standard deviation of the log of the lifetime, lifetimes are
+    /// log-normal so that most orders are cancelled quickly while a few rest
+    /// for a long time.
+    double lifetime_sigma = 2.0;
+
+    /// Order quantities are a geometric number of lots.
+    Qty lot_size = 100;
+    /// Maximum number of live orders per ticker, new orders are dropped while
+    /// a ticker is full.
+    size_t max_live_orders = 100'000;
+};
+
+/// \struct OrderFlowEvent
+/// \brief A generated market update and the time it occurred.
+struct OrderFlowEvent {
+    /// Nanoseconds since the start of the flow.
+    uint64_t timestamp_ns = 0;
+    /// The market update.
+    MEMarketUpdate update;
+};
+
+/// \brief Generates realistic, self-consistent L3 order flow for any number
+/// of tickers.
+///
+/// The flow is driven by a Poisson arrival process. Each arrival is a new
+/// limit order placed at a power-law distance behind the inside price, a
+/// quantity modification of a live order, an aggressive order trading against
+/// the front of the queue at the touch, or a mid price move that trades out
+/// the level it moves onto. Every new order draws a log-normal lifetime after
+/// which it is cancelled if it is still resting, which produces the high
+/// cancel to trade ratios and short queue lifetimes seen on real venues.
+///
+/// The events are produced in bounded chunks: a mid move trades out its level
+/// at most MAX_MID_FILLS orders at a time, before any other arrival, and at
+/// most MAX_EXPIRIES orders are cancelled before an arrival, later ones before
+/// the next arrivals. All storage is sized up front, so generation never
+/// allocates after construction.
+///
+/// Each ticker's prices stay inside a window of ME_MAX_PRICE_LEVELS ticks and
+/// its order ids below max_live_orders, so the flow can be fed straight into a
+/// MarketOrderBook. Bids always rest below the mid price and asks above it,
+/// the book never crosses.
+class OrderFlowGenerator final {
+   public:
+    /// \brief Constructs an OrderFlowGenerator.
+    /// \param config Parameters of the flow.
+    explicit OrderFlowGenerator(const OrderFlowConfig &config);
+
+    /// \brief Returns the next event of the flow, which never ends.
+    /// \return Pointer to the event, valid until the next call.
+    auto next() noexcept -> const OrderFlowEvent *;
+
+    /// \brief Returns true while events of the last arrival are still to be
+    /// returned by next(), an arrival can produce several events.
+    auto hasPending() const noexcept {
+        return mNext_pending != mPending.size() ||
+               mMid_ticker != TickerId_INVALID;
+    }
+
+    /// \brief Returns the best bid and offer of a ticker as implied by all
+    /// the events returned so far. Only meaningful while hasPending() is
+    /// false, the internal state runs ahead of the pending events.
+    /// \param ticker_id The ticker.
+    auto bestBidOffer(TickerId ticker_id) const noexcept -> BestBidOffer;
+
+    /// \brief Returns the number of live orders of a ticker.
+    auto liveOrders(TickerId ticker_id) const noexcept {
+        return mTickers[ticker_id].live.size();
+    }
+
+    /// \brief Returns the number of events of a type returned so far.
+    auto eventCount(MarketUpdateType type) const noexcept {
+        return mEvent_counts[static_cast<size_t>(type)];
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    OrderFlowGenerator() = delete;
+    OrderFlowGenerator(const OrderFlowGenerator &) = delete;
+    OrderFlowGenerator(const OrderFlowGenerator &&) = delete;
+    OrderFlowGenerator &operator=(const OrderFlowGenerator &) = delete;
+    OrderFlowGenerator &operator=(const OrderFlowGenerator &&) = delete;
+
+    /// \brief Largest number of orders a mid move trades out at a time.
+    static constexpr size_t MAX_MID_FILLS = 32;
+
+    /// \brief Largest number of expired orders cancelled before an arrival.
+    static constexpr size_t MAX_EXPIRIES = 64;
+
+   private:
+    /// \brief Marks the end of an intrusive list of slots.
+    static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+
+    /// \struct Slot
+    /// \brief A live order, its slot index is its OrderId.
+    struct Slot {
+        Side side = Side::INVALID;
+        Price price = Price_INVALID;
+        Qty qty = 0;
+        /// Previous and next order in the FIFO queue at the same price.
+        uint32_t prev = NO_SLOT;
+        uint32_t next = NO_SLOT;
+        /// Position in TickerState::live, NO_SLOT if not live.
+        uint32_t live_index = NO_SLOT;
+        /// Incremented every time the slot is reused, lets stale expiries be
+        /// recognised.
+        uint32_t generation = 0;
+    };
+
+    /// \struct Level
+    /// \brief FIFO queue of the orders at one price.
+    struct Level {
+        uint32_t head = NO_SLOT;
+        uint32_t tail = NO_SLOT;
+    };
+
+    /// \struct TickerState
+    /// \brief Book state of a single ticker.
+    struct TickerState {
+        /// Lowest price of the window, levels are indexed by price - base.
+        Price base = 0;
+        /// Bids rest strictly below the mid, asks strictly above it.
+        Price mid = 0;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> free_slots;
+        /// Slots of all live orders, for picking one uniformly.
+        std::vector<uint32_t> live;
+        std::vector<Level> levels;
+        Priority next_priority = 0;
+    };
+
+    /// \struct Expiry
+    /// \brief Scheduled cancellation of an order at the end of its lifetime.
+    struct Expiry {
+        uint64_t timestamp_ns = 0;
+        TickerId ticker_id = TickerId_INVALID;
+        uint32_t slot = NO_SLOT;
+        uint32_t generation = 0;
+
+        /// Orders the heap so that the earliest expiry is on top.
+        auto operator>(const Expiry &other) const noexcept {
+            return timestamp_ns > other.timestamp_ns;
+        }
+    };
+
+    /// \brief Runs the flow forward until at least one event is pending.
+    auto advance() noexcept -> void;
+    /// \brief Picks the ticker of the next arrival.
+    auto drawTicker() noexcept -> TickerId;
+    /// \brief Places a new limit order.
+    auto addOrder(TickerId ticker_id) noexcept -> void;
+    /// \brief Changes the quantity of a random live order.
+    auto modifyOrder(TickerId ticker_id) noexcept -> void;
+    /// \brief Trades against the front of the queue at one touch.
+    auto tradeAtTouch(TickerId ticker_id) noexcept -> void;
+    /// \brief Starts moving the mid price by one tick.
+    auto moveMid(TickerId ticker_id) noexcept -> void;
+    /// \brief Trades out the next orders of the level the mid moves onto,
+    /// and moves the mid once the level is empty.
+    auto continueMidMove() noexcept -> void;
+    /// \brief Returns true if the order of an expiry already left the book.
+    auto isStale(const Expiry &expiry) const noexcept -> bool;
+    /// \brief Schedules the cancellation of a new order, first dropping the
+    /// stale expiries once they fill the heap.
+    auto scheduleExpiry(const Expiry &expiry) noexcept -> void;
+    /// \brief Removes a live order from its level and recycles its slot.
+    auto removeOrder(TickerId ticker_id, uint32_t slot) noexcept -> void;
+    /// \brief Emits a TRADE of a resting order followed by a MODIFY or CANCEL.
+    auto fillOrder(TickerId ticker_id, uint32_t slot, Qty qty) noexcept -> void;
+    /// \brief Returns the best price level of a side, or nullptr.
+    auto touch(const TickerState &ticker, Side side) const noexcept
+        -> const Level *;
+    /// \brief Appends an event to the pending events.
+    auto emit(MarketUpdateType type, TickerId ticker_id, OrderId order_id,
+              const Slot &slot, Qty qty, Priority priority) noexcept -> void;
+
+    /// \brief Parameters of the flow.
+    const OrderFlowConfig mConfig;
+    /// \brief Random number generator driving the flow.
+    std::mt19937_64 mRng;
+    /// \brief Uniform draws in [0, 1).
+    std::uniform_real_distribution<double> mUniform{0.0, 1.0};
+    /// \brief Inter-arrival times of the Poisson process.
+    std::exponential_distribution<double> mInter_arrival;
+    /// \brief Order lifetimes.
+    std::lognormal_distribution<double> mLifetime;
+    /// \brief Number of extra lots in an order quantity.
+    std::geometric_distribution<Qty> mLots{0.4};
+    /// \brief Cumulative activity weights of the tickers.
+    std::vector<double> mTicker_weights;
+
+    /// \brief Book state of every ticker.
+    std::vector<TickerState> mTickers;
+    /// \brief Min-heap of scheduled cancellations, at most one per slot that
+    /// is not stale.
+    std::vector<Expiry> mExpiries;
+    /// \brief Largest number of expiries, one per slot of every ticker.
+    size_t mMax_expiries = 0;
+    /// \brief Time of the current arrival in nanoseconds.
+    double mNow_ns = 0.0;
+
+    /// \brief Ticker whose mid is moving, TickerId_INVALID if none.
+    TickerId mMid_ticker = TickerId_INVALID;
+    /// \brief Mid price the ticker moves to.
+    Price mMid_target = Price_INVALID;
+
+    /// \brief Events produced but not yet returned.
+    std::vector<OrderFlowEvent> mPending;
+    /// \brief Index of the next pending event to return.
+    size_t mNext_pending = 0;
+    /// \brief Number of events returned per MarketUpdateType.
+    std::array<size_t, 8> mEvent_counts = {};
+};
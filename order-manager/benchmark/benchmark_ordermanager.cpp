@@ -0,0 +1,523 @@
+/// \file benchmark_ordermanager.cpp
+/// \brief Cost of tracking own orders and their queue positions, with every
+/// estimate checked against the book and no allocation after startup.
+/// \details Replays synthetic order flow through the books of a quoting
+/// strategy, which keeps an order at the touch of both sides of every ticker
+/// and leaves its older orders resting up to two ticks behind. A simulated
+/// exchange acknowledges the orders, publishes them in the market data with
+/// priorities between those of the flow, fills the order at the front of a
+/// level traded against and cancels on request. After every market update,
+/// the quantity ahead of each own order at its level is compared with an
+/// exact walk of the book, and the replaced global operators new count any
+/// allocation made while the session runs.
+///
+/// Usage: OrderManagerBenchmark [--updates N] [--max-orders N]
+///                              [harness options]
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowbooks.h"
+#include "order-manager/ordermanager.h"
+#include "strategy/strategyrunner.h"
+#include "utilities/latencyhistogram.h"
+#include "utilities/tscclock.h"
+
+/// \brief Heap allocations made while counting is on.
+std::atomic<uint64_t> gAllocations = 0;
+/// \brief Whether operator new counts allocations.
+std::atomic<bool> gCount_allocations = false;
+
+/// \brief Allocates for every replaced operator new, counting the
+/// allocation while counting is on. Every replaced operator delete frees with
+/// std::free, so all forms stay matched.
+/// \return The memory, nullptr if none is left.
+auto countedAllocate(std::size_t size, std::size_t alignment) noexcept
+    -> void * {
+    if (gCount_allocations.load(std::memory_order_relaxed)) [[unlikely]] {
+        gAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    size = std::max<std::size_t>(size, 1);
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+    // aligned_alloc() takes a multiple of the alignment.
+    return std::aligned_alloc(alignment,
+                              (size + alignment - 1) / alignment * alignment);
+}
+
+/// \brief Allocates like countedAllocate(), throwing if no memory is left.
+auto countedAllocateOrThrow(std::size_t size, std::size_t alignment)
+    -> void * {
+    if (auto ptr = countedAllocate(size, alignment)) return ptr;
+    throw std::bad_alloc();
+}
+
+auto operator new(std::size_t size) -> void * {
+    return countedAllocateOrThrow(size, alignof(std::max_align_t));
+}
+auto operator new[](std::size_t size) -> void * {
+    return countedAllocateOrThrow(size, alignof(std::max_align_t));
+}
+auto operator new(std::size_t size, std::align_val_t align) -> void * {
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(align));
+}
+auto operator new[](std::size_t size, std::align_val_t align) -> void * {
+    return countedAllocateOrThrow(size, static_cast<std::size_t>(align));
+}
+auto operator new(std::size_t size, const std::nothrow_t &) noexcept
+    -> void * {
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+auto operator new[](std::size_t size, const std::nothrow_t &) noexcept
+    -> void * {
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+auto operator new(std::size_t size, std::align_val_t align,
+                  const std::nothrow_t &) noexcept -> void * {
+    return countedAllocate(size, static_cast<std::size_t>(align));
+}
+auto operator new[](std::size_t size, std::align_val_t align,
+                    const std::nothrow_t &) noexcept -> void * {
+    return countedAllocate(size, static_cast<std::size_t>(align));
+}
+
+auto operator delete(void *ptr) noexcept -> void { std::free(ptr); }
+auto operator delete[](void *ptr) noexcept -> void { std::free(ptr); }
+auto operator delete(void *ptr, std::size_t) noexcept -> void {
+    std::free(ptr);
+}
+auto operator delete[](void *ptr, std::size_t) noexcept -> void {
+    std::free(ptr);
+}
+auto operator delete(void *ptr, std::align_val_t) noexcept -> void {
+    std::free(ptr);
+}
+auto operator delete[](void *ptr, std::align_val_t) noexcept -> void {
+    std::free(ptr);
+}
+auto operator delete(void *ptr, std::size_t, std::align_val_t) noexcept
+    -> void {
+    std::free(ptr);
+}
+auto operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+    -> void {
+    std::free(ptr);
+}
+auto operator delete(void *ptr, const std::nothrow_t &) noexcept -> void {
+    std::free(ptr);
+}
+auto operator delete[](void *ptr, const std::nothrow_t &) noexcept -> void {
+    std::free(ptr);
+}
+auto operator delete(void *ptr, std::align_val_t,
+                     const std::nothrow_t &) noexcept -> void {
+    std::free(ptr);
+}
+auto operator delete[](void *ptr, std::align_val_t,
+                       const std::nothrow_t &) noexcept -> void {
+    std::free(ptr);
+}
+
+/// \brief Market order ids of the own orders start above those of the flow.
+constexpr OrderId MARKET_ORDER_ID_BASE = 500'000;
+
+/// \brief Number of market order ids the own orders cycle through.
+constexpr OrderId MARKET_ORDER_IDS = 1 << 18;
+
+/// \brief The priorities of the flow are shifted left by this many bits, so
+/// that the own orders added between two orders of the flow fit in between.
+constexpr int PRIORITY_SHIFT = 16;
+
+/// \brief Quantity of every own order.
+constexpr Qty QUOTE_QTY = 100;
+
+/// \brief Own orders further than this many ticks behind the touch are
+/// cancelled.
+constexpr Price MAX_TICKS_BEHIND = 2;
+
+/// \struct Timing
+/// \brief Ticks spent in one OrderManager operation.
+struct Timing {
+    uint64_t ticks = 0;
+    uint64_t calls = 0;
+
+    auto nanosPerCall() const noexcept {
+        return calls ? TscClock::ticksToNanos(ticks) / calls : 0.0;
+    }
+};
+
+/// \brief The OrderManager, its strategy and a simulated exchange, wired
+/// together and driven by the flow. Market updates reach the books and the
+/// manager through a StrategyRunner.
+class Session final {
+   public:
+    Session(const MarketOrderBookHashMap &books, size_t max_orders)
+        : mBooks(books),
+          mQueue(ME_MAX_CLIENT_UPDATES),
+          mOrders(1, &mQueue),
+          mManager(mOrders, max_orders),
+          mTracker(*this),
+          mRunner(books, mOrders, mTracker),
+          mExchange(std::bit_ceil(2 * max_orders)) {}
+
+    /// \brief Processes an update of the flow and everything it triggers.
+    auto onFlowUpdate(MEMarketUpdate update) noexcept -> void {
+        const auto book = mBooks[update.ticker_id];
+        if (update.type == MarketUpdateType::ADD) {
+            mFlow_priority[update.ticker_id] = update.priority;
+            mOwn_priority[update.ticker_id] = 0;
+            update.priority <<= PRIORITY_SHIFT;
+            // The order would have traded against own orders on the other
+            // side, which would also share its level in the book.
+            fillAll(update.ticker_id, oppositeSide(update.side),
+                    update.price);
+        }
+
+        const auto before = *book->getBestBidOffer();
+        onMarketUpdate(update);
+
+        if (update.type == MarketUpdateType::TRADE) {
+            fillFront(update);
+        }
+        const auto &after = *book->getBestBidOffer();
+        if (before != after) {
+            requote(update.ticker_id, Side::BUY, after.mBid_price);
+            requote(update.ticker_id, Side::SELL, after.mAsk_price);
+            runExchange();
+        }
+    }
+
+    auto manager() const noexcept -> const OrderManager & { return mManager; }
+    auto marketTiming() const noexcept -> const Timing & { return mMarket; }
+    auto marketLatency() const noexcept -> const LatencyHistogram & {
+        return mMarket_latency;
+    }
+    auto newTiming() const noexcept -> const Timing & { return mNew; }
+    auto cancelTiming() const noexcept -> const Timing & { return mCancel; }
+    auto responseTiming() const noexcept -> const Timing & {
+        return mResponse;
+    }
+    auto fills() const noexcept { return mFills; }
+    auto checks() const noexcept { return mChecks; }
+
+   private:
+    /// \struct ExchangeOrder
+    /// \brief An own order as the exchange knows it.
+    struct ExchangeOrder {
+        OrderId order_id = OrderId_INVALID;
+        OrderId market_order_id = OrderId_INVALID;
+        TickerId ticker_id = TickerId_INVALID;
+        Side side = Side::INVALID;
+        Price price = Price_INVALID;
+        Qty leaves_qty = 0;
+    };
+
+    static auto oppositeSide(Side side) noexcept -> Side {
+        return side == Side::BUY ? Side::SELL : Side::BUY;
+    }
+
+    /// \brief Runs the manager from the StrategyRunner, before the book
+    /// applies an update, and checks its estimates after.
+    class Tracker final : public Strategy<Tracker> {
+       public:
+        explicit Tracker(Session &session) noexcept : mSession(session) {}
+
+        auto onBeforeBookUpdate(const MEMarketUpdate &update,
+                                const MarketOrderBook &book,
+                                OrderEmitter &) noexcept -> void {
+            mSession.track(update, book);
+        }
+        auto onBookUpdate(const MEMarketUpdate &update,
+                          const MarketOrderBook &, OrderEmitter &) noexcept
+            -> void {
+            mSession.verify(update.ticker_id, update.side, update.price);
+        }
+        auto onTrade(const MEMarketUpdate &update, const MarketOrderBook &,
+                     OrderEmitter &) noexcept -> void {
+            mSession.verify(update.ticker_id, update.side, update.price);
+        }
+
+       private:
+        Session &mSession;
+    };
+
+    /// \brief Passes a market update through the manager and the book, then
+    /// checks the estimates at its level.
+    auto onMarketUpdate(const MEMarketUpdate &update) noexcept -> void {
+        mRunner.onMarketUpdate(update);
+    }
+
+    /// \brief Updates the manager with a market update the book has not
+    /// applied yet.
+    auto track(const MEMarketUpdate &update,
+               const MarketOrderBook &book) noexcept -> void {
+        const auto start = TscClock::now();
+        mManager.onMarketUpdate(update, book);
+        const auto end = TscClock::now();
+        mMarket.ticks += end - start;
+        ++mMarket.calls;
+        mMarket_latency.record(end - start);
+    }
+
+    /// \brief Compares the quantity ahead of every own order at a level with
+    /// the quantity of the orders of lower priority in the book.
+    auto verify(TickerId ticker_id, Side side, Price price) noexcept -> void {
+        const auto level = mBooks[ticker_id]->getLevel(side, price);
+        mManager.forEachOrderAt(
+            ticker_id, side, price, [&](const OwnOrder &order) {
+                if (!order.hasQueuePosition()) return;
+                Qty ahead = 0;
+                if (level) {
+                    auto market_order = level->mFirst_market_order;
+                    do {
+                        if (market_order->mPriority < order.mPriority) {
+                            ahead += market_order->mQty;
+                        }
+                        market_order = market_order->mNext_order;
+                    } while (market_order != level->mFirst_market_order);
+                }
+                if (ahead != order.mQty_ahead) [[unlikely]] {
+                    FATAL("Queue position estimate " +
+                          qtyToString(order.mQty_ahead) + " instead of " +
+                          qtyToString(ahead) + " for " + order.toString());
+                }
+                ++mChecks;
+            });
+    }
+
+    /// \brief Passes a response to the manager.
+    auto respond(ClientResponseType type, const ExchangeOrder &order,
+                 Qty exec_qty) noexcept -> void {
+        MEClientResponse response;
+        response.type = type;
+        response.client_id = mOrders.clientId();
+        response.ticker_id = order.ticker_id;
+        response.order_id = order.order_id;
+        response.market_order_id = order.market_order_id;
+        response.side = order.side;
+        response.price = order.price;
+        response.exec_price = order.price;
+        response.exec_qty = exec_qty;
+        response.leaves_qty = order.leaves_qty;
+        const auto start = TscClock::now();
+        mManager.onResponse(response);
+        mResponse.ticks += TscClock::now() - start;
+        ++mResponse.calls;
+    }
+
+    /// \brief Publishes the change of an own order in the market data.
+    auto publish(MarketUpdateType type, const ExchangeOrder &order,
+                 Priority priority) noexcept -> void {
+        MEMarketUpdate update;
+        update.type = type;
+        update.ticker_id = order.ticker_id;
+        update.order_id = order.market_order_id;
+        update.side = order.side;
+        update.price = order.price;
+        update.qty = order.leaves_qty;
+        update.priority = priority;
+        onMarketUpdate(update);
+    }
+
+    auto exchangeOrder(OrderId order_id) noexcept -> ExchangeOrder & {
+        return mExchange[order_id & (mExchange.size() - 1)];
+    }
+
+    /// \brief Fills an own order, fully unless qty is smaller.
+    auto fill(OrderId order_id, Qty qty) noexcept -> void {
+        auto &order = exchangeOrder(order_id);
+        if (order.order_id != order_id || !order.leaves_qty) return;
+        const auto exec_qty = std::min(qty, order.leaves_qty);
+        if (!exec_qty) return;
+        order.leaves_qty -= exec_qty;
+        publish(order.leaves_qty ? MarketUpdateType::MODIFY
+                                 : MarketUpdateType::CANCEL,
+                order, Priority_INVALID);
+        respond(ClientResponseType::FILLED, order, exec_qty);
+        ++mFills;
+    }
+
+    /// \brief Fills every own order at a level.
+    auto fillAll(TickerId ticker_id, Side side, Price price) noexcept
+        -> void {
+        mManager.forEachOrderAt(ticker_id, side, price,
+                                [&](const OwnOrder &order) {
+                                    mFilled[mFilled_count++] = order.mOrder_id;
+                                });
+        flushFills(QUOTE_QTY);
+    }
+
+    /// \brief Fills the own orders at the front of a level traded against.
+    auto fillFront(const MEMarketUpdate &trade) noexcept -> void {
+        mManager.forEachOrderAt(trade.ticker_id, trade.side, trade.price,
+                                [&](const OwnOrder &order) {
+                                    if (order.hasQueuePosition() &&
+                                        !order.mQty_ahead) {
+                                        mFilled[mFilled_count++] =
+                                            order.mOrder_id;
+                                    }
+                                });
+        flushFills(trade.qty / 2);
+    }
+
+    /// \brief Fills the orders collected, which must not be removed while
+    /// the manager iterates over them.
+    auto flushFills(Qty qty) noexcept -> void {
+        for (size_t i = 0; i < mFilled_count; ++i) fill(mFilled[i], qty);
+        mFilled_count = 0;
+    }
+
+    /// \brief Keeps an own order at the touch of a side, cancelling those
+    /// that fell too far behind.
+    auto requote(TickerId ticker_id, Side side, Price touch) noexcept
+        -> void {
+        if (touch == Price_INVALID) return;
+        auto &quotes = mQuotes[ticker_id][side == Side::BUY ? 0 : 1];
+        OrderId *free_slot = nullptr;
+        auto at_touch = false;
+        for (auto &order_id : quotes) {
+            const auto order = mManager.getOrder(order_id);
+            if (!order) {
+                free_slot = &order_id;
+                continue;
+            }
+            at_touch |= order->mPrice == touch;
+            if (sideToValue(side) * (touch - order->mPrice) >
+                    MAX_TICKS_BEHIND &&
+                order->mState != OwnOrderState::PENDING_CANCEL) {
+                const auto start = TscClock::now();
+                mManager.sendCancel(order_id);
+                mCancel.ticks += TscClock::now() - start;
+                ++mCancel.calls;
+            }
+        }
+        if (at_touch || !free_slot) return;
+        const auto start = TscClock::now();
+        const auto order = mManager.sendNew(ticker_id, side, touch, QUOTE_QTY);
+        mNew.ticks += TscClock::now() - start;
+        ++mNew.calls;
+        if (order) *free_slot = order->mOrder_id;
+    }
+
+    /// \brief Acknowledges the requests of the strategy, publishing new
+    /// orders after their ACCEPTED response like the matching engine does.
+    auto runExchange() noexcept -> void {
+        while (const auto request = mQueue.getNextRead()) {
+            auto &order = exchangeOrder(request->order_id);
+            if (request->type == ClientRequestType::NEW) {
+                order.order_id = request->order_id;
+                order.market_order_id =
+                    MARKET_ORDER_ID_BASE + request->order_id % MARKET_ORDER_IDS;
+                order.ticker_id = request->ticker_id;
+                order.side = request->side;
+                order.price = request->price;
+                order.leaves_qty = request->qty;
+                respond(ClientResponseType::ACCEPTED, order, 0);
+                const auto ticker_id = request->ticker_id;
+                publish(MarketUpdateType::ADD, order,
+                        (mFlow_priority[ticker_id] << PRIORITY_SHIFT) +
+                            ++mOwn_priority[ticker_id]);
+            } else if (order.order_id == request->order_id &&
+                       order.leaves_qty) {
+                publish(MarketUpdateType::CANCEL, order, Priority_INVALID);
+                respond(ClientResponseType::CANCELED, order, 0);
+                order.leaves_qty = 0;
+            } else {
+                respond(ClientResponseType::CANCEL_REJECTED, order, 0);
+            }
+            mQueue.updateReadIndex();
+        }
+    }
+
+    const MarketOrderBookHashMap &mBooks;
+    ClientRequestLFQueue mQueue;
+    OrderEmitter mOrders;
+    OrderManager mManager;
+    Tracker mTracker;
+    StrategyRunner<Tracker> mRunner;
+
+    std::vector<ExchangeOrder> mExchange;
+    std::array<Priority, ME_MAX_TICKERS> mFlow_priority = {};
+    std::array<Priority, ME_MAX_TICKERS> mOwn_priority = {};
+    std::array<std::array<std::array<OrderId, 8>, 2>, ME_MAX_TICKERS>
+        mQuotes = {};
+    std::array<OrderId, 64> mFilled = {};
+    size_t mFilled_count = 0;
+
+    Timing mMarket;
+    LatencyHistogram mMarket_latency;
+    Timing mNew;
+    Timing mCancel;
+    Timing mResponse;
+    uint64_t mFills = 0;
+    uint64_t mChecks = 0;
+};
+
+/// \brief Main function running the order manager benchmark.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    size_t updates = 2'000'000;
+    size_t max_orders = 1'024;
+    setUpBenchmarkThread(parseBenchmarkOptions(
+        argc, argv, {{"--updates", updates}, {"--max-orders", max_orders, 1}}));
+
+    OrderFlowConfig config;
+    OrderFlowGenerator generator(config);
+    const auto flow = generateOrderFlow(generator, updates);
+    OrderFlowBooks books(config.num_tickers);
+    auto session = std::make_unique<Session>(books.books(), max_orders);
+
+    gCount_allocations = true;
+    for (const auto &update : flow) session->onFlowUpdate(update);
+    gCount_allocations = false;
+
+    if (gAllocations) [[unlikely]] {
+        FATAL(std::to_string(gAllocations) +
+              " heap allocations while the session ran.");
+    }
+    const auto &manager = session->manager();
+    std::cout << "replayed " << flow.size() << " updates, "
+              << session->newTiming().calls - manager.ordersRefused()
+              << " orders, "
+              << session->fills() << " fills, " << session->checks()
+              << " queue positions checked, " << manager.workingOrders()
+              << " working, " << manager.ordersRefused()
+              << " refused, 0 allocations" << std::endl;
+
+    const auto &latency = session->marketLatency();
+    std::cout << std::left << std::setw(20) << "operation" << std::right
+              << std::setw(12) << "calls" << std::setw(12) << "ns/call"
+              << std::endl;
+    const auto printRow = [](const std::string &name, const Timing &timing) {
+        std::cout << std::left << std::setw(20) << name << std::right
+                  << std::setw(12) << timing.calls << std::fixed
+                  << std::setprecision(2) << std::setw(12)
+                  << timing.nanosPerCall() << std::endl;
+    };
+    // Reading the clock twice is included in every call timed.
+    Timing clock;
+    for (size_t i = 0; i < 1'000'000; ++i) {
+        const auto start = TscClock::now();
+        clock.ticks += TscClock::now() - start;
+        ++clock.calls;
+    }
+    printRow("(clock)", clock);
+    printRow("onMarketUpdate", session->marketTiming());
+    printRow("sendNew", session->newTiming());
+    printRow("sendCancel", session->cancelTiming());
+    printRow("onResponse", session->responseTiming());
+    std::cout << "onMarketUpdate p50 "
+              << TscClock::toNanos(latency.percentile(50.0)) << " ns, p99 "
+              << TscClock::toNanos(latency.percentile(99.0))
+              << " ns, max " << TscClock::toNanos(latency.max()) << " ns"
+              << std::endl;
+
+    return 0;
+}
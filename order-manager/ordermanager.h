@@ -0,0 +1,428 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "market-orders/clientresponse.h"
+#include "market-orders/marketupdate.h"
+#include "memory-pool/memorypool.h"
+#include "order-book/orderbook.h"
+#include "strategy/orderemitter.h"
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+/// \enum OwnOrderState
+/// \brief Life cycle of an order sent by the strategy.
+enum class OwnOrderState : uint8_t {
+    INVALID = 0,
+    PENDING_NEW = 1,
+    LIVE = 2,
+    PENDING_CANCEL = 3,
+    FILLED = 4,
+    CANCELED = 5
+};
+
+/// \brief Converts an OwnOrderState enum to a string.
+/// \param state The OwnOrderState to convert.
+/// \return String representation of the OwnOrderState.
+inline auto ownOrderStateToString(OwnOrderState state) -> std::string {
+    switch (state) {
+        case OwnOrderState::PENDING_NEW:
+            return "PENDING_NEW";
+        case OwnOrderState::LIVE:
+            return "LIVE";
+        case OwnOrderState::PENDING_CANCEL:
+            return "PENDING_CANCEL";
+        case OwnOrderState::FILLED:
+            return "FILLED";
+        case OwnOrderState::CANCELED:
+            return "CANCELED";
+        case OwnOrderState::INVALID:
+            return "INVALID";
+    }
+    return "UNKNOWN";
+}
+
+/// \struct OwnOrder
+/// \brief An order sent by the strategy, as tracked by the OrderManager.
+struct OwnOrder {
+    /// Order identifier, assigned by the OrderEmitter.
+    OrderId mOrder_id = OrderId_INVALID;
+    /// Identifier of the order in the market data, known once accepted.
+    OrderId mMarket_order_id = OrderId_INVALID;
+    /// Ticker of the order.
+    TickerId mTicker_id = TickerId_INVALID;
+    /// Side of the order (buy/sell).
+    Side mSide = Side::INVALID;
+    /// State of the order.
+    OwnOrderState mState = OwnOrderState::INVALID;
+    /// Limit price of the order.
+    Price mPrice = Price_INVALID;
+    /// Quantity of the order when it was sent.
+    Qty mQty = 0;
+    /// Quantity not filled yet.
+    Qty mLeaves_qty = 0;
+    /// Priority of the order in the market data, once its ADD was seen.
+    Priority mPriority = Priority_INVALID;
+    /// Estimated quantity queued ahead of the order at its price.
+    Qty mQty_ahead = 0;
+
+    /// Pointer to the previous own order at the same level.
+    OwnOrder *mPrev_order = nullptr;
+    /// Pointer to the next own order at the same level.
+    OwnOrder *mNext_order = nullptr;
+
+    /// \brief Returns true if the queue position of the order is known.
+    auto hasQueuePosition() const noexcept {
+        return mPriority != Priority_INVALID;
+    }
+
+    /// \brief Returns a string representation of the OwnOrder.
+    auto toString() const {
+        std::stringstream ss;
+        ss << "OwnOrder"
+           << " ["
+           << " oid:" << orderIdToString(mOrder_id)
+           << " moid:" << orderIdToString(mMarket_order_id)
+           << " ticker:" << tickerIdToString(mTicker_id)
+           << " side:" << sideToString(mSide)
+           << " state:" << ownOrderStateToString(mState)
+           << " price:" << priceToString(mPrice) << " qty:" << qtyToString(mQty)
+           << " leaves:" << qtyToString(mLeaves_qty)
+           << " priority:" << priorityToString(mPriority)
+           << " ahead:" << qtyToString(mQty_ahead) << "]";
+        return ss.str();
+    }
+};
+
+/// \brief Tracks the working orders of a strategy: their state, matched by
+/// OrderId against the responses of the exchange, and their estimated
+/// position in the queue of their price level.
+///
+/// Orders live in a MemoryPool sized at construction and are indexed by
+/// OrderId in an open addressing table at most half full, where the
+/// sequential ids of the OrderEmitter mostly land in their home slot. The
+/// own orders of a ticker, side and price form a list headed in a flat array
+/// indexed like the book's levels, so a market update finds the own orders
+/// at its level with one load, and nothing is allocated after construction.
+///
+/// The queue position is estimated from the market data. When the ADD of an
+/// own order is seen, identified by the market order id of its ACCEPTED
+/// response, every order at the level is ahead of it. From then on, a
+/// MODIFY or CANCEL of an order whose Priority is lower changes the quantity
+/// ahead by its change of quantity. onMarketUpdate() must therefore see
+/// every update before the book applies it, while the book still holds the
+/// quantity and priority of the order it changes. Under a StrategyRunner, the
+/// strategy owning the manager calls it from its onBeforeBookUpdate() hook.
+/// An exchange acknowledging an order before publishing its ADD, as the
+/// matching engine does, gives every own order a queue position.
+class OrderManager final {
+   public:
+    /// \brief Constructs an OrderManager, allocating all its memory.
+    /// \param orders The emitter the orders are sent with.
+    /// \param max_orders Largest number of working orders.
+    OrderManager(OrderEmitter &orders, size_t max_orders)
+        : mOrders(orders),
+          mMax_orders(max_orders),
+          mOrder_pool(max_orders),
+          mOrder_index(std::bit_ceil(2 * max_orders), nullptr),
+          mIndex_mask(mOrder_index.size() - 1) {
+        for (auto &sides : mLevels) {
+            for (auto &levels : sides) levels.fill({nullptr, nullptr});
+        }
+    }
+
+    /// \brief Sends a new limit order and starts tracking it.
+    /// \param ticker_id Ticker of the order.
+    /// \param side Side of the order.
+    /// \param price Limit price of the order.
+    /// \param qty Quantity of the order.
+    /// \return The order in state PENDING_NEW, nullptr if it was not sent
+    /// because max_orders orders are working or the outbound queue is full.
+    auto sendNew(TickerId ticker_id, Side side, Price price, Qty qty) noexcept
+        -> const OwnOrder * {
+        if (mWorking == mMax_orders) [[unlikely]] {
+            ++mOrders_refused;
+            return nullptr;
+        }
+        const auto order_id = mOrders.sendNew(ticker_id, side, price, qty);
+        if (order_id == OrderId_INVALID) [[unlikely]] {
+            ++mOrders_refused;
+            return nullptr;
+        }
+
+        auto order = mOrder_pool.allocate();
+        order->mOrder_id = order_id;
+        order->mTicker_id = ticker_id;
+        order->mSide = side;
+        order->mState = OwnOrderState::PENDING_NEW;
+        order->mPrice = price;
+        order->mQty = order->mLeaves_qty = qty;
+        mOrder_index[slotOf(order_id)] = order;
+        ++mWorking;
+
+        // Appends the order to the own orders of its level.
+        auto &level = levelOf(ticker_id, side, price);
+        order->mPrev_order = level.tail;
+        (level.tail ? level.tail->mNext_order : level.head) = order;
+        level.tail = order;
+        return order;
+    }
+
+    /// \brief Sends the cancel of a working order.
+    /// \param order_id Id of the order.
+    /// \return false if the order is unknown, already being cancelled, or
+    /// the outbound queue is full.
+    auto sendCancel(OrderId order_id) noexcept -> bool {
+        const auto order = find(order_id);
+        if (!order || order->mState == OwnOrderState::PENDING_CANCEL)
+            [[unlikely]] {
+            return false;
+        }
+        if (!mOrders.sendCancel(order->mTicker_id, order_id, order->mSide))
+            [[unlikely]] {
+            return false;
+        }
+        order->mState = OwnOrderState::PENDING_CANCEL;
+        return true;
+    }
+
+    /// \brief Applies a response of the exchange to the order it is for. An
+    /// order that is filled or cancelled is no longer tracked afterwards.
+    /// \param response The response.
+    /// \return State of the order after the response, INVALID for a
+    /// response to an unknown order.
+    auto onResponse(const MEClientResponse &response) noexcept
+        -> OwnOrderState {
+        const auto order = find(response.order_id);
+        if (!order) [[unlikely]] return OwnOrderState::INVALID;
+
+        switch (response.type) {
+            case ClientResponseType::ACCEPTED:
+                order->mMarket_order_id = response.market_order_id;
+                if (order->mState == OwnOrderState::PENDING_NEW) {
+                    order->mState = OwnOrderState::LIVE;
+                }
+                break;
+            case ClientResponseType::FILLED:
+                order->mLeaves_qty = response.leaves_qty;
+                // Whatever was ahead traded first.
+                order->mQty_ahead = 0;
+                if (!order->mLeaves_qty) {
+                    remove(order);
+                    return OwnOrderState::FILLED;
+                }
+                break;
+            case ClientResponseType::CANCELED:
+                remove(order);
+                return OwnOrderState::CANCELED;
+            case ClientResponseType::CANCEL_REJECTED:
+                if (order->mState == OwnOrderState::PENDING_CANCEL) {
+                    order->mState = OwnOrderState::LIVE;
+                }
+                break;
+            case ClientResponseType::INVALID:
+                break;
+        }
+        return order->mState;
+    }
+
+    /// \brief Updates the queue positions of the own orders at the level of
+    /// a market update. Must be called before the book applies the update,
+    /// from Strategy::onBeforeBookUpdate() under a StrategyRunner.
+    /// \param update The market update.
+    /// \param book The book of the update's ticker.
+    auto onMarketUpdate(const MEMarketUpdate &update,
+                        const MarketOrderBook &book) noexcept -> void {
+        if (update.type == MarketUpdateType::CLEAR) [[unlikely]] {
+            forgetQueuePositions(update.ticker_id);
+            return;
+        }
+        if (update.ticker_id >= ME_MAX_TICKERS ||
+            (update.side != Side::BUY && update.side != Side::SELL))
+            [[unlikely]] {
+            return;
+        }
+        const auto head = levelOf(update.ticker_id, update.side, update.price)
+                              .head;
+        // Most updates are at levels without own orders.
+        if (!head) return;
+
+        switch (update.type) {
+            case MarketUpdateType::ADD:
+                for (auto order = head; order; order = order->mNext_order) {
+                    if (order->mMarket_order_id == update.order_id &&
+                        order->mPrice == update.price) {
+                        const auto level =
+                            book.getLevel(update.side, update.price);
+                        order->mPriority = update.priority;
+                        order->mQty_ahead = level ? level->mTotal_qty : 0;
+                    }
+                }
+                break;
+            case MarketUpdateType::MODIFY:
+            case MarketUpdateType::CANCEL: {
+                const auto market_order = book.getOrder(update.order_id);
+                if (!market_order) [[unlikely]] break;
+                const auto new_qty =
+                    update.type == MarketUpdateType::CANCEL ? 0 : update.qty;
+                for (auto order = head; order; order = order->mNext_order) {
+                    if (order->hasQueuePosition() &&
+                        order->mPrice == update.price &&
+                        market_order->mPriority < order->mPriority) {
+                        order->mQty_ahead =
+                            order->mQty_ahead + new_qty - market_order->mQty;
+                    }
+                }
+            } break;
+            case MarketUpdateType::TRADE:
+            case MarketUpdateType::CLEAR:
+            case MarketUpdateType::INVALID:
+            case MarketUpdateType::SNAPSHOT_START:
+            case MarketUpdateType::SNAPSHOT_END:
+                // A trade is followed by the MODIFY or CANCEL of the order
+                // it traded against, which moves the queue.
+                break;
+        }
+    }
+
+    /// \brief Returns a working order by its id.
+    /// \return The order, nullptr if it is not working.
+    auto getOrder(OrderId order_id) const noexcept -> const OwnOrder * {
+        return find(order_id);
+    }
+
+    /// \brief Calls a function with every working order at a level, in the
+    /// order they were sent.
+    /// \param ticker_id Ticker of the level.
+    /// \param side Side of the level.
+    /// \param price Price of the level.
+    /// \param function Called with a const reference to every OwnOrder.
+    template <typename Function>
+    auto forEachOrderAt(TickerId ticker_id, Side side, Price price,
+                        Function &&function) const noexcept -> void {
+        for (auto order = levelOf(ticker_id, side, price).head; order;
+             order = order->mNext_order) {
+            if (order->mPrice == price) {
+                function(static_cast<const OwnOrder &>(*order));
+            }
+        }
+    }
+
+    /// \brief Returns the number of working orders.
+    auto workingOrders() const noexcept { return mWorking; }
+
+    /// \brief Returns the number of new orders that could not be sent.
+    auto ordersRefused() const noexcept { return mOrders_refused; }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    OrderManager() = delete;
+    OrderManager(const OrderManager &) = delete;
+    OrderManager(const OrderManager &&) = delete;
+    OrderManager &operator=(const OrderManager &) = delete;
+    OrderManager &operator=(const OrderManager &&) = delete;
+
+   private:
+    /// \struct OwnLevel
+    /// \brief First and last own order of a level.
+    struct OwnLevel {
+        OwnOrder *head;
+        OwnOrder *tail;
+    };
+
+    /// \brief Returns the working order with an id, nullptr if none.
+    auto find(OrderId order_id) const noexcept -> OwnOrder * {
+        return mOrder_index[slotOf(order_id)];
+    }
+
+    /// \brief Returns the slot of the index holding an order id, or the
+    /// empty slot it would be inserted into.
+    auto slotOf(OrderId order_id) const noexcept -> size_t {
+        auto slot = order_id & mIndex_mask;
+        while (mOrder_index[slot] && mOrder_index[slot]->mOrder_id != order_id)
+            slot = (slot + 1) & mIndex_mask;
+        return slot;
+    }
+
+    /// \brief Empties a slot of the index, moving back the orders probed
+    /// past it so that every order stays reachable from its home slot.
+    auto eraseSlot(size_t slot) noexcept -> void {
+        for (auto next = (slot + 1) & mIndex_mask; mOrder_index[next];
+             next = (next + 1) & mIndex_mask) {
+            const auto home = mOrder_index[next]->mOrder_id & mIndex_mask;
+            // Moves the order back unless its home lies cyclically in
+            // (slot, next].
+            if (((next - home) & mIndex_mask) >=
+                ((next - slot) & mIndex_mask)) {
+                mOrder_index[slot] = mOrder_index[next];
+                slot = next;
+            }
+        }
+        mOrder_index[slot] = nullptr;
+    }
+
+    /// \brief Returns the own orders of a level. Prices are mapped like the
+    /// book's levels, the list holds the orders of every price of the slot.
+    auto levelOf(TickerId ticker_id, Side side, Price price) noexcept
+        -> OwnLevel & {
+        return mLevels[ticker_id][side == Side::BUY ? 0 : 1]
+                      [price % ME_MAX_PRICE_LEVELS];
+    }
+    auto levelOf(TickerId ticker_id, Side side, Price price) const noexcept
+        -> const OwnLevel & {
+        return mLevels[ticker_id][side == Side::BUY ? 0 : 1]
+                      [price % ME_MAX_PRICE_LEVELS];
+    }
+
+    /// \brief Stops tracking an order and returns it to the pool.
+    auto remove(OwnOrder *order) noexcept -> void {
+        auto &level = levelOf(order->mTicker_id, order->mSide, order->mPrice);
+        (order->mPrev_order ? order->mPrev_order->mNext_order : level.head) =
+            order->mNext_order;
+        (order->mNext_order ? order->mNext_order->mPrev_order : level.tail) =
+            order->mPrev_order;
+        eraseSlot(slotOf(order->mOrder_id));
+        --mWorking;
+        mOrder_pool.deallocate(order);
+    }
+
+    /// \brief Forgets the queue positions of the orders of a ticker whose
+    /// book was cleared.
+    auto forgetQueuePositions(TickerId ticker_id) noexcept -> void {
+        if (ticker_id >= ME_MAX_TICKERS) return;
+        for (auto &levels : mLevels[ticker_id]) {
+            for (auto &level : levels) {
+                for (auto order = level.head; order;
+                     order = order->mNext_order) {
+                    order->mPriority = Priority_INVALID;
+                    order->mQty_ahead = 0;
+                }
+            }
+        }
+    }
+
+    /// \brief The emitter the orders are sent with.
+    OrderEmitter &mOrders;
+    /// \brief Largest number of working orders.
+    const size_t mMax_orders;
+    /// \brief Number of working orders.
+    size_t mWorking = 0;
+    /// \brief Number of new orders that could not be sent.
+    uint64_t mOrders_refused = 0;
+
+    /// \brief Memory pool of the working orders.
+    MemoryPool<OwnOrder> mOrder_pool;
+    /// \brief Working orders by OrderId, linearly probed from the id modulo
+    /// the table size.
+    std::vector<OwnOrder *> mOrder_index;
+    /// \brief Size of the index table minus one.
+    const size_t mIndex_mask;
+    /// \brief Own orders per ticker, side and price slot.
+    std::array<std::array<std::array<OwnLevel, ME_MAX_PRICE_LEVELS>, 2>,
+               ME_MAX_TICKERS>
+        mLevels;
+};
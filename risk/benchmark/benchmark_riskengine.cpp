@@ -0,0 +1,392 @@
+/// \file benchmark_riskengine.cpp
+/// \brief Cost of the pre-trade risk checks, with a deterministic replay of a
+/// session checked against a straightforward reference model.
+/// \details Generates a seeded session of order requests and the matching
+/// engine's fills and cancels for 64 clients in 4 tickers, with limits and
+/// throttles tight enough that every check fails regularly, and NEW requests
+/// with invalid prices or quantities or an overflowing notional. The reference
+/// model, maps and an if-chain, decides every request while the session is
+/// generated. The RiskEngine then replays the recorded session and must
+/// reach the same decision for every request, and the digest of the
+/// decisions printed is the same on every run. Finally both are timed over
+/// the session.
+
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "micro-benchmark/microbenchmark.h"
+#include "risk/riskengine.h"
+
+/// \brief Number of events of the session.
+constexpr size_t NUM_EVENTS = 1'000'000;
+
+/// \brief Number of clients of the session.
+constexpr ClientId NUM_CLIENTS = 64;
+
+/// \brief Number of tickers of the session.
+constexpr TickerId NUM_TICKERS = 4;
+
+/// \struct RiskEvent
+/// \brief One recorded event of the session, a request with the decision of
+/// the reference model or a response.
+struct RiskEvent {
+    bool is_request = true;
+    uint64_t time = 0;
+    MEClientRequest request;
+    MEClientResponse response;
+    RiskCheckResult expected = RiskCheckResult::ALLOWED;
+};
+
+/// \brief The risk rules written plainly, one map lookup and one condition
+/// after the other.
+class ReferenceRisk {
+   public:
+    auto setLimits(ClientId client_id, TickerId ticker_id,
+                   const RiskLimits &limits) -> void {
+        mState[{client_id, ticker_id}].limits = limits;
+    }
+
+    auto setThrottle(ClientId client_id, uint32_t max_messages,
+                     uint64_t window_ns) -> void {
+        mThrottle[client_id].max_messages = max_messages;
+        mThrottle[client_id].window_ns = window_ns;
+    }
+
+    auto check(const MEClientRequest &request, uint64_t now)
+        -> RiskCheckResult {
+        if (request.client_id >= ME_MAX_NUM_CLIENTS ||
+            request.ticker_id >= ME_MAX_TICKERS ||
+            (request.type != ClientRequestType::NEW &&
+             request.type != ClientRequestType::CANCEL) ||
+            (request.side != Side::BUY && request.side != Side::SELL)) {
+            return RiskCheckResult::INVALID_REQUEST;
+        }
+        if (request.type == ClientRequestType::NEW &&
+            (request.price <= 0 || request.price == Price_INVALID ||
+             request.qty == 0)) {
+            return RiskCheckResult::INVALID_REQUEST;
+        }
+        auto &throttle = mThrottle[request.client_id];
+        if (now - throttle.window_start >= throttle.window_ns) {
+            throttle.window_start = now;
+            throttle.messages = 0;
+        }
+        auto &state = mState[{request.client_id, request.ticker_id}];
+        if (request.type == ClientRequestType::NEW) {
+            const int64_t qty = request.qty;
+            if (request.qty > state.limits.max_order_size) {
+                return RiskCheckResult::ORDER_TOO_LARGE;
+            }
+            if (request.side == Side::BUY &&
+                state.position + state.open_buy_qty + qty >
+                    state.limits.max_position) {
+                return RiskCheckResult::POSITION_TOO_LARGE;
+            }
+            if (request.side == Side::SELL &&
+                state.open_sell_qty + qty - state.position >
+                    state.limits.max_position) {
+                return RiskCheckResult::POSITION_TOO_LARGE;
+            }
+            if (state.open_notional +
+                    static_cast<__int128>(qty) * request.price >
+                state.limits.max_open_notional) {
+                return RiskCheckResult::NOTIONAL_TOO_LARGE;
+            }
+        }
+        if (throttle.messages >= throttle.max_messages) {
+            return RiskCheckResult::THROTTLED;
+        }
+        ++throttle.messages;
+        if (request.type == ClientRequestType::NEW) {
+            const int64_t qty = request.qty;
+            if (request.side == Side::BUY) {
+                state.open_buy_qty += qty;
+            } else {
+                state.open_sell_qty += qty;
+            }
+            state.open_notional += qty * request.price;
+        }
+        return RiskCheckResult::ALLOWED;
+    }
+
+    auto onResponse(const MEClientResponse &response) -> void {
+        auto &state = mState[{response.client_id, response.ticker_id}];
+        int64_t qty = 0;
+        if (response.type == ClientResponseType::FILLED) {
+            qty = response.exec_qty;
+            state.position += response.side == Side::BUY ? qty : -qty;
+        } else if (response.type == ClientResponseType::CANCELED) {
+            qty = response.leaves_qty;
+        }
+        if (response.side == Side::BUY) {
+            state.open_buy_qty -= qty;
+        } else {
+            state.open_sell_qty -= qty;
+        }
+        state.open_notional -= qty * response.price;
+    }
+
+   private:
+    struct State {
+        RiskLimits limits;
+        int64_t position = 0;
+        int64_t open_buy_qty = 0;
+        int64_t open_sell_qty = 0;
+        int64_t open_notional = 0;
+    };
+
+    struct Throttle {
+        uint64_t window_start = 0;
+        uint64_t window_ns = 0;
+        uint32_t messages = 0;
+        uint32_t max_messages = 0;
+    };
+
+    std::map<std::pair<ClientId, TickerId>, State> mState;
+    std::map<ClientId, Throttle> mThrottle;
+};
+
+/// \brief Sets the same seeded limits and throttles on a risk model.
+template <typename Risk>
+auto configure(Risk &risk) -> void {
+    std::mt19937_64 random(7);
+    for (ClientId client_id = 0; client_id < NUM_CLIENTS; ++client_id) {
+        risk.setThrottle(client_id, 40 + random() % 80,
+                         200'000 + random() % 800'000);
+        for (TickerId ticker_id = 0; ticker_id < NUM_TICKERS; ++ticker_id) {
+            RiskLimits limits;
+            limits.max_order_size = 1'000 + random() % 2'000;
+            limits.max_position = 4'000 + random() % 8'000;
+            limits.max_open_notional = 400'000 + random() % 800'000;
+            risk.setLimits(client_id, ticker_id, limits);
+        }
+    }
+}
+
+/// \struct OpenOrder
+/// \brief An order of the session that passed the checks.
+struct OpenOrder {
+    ClientId client_id;
+    TickerId ticker_id;
+    OrderId order_id;
+    Side side;
+    Price price;
+    Qty leaves_qty;
+};
+
+/// \brief Generates the session, deciding every request with the reference
+/// model.
+auto generateSession() -> std::vector<RiskEvent> {
+    ReferenceRisk reference;
+    configure(reference);
+    std::mt19937_64 random(42);
+    std::exponential_distribution<double> gap(1.0 / 100.0);
+    std::geometric_distribution<Qty> lots(0.25);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    std::vector<RiskEvent> events;
+    events.reserve(NUM_EVENTS);
+    std::vector<OpenOrder> open;
+    uint64_t time = 0;
+    OrderId next_order_id = 0;
+    while (events.size() < NUM_EVENTS) {
+        time += static_cast<uint64_t>(gap(random));
+        RiskEvent event;
+        event.time = time;
+        if (!open.empty() && uniform(random) < 0.45) {
+            // A fill or cancel of an open order by the matching engine.
+            const auto index = random() % open.size();
+            auto &order = open[index];
+            auto &response = event.response;
+            event.is_request = false;
+            response.client_id = order.client_id;
+            response.ticker_id = order.ticker_id;
+            response.order_id = order.order_id;
+            response.side = order.side;
+            response.price = order.price;
+            if (uniform(random) < 0.6) {
+                response.type = ClientResponseType::FILLED;
+                response.exec_price = order.price;
+                response.exec_qty = 1 + random() % order.leaves_qty;
+                response.leaves_qty = order.leaves_qty - response.exec_qty;
+            } else {
+                response.type = ClientResponseType::CANCELED;
+                response.leaves_qty = order.leaves_qty;
+            }
+            reference.onResponse(response);
+            order.leaves_qty = response.type == ClientResponseType::FILLED
+                                   ? response.leaves_qty
+                                   : 0;
+            if (!order.leaves_qty) {
+                order = open.back();
+                open.pop_back();
+            }
+        } else {
+            auto &request = event.request;
+            request.client_id = random() % NUM_CLIENTS;
+            request.ticker_id = random() % NUM_TICKERS;
+            request.side = random() % 2 ? Side::BUY : Side::SELL;
+            if (!open.empty() && uniform(random) < 0.2) {
+                const auto &order = open[random() % open.size()];
+                request.type = ClientRequestType::CANCEL;
+                request.client_id = order.client_id;
+                request.ticker_id = order.ticker_id;
+                request.order_id = order.order_id;
+                request.side = order.side;
+            } else {
+                request.type = ClientRequestType::NEW;
+                request.order_id = next_order_id++;
+                request.price = 100 + random() % 10;
+                request.qty = 100 * (1 + lots(random));
+            }
+            if (uniform(random) < 0.001) request.client_id = ClientId_INVALID;
+            if (request.type == ClientRequestType::NEW &&
+                uniform(random) < 0.005) {
+                // Prices and quantities the checks must refuse, the last
+                // price overflows the notional of any quantity.
+                switch (random() % 5) {
+                    case 0:
+                        request.price = 0;
+                        break;
+                    case 1:
+                        request.price = -request.price;
+                        break;
+                    case 2:
+                        request.price = Price_INVALID;
+                        break;
+                    case 3:
+                        request.qty = 0;
+                        break;
+                    default:
+                        request.price = Price_INVALID / 2;
+                        break;
+                }
+            }
+            event.expected = reference.check(request, time);
+            if (request.type == ClientRequestType::NEW &&
+                event.expected == RiskCheckResult::ALLOWED) {
+                open.push_back({request.client_id, request.ticker_id,
+                                request.order_id, request.side, request.price,
+                                request.qty});
+            }
+        }
+        events.push_back(event);
+    }
+    return events;
+}
+
+/// \brief Main function running the risk engine benchmarks.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    MicroBenchmark benchmark(argc, argv);
+
+    const auto events = generateSession();
+
+    // Deterministic replay against the decisions of the reference model.
+    {
+        auto engine = std::make_unique<RiskEngine>();
+        configure(*engine);
+        uint64_t digest = 0;
+        for (size_t index = 0; index < events.size(); ++index) {
+            const auto &event = events[index];
+            if (!event.is_request) {
+                engine->onResponse(event.response);
+                continue;
+            }
+            const auto result = engine->check(event.request, event.time);
+            if (result != event.expected) [[unlikely]] {
+                FATAL("Event " + std::to_string(index) + " " +
+                      event.request.toString() + " is " +
+                      riskCheckResultToString(result) + " instead of " +
+                      riskCheckResultToString(event.expected));
+            }
+            digest = digest * 31 + static_cast<uint64_t>(result);
+        }
+        std::cout << "replayed " << events.size() << " events, digest "
+                  << digest << ", results";
+        for (size_t result = 0; result < RISK_CHECK_RESULT_COUNT; ++result) {
+            std::cout << " " << riskCheckResultToString(
+                                    static_cast<RiskCheckResult>(result))
+                      << " " << engine->results(
+                                    static_cast<RiskCheckResult>(result));
+        }
+        std::cout << std::endl;
+    }
+
+    benchmark.run("risk engine", events.size(), [&]() {
+        auto engine = std::make_unique<RiskEngine>();
+        configure(*engine);
+        for (const auto &event : events) {
+            if (event.is_request) {
+                doNotOptimize(engine->check(event.request, event.time));
+            } else {
+                engine->onResponse(event.response);
+            }
+        }
+    });
+
+    // The steady state of a well behaved client: every order is allowed and
+    // later cancelled, the requests are hot in the cache.
+    {
+        constexpr size_t NUM_ORDERS = 4'096;
+        RiskLimits limits;
+        limits.max_order_size = 1'000'000;
+        limits.max_position = 1'000'000'000;
+        limits.max_open_notional = 1'000'000'000'000;
+        std::vector<MEClientRequest> requests(NUM_ORDERS);
+        std::vector<MEClientResponse> responses(NUM_ORDERS);
+        std::mt19937_64 random(1);
+        for (size_t index = 0; index < NUM_ORDERS; ++index) {
+            auto &request = requests[index];
+            request.type = ClientRequestType::NEW;
+            request.client_id = random() % NUM_CLIENTS;
+            request.ticker_id = random() % NUM_TICKERS;
+            request.order_id = index;
+            request.side = random() % 2 ? Side::BUY : Side::SELL;
+            request.price = 100 + random() % 10;
+            request.qty = 100 * (1 + random() % 10);
+            auto &response = responses[index];
+            response.type = ClientResponseType::CANCELED;
+            response.client_id = request.client_id;
+            response.ticker_id = request.ticker_id;
+            response.order_id = request.order_id;
+            response.side = request.side;
+            response.price = request.price;
+            response.leaves_qty = request.qty;
+        }
+        auto engine = std::make_unique<RiskEngine>();
+        for (ClientId client_id = 0; client_id < NUM_CLIENTS; ++client_id) {
+            engine->setThrottle(client_id, 1'000'000'000, 1'000'000'000);
+            for (TickerId ticker_id = 0; ticker_id < NUM_TICKERS;
+                 ++ticker_id) {
+                engine->setLimits(client_id, ticker_id, limits);
+            }
+        }
+        uint64_t now = 0;
+        benchmark.run("allowed check", NUM_ORDERS, [&]() {
+            for (const auto &request : requests) {
+                doNotOptimize(engine->check(request, ++now));
+            }
+            for (const auto &response : responses) {
+                engine->onResponse(response);
+            }
+        });
+    }
+
+    benchmark.run("reference model", events.size(), [&]() {
+        ReferenceRisk reference;
+        configure(reference);
+        for (const auto &event : events) {
+            if (event.is_request) {
+                doNotOptimize(reference.check(event.request, event.time));
+            } else {
+                reference.onResponse(event.response);
+            }
+        }
+    });
+
+    return 0;
+}
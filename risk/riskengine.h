@@ -0,0 +1,263 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string>
+
+#include "market-orders/clientrequest.h"
+#include "market-orders/clientresponse.h"
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+/// \enum RiskCheckResult
+/// \brief Outcome of the pre-trade check of an order request.
+enum class RiskCheckResult : uint8_t {
+    ALLOWED = 0,
+    INVALID_REQUEST = 1,
+    ORDER_TOO_LARGE = 2,
+    POSITION_TOO_LARGE = 3,
+    NOTIONAL_TOO_LARGE = 4,
+    THROTTLED = 5,
+    MAX = 6
+};
+
+/// \brief Number of RiskCheckResult values.
+constexpr size_t RISK_CHECK_RESULT_COUNT =
+    static_cast<size_t>(RiskCheckResult::MAX);
+
+/// \brief Converts a RiskCheckResult enum to a string.
+/// \param result The RiskCheckResult to convert.
+/// \return String representation of the RiskCheckResult.
+inline auto riskCheckResultToString(RiskCheckResult result) -> std::string {
+    switch (result) {
+        case RiskCheckResult::ALLOWED:
+            return "ALLOWED";
+        case RiskCheckResult::INVALID_REQUEST:
+            return "INVALID_REQUEST";
+        case RiskCheckResult::ORDER_TOO_LARGE:
+            return "ORDER_TOO_LARGE";
+        case RiskCheckResult::POSITION_TOO_LARGE:
+            return "POSITION_TOO_LARGE";
+        case RiskCheckResult::NOTIONAL_TOO_LARGE:
+            return "NOTIONAL_TOO_LARGE";
+        case RiskCheckResult::THROTTLED:
+            return "THROTTLED";
+        case RiskCheckResult::MAX:
+            return "MAX";
+    }
+    return "UNKNOWN";
+}
+
+/// \struct RiskLimits
+/// \brief Limits of a client in one ticker. All limits default to 0, so a
+/// client must be configured before any of its orders is allowed.
+struct RiskLimits {
+    /// Largest quantity of a single order.
+    Qty max_order_size = 0;
+    /// Largest long or short position, counting every open order of that
+    /// side as filled.
+    int64_t max_position = 0;
+    /// Largest sum of quantity times limit price of the open orders.
+    int64_t max_open_notional = 0;
+};
+
+/// \struct TickerRisk
+/// \brief Limits and state of a client in one ticker, one cache line so that
+/// a check touches a single line besides the throttle.
+struct alignas(64) TickerRisk {
+    /// Limits of the client in the ticker.
+    RiskLimits limits;
+    /// Filled position, positive when long.
+    int64_t position = 0;
+    /// Open quantity of the orders of each side, indexed by sideToIndex().
+    std::array<int64_t, 3> open_qty = {0, 0, 0};
+    /// Sum of quantity times limit price of the open orders.
+    int64_t open_notional = 0;
+};
+
+static_assert(sizeof(TickerRisk) == 64, "TickerRisk must be one cache line.");
+
+/// \struct ClientThrottle
+/// \brief Message rate limit of a client over fixed windows of time.
+struct alignas(64) ClientThrottle {
+    /// Start of the current window, in nanoseconds.
+    uint64_t window_start = 0;
+    /// Length of a window, in nanoseconds.
+    uint64_t window_ns = 0;
+    /// Requests allowed in the current window.
+    uint32_t messages = 0;
+    /// Largest number of requests allowed per window.
+    uint32_t max_messages = 0;
+};
+
+/// \brief Pre-trade risk checks of the order requests of every client,
+/// before they reach the matching engine.
+///
+/// The limits and state of every client and ticker live in flat arrays of
+/// cache lines indexed by ClientId and TickerId, so a check is two array
+/// lookups and no hashing. All conditions of a check are evaluated into a
+/// bit mask without branching, the lowest set bit names the result, and the
+/// only branch, taken when the request is rejected, is well predicted in
+/// normal operation.
+///
+/// A NEW order that passes reserves its quantity and notional as open until
+/// the matching engine's response for it arrives: a fill moves quantity from
+/// open to the position, a cancel releases it. Time is passed in by the
+/// caller, so a replay of the same requests and responses always gives the
+/// same results.
+class RiskEngine final {
+   public:
+    /// \brief Constructs a RiskEngine with every limit at 0.
+    RiskEngine() = default;
+
+    /// \brief Sets the limits of a client in a ticker.
+    auto setLimits(ClientId client_id, TickerId ticker_id,
+                   const RiskLimits &limits) -> void {
+        ASSERT(client_id < ME_MAX_NUM_CLIENTS && ticker_id < ME_MAX_TICKERS,
+               "Risk limits for an unknown client or ticker");
+        mRisk[client_id][ticker_id].limits = limits;
+    }
+
+    /// \brief Sets the message rate limit of a client.
+    /// \param client_id The client.
+    /// \param max_messages Largest number of requests per window.
+    /// \param window_ns Length of a window, in nanoseconds.
+    auto setThrottle(ClientId client_id, uint32_t max_messages,
+                     uint64_t window_ns) -> void {
+        ASSERT(client_id < ME_MAX_NUM_CLIENTS,
+               "Throttle for an unknown client");
+        mThrottles[client_id].max_messages = max_messages;
+        mThrottles[client_id].window_ns = window_ns;
+    }
+
+    /// \brief Checks an order request and, if it is allowed, accounts for it.
+    /// \param request The NEW or CANCEL request. A NEW needs a positive,
+    /// valid price and a quantity.
+    /// \param now Current time in nanoseconds, never decreasing.
+    /// \return ALLOWED or the reason of the rejection.
+    auto check(const MEClientRequest &request, uint64_t now) noexcept
+        -> RiskCheckResult {
+        const auto is_new = request.type == ClientRequestType::NEW;
+        if (request.client_id >= ME_MAX_NUM_CLIENTS ||
+            request.ticker_id >= ME_MAX_TICKERS ||
+            (!is_new && request.type != ClientRequestType::CANCEL) ||
+            (request.side != Side::BUY && request.side != Side::SELL) ||
+            (is_new && (request.price <= 0 || request.price == Price_INVALID ||
+                        !request.qty))) [[unlikely]] {
+            return reject(RiskCheckResult::INVALID_REQUEST);
+        }
+
+        auto &throttle = mThrottles[request.client_id];
+        const auto expired = now - throttle.window_start >= throttle.window_ns;
+        const auto window_start = expired ? now : throttle.window_start;
+        const auto messages = expired ? 0 : throttle.messages;
+
+        // The side and type select by arithmetic rather than branches, as
+        // both are random from one request to the next. A cancel only counts
+        // against the throttle, its quantity is 0 here.
+        auto &risk = mRisk[request.client_id][request.ticker_id];
+        const auto side = sideToIndex(request.side);
+        const auto qty = static_cast<int64_t>(request.qty) * is_new;
+        // A notional beyond int64_t exceeds any limit.
+        int64_t notional = 0;
+        const bool notional_overflow =
+            __builtin_mul_overflow(qty, request.price, &notional);
+        // The long or short position if every open order of the side was
+        // filled.
+        const auto worst_position = sideToValue(request.side) * risk.position +
+                                    risk.open_qty[side] + qty;
+        const uint32_t order_failed =
+            (qty > risk.limits.max_order_size) |
+            (worst_position > risk.limits.max_position) << 1 |
+            (notional_overflow |
+             (notional > risk.limits.max_open_notional - risk.open_notional))
+                << 2;
+        const uint32_t failed = order_failed * is_new |
+                                (messages >= throttle.max_messages) << 3;
+        // A new window starts with the first request after the last one
+        // expired, whether or not that request is allowed.
+        throttle.window_start = window_start;
+        throttle.messages = messages;
+        if (failed) [[unlikely]] {
+            return reject(static_cast<RiskCheckResult>(
+                std::countr_zero(failed) +
+                static_cast<int>(RiskCheckResult::ORDER_TOO_LARGE)));
+        }
+
+        ++throttle.messages;
+        risk.open_qty[side] += qty;
+        risk.open_notional += notional;
+        ++mResults[static_cast<size_t>(RiskCheckResult::ALLOWED)];
+        return RiskCheckResult::ALLOWED;
+    }
+
+    /// \brief Accounts for a response of the matching engine to an order
+    /// that passed check().
+    /// \param response The response.
+    auto onResponse(const MEClientResponse &response) noexcept -> void {
+        if (response.client_id >= ME_MAX_NUM_CLIENTS ||
+            response.ticker_id >= ME_MAX_TICKERS ||
+            (response.side != Side::BUY && response.side != Side::SELL))
+            [[unlikely]] {
+            return;
+        }
+        auto &risk = mRisk[response.client_id][response.ticker_id];
+        switch (response.type) {
+            case ClientResponseType::FILLED: {
+                const auto qty = static_cast<int64_t>(response.exec_qty);
+                risk.position += sideToValue(response.side) * qty;
+                release(risk, response.side, qty, response.price);
+            } break;
+            case ClientResponseType::CANCELED:
+                release(risk, response.side,
+                        static_cast<int64_t>(response.leaves_qty),
+                        response.price);
+                break;
+            case ClientResponseType::ACCEPTED:
+            case ClientResponseType::CANCEL_REJECTED:
+            case ClientResponseType::INVALID:
+                // These response types do not change the open orders
+                break;
+        }
+    }
+
+    /// \brief Returns the limits and state of a client in a ticker.
+    auto risk(ClientId client_id, TickerId ticker_id) const noexcept
+        -> const TickerRisk & {
+        return mRisk[client_id][ticker_id];
+    }
+
+    /// \brief Returns the number of checks with a result.
+    auto results(RiskCheckResult result) const noexcept {
+        return mResults[static_cast<size_t>(result)];
+    }
+
+    // Deleted copy & move constructors and assignment-operators.
+    RiskEngine(const RiskEngine &) = delete;
+    RiskEngine(const RiskEngine &&) = delete;
+    RiskEngine &operator=(const RiskEngine &) = delete;
+    RiskEngine &operator=(const RiskEngine &&) = delete;
+
+   private:
+    /// \brief Counts and returns a rejection.
+    auto reject(RiskCheckResult result) noexcept -> RiskCheckResult {
+        ++mResults[static_cast<size_t>(result)];
+        return result;
+    }
+
+    /// \brief Removes quantity of an order from the open orders.
+    static auto release(TickerRisk &risk, Side side, int64_t qty,
+                        Price price) noexcept -> void {
+        risk.open_qty[sideToIndex(side)] -= qty;
+        risk.open_notional -= qty * price;
+    }
+
+    /// \brief Limits and state, indexed by ClientId and TickerId.
+    std::array<std::array<TickerRisk, ME_MAX_TICKERS>, ME_MAX_NUM_CLIENTS>
+        mRisk;
+    /// \brief Message rate limits, indexed by ClientId.
+    std::array<ClientThrottle, ME_MAX_NUM_CLIENTS> mThrottles;
+    /// \brief Number of checks per result.
+    std::array<uint64_t, RISK_CHECK_RESULT_COUNT> mResults = {};
+};
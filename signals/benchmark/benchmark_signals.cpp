@@ -0,0 +1,196 @@
+/// \file benchmark_signals.cpp
+/// \brief Cost of the incremental signal engine against recomputing the
+/// signals from the levels on every change.
+/// \details Derives a market-by-price feed from synthetic order flow, flushed
+/// after every order event so that the signals follow every change of the
+/// book. The SignalEngine's features are checked against a recomputation from
+/// the consumer's MarketByPriceBook after every publish. Then both ways of
+/// producing the signals are timed over the recorded feed.
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "market-by-price/marketbypricebuilder.h"
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowbooks.h"
+#include "signals/signalengine.h"
+
+/// \brief Number of order events of the flow.
+constexpr size_t NUM_EVENTS = 500'000;
+
+/// \brief Published depth of the market-by-price feed.
+constexpr size_t DEPTH = 20;
+
+/// \struct SignalInput
+/// \brief One recorded input of the signal engine.
+struct SignalInput {
+    enum class Kind : uint8_t { LEVEL, TRADE, PUBLISH } kind;
+    MBPUpdate level;
+    MEMarketUpdate trade;
+};
+
+/// \brief Average price of sweeping size from the best level of a side.
+auto fillPriceFromScratch(const MarketByPriceBook &book, Side side,
+                          int64_t size) -> double {
+    int64_t filled = 0;
+    int64_t notional = 0;
+    for (size_t index = 0; index < book.depth(side); ++index) {
+        const auto &level = book.level(side, index);
+        const auto take = std::min<int64_t>(level.qty, size - filled);
+        filled += take;
+        notional += take * level.price;
+        if (filled == size) return static_cast<double>(notional) / size;
+    }
+    return SIGNAL_UNDEFINED;
+}
+
+/// \brief Quantity of the best levels of a side.
+auto depthFromScratch(const MarketByPriceBook &book, Side side, size_t levels)
+    -> int64_t {
+    int64_t qty = 0;
+    for (size_t index = 0; index < std::min(levels, book.depth(side));
+         ++index) {
+        qty += book.level(side, index).qty;
+    }
+    return qty;
+}
+
+/// \brief Recomputes the quote features from the levels, the way strategies
+/// did on every change.
+auto featuresFromScratch(const MarketByPriceBook &book,
+                         const SignalConfig &config) -> SignalFeatures {
+    SignalFeatures features;
+    if (book.depth(Side::BUY) && book.depth(Side::SELL)) {
+        const auto &bid = book.level(Side::BUY, 0);
+        const auto &ask = book.level(Side::SELL, 0);
+        features.mid = 0.5 * static_cast<double>(bid.price + ask.price);
+        features.spread = static_cast<double>(ask.price - bid.price);
+        features.microprice =
+            static_cast<double>(bid.price * ask.qty + ask.price * bid.qty) /
+            static_cast<double>(bid.qty + ask.qty);
+    }
+    const auto bid_top =
+        depthFromScratch(book, Side::BUY, config.imbalance_levels);
+    const auto ask_top =
+        depthFromScratch(book, Side::SELL, config.imbalance_levels);
+    features.imbalance =
+        bid_top + ask_top
+            ? static_cast<double>(bid_top - ask_top) / (bid_top + ask_top)
+            : 0.0;
+    features.bid_depth = depthFromScratch(book, Side::BUY, MBP_MAX_DEPTH);
+    features.ask_depth = depthFromScratch(book, Side::SELL, MBP_MAX_DEPTH);
+    features.buy_fill_price =
+        fillPriceFromScratch(book, Side::SELL, config.fill_size);
+    features.sell_fill_price =
+        fillPriceFromScratch(book, Side::BUY, config.fill_size);
+    return features;
+}
+
+/// \brief Returns true if two features are equal, or both undefined.
+auto same(double a, double b) -> bool {
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+/// \brief Main function running the signal benchmarks.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    MicroBenchmark benchmark(argc, argv);
+
+    OrderFlowConfig flow_config;
+    OrderFlowGenerator generator(flow_config);
+
+    OrderFlowBooks books(flow_config.num_tickers);
+
+    MarketByPriceConfig mbp_config;
+    mbp_config.depth = DEPTH;
+    MarketByPriceBuilder builder(books.books(), mbp_config);
+
+    SignalConfig config;
+    SignalEngine engine(config);
+    std::array<MarketByPriceBook, ME_MAX_TICKERS> consumer;
+    std::vector<SignalInput> inputs;
+    inputs.reserve(4 * NUM_EVENTS);
+
+    // Records the inputs and checks the engine after every publish.
+    for (size_t event = 0; event < NUM_EVENTS || generator.hasPending();
+         ++event) {
+        const auto &update = generator.next()->update;
+        books.onMarketUpdate(&update);
+        builder.onMarketUpdate(&update);
+        if (update.type == MarketUpdateType::TRADE) {
+            engine.onTrade(update);
+            inputs.push_back({SignalInput::Kind::TRADE, {}, update});
+        }
+        builder.flush([&](const MBPUpdate &level) {
+            engine.onLevelUpdate(level);
+            consumer[level.ticker_id].onUpdate(level);
+            inputs.push_back({SignalInput::Kind::LEVEL, level, {}});
+        });
+        inputs.push_back({SignalInput::Kind::PUBLISH, {}, {}});
+        engine.publish([&](TickerId ticker_id,
+                           const SignalFeatures &features) {
+            const auto expected =
+                featuresFromScratch(consumer[ticker_id], config);
+            if (!same(features.microprice, expected.microprice) ||
+                !same(features.spread, expected.spread) ||
+                !same(features.imbalance, expected.imbalance) ||
+                features.bid_depth != expected.bid_depth ||
+                features.ask_depth != expected.ask_depth ||
+                !same(features.buy_fill_price, expected.buy_fill_price) ||
+                !same(features.sell_fill_price, expected.sell_fill_price))
+                [[unlikely]] {
+                FATAL("Signals of ticker " + std::to_string(ticker_id) +
+                      " differ from the recomputation after event " +
+                      std::to_string(event));
+            }
+        });
+    }
+    std::cout << "checked " << inputs.size() << " inputs, last features of "
+              << "ticker 0: microprice " << engine.features(0).microprice
+              << " imbalance " << engine.features(0).imbalance << " ofi "
+              << engine.features(0).order_flow_imbalance << std::endl;
+
+    benchmark.run("incremental engine", NUM_EVENTS, [&]() {
+        auto engine = std::make_unique<SignalEngine>(config);
+        for (const auto &input : inputs) {
+            switch (input.kind) {
+                case SignalInput::Kind::LEVEL:
+                    engine->onLevelUpdate(input.level);
+                    break;
+                case SignalInput::Kind::TRADE:
+                    engine->onTrade(input.trade);
+                    break;
+                case SignalInput::Kind::PUBLISH:
+                    engine->publish([](TickerId, const SignalFeatures &f) {
+                        doNotOptimize(f);
+                    });
+                    break;
+            }
+        }
+    });
+
+    benchmark.run("recompute from levels", NUM_EVENTS, [&]() {
+        std::array<MarketByPriceBook, ME_MAX_TICKERS> books;
+        uint64_t dirty = 0;
+        for (const auto &input : inputs) {
+            switch (input.kind) {
+                case SignalInput::Kind::LEVEL:
+                    books[input.level.ticker_id].onUpdate(input.level);
+                    dirty |= uint64_t{1} << input.level.ticker_id;
+                    break;
+                case SignalInput::Kind::TRADE:
+                    dirty |= uint64_t{1} << input.trade.ticker_id;
+                    break;
+                case SignalInput::Kind::PUBLISH:
+                    for (; dirty; dirty &= dirty - 1) {
+                        doNotOptimize(featuresFromScratch(
+                            books[std::countr_zero(dirty)], config));
+                    }
+                    break;
+            }
+        }
+    });
+
+    return 0;
+}
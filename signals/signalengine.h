@@ -0,0 +1,354 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "market-by-price/mbpupdate.h"
+#include "market-orders/marketupdate.h"
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+/// \brief Value of the features that are undefined, e.g. prices on an empty
+/// side.
+constexpr double SIGNAL_UNDEFINED = std::numeric_limits<double>::quiet_NaN();
+
+/// \struct SignalConfig
+/// \brief Parameters of the signal engine.
+struct SignalConfig {
+    /// Number of levels per side of the top-k imbalance.
+    size_t imbalance_levels = 5;
+    /// Quantity whose cost to fill is reported.
+    Qty fill_size = 1'000;
+    /// Weight of the newest sample of the exponentially weighted moving
+    /// averages, per quote publish or trade.
+    double ewma_alpha = 0.05;
+};
+
+/// \struct SignalFeatures
+/// \brief Features of a ticker, published by the SignalEngine. Prices are in
+/// ticks, like Price, and NaN while they are undefined, e.g. on an empty side.
+struct alignas(64) SignalFeatures {
+    /// Mid price weighted by the opposite quantities at the touch.
+    double microprice = SIGNAL_UNDEFINED;
+    /// Mid price.
+    double mid = SIGNAL_UNDEFINED;
+    /// Ask price minus bid price.
+    double spread = SIGNAL_UNDEFINED;
+    /// (bid - ask) / (bid + ask) quantity over the top imbalance_levels
+    /// levels, in [-1, 1].
+    double imbalance = 0.0;
+    /// Total quantity over the levels of the bid side.
+    int64_t bid_depth = 0;
+    /// Total quantity over the levels of the ask side.
+    int64_t ask_depth = 0;
+    /// Average price paid to buy fill_size by sweeping the asks, NaN if the
+    /// levels do not hold fill_size.
+    double buy_fill_price = SIGNAL_UNDEFINED;
+    /// Average price received to sell fill_size by sweeping the bids, NaN if
+    /// the levels do not hold fill_size.
+    double sell_fill_price = SIGNAL_UNDEFINED;
+    /// Cumulative order flow imbalance at the touch, in quantity.
+    int64_t order_flow_imbalance = 0;
+    /// Moving average of the order flow imbalance per publish.
+    double ewma_order_flow_imbalance = 0.0;
+    /// Moving average of the spread.
+    double ewma_spread = SIGNAL_UNDEFINED;
+    /// Moving average of the signed trade quantity, positive when buyers
+    /// initiate the trades.
+    double ewma_trade_imbalance = 0.0;
+    /// Moving average of the trade quantity.
+    double ewma_trade_size = 0.0;
+    /// Number of publishes of the ticker.
+    uint64_t publishes = 0;
+    /// Number of trades of the ticker.
+    uint64_t trades = 0;
+};
+
+/// \brief Maintains order book signals of every ticker incrementally from
+/// its level changes and trades.
+///
+/// Level changes arrive as market-by-price updates, usually straight from
+/// the MarketByPriceBuilder's flush(). Each side of a ticker is kept as
+/// contiguous arrays of prices and quantities, and a level change adjusts
+/// running sums of the quantity of the top levels and of all levels by its
+/// difference, so imbalance and depth never revisit the levels. The cost to
+/// fill a size walks the levels from the best price and stops once filled,
+/// which for the sizes of interest is the first few levels.
+///
+/// publish() recomputes the features of the tickers whose levels changed or
+/// which traded in O(1) each, updating the order flow imbalance from the
+/// previous touch, and hands them to a sink, for instance a
+/// ConflatingQueue<SignalFeatures> feeding strategies on other threads. Each
+/// ticker's SignalFeatures is cache line aligned, so readers of one ticker do
+/// not share lines with another.
+class SignalEngine final {
+   public:
+    /// \brief Constructs a SignalEngine with empty books for every ticker.
+    /// \param config Parameters of the signals.
+    explicit SignalEngine(SignalConfig config) : mConfig(config) {
+        ASSERT(mConfig.imbalance_levels &&
+                   mConfig.imbalance_levels <= MBP_MAX_DEPTH,
+               "Imbalance levels must be within [1, " +
+                   std::to_string(MBP_MAX_DEPTH) + "]");
+    }
+
+    /// \brief Applies a level change of a ticker.
+    /// \param update The market-by-price update.
+    auto onLevelUpdate(const MBPUpdate &update) noexcept -> void {
+        auto &ticker = mTickers[update.ticker_id];
+        mDirty |= uint64_t{1} << update.ticker_id;
+        switch (update.type) {
+            case MBPUpdateType::NEW_LEVEL:
+                ticker.sides[sideSlot(update.side)].insert(
+                    update.level, update.price, update.qty,
+                    mConfig.imbalance_levels);
+                break;
+            case MBPUpdateType::CHANGE_LEVEL:
+                ticker.sides[sideSlot(update.side)].change(
+                    update.level, update.qty, mConfig.imbalance_levels);
+                break;
+            case MBPUpdateType::DELETE_LEVEL:
+                ticker.sides[sideSlot(update.side)].erase(
+                    update.level, mConfig.imbalance_levels);
+                break;
+            case MBPUpdateType::REFRESH_START:
+                ticker.sides[0].clear();
+                ticker.sides[1].clear();
+                break;
+            case MBPUpdateType::REFRESH_END:
+            case MBPUpdateType::INVALID:
+                // These update types require no processing
+                break;
+        }
+    }
+
+    /// \brief Updates the trade features of a ticker. The side of a trade is
+    /// the side of the resting order, so a trade against a resting sell order
+    /// is initiated by a buyer.
+    /// \param trade A MarketUpdateType::TRADE update.
+    auto onTrade(const MEMarketUpdate &trade) noexcept -> void {
+        auto &features = mFeatures[trade.ticker_id];
+        mDirty |= uint64_t{1} << trade.ticker_id;
+        const auto qty = static_cast<double>(trade.qty);
+        const auto signed_qty = trade.side == Side::SELL ? qty : -qty;
+        features.ewma_trade_imbalance +=
+            mConfig.ewma_alpha * (signed_qty - features.ewma_trade_imbalance);
+        features.ewma_trade_size +=
+            mConfig.ewma_alpha * (qty - features.ewma_trade_size);
+        ++features.trades;
+    }
+
+    /// \brief Recomputes the features of every ticker whose levels changed
+    /// or which traded since the previous publish.
+    /// \param sink Called with the TickerId and a const reference to the
+    /// SignalFeatures of every updated ticker.
+    /// \return Number of tickers published.
+    template <typename Sink>
+    auto publish(Sink &&sink) noexcept -> size_t {
+        size_t published = 0;
+        for (auto dirty = mDirty; dirty; dirty &= dirty - 1) {
+            const auto ticker_id =
+                static_cast<TickerId>(std::countr_zero(dirty));
+            computeFeatures(ticker_id);
+            sink(ticker_id,
+                 static_cast<const SignalFeatures &>(mFeatures[ticker_id]));
+            ++published;
+        }
+        mDirty = 0;
+        return published;
+    }
+
+    /// \brief Returns the features of a ticker as last published.
+    auto features(TickerId ticker_id) const noexcept
+        -> const SignalFeatures & {
+        return mFeatures[ticker_id];
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    SignalEngine() = delete;
+    SignalEngine(const SignalEngine &) = delete;
+    SignalEngine(const SignalEngine &&) = delete;
+    SignalEngine &operator=(const SignalEngine &) = delete;
+    SignalEngine &operator=(const SignalEngine &&) = delete;
+
+   private:
+    static_assert(ME_MAX_TICKERS <= 64, "Dirty tickers are a 64 bit mask.");
+
+    /// \struct SideLevels
+    /// \brief Levels of one side from the best price, with running sums of
+    /// the quantity of the top imbalance_levels levels and of all levels.
+    struct alignas(64) SideLevels {
+        std::array<int64_t, MBP_MAX_DEPTH> price;
+        std::array<int64_t, MBP_MAX_DEPTH> qty;
+        size_t depth = 0;
+        int64_t top_qty = 0;
+        int64_t total_qty = 0;
+
+        /// \brief Inserts a level, the worst level falls off a full side.
+        auto insert(size_t index, Price level_price, Qty level_qty,
+                    size_t top) noexcept -> void {
+            // The level entering the top levels pushes the last one out.
+            if (index < top) {
+                top_qty += level_qty;
+                if (depth >= top) top_qty -= qty[top - 1];
+            }
+            total_qty += level_qty;
+            if (depth == MBP_MAX_DEPTH) total_qty -= qty[MBP_MAX_DEPTH - 1];
+
+            const auto moved = std::min(depth, MBP_MAX_DEPTH - 1) - index;
+            std::memmove(&price[index + 1], &price[index],
+                         moved * sizeof(int64_t));
+            std::memmove(&qty[index + 1], &qty[index],
+                         moved * sizeof(int64_t));
+            price[index] = level_price;
+            qty[index] = level_qty;
+            depth = std::min(depth + 1, MBP_MAX_DEPTH);
+        }
+
+        /// \brief Changes the quantity of a level.
+        auto change(size_t index, Qty level_qty, size_t top) noexcept -> void {
+            const auto delta = static_cast<int64_t>(level_qty) - qty[index];
+            if (index < top) top_qty += delta;
+            total_qty += delta;
+            qty[index] = level_qty;
+        }
+
+        /// \brief Removes a level.
+        auto erase(size_t index, size_t top) noexcept -> void {
+            // The level behind the top levels moves into them.
+            if (index < top) {
+                top_qty -= qty[index];
+                if (depth > top) top_qty += qty[top];
+            }
+            total_qty -= qty[index];
+
+            const auto moved = depth - index - 1;
+            std::memmove(&price[index], &price[index + 1],
+                         moved * sizeof(int64_t));
+            std::memmove(&qty[index], &qty[index + 1],
+                         moved * sizeof(int64_t));
+            --depth;
+        }
+
+        /// \brief Removes every level.
+        auto clear() noexcept -> void {
+            depth = 0;
+            top_qty = total_qty = 0;
+        }
+
+        /// \brief Returns the average price of sweeping size from the best
+        /// level, NaN if the side does not hold size. Sizes of interest are
+        /// filled within the first few levels, so this stops as soon as it
+        /// is filled.
+        auto fillPrice(int64_t size) const noexcept -> double {
+            if (size <= 0 || size > total_qty) return SIGNAL_UNDEFINED;
+            int64_t remaining = size;
+            int64_t notional = 0;
+            for (size_t index = 0;; ++index) {
+                if (qty[index] >= remaining) {
+                    notional += remaining * price[index];
+                    return static_cast<double>(notional) / size;
+                }
+                notional += qty[index] * price[index];
+                remaining -= qty[index];
+            }
+        }
+    };
+
+    /// \struct TickerState
+    /// \brief Levels of a ticker and its touch at the previous publish.
+    struct TickerState {
+        std::array<SideLevels, 2> sides;
+        Price previous_bid_price = Price_INVALID;
+        Price previous_ask_price = Price_INVALID;
+        int64_t previous_bid_qty = 0;
+        int64_t previous_ask_qty = 0;
+    };
+
+    /// \brief Maps a side to its index in the level arrays.
+    static auto sideSlot(Side side) noexcept -> size_t {
+        return side == Side::BUY ? 0 : 1;
+    }
+
+    /// \brief Recomputes the quote features of a ticker from its levels.
+    auto computeFeatures(TickerId ticker_id) noexcept -> void {
+        auto &ticker = mTickers[ticker_id];
+        auto &features = mFeatures[ticker_id];
+        const auto &bids = ticker.sides[0];
+        const auto &asks = ticker.sides[1];
+
+        const auto has_touch = bids.depth && asks.depth;
+        const auto bid_price = bids.depth ? bids.price[0] : Price_INVALID;
+        const auto ask_price = asks.depth ? asks.price[0] : Price_INVALID;
+        const auto bid_qty = bids.depth ? bids.qty[0] : 0;
+        const auto ask_qty = asks.depth ? asks.qty[0] : 0;
+
+        if (has_touch) {
+            features.mid = 0.5 * static_cast<double>(bid_price + ask_price);
+            features.spread = static_cast<double>(ask_price - bid_price);
+            features.microprice =
+                static_cast<double>(bid_price * ask_qty + ask_price * bid_qty) /
+                static_cast<double>(bid_qty + ask_qty);
+            features.ewma_spread =
+                std::isnan(features.ewma_spread)
+                    ? features.spread
+                    : features.ewma_spread +
+                          mConfig.ewma_alpha *
+                              (features.spread - features.ewma_spread);
+        } else {
+            features.mid = features.spread = features.microprice =
+                SIGNAL_UNDEFINED;
+        }
+
+        const auto bid_top = bids.top_qty;
+        const auto ask_top = asks.top_qty;
+        features.imbalance =
+            bid_top + ask_top
+                ? static_cast<double>(bid_top - ask_top) / (bid_top + ask_top)
+                : 0.0;
+        features.bid_depth = bids.total_qty;
+        features.ask_depth = asks.total_qty;
+        features.buy_fill_price = asks.fillPrice(mConfig.fill_size);
+        features.sell_fill_price = bids.fillPrice(mConfig.fill_size);
+
+        // Order flow imbalance of Cont, Kukanov and Stoikov: queue growth at
+        // an unchanged or better bid is buying pressure, at an unchanged or
+        // better ask selling pressure.
+        int64_t flow = 0;
+        if (has_touch && ticker.previous_bid_price != Price_INVALID &&
+            ticker.previous_ask_price != Price_INVALID) {
+            flow = (bid_price >= ticker.previous_bid_price ? bid_qty : 0) -
+                   (bid_price <= ticker.previous_bid_price
+                        ? ticker.previous_bid_qty
+                        : 0) -
+                   (ask_price <= ticker.previous_ask_price ? ask_qty : 0) +
+                   (ask_price >= ticker.previous_ask_price
+                        ? ticker.previous_ask_qty
+                        : 0);
+        }
+        features.order_flow_imbalance += flow;
+        features.ewma_order_flow_imbalance +=
+            mConfig.ewma_alpha *
+            (static_cast<double>(flow) - features.ewma_order_flow_imbalance);
+        ++features.publishes;
+
+        ticker.previous_bid_price = bid_price;
+        ticker.previous_ask_price = ask_price;
+        ticker.previous_bid_qty = bid_qty;
+        ticker.previous_ask_qty = ask_qty;
+    }
+
+    /// \brief Parameters of the signals.
+    const SignalConfig mConfig;
+    /// \brief Published features of every ticker.
+    std::array<SignalFeatures, ME_MAX_TICKERS> mFeatures;
+    /// \brief Levels of every ticker.
+    std::array<TickerState, ME_MAX_TICKERS> mTickers;
+    /// \brief One bit per ticker whose levels changed or which traded since
+    /// the last publish.
+    uint64_t mDirty = 0;
+};
@@ -0,0 +1,273 @@
+/// \file benchmark_strategy.cpp
+/// \brief Latency from a book update to the order request it triggers, with
+/// the statically dispatched StrategyRunner and with virtual callbacks.
+/// \details Replays synthetic order flow through a quoting strategy, which
+/// joins the touch whenever the best bid or offer changes, and a trade
+/// following strategy. Every update that makes a strategy send an order
+/// request is timed from before the book update to after the last request
+/// was written into the outbound queue. The same strategies then run behind
+/// virtual callbacks, the way the prototypes did, and must send the same
+/// requests.
+///
+/// Usage: StrategyBenchmark [--updates N] [--passes N] [harness options]
+
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowbooks.h"
+#include "strategy/strategyrunner.h"
+#include "utilities/latencyhistogram.h"
+#include "utilities/tscclock.h"
+
+/// \brief Joins the best bid and offer of every ticker with one lot,
+/// cancelling the previous quote of a side whenever its price moves.
+class QuoteStrategy final : public Strategy<QuoteStrategy> {
+   public:
+    auto onBestBidOfferUpdate(TickerId ticker_id, const BestBidOffer &bbo,
+                              const MarketOrderBook &,
+                              OrderEmitter &orders) noexcept -> void {
+        auto &quotes = mQuotes[ticker_id];
+        requote(ticker_id, Side::BUY, bbo.mBid_price, quotes[0], orders);
+        requote(ticker_id, Side::SELL, bbo.mAsk_price, quotes[1], orders);
+    }
+
+   private:
+    /// \struct Quote
+    /// \brief The live quote of one side.
+    struct Quote {
+        OrderId order_id = OrderId_INVALID;
+        Price price = Price_INVALID;
+    };
+
+    static auto requote(TickerId ticker_id, Side side, Price price,
+                        Quote &quote, OrderEmitter &orders) noexcept -> void {
+        if (price == quote.price) return;
+        if (quote.order_id != OrderId_INVALID) {
+            orders.sendCancel(ticker_id, quote.order_id, side);
+            quote.order_id = OrderId_INVALID;
+        }
+        if (price != Price_INVALID) {
+            quote.order_id = orders.sendNew(ticker_id, side, price, 100);
+        }
+        quote.price = price;
+    }
+
+    std::array<std::array<Quote, 2>, ME_MAX_TICKERS> mQuotes;
+};
+
+/// \brief Follows large trades with an order on the aggressor's side.
+class TradeFollowStrategy final : public Strategy<TradeFollowStrategy> {
+   public:
+    auto onTrade(const MEMarketUpdate &update, const MarketOrderBook &,
+                 OrderEmitter &orders) noexcept -> void {
+        if (update.qty < 500) return;
+        // The trade carries the side of the resting order.
+        const auto side = update.side == Side::SELL ? Side::BUY : Side::SELL;
+        orders.sendNew(update.ticker_id, side, update.price, 100);
+    }
+};
+
+/// \brief Strategy interface of the prototypes, with virtual callbacks.
+class VirtualStrategy {
+   public:
+    virtual ~VirtualStrategy() = default;
+    virtual auto onBeforeBookUpdate(const MEMarketUpdate &,
+                                    const MarketOrderBook &,
+                                    OrderEmitter &) noexcept -> void {}
+    virtual auto onBookUpdate(const MEMarketUpdate &, const MarketOrderBook &,
+                              OrderEmitter &) noexcept -> void {}
+    virtual auto onBestBidOfferUpdate(TickerId, const BestBidOffer &,
+                                      const MarketOrderBook &,
+                                      OrderEmitter &) noexcept -> void {}
+    virtual auto onTrade(const MEMarketUpdate &, const MarketOrderBook &,
+                         OrderEmitter &) noexcept -> void {}
+};
+
+/// \brief Runs a strategy behind the virtual interface.
+template <typename S>
+class VirtualAdapter : public VirtualStrategy {
+   public:
+    auto onBeforeBookUpdate(const MEMarketUpdate &update,
+                            const MarketOrderBook &book,
+                            OrderEmitter &orders) noexcept -> void override {
+        mStrategy.onBeforeBookUpdate(update, book, orders);
+    }
+    auto onBookUpdate(const MEMarketUpdate &update,
+                      const MarketOrderBook &book,
+                      OrderEmitter &orders) noexcept -> void override {
+        mStrategy.onBookUpdate(update, book, orders);
+    }
+    auto onBestBidOfferUpdate(TickerId ticker_id, const BestBidOffer &bbo,
+                              const MarketOrderBook &book,
+                              OrderEmitter &orders) noexcept
+        -> void override {
+        mStrategy.onBestBidOfferUpdate(ticker_id, bbo, book, orders);
+    }
+    auto onTrade(const MEMarketUpdate &update, const MarketOrderBook &book,
+                 OrderEmitter &orders) noexcept -> void override {
+        mStrategy.onTrade(update, book, orders);
+    }
+
+   private:
+    S mStrategy;
+};
+
+/// \brief The prototype runner, calling every strategy through its vtable.
+class VirtualRunner final {
+   public:
+    VirtualRunner(const MarketOrderBookHashMap &books, OrderEmitter &orders,
+                  std::vector<VirtualStrategy *> strategies)
+        : mBooks(books), mOrders(orders), mStrategies(std::move(strategies)) {}
+
+    auto onMarketUpdate(const MEMarketUpdate &update) noexcept -> void {
+        auto book = mBooks[update.ticker_id];
+        for (auto strategy : mStrategies) {
+            strategy->onBeforeBookUpdate(update, *book, mOrders);
+        }
+        const auto before = *book->getBestBidOffer();
+        book->onMarketUpdate(&update);
+        const auto bbo_changed = before != *book->getBestBidOffer();
+        for (auto strategy : mStrategies) {
+            if (update.type == MarketUpdateType::TRADE) {
+                strategy->onTrade(update, *book, mOrders);
+            } else {
+                strategy->onBookUpdate(update, *book, mOrders);
+                if (bbo_changed) {
+                    strategy->onBestBidOfferUpdate(update.ticker_id,
+                                                   *book->getBestBidOffer(),
+                                                   *book, mOrders);
+                }
+            }
+        }
+    }
+
+   private:
+    const MarketOrderBookHashMap mBooks;
+    OrderEmitter &mOrders;
+    std::vector<VirtualStrategy *> mStrategies;
+};
+
+/// \struct RunResult
+/// \brief Latency and output of the passes of one runner.
+struct RunResult {
+    /// Ticks from the book update to the last request, per update that
+    /// sent requests.
+    LatencyHistogram latency;
+    /// Ticks of all updates, per pass.
+    uint64_t total_ticks = 0;
+    /// Number of updates processed.
+    uint64_t updates = 0;
+    /// Number of requests sent.
+    uint64_t requests = 0;
+    /// Hash of the requests of the first pass, to compare the runners.
+    uint64_t checksum = 0;
+};
+
+/// \brief Replays the flow through a runner, timing every update.
+template <typename Runner>
+auto replay(Runner &runner, OrderEmitter &orders, ClientRequestLFQueue &queue,
+            const std::vector<MEMarketUpdate> &flow, OrderFlowBooks &books,
+            size_t passes, RunResult &result) -> void {
+    for (size_t pass = 0; pass < passes; ++pass) {
+        for (const auto &update : flow) {
+            const auto sent = orders.requestsSent();
+            const auto start = TscClock::now();
+            runner.onMarketUpdate(update);
+            const auto end = TscClock::now();
+            result.total_ticks += end - start;
+            if (orders.requestsSent() != sent) {
+                result.latency.record(end - start);
+            }
+
+            // The order gateway, untimed.
+            while (const auto request = queue.getNextRead()) {
+                if (!pass) {
+                    result.checksum = result.checksum * 31 +
+                                      request->order_id * 7 +
+                                      static_cast<uint64_t>(request->price) +
+                                      static_cast<uint64_t>(request->type);
+                }
+                queue.updateReadIndex();
+            }
+        }
+        result.updates += flow.size();
+        // Starts the next pass from empty books, untimed.
+        books.clear();
+    }
+    result.requests = orders.requestsSent();
+    if (orders.requestsRejected()) [[unlikely]] {
+        FATAL("The outbound queue filled up.");
+    }
+}
+
+/// \brief Writes one row of the results.
+auto printRow(const std::string &name, const RunResult &result) -> void {
+    const auto &latency = result.latency;
+    std::cout << std::left << std::setw(20) << name << std::right
+              << std::fixed << std::setprecision(2) << std::setw(12)
+              << TscClock::ticksToNanos(result.total_ticks) / result.updates
+              << std::setw(12) << latency.count() << std::setw(10)
+              << TscClock::toNanos(latency.percentile(50.0)) << std::setw(10)
+              << TscClock::toNanos(latency.percentile(99.0)) << std::setw(10)
+              << TscClock::toNanos(latency.percentile(99.9)) << std::setw(12)
+              << TscClock::toNanos(latency.max()) << std::endl;
+}
+
+/// \brief Main function running the strategy benchmark.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    size_t updates = 1'000'000;
+    size_t passes = 5;
+    setUpBenchmarkThread(parseBenchmarkOptions(
+        argc, argv, {{"--updates", updates}, {"--passes", passes, 1}}));
+
+    OrderFlowConfig config;
+    OrderFlowGenerator generator(config);
+    const auto flow = generateOrderFlow(generator, updates);
+    OrderFlowBooks books(config.num_tickers);
+    ClientRequestLFQueue queue(ME_MAX_CLIENT_UPDATES);
+
+    // Faults in the pools of the books before either runner is timed.
+    for (const auto &update : flow) books.onMarketUpdate(&update);
+    books.clear();
+
+    RunResult crtp;
+    {
+        OrderEmitter orders(1, &queue);
+        QuoteStrategy quotes;
+        TradeFollowStrategy follower;
+        StrategyRunner runner(books.books(), orders, quotes, follower);
+        replay(runner, orders, queue, flow, books, passes, crtp);
+    }
+
+    RunResult virtuals;
+    {
+        OrderEmitter orders(1, &queue);
+        VirtualAdapter<QuoteStrategy> quotes;
+        VirtualAdapter<TradeFollowStrategy> follower;
+        VirtualRunner runner(books.books(), orders, {&quotes, &follower});
+        replay(runner, orders, queue, flow, books, passes, virtuals);
+    }
+
+    if (crtp.checksum != virtuals.checksum ||
+        crtp.requests != virtuals.requests) [[unlikely]] {
+        FATAL("The runners sent different order requests.");
+    }
+
+    std::cout << "replayed " << flow.size() << " updates " << passes
+              << " times, " << crtp.requests << " order requests"
+              << std::endl;
+    std::cout << std::left << std::setw(20) << "runner" << std::right
+              << std::setw(12) << "ns/update" << std::setw(12) << "emitting"
+              << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns"
+              << std::setw(10) << "p99.9 ns" << std::setw(12) << "max ns"
+              << std::endl;
+    printRow("crtp", crtp);
+    printRow("virtual", virtuals);
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+
+#include "market-orders/clientrequest.h"
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+/// \brief Writes the order requests of the strategies of one thread into
+/// the outbound queue of the order gateway.
+///
+/// Order ids are assigned from a sequence of the client, so a strategy knows
+/// the id of its order as soon as it sends it. The emitter never blocks the
+/// strategy thread: a request that finds the queue full is rejected and
+/// counted, and the strategy sees OrderId_INVALID or false.
+class OrderEmitter final {
+   public:
+    /// \brief Constructs an OrderEmitter writing into a queue.
+    /// \param client_id The client the requests are sent for.
+    /// \param queue The outbound queue, the emitter must be its only writer.
+    /// \param first_order_id Id of the first order sent.
+    OrderEmitter(ClientId client_id, ClientRequestLFQueue *queue,
+                 OrderId first_order_id = 0)
+        : mClient_id(client_id),
+          mQueue(queue),
+          mNext_order_id(first_order_id) {}
+
+    /// \brief Sends a new limit order.
+    /// \param ticker_id Ticker of the order.
+    /// \param side Side of the order.
+    /// \param price Limit price of the order.
+    /// \param qty Quantity of the order.
+    /// \return Id of the order, OrderId_INVALID if the queue was full.
+    auto sendNew(TickerId ticker_id, Side side, Price price, Qty qty) noexcept
+        -> OrderId {
+        if (!send(ClientRequestType::NEW, ticker_id, mNext_order_id, side,
+                  price, qty)) [[unlikely]] {
+            return OrderId_INVALID;
+        }
+        return mNext_order_id++;
+    }
+
+    /// \brief Sends the cancel of an order sent earlier.
+    /// \param ticker_id Ticker of the order.
+    /// \param order_id Id returned by sendNew().
+    /// \param side Side of the order.
+    /// \return false if the queue was full.
+    auto sendCancel(TickerId ticker_id, OrderId order_id, Side side) noexcept
+        -> bool {
+        return send(ClientRequestType::CANCEL, ticker_id, order_id, side,
+                    Price_INVALID, Qty_INVALID);
+    }
+
+    /// \brief Returns the id the next new order will be sent with.
+    auto nextOrderId() const noexcept { return mNext_order_id; }
+
+    /// \brief Returns the client the requests are sent for.
+    auto clientId() const noexcept { return mClient_id; }
+
+    /// \brief Returns the number of requests written into the queue.
+    auto requestsSent() const noexcept { return mRequests_sent; }
+
+    /// \brief Returns the number of requests rejected on a full queue.
+    auto requestsRejected() const noexcept { return mRequests_rejected; }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    OrderEmitter() = delete;
+    OrderEmitter(const OrderEmitter &) = delete;
+    OrderEmitter(const OrderEmitter &&) = delete;
+    OrderEmitter &operator=(const OrderEmitter &) = delete;
+    OrderEmitter &operator=(const OrderEmitter &&) = delete;
+
+   private:
+    /// \brief Writes a request into the queue unless it is full.
+    auto send(ClientRequestType type, TickerId ticker_id, OrderId order_id,
+              Side side, Price price, Qty qty) noexcept -> bool {
+        if (mQueue->size() == mQueue->capacity()) [[unlikely]] {
+            ++mRequests_rejected;
+            return false;
+        }
+        auto request = mQueue->getNextWrite();
+        request->type = type;
+        request->client_id = mClient_id;
+        request->ticker_id = ticker_id;
+        request->order_id = order_id;
+        request->side = side;
+        request->price = price;
+        request->qty = qty;
+        mQueue->updateWriteIndex();
+        ++mRequests_sent;
+        return true;
+    }
+
+    /// \brief The client the requests are sent for.
+    const ClientId mClient_id;
+    /// \brief The outbound queue.
+    ClientRequestLFQueue *mQueue;
+    /// \brief Id of the next new order.
+    OrderId mNext_order_id;
+
+    /// \brief Number of requests written into the queue.
+    uint64_t mRequests_sent = 0;
+    /// \brief Number of requests rejected on a full queue.
+    uint64_t mRequests_rejected = 0;
+};
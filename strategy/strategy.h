@@ -0,0 +1,100 @@
+#pragma once
+
+#include "market-orders/marketupdate.h"
+#include "order-book/orderbook.h"
+#include "strategy/orderemitter.h"
+#include "utilities/types.h"
+
+/// \brief Base of the strategies run by a StrategyRunner, using the curiously
+/// recurring template pattern instead of virtual callbacks.
+///
+/// A strategy derives from Strategy<itself> and declares only the hooks it
+/// needs, hiding the empty defaults below. Every call is resolved at compile
+/// time, so the hooks inline into the runner's update loop and a hook a
+/// strategy does not declare costs nothing.
+///
+/// Hooks, each also given the book of the update's ticker and the
+/// OrderEmitter for sending order requests:
+/// - onBeforeBookUpdate(update, book, orders): any update, before it is
+///   applied, while the book still holds the orders it changes. An
+///   OrderManager tracking queue positions is updated here.
+///
+/// and, after the update was applied:
+/// - onBookUpdate(update, book, orders): an ADD, MODIFY, CANCEL or CLEAR was
+///   applied to the book.
+/// - onBestBidOfferUpdate(ticker_id, bbo, book, orders): the update changed
+///   the price or quantity of the best bid or offer.
+/// - onTrade(update, book, orders): a trade, the book does not change.
+/// \tparam Derived The strategy deriving from this class.
+template <typename Derived>
+class Strategy {
+   public:
+    /// \brief Passes an update, not yet applied to its book, to the hook of
+    /// the strategy.
+    /// \param update The market update.
+    /// \param book The book of the update's ticker.
+    /// \param orders The emitter for order requests.
+    auto dispatchBefore(const MEMarketUpdate &update,
+                        const MarketOrderBook &book,
+                        OrderEmitter &orders) noexcept -> void {
+        derived().onBeforeBookUpdate(update, book, orders);
+    }
+
+    /// \brief Dispatches an update, already applied to its book, to the
+    /// hooks of the strategy.
+    /// \param update The market update.
+    /// \param book The book of the update's ticker.
+    /// \param bbo_changed Whether the update changed the best bid or offer.
+    /// \param orders The emitter for order requests.
+    auto dispatch(const MEMarketUpdate &update, const MarketOrderBook &book,
+                  bool bbo_changed, OrderEmitter &orders) noexcept -> void {
+        switch (update.type) {
+            case MarketUpdateType::ADD:
+            case MarketUpdateType::MODIFY:
+            case MarketUpdateType::CANCEL:
+            case MarketUpdateType::CLEAR:
+                derived().onBookUpdate(update, book, orders);
+                if (bbo_changed) {
+                    derived().onBestBidOfferUpdate(update.ticker_id,
+                                                   *book.getBestBidOffer(),
+                                                   book, orders);
+                }
+                break;
+            case MarketUpdateType::TRADE:
+                derived().onTrade(update, book, orders);
+                break;
+            case MarketUpdateType::INVALID:
+            case MarketUpdateType::SNAPSHOT_START:
+            case MarketUpdateType::SNAPSHOT_END:
+                // These update types are not passed to strategies
+                break;
+        }
+    }
+
+    /// \brief Default hook for an update about to be applied, does nothing.
+    auto onBeforeBookUpdate(const MEMarketUpdate &, const MarketOrderBook &,
+                            OrderEmitter &) noexcept -> void {}
+
+    /// \brief Default hook for a book change, does nothing.
+    auto onBookUpdate(const MEMarketUpdate &, const MarketOrderBook &,
+                      OrderEmitter &) noexcept -> void {}
+
+    /// \brief Default hook for a best bid or offer change, does nothing.
+    auto onBestBidOfferUpdate(TickerId, const BestBidOffer &,
+                              const MarketOrderBook &, OrderEmitter &) noexcept
+        -> void {}
+
+    /// \brief Default hook for a trade, does nothing.
+    auto onTrade(const MEMarketUpdate &, const MarketOrderBook &,
+                 OrderEmitter &) noexcept -> void {}
+
+   protected:
+    /// \brief Only derived strategies construct the base.
+    Strategy() = default;
+
+   private:
+    /// \brief Returns the strategy deriving from this class.
+    auto derived() noexcept -> Derived & {
+        return static_cast<Derived &>(*this);
+    }
+};
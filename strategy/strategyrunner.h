@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include "market-orders/marketupdate.h"
+#include "order-book/orderbook.h"
+#include "strategy/orderemitter.h"
+#include "strategy/strategy.h"
+#include "thread-runtime/pipelinestage.h"
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+/// \brief Runs any number of strategies on one thread, applying every market
+/// update to its book and passing it to each strategy in turn.
+///
+/// The set of strategies is fixed at compile time: the runner holds them in
+/// a tuple and dispatches to each with a fold expression, so the whole path
+/// from the book update to the order request written into the outbound queue
+/// is one inlined function without indirect calls. Every strategy sees the
+/// update once before the book applies it and once after. The best bid and
+/// offer is compared before and after the update, so the strategies are told
+/// whether it changed without each one keeping its own copy.
+///
+/// Usage, with the strategy types deduced from the arguments:
+/// StrategyRunner runner(books, orders, market_maker, taker);
+/// PipelineStage stage(config, [&]() { return runner.poll(queue); });
+/// \tparam Strategies The strategies, each deriving from Strategy<itself>.
+template <typename... Strategies>
+class StrategyRunner final {
+    static_assert(sizeof...(Strategies) > 0, "A runner needs a strategy.");
+    static_assert((std::is_base_of_v<Strategy<Strategies>, Strategies> && ...),
+                  "Strategies must derive from Strategy<Derived>.");
+
+   public:
+    /// \brief Constructs a StrategyRunner.
+    /// \param books The books of the tickers, indexed by TickerId, owned by
+    /// the caller and updated only by this runner.
+    /// \param orders The emitter the strategies send order requests with.
+    /// \param strategies The strategies, in the order they see each update.
+    StrategyRunner(const MarketOrderBookHashMap &books, OrderEmitter &orders,
+                   Strategies &...strategies)
+        : mBooks(books), mOrders(orders), mStrategies(strategies...) {}
+
+    /// \brief Passes a market update to every strategy, applies it to its
+    /// book and passes it to every strategy again.
+    /// \param update The market update.
+    auto onMarketUpdate(const MEMarketUpdate &update) noexcept -> void {
+        auto book = mBooks[update.ticker_id];
+        if (!book) [[unlikely]] {
+            FATAL("No book for ticker " + tickerIdToString(update.ticker_id) +
+                  " in " + update.toString());
+        }
+        std::apply(
+            [&](auto &...strategies) {
+                (strategies.dispatchBefore(update, *book, mOrders), ...);
+            },
+            mStrategies);
+
+        const auto before = *book->getBestBidOffer();
+        book->onMarketUpdate(&update);
+        const auto bbo_changed = before != *book->getBestBidOffer();
+        ++mUpdates;
+
+        std::apply(
+            [&](auto &...strategies) {
+                (strategies.dispatch(update, *book, bbo_changed, mOrders), ...);
+            },
+            mStrategies);
+    }
+
+    /// \brief Consumes up to max_batch updates of a queue, the work function
+    /// of a PipelineStage.
+    /// \param queue The market update queue, the runner must be its only
+    /// reader.
+    /// \param max_batch Maximum number of updates consumed.
+    /// \return Number of updates consumed.
+    auto poll(MEMarketUpdateLFQueue &queue,
+              size_t max_batch = PIPELINE_STAGE_BATCH_SIZE) noexcept
+        -> size_t {
+        return pollQueue(
+            queue,
+            [this](const MEMarketUpdate &update) { onMarketUpdate(update); },
+            max_batch);
+    }
+
+    /// \brief Returns the number of market updates processed.
+    auto updates() const noexcept { return mUpdates; }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    StrategyRunner() = delete;
+    StrategyRunner(const StrategyRunner &) = delete;
+    StrategyRunner(const StrategyRunner &&) = delete;
+    StrategyRunner &operator=(const StrategyRunner &) = delete;
+    StrategyRunner &operator=(const StrategyRunner &&) = delete;
+
+   private:
+    /// \brief The books of the tickers, indexed by TickerId.
+    const MarketOrderBookHashMap mBooks;
+    /// \brief The emitter for order requests.
+    OrderEmitter &mOrders;
+    /// \brief The strategies, in the order they see each update.
+    std::tuple<Strategies &...> mStrategies;
+
+    /// \brief Number of market updates processed.
+    uint64_t mUpdates = 0;
+};
@@ -0,0 +1,94 @@
+/// \file example_threadruntime.cpp
+/// \brief Runs a feed handler and a book builder as pinned pipeline stages.
+/// \details The feed stage writes synthetic updates into a LockFreeQueue, the
+/// book stage polls it and applies the updates to the books. The main thread
+/// monitors both stages, then shuts them down cooperatively.
+///
+/// Options: --feed-cpu N --book-cpu N --fifo N --spin and the options
+/// of the benchmark harness.
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "lock-free-queue/lockfreequeue.h"
+#include "micro-benchmark/microbenchmark.h"
+#include "order-flow/orderflowbooks.h"
+#include "thread-runtime/pipelinestage.h"
+
+/// \brief Number of updates sent through the pipeline.
+constexpr size_t NUM_UPDATES = 1'000'000;
+
+/// \brief Main function running the pipeline stages.
+/// \return Exit status code (0 for success)
+int main(int argc, char **argv) {
+    PipelineStageConfig feed_config;
+    feed_config.name = "feed";
+    PipelineStageConfig book_config;
+    book_config.name = "book";
+
+    // Busy polling only pays off with a core per stage, otherwise the stages
+    // have to hand the core over when they run out of work.
+    const auto idle_policy = std::thread::hardware_concurrency() > 2
+                                 ? IdlePolicy::PAUSE
+                                 : IdlePolicy::YIELD;
+    feed_config.idle_policy = book_config.idle_policy = idle_policy;
+
+    int fifo_priority = 0;
+    bool spin = false;
+    setUpBenchmarkThread(
+        parseBenchmarkOptions(argc, argv,
+                              {{"--feed-cpu", feed_config.cpu},
+                               {"--book-cpu", book_config.cpu},
+                               {"--fifo", fifo_priority},
+                               {"--spin", spin}}));
+    feed_config.fifo_priority = book_config.fifo_priority = fifo_priority;
+    if (spin) {
+        feed_config.idle_policy = book_config.idle_policy = IdlePolicy::SPIN;
+    }
+
+    OrderFlowConfig config;
+    OrderFlowGenerator generator(config);
+
+    OrderFlowBooks books(config.num_tickers);
+
+    LockFreeQueue<MEMarketUpdate> queue(1024);
+    size_t sent = 0;
+
+    PipelineStage feed(feed_config, [&]() -> size_t {
+        size_t written = 0;
+        while (sent < NUM_UPDATES && written < PIPELINE_STAGE_BATCH_SIZE &&
+               queue.size() < queue.capacity()) {
+            *queue.getNextWrite() = generator.next()->update;
+            queue.updateWriteIndex();
+            ++sent;
+            ++written;
+        }
+        return written;
+    });
+
+    PipelineStage book(book_config, [&]() {
+        return pollQueue(queue, [&](const MEMarketUpdate &update) {
+            books.onMarketUpdate(&update);
+        });
+    });
+
+    book.start();
+    feed.start();
+
+    // The monitor only reads the stage counters, the stages never pause.
+    while (book.workDone() < NUM_UPDATES) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        feed.dump(std::cout);
+        book.dump(std::cout);
+        std::cout << std::endl;
+    }
+
+    feed.stop();
+    book.stop();
+    std::cout << "final" << std::endl;
+    feed.dump(std::cout);
+    book.dump(std::cout);
+
+    return 0;
+}
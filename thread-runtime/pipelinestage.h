@@ -0,0 +1,326 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+#endif
+
+#include "lock-free-queue/lockfreequeue.h"
+#include "utilities/latencyhistogram.h"
+#include "utilities/macros.h"
+#include "utilities/threadplacement.h"
+#include "utilities/tscclock.h"
+
+/// \enum IdlePolicy
+/// \brief What a stage does after an iteration that found no work.
+enum class IdlePolicy : uint8_t {
+    /// Polls again immediately, lowest latency, the core is never released.
+    SPIN = 0,
+    /// Issues a pause instruction first, saving power and yielding the
+    /// pipeline to a hyper-threaded sibling.
+    PAUSE = 1,
+    /// Yields the core to the scheduler, for cores shared with other stages.
+    YIELD = 2
+};
+
+/// \brief Converts an IdlePolicy enum to a string.
+/// \param policy The IdlePolicy to convert.
+/// \return String representation of the IdlePolicy.
+inline auto idlePolicyToString(IdlePolicy policy) -> std::string {
+    switch (policy) {
+        case IdlePolicy::SPIN:
+            return "SPIN";
+        case IdlePolicy::PAUSE:
+            return "PAUSE";
+        case IdlePolicy::YIELD:
+            return "YIELD";
+    }
+    return "UNKNOWN";
+}
+
+/// \brief Default maximum number of elements consumed from one queue per
+/// iteration, so that a busy queue cannot starve the other inputs.
+constexpr size_t PIPELINE_STAGE_BATCH_SIZE = 64;
+
+/// \struct PipelineStageConfig
+/// \brief Placement and scheduling of a pipeline stage thread.
+struct PipelineStageConfig {
+    /// Thread name, shown by top and perf.
+    std::string name = "stage";
+    /// CPU the stage is pinned to, ideally an isolated core, -1 for none.
+    int cpu = -1;
+    /// SCHED_FIFO priority from 1 to 99, 0 keeps the default policy.
+    int fifo_priority = 0;
+    /// Bytes of stack faulted in before the run loop starts.
+    size_t prefault_stack_size = THREAD_PREFAULT_STACK_SIZE;
+    /// What to do after an iteration that found no work.
+    IdlePolicy idle_policy = IdlePolicy::PAUSE;
+    /// Whether the inputs are drained after stop() before the thread exits.
+    bool drain_on_stop = true;
+};
+
+/// \brief Consumes up to max_batch elements of a queue.
+///
+/// The building block of a stage's work function, which polls each of its
+/// input queues in turn and returns the total work done.
+/// \param queue The input queue, the stage must be its only reader.
+/// \param handler Called with a const reference to every element.
+/// \param max_batch Maximum number of elements consumed.
+/// \return Number of elements consumed.
+template <typename T, typename Handler>
+inline auto pollQueue(LockFreeQueue<T> &queue, Handler &&handler,
+                      size_t max_batch = PIPELINE_STAGE_BATCH_SIZE) noexcept
+    -> size_t {
+    size_t consumed = 0;
+    for (; consumed < max_batch; ++consumed) {
+        const auto next = queue.getNextRead();
+        if (!next) break;
+        handler(*next);
+        queue.updateReadIndex();
+    }
+    return consumed;
+}
+
+/// \brief A pipeline stage, such as a feed handler, book builder or
+/// strategy, running a busy-poll loop on its own thread.
+///
+/// On start() the thread names itself, pins itself to its core, optionally
+/// switches to SCHED_FIFO and prefaults its stack, so that the first messages
+/// do not pay for migrations or page faults. It then calls the work function
+/// in a loop until stopped. The work function polls the stage's inputs,
+/// usually with pollQueue(), and returns the number of items processed,
+/// 0 when it found nothing to do.
+///
+/// Every iteration is timed with a time stamp counter read and accounted as
+/// busy or idle. The idle policy runs between the timed iterations, so an
+/// idle iteration does a fixed, small amount of work and the spread of idle
+/// iteration times is the jitter the stage sees from interrupts, preemption
+/// and SMT siblings. Counters and histograms have the stage thread as single
+/// writer and can be read by a monitoring thread while the stage runs.
+///
+/// Shutdown is cooperative: stop() asks the loop to exit, optionally lets it
+/// drain its inputs, and joins the thread.
+/// \tparam Work Callable taking no arguments and returning the work done.
+template <typename Work>
+class PipelineStage final {
+   public:
+    /// \brief Constructs a stopped stage.
+    /// \param config Placement and scheduling of the stage thread.
+    /// \param work The work function called by every loop iteration.
+    PipelineStage(PipelineStageConfig config, Work work)
+        : mConfig(std::move(config)), mWork(std::move(work)) {}
+
+    /// \brief Stops the stage if it is still running.
+    ~PipelineStage() { stop(); }
+
+    /// \brief Starts the stage thread and waits until it has been placed.
+    auto start() -> void {
+        ASSERT(!mThread.joinable(),
+               "Pipeline stage " + mConfig.name + " is already started");
+        mRunning = true;
+        mPlaced = false;
+        mThread = std::thread([this]() { run(); });
+        while (!mPlaced.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    /// \brief Asks the run loop to exit after its current iteration. Safe
+    /// to call from any thread, including the stage itself.
+    auto requestStop() noexcept -> void {
+        mRunning.store(false, std::memory_order_relaxed);
+    }
+
+    /// \brief Asks the run loop to exit and waits for the thread to finish.
+    auto stop() -> void {
+        requestStop();
+        if (mThread.joinable()) mThread.join();
+    }
+
+    /// \brief Returns the configuration of the stage.
+    auto config() const noexcept -> const PipelineStageConfig & {
+        return mConfig;
+    }
+
+    /// \brief Returns true if the thread was pinned as configured.
+    auto isPinned() const noexcept { return mPinned; }
+
+    /// \brief Returns true if the thread runs with the configured SCHED_FIFO
+    /// priority.
+    auto isFifo() const noexcept { return mFifo; }
+
+    /// \brief Returns the number of loop iterations.
+    auto iterations() const noexcept -> uint64_t {
+        return mBusy_iterations.load(std::memory_order_relaxed) +
+               mIdle_iterations.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the number of iterations that found work.
+    auto busyIterations() const noexcept -> uint64_t {
+        return mBusy_iterations.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the total work done, as returned by the work function.
+    auto workDone() const noexcept -> uint64_t {
+        return mWork_done.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the ticks spent in iterations that found work.
+    auto busyTicks() const noexcept -> uint64_t {
+        return mBusy_ticks.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the ticks spent in iterations that found no work.
+    auto idleTicks() const noexcept -> uint64_t {
+        return mIdle_ticks.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the fraction of the time spent in busy iterations.
+    auto utilisation() const noexcept -> double {
+        const auto busy = busyTicks();
+        const auto total = busy + idleTicks();
+        return total ? static_cast<double>(busy) / total : 0.0;
+    }
+
+    /// \brief Returns the histogram of busy iteration times, in ticks.
+    auto busyTime() const noexcept -> const LatencyHistogram & {
+        return mBusy_time;
+    }
+
+    /// \brief Returns the histogram of idle iteration times, in ticks. Its
+    /// tail is the scheduling jitter of the stage.
+    auto jitter() const noexcept -> const LatencyHistogram & {
+        return mJitter;
+    }
+
+    /// \brief Writes the placement and loop statistics of the stage. Safe to
+    /// call from any thread while the stage runs.
+    /// \param os The stream to write to.
+    auto dump(std::ostream &os) const -> void {
+        os << mConfig.name << " cpu:" << mConfig.cpu
+           << (mPinned ? "" : " (not pinned)")
+           << " fifo:" << mConfig.fifo_priority
+           << (mFifo ? "" : " (not set)")
+           << " idle:" << idlePolicyToString(mConfig.idle_policy)
+           << " iterations:" << iterations() << " work:" << workDone()
+           << " busy:" << std::fixed << std::setprecision(1)
+           << utilisation() * 100.0 << "%\n";
+        dumpRow(os, "  busy iteration", mBusy_time);
+        dumpRow(os, "  idle iteration", mJitter);
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    PipelineStage() = delete;
+    PipelineStage(const PipelineStage &) = delete;
+    PipelineStage(const PipelineStage &&) = delete;
+    PipelineStage &operator=(const PipelineStage &) = delete;
+    PipelineStage &operator=(const PipelineStage &&) = delete;
+
+   private:
+    /// \brief Body of the stage thread.
+    auto run() noexcept -> void {
+        setThreadName(mConfig.name);
+        mPinned = pinThread(mConfig.cpu);
+        mFifo = setFifoPriority(mConfig.fifo_priority);
+        if (mConfig.prefault_stack_size) {
+            prefaultStack(mConfig.prefault_stack_size);
+        }
+        mPlaced.store(true, std::memory_order_release);
+
+        auto previous = TscClock::now();
+        while (mRunning.load(std::memory_order_relaxed)) [[likely]] {
+            const auto work = static_cast<uint64_t>(mWork());
+            const auto now = TscClock::now();
+            const auto elapsed = now - previous;
+            previous = now;
+
+            if (work) {
+                increment(mBusy_iterations, 1);
+                increment(mBusy_ticks, elapsed);
+                increment(mWork_done, work);
+                mBusy_time.record(elapsed);
+            } else {
+                increment(mIdle_iterations, 1);
+                increment(mIdle_ticks, elapsed);
+                mJitter.record(elapsed);
+                idle();
+                // The idle policy is not part of the next iteration, whose
+                // time would otherwise include a pause or a yield.
+                previous = TscClock::now();
+            }
+        }
+
+        if (mConfig.drain_on_stop) {
+            while (const auto work = static_cast<uint64_t>(mWork())) {
+                increment(mWork_done, work);
+            }
+        }
+    }
+
+    /// \brief Applies the idle policy after an iteration without work.
+    auto idle() const noexcept -> void {
+        switch (mConfig.idle_policy) {
+            case IdlePolicy::SPIN:
+                break;
+            case IdlePolicy::PAUSE:
+#if defined(__x86_64__) || defined(__i386__)
+                _mm_pause();
+#endif
+                break;
+            case IdlePolicy::YIELD:
+                std::this_thread::yield();
+                break;
+        }
+    }
+
+    /// \brief Increments a counter that has a single writer.
+    static auto increment(std::atomic<uint64_t> &counter,
+                          uint64_t value) noexcept -> void {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+    }
+
+    /// \brief Writes one histogram row of the dump.
+    static auto dumpRow(std::ostream &os, const std::string &name,
+                        const LatencyHistogram &histogram) -> void {
+        os << std::left << std::setw(18) << name << std::right
+           << " count:" << histogram.count()
+           << " p50:" << TscClock::toNanos(histogram.percentile(50.0))
+           << "ns p99:" << TscClock::toNanos(histogram.percentile(99.0))
+           << "ns p99.9:" << TscClock::toNanos(histogram.percentile(99.9))
+           << "ns max:" << TscClock::toNanos(histogram.max()) << "ns\n";
+    }
+
+    /// \brief Placement and scheduling of the stage thread.
+    const PipelineStageConfig mConfig;
+    /// \brief The work function called by every loop iteration.
+    Work mWork;
+    /// \brief The stage thread.
+    std::thread mThread;
+
+    /// \brief Cleared to make the run loop exit.
+    alignas(64) std::atomic<bool> mRunning = {false};
+    /// \brief Set once the thread is placed, before the run loop starts.
+    std::atomic<bool> mPlaced = {false};
+    /// \brief Outcome of the placement, written before mPlaced is set.
+    bool mPinned = false;
+    bool mFifo = false;
+
+    /// \brief Loop accounting, written by the stage thread only.
+    alignas(64) std::atomic<uint64_t> mBusy_iterations = {0};
+    std::atomic<uint64_t> mIdle_iterations = {0};
+    std::atomic<uint64_t> mBusy_ticks = {0};
+    std::atomic<uint64_t> mIdle_ticks = {0};
+    std::atomic<uint64_t> mWork_done = {0};
+    /// \brief Duration of the iterations that found work.
+    LatencyHistogram mBusy_time;
+    /// \brief Duration of the iterations that found no work.
+    LatencyHistogram mJitter;
+};
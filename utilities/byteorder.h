@@ -0,0 +1,82 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/// \brief Reverses the byte order of an integral value.
+/// \tparam T Integral type of 1, 2, 4 or 8 bytes.
+/// \param value The value to byte swap.
+/// \return The value with its bytes in reverse order.
+template <typename T>
+inline constexpr auto byteSwap(T value) noexcept -> T {
+    static_assert(std::is_integral_v<T>, "byteSwap requires an integral type.");
+
+    if constexpr (sizeof(T) == 1) {
+        return value;
+    } else if constexpr (sizeof(T) == 2) {
+        return static_cast<T>(__builtin_bswap16(static_cast<uint16_t>(value)));
+    } else if constexpr (sizeof(T) == 4) {
+        return static_cast<T>(__builtin_bswap32(static_cast<uint32_t>(value)));
+    } else {
+        static_assert(sizeof(T) == 8, "Unsupported integral size.");
+        return static_cast<T>(__builtin_bswap64(static_cast<uint64_t>(value)));
+    }
+}
+
+/// \brief Reads a little-endian integral value from a possibly unaligned
+/// address.
+/// \tparam T Integral type to read.
+/// \param src Address of the first byte of the value.
+/// \return The value in host byte order.
+template <typename T>
+inline auto loadLittleEndian(const void *src) noexcept -> T {
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    if constexpr (std::endian::native == std::endian::big) {
+        value = byteSwap(value);
+    }
+    return value;
+}
+
+/// \brief Writes an integral value in little-endian order to a possibly
+/// unaligned address.
+/// \tparam T Integral type to write.
+/// \param dst Address of the first byte to write.
+/// \param value The value in host byte order.
+template <typename T>
+inline auto storeLittleEndian(void *dst, T value) noexcept -> void {
+    if constexpr (std::endian::native == std::endian::big) {
+        value = byteSwap(value);
+    }
+    std::memcpy(dst, &value, sizeof(T));
+}
+
+/// \brief Reads a big-endian (network order) integral value from a possibly
+/// unaligned address.
+/// \tparam T Integral type to read.
+/// \param src Address of the first byte of the value.
+/// \return The value in host byte order.
+template <typename T>
+inline auto loadBigEndian(const void *src) noexcept -> T {
+    T value;
+    std::memcpy(&value, src, sizeof(T));
+    if constexpr (std::endian::native == std::endian::little) {
+        value = byteSwap(value);
+    }
+    return value;
+}
+
+/// \brief Writes an integral value in big-endian (network) order to a possibly
+/// unaligned address.
+/// \tparam T Integral type to write.
+/// \param dst Address of the first byte to write.
+/// \param value The value in host byte order.
+template <typename T>
+inline auto storeBigEndian(void *dst, T value) noexcept -> void {
+    if constexpr (std::endian::native == std::endian::little) {
+        value = byteSwap(value);
+    }
+    std::memcpy(dst, &value, sizeof(T));
+}
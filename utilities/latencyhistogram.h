@@ -0,0 +1,193 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+/// \brief Fixed size, log-linear histogram of latency samples in the style of
+/// HdrHistogram.
+///
+/// Values below 2^SUB_BUCKET_BITS are counted exactly, larger values are
+/// grouped into buckets whose width doubles with every power of two, giving a
+/// relative error below 1% over the whole 64 bit range in about 30KB. Recording
+/// is a handful of instructions and never allocates.
+///
+/// The histogram has a single writer. Counters are relaxed atomics, so other
+/// threads can read percentiles while samples are being recorded without
+/// pausing the writer, at the cost of a slightly inconsistent snapshot.
+class LatencyHistogram final {
+   public:
+    /// \brief Bits of precision within each power of two.
+    static constexpr size_t SUB_BUCKET_BITS = 7;
+    /// \brief Number of exactly counted values.
+    static constexpr size_t SUB_BUCKET_COUNT = size_t{1} << SUB_BUCKET_BITS;
+    /// \brief Number of buckets per power of two above SUB_BUCKET_COUNT.
+    static constexpr size_t SUB_BUCKET_HALF_COUNT = SUB_BUCKET_COUNT / 2;
+    /// \brief Total number of buckets covering the 64 bit range.
+    static constexpr size_t BUCKET_COUNT =
+        SUB_BUCKET_COUNT + (64 - SUB_BUCKET_BITS) * SUB_BUCKET_HALF_COUNT;
+
+    /// \brief Constructs an empty histogram.
+    LatencyHistogram() noexcept { reset(); }
+
+    /// \brief Records a single sample. Must only be called by the writer.
+    /// \param value The sample, usually a latency in ticks or nanoseconds.
+    auto record(uint64_t value) noexcept -> void {
+        increment(mCounts[bucketIndex(value)], 1);
+        increment(mCount, 1);
+        increment(mSum, value);
+        if (value < mMin.load(std::memory_order_relaxed)) {
+            mMin.store(value, std::memory_order_relaxed);
+        }
+        if (value > mMax.load(std::memory_order_relaxed)) {
+            mMax.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    /// \brief Adds all samples of another histogram. Must only be called by
+    /// the writer.
+    /// \param other The histogram to merge in.
+    auto merge(const LatencyHistogram &other) noexcept -> void {
+        for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+            increment(mCounts[index],
+                      other.mCounts[index].load(std::memory_order_relaxed));
+        }
+        increment(mCount, other.count());
+        increment(mSum, other.mSum.load(std::memory_order_relaxed));
+        if (other.count() && other.min() < min()) {
+            mMin.store(other.min(), std::memory_order_relaxed);
+        }
+        if (other.count() && other.max() > max()) {
+            mMax.store(other.max(), std::memory_order_relaxed);
+        }
+    }
+
+    /// \brief Removes all samples. Must only be called by the writer.
+    auto reset() noexcept -> void {
+        for (auto &count : mCounts) count.store(0, std::memory_order_relaxed);
+        mCount.store(0, std::memory_order_relaxed);
+        mSum.store(0, std::memory_order_relaxed);
+        mMin.store(std::numeric_limits<uint64_t>::max(),
+                   std::memory_order_relaxed);
+        mMax.store(0, std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the number of samples recorded.
+    auto count() const noexcept -> uint64_t {
+        return mCount.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the smallest sample, 0 if the histogram is empty.
+    auto min() const noexcept -> uint64_t {
+        return count() ? mMin.load(std::memory_order_relaxed) : 0;
+    }
+
+    /// \brief Returns the largest sample.
+    auto max() const noexcept -> uint64_t {
+        return mMax.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the mean of the samples, 0 if the histogram is empty.
+    auto mean() const noexcept -> double {
+        const auto samples = count();
+        return samples ? static_cast<double>(
+                             mSum.load(std::memory_order_relaxed)) /
+                             samples
+                       : 0.0;
+    }
+
+    /// \brief Returns the value at a percentile.
+    /// \param percentile Percentile in the range [0, 100].
+    /// \return Highest value equivalent to the bucket holding the percentile,
+    /// capped at max(). 0 if the histogram is empty.
+    auto percentile(double percentile) const noexcept -> uint64_t {
+        const auto samples = count();
+        if (!samples) return 0;
+
+        auto target = static_cast<uint64_t>(percentile / 100.0 * samples + 0.5);
+        if (target == 0) target = 1;
+
+        uint64_t seen = 0;
+        for (size_t index = 0; index < BUCKET_COUNT; ++index) {
+            seen += mCounts[index].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                const auto value = highestEquivalentValue(index);
+                return value < max() ? value : max();
+            }
+        }
+        return max();
+    }
+
+    /// \brief Returns the number of samples in a bucket.
+    /// \param index Bucket index in the range [0, BUCKET_COUNT).
+    auto bucketCount(size_t index) const noexcept -> uint64_t {
+        return mCounts[index].load(std::memory_order_relaxed);
+    }
+
+    /// \brief Maps a value to its bucket index.
+    static constexpr auto bucketIndex(uint64_t value) noexcept -> size_t {
+        if (value < SUB_BUCKET_COUNT) return static_cast<size_t>(value);
+
+        const auto shift =
+            static_cast<size_t>(std::bit_width(value)) - SUB_BUCKET_BITS;
+        const auto mantissa = static_cast<size_t>(value >> shift);
+        return SUB_BUCKET_COUNT + (shift - 1) * SUB_BUCKET_HALF_COUNT +
+               (mantissa - SUB_BUCKET_HALF_COUNT);
+    }
+
+    /// \brief Returns the smallest value that maps to a bucket.
+    static constexpr auto lowestEquivalentValue(size_t index) noexcept
+        -> uint64_t {
+        if (index < SUB_BUCKET_COUNT) return index;
+
+        const auto offset = index - SUB_BUCKET_COUNT;
+        const auto shift = offset / SUB_BUCKET_HALF_COUNT + 1;
+        const auto mantissa =
+            offset % SUB_BUCKET_HALF_COUNT + SUB_BUCKET_HALF_COUNT;
+        return static_cast<uint64_t>(mantissa) << shift;
+    }
+
+    /// \brief Returns the largest value that maps to a bucket.
+    static constexpr auto highestEquivalentValue(size_t index) noexcept
+        -> uint64_t {
+        return index + 1 < BUCKET_COUNT ? lowestEquivalentValue(index + 1) - 1
+                                        : std::numeric_limits<uint64_t>::max();
+    }
+
+    // Deleted copy & move constructors and assignment-operators.
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram(const LatencyHistogram &&) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &&) = delete;
+
+   private:
+    /// \brief Adds to a counter owned by the single writer. A relaxed load and
+    /// store avoids the locked instruction of fetch_add.
+    static auto increment(std::atomic<uint64_t> &counter,
+                          uint64_t value) noexcept -> void {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+    }
+
+    /// \brief Number of samples per bucket.
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> mCounts;
+    /// \brief Total number of samples.
+    std::atomic<uint64_t> mCount = {0};
+    /// \brief Sum of all samples.
+    std::atomic<uint64_t> mSum = {0};
+    /// \brief Smallest sample.
+    std::atomic<uint64_t> mMin = {std::numeric_limits<uint64_t>::max()};
+    /// \brief Largest sample.
+    std::atomic<uint64_t> mMax = {0};
+};
+
+static_assert(LatencyHistogram::bucketIndex(
+                  LatencyHistogram::SUB_BUCKET_COUNT) ==
+                  LatencyHistogram::SUB_BUCKET_COUNT,
+              "Log-linear buckets must continue the linear ones.");
+static_assert(LatencyHistogram::bucketIndex(
+                  std::numeric_limits<uint64_t>::max()) ==
+                  LatencyHistogram::BUCKET_COUNT - 1,
+              "The last bucket must hold the largest value.");
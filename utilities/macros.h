@@ -3,20 +3,29 @@
 #include <cstring>
 #include <iostream>
 
+/// \brief Prints the message of a failed ASSERT and terminates the program.
+/// \param msg The message to display.
+[[noreturn]] inline auto assertFailure(const std::string &msg) noexcept
+    -> void {
+    std::cerr << "ASSERT : " << msg << std::endl;
+
+    exit(EXIT_FAILURE);
+}
+
 /// \brief Asserts a condition and prints an error message if the condition is
 /// false.
 ///
 /// If the condition is false, prints the provided message to std::cerr and
-/// terminates the program.
+/// terminates the program. The message is only evaluated when the condition
+/// is false, so building it costs nothing on the hot path.
 /// \param cond The condition to check.
 /// \param msg The message to display if the assertion fails.
-inline auto ASSERT(bool cond, const std::string &msg) noexcept {
-    if (!cond) [[unlikely]] {
-        std::cerr << "ASSERT : " << msg << std::endl;
-
-        exit(EXIT_FAILURE);
-    }
-}
+#define ASSERT(cond, msg)           \
+    do {                            \
+        if (!(cond)) [[unlikely]] { \
+            assertFailure(msg);     \
+        }                           \
+    } while (false)
 
 /// \brief Prints a fatal error message and terminates the program.
 ///
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+
+/// \brief RAII wrapper around a memory mapped file.
+///
+/// Files are either mapped read-only for replay and parsing, or created at a
+/// fixed size with their blocks pre-allocated and pages pre-faulted so that
+/// writers never hit the file system or a page fault on the hot path.
+class MappedFile final {
+   public:
+    /// \brief Constructs an unmapped file.
+    MappedFile() = default;
+
+    /// \brief Unmaps the file.
+    ~MappedFile() { close(); }
+
+    /// \brief Maps an existing file read-only.
+    /// \param path Path of the file to map.
+    /// \param populate Pre-fault all pages of the mapping up front.
+    /// \return true on success, false if the file cannot be opened or mapped.
+    auto openReadOnly(const std::string &path, bool populate = false) noexcept
+        -> bool {
+        close();
+
+        const auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) [[unlikely]] {
+            return false;
+        }
+
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+            [[unlikely]] {
+            ::close(fd);
+            return false;
+        }
+
+        mSize = static_cast<size_t>(file_stat.st_size);
+        mData = ::mmap(nullptr, mSize, PROT_READ,
+                       MAP_SHARED | (populate ? MAP_POPULATE : 0), fd, 0);
+        ::close(fd);  // the mapping keeps its own reference to the file
+
+        if (mData == MAP_FAILED) [[unlikely]] {
+            mData = nullptr;
+            mSize = 0;
+            return false;
+        }
+
+        return true;
+    }
+
+    /// \brief Creates (or truncates) a file of a fixed size and maps it
+    /// read-write.
+    ///
+    /// The file blocks are allocated with posix_fallocate and the pages are
+    /// pre-faulted, so writes into the mapping never extend the file.
+    /// \param path Path of the file to create.
+    /// \param size Size of the file in bytes.
+    /// \return true on success, false if the file cannot be created or mapped.
+    auto create(const std::string &path, size_t size) noexcept -> bool {
+        close();
+
+        const auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) [[unlikely]] {
+            return false;
+        }
+
+        if (::posix_fallocate(fd, 0, static_cast<off_t>(size)) != 0)
+            [[unlikely]] {
+            ::close(fd);
+            return false;
+        }
+
+        mSize = size;
+        mData = ::mmap(nullptr, mSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, 0);
+        ::close(fd);
+
+        if (mData == MAP_FAILED) [[unlikely]] {
+            mData = nullptr;
+            mSize = 0;
+            return false;
+        }
+
+        return true;
+    }
+
+    /// \brief Hints the kernel that the mapping will be read sequentially.
+    auto adviseSequential() const noexcept -> void {
+        if (mData) ::madvise(mData, mSize, MADV_SEQUENTIAL);
+    }
+
+    /// \brief Schedules dirty pages of a writable mapping to be written back,
+    /// without waiting for the write to complete.
+    auto syncAsync() const noexcept -> void {
+        if (mData) ::msync(mData, mSize, MS_ASYNC);
+    }
+
+    /// \brief Unmaps the file if it is mapped.
+    auto close() noexcept -> void {
+        if (mData) {
+            ::munmap(mData, mSize);
+            mData = nullptr;
+            mSize = 0;
+        }
+    }
+
+    /// \brief Returns whether a file is currently mapped.
+    auto isOpen() const noexcept { return mData != nullptr; }
+
+    /// \brief Returns the start of the mapping.
+    auto data() const noexcept { return static_cast<char *>(mData); }
+
+    /// \brief Returns the size of the mapping in bytes.
+    auto size() const noexcept { return mSize; }
+
+    // Deleted copy & move constructors and assignment-operators.
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(const MappedFile &&) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &&) = delete;
+
+   private:
+    /// \brief Start of the mapping, nullptr when nothing is mapped.
+    void *mData = nullptr;
+    /// \brief Size of the mapping in bytes.
+    size_t mSize = 0;
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+
+/// \brief RAII wrapper around a mapped POSIX shared memory object.
+///
+/// Objects are either created at a fixed size and mapped read-write by their
+/// single owner, with the pages pre-faulted, or mapped read-only by any
+/// number of observers in other processes. The object is named like
+/// shm_open() expects, "/name", and lives in /dev/shm until the owner
+/// unlinks it.
+class SharedMemory final {
+   public:
+    /// \brief Constructs an unmapped object.
+    SharedMemory() = default;
+
+    /// \brief Unmaps the object, and unlinks it if it was created here.
+    ~SharedMemory() { close(); }
+
+    /// \brief Creates a new shared memory object of a fixed size, zero
+    /// filled, and maps it read-write. An existing object of the same name is
+    /// unlinked first rather than truncated, so observers still mapping it
+    /// keep the old contents instead of faulting on truncated pages.
+    /// \param name Name of the object.
+    /// \param size Size of the object in bytes.
+    /// \return true on success, false if the object cannot be created or
+    /// mapped.
+    auto create(const std::string &name, size_t size) noexcept -> bool {
+        close();
+
+        ::shm_unlink(name.c_str());
+        const auto fd =
+            ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd < 0) [[unlikely]] {
+            return false;
+        }
+
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) [[unlikely]] {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            return false;
+        }
+
+        mSize = size;
+        mData = ::mmap(nullptr, mSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, 0);
+        ::close(fd);  // the mapping keeps its own reference to the object
+
+        if (mData == MAP_FAILED) [[unlikely]] {
+            mData = nullptr;
+            mSize = 0;
+            ::shm_unlink(name.c_str());
+            return false;
+        }
+
+        mName = name;
+        mOwner = true;
+        return true;
+    }
+
+    /// \brief Maps an existing shared memory object read-only.
+    /// \param name Name of the object.
+    /// \return true on success, false if the object cannot be opened or
+    /// mapped.
+    auto openReadOnly(const std::string &name) noexcept -> bool {
+        close();
+
+        const auto fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) [[unlikely]] {
+            return false;
+        }
+
+        struct stat object_stat;
+        if (::fstat(fd, &object_stat) != 0 || object_stat.st_size == 0)
+            [[unlikely]] {
+            ::close(fd);
+            return false;
+        }
+
+        mSize = static_cast<size_t>(object_stat.st_size);
+        mData = ::mmap(nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (mData == MAP_FAILED) [[unlikely]] {
+            mData = nullptr;
+            mSize = 0;
+            return false;
+        }
+
+        mName = name;
+        mOwner = false;
+        return true;
+    }
+
+    /// \brief Unmaps the object if it is mapped. The owner also unlinks it,
+    /// observers keep their mappings until they close them.
+    auto close() noexcept -> void {
+        if (mData) {
+            ::munmap(mData, mSize);
+            if (mOwner) ::shm_unlink(mName.c_str());
+            mData = nullptr;
+            mSize = 0;
+            mOwner = false;
+        }
+    }
+
+    /// \brief Returns whether an object is currently mapped.
+    auto isOpen() const noexcept { return mData != nullptr; }
+
+    /// \brief Returns the start of the mapping.
+    auto data() const noexcept { return static_cast<char *>(mData); }
+
+    /// \brief Returns the size of the mapping in bytes.
+    auto size() const noexcept { return mSize; }
+
+    /// \brief Returns the name of the mapped object.
+    auto name() const noexcept -> const std::string & { return mName; }
+
+    // Deleted copy & move constructors and assignment-operators.
+    SharedMemory(const SharedMemory &) = delete;
+    SharedMemory(const SharedMemory &&) = delete;
+    SharedMemory &operator=(const SharedMemory &) = delete;
+    SharedMemory &operator=(const SharedMemory &&) = delete;
+
+   private:
+    /// \brief Start of the mapping, nullptr when nothing is mapped.
+    void *mData = nullptr;
+    /// \brief Size of the mapping in bytes.
+    size_t mSize = 0;
+    /// \brief Name of the mapped object.
+    std::string mName;
+    /// \brief Whether the object was created here and is unlinked on close.
+    bool mOwner = false;
+};
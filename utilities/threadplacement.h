@@ -0,0 +1,71 @@
+#pragma once
+
+#include <alloca.h>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+/// \brief Size of the stack region prefaulted by default, well above what
+/// the pipeline stages use and well below the default 8MB thread stack.
+constexpr size_t THREAD_PREFAULT_STACK_SIZE = 256 * 1024;
+
+/// \brief Pins the calling thread to a single CPU.
+/// \param cpu The CPU to run on, a negative value leaves the thread unpinned.
+/// \return true if the thread is pinned, or pinning was not requested.
+inline auto pinThread(int cpu) noexcept -> bool {
+    if (cpu < 0) return true;
+#if defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set),
+                                  &cpu_set) == 0;
+#else
+    return false;
+#endif
+}
+
+/// \brief Runs the calling thread under the SCHED_FIFO real-time policy, so
+/// that it is only preempted by higher priority real-time threads. Needs
+/// CAP_SYS_NICE or a suitable RLIMIT_RTPRIO.
+/// \param priority SCHED_FIFO priority from 1 to 99, 0 keeps the current
+/// policy.
+/// \return true if the policy is set, or no change was requested.
+inline auto setFifoPriority(int priority) noexcept -> bool {
+    if (priority <= 0) return true;
+#if defined(__linux__)
+    sched_param param = {};
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+    return false;
+#endif
+}
+
+/// \brief Names the calling thread, as shown by top and perf. Linux keeps
+/// the first 15 characters.
+/// \param name The thread name.
+inline auto setThreadName(const std::string &name) noexcept -> void {
+#if defined(__linux__)
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#endif
+}
+
+/// \brief Touches every page of the next bytes of the calling thread's
+/// stack, so that the first deep call on the hot path does not take a page
+/// fault per page.
+/// \param bytes Size of the stack region to fault in.
+[[gnu::noinline]] inline auto prefaultStack(
+    size_t bytes = THREAD_PREFAULT_STACK_SIZE) noexcept -> void {
+    constexpr size_t PAGE_SIZE = 4096;
+    volatile char *stack = static_cast<volatile char *>(alloca(bytes));
+    for (size_t offset = 0; offset < bytes; offset += PAGE_SIZE) {
+        stack[offset] = 0;
+    }
+}
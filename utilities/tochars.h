@@ -0,0 +1,96 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+/// \brief Size of a buffer large enough for the toChars() rendering of any of
+/// the domain types.
+constexpr size_t TO_CHARS_BUFFER_SIZE = 512;
+
+/// \brief Copies text into a caller provided buffer.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param text The text to copy.
+/// \return Number of characters written, 0 if the text does not fit.
+inline auto copyChars(char *first, char *last, std::string_view text) noexcept
+    -> size_t {
+    if (static_cast<size_t>(last - first) < text.size()) [[unlikely]] {
+        return 0;
+    }
+    std::memcpy(first, text.data(), text.size());
+    return text.size();
+}
+
+/// \brief Renders an integer into a caller provided buffer.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param value The integer to render.
+/// \return Number of characters written, 0 if the value does not fit.
+template <typename T>
+inline auto integerToChars(char *first, char *last, T value) noexcept
+    -> size_t {
+    const auto [end, error] = std::to_chars(first, last, value);
+    return error == std::errc() ? static_cast<size_t>(end - first) : 0;
+}
+
+/// \brief Appends the fields of a composite rendering one after the other
+/// into a caller provided buffer.
+///
+/// Fields are rendered by the toChars functions, which return 0 when the field
+/// does not fit. Once a field does not fit the whole rendering fails and
+/// length() returns 0.
+class CharsWriter final {
+   public:
+    /// \brief Constructs a CharsWriter over a buffer.
+    /// \param first Start of the buffer.
+    /// \param last One past the end of the buffer.
+    CharsWriter(char *first, char *last) noexcept
+        : mFirst(first), mNext(first), mLast(last) {}
+
+    /// \brief Appends text.
+    auto text(std::string_view text) noexcept -> CharsWriter & {
+        return advance(mOk ? copyChars(mNext, mLast, text) : 0);
+    }
+
+    /// \brief Appends a field rendered by a toChars function.
+    /// \param render The toChars function, called with the free part of the
+    /// buffer followed by args.
+    /// \param args The value to render and any further arguments.
+    template <typename Render, typename... Args>
+    auto field(Render render, Args... args) noexcept -> CharsWriter & {
+        return advance(mOk ? render(mNext, mLast, args...) : 0);
+    }
+
+    /// \brief Returns the total length written, 0 if anything did not fit.
+    auto length() const noexcept -> size_t {
+        return mOk ? static_cast<size_t>(mNext - mFirst) : 0;
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    CharsWriter() = delete;
+    CharsWriter(const CharsWriter &) = delete;
+    CharsWriter(const CharsWriter &&) = delete;
+    CharsWriter &operator=(const CharsWriter &) = delete;
+    CharsWriter &operator=(const CharsWriter &&) = delete;
+
+   private:
+    /// \brief Moves past a field, or fails the rendering if it did not fit.
+    auto advance(size_t length) noexcept -> CharsWriter & {
+        if (!length) [[unlikely]] {
+            mOk = false;
+        }
+        mNext += length;
+        return *this;
+    }
+
+    /// \brief Start of the buffer.
+    char *const mFirst;
+    /// \brief Where the next field is written.
+    char *mNext;
+    /// \brief One past the end of the buffer.
+    char *const mLast;
+    /// \brief Cleared once a field does not fit.
+    bool mOk = true;
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <time.h>
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+    #include <x86intrin.h>
+#endif
+
+/// \brief Cycle accurate clock reading the CPU time stamp counter.
+///
+/// Reading the counter costs a handful of nanoseconds compared to tens of
+/// nanoseconds for a system clock call, which matters when timing every
+/// message. On CPUs with an invariant TSC the counter ticks at a constant rate
+/// on every core, independent of frequency scaling and sleep states, so ticks
+/// taken on different threads can be compared.
+///
+/// calibrate() measures the tick rate against CLOCK_MONOTONIC once at start
+/// up. Ticks are then converted to nanoseconds with a fixed-point multiply and
+/// shift, and nanos() extends the monotonic clock without a system call.
+/// calibrate() must be called before any other thread uses the clock.
+class TscClock final {
+   public:
+    /// \brief Reads the time stamp counter.
+    /// \return Current tick count.
+    static auto now() noexcept -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return monotonicNanos();
+#endif
+    }
+
+    /// \brief Reads the time stamp counter once all preceding instructions
+    /// have completed, and before any following instruction starts. Used to
+    /// close a timed region.
+    /// \return Current tick count.
+    static auto nowSerialized() noexcept -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int aux;
+        const auto ticks = __rdtscp(&aux);
+        _mm_lfence();
+        return ticks;
+#else
+        return now();
+#endif
+    }
+
+    /// \brief Returns true if the CPU advertises an invariant time stamp
+    /// counter (CPUID 0x80000007, EDX bit 8).
+    static auto hasInvariantTsc() noexcept -> bool {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+        return edx & (1u << 8);
+#else
+        return false;
+#endif
+    }
+
+    /// \brief Reads CLOCK_MONOTONIC.
+    /// \return Nanoseconds since an unspecified point in the past.
+    static auto monotonicNanos() noexcept -> uint64_t {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 +
+               static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    /// \brief Measures the tick rate against CLOCK_MONOTONIC and anchors
+    /// nanos() to it.
+    /// \param duration How long to measure for, longer is more accurate.
+    static auto calibrate(std::chrono::nanoseconds duration =
+                              std::chrono::milliseconds(20)) noexcept -> void {
+        const auto start = sample();
+        while (monotonicNanos() - start.nanos <
+               static_cast<uint64_t>(duration.count())) {
+        }
+        const auto end = sample();
+
+        sTicks_per_nano = static_cast<double>(end.ticks - start.ticks) /
+                          static_cast<double>(end.nanos - start.nanos);
+        sNanos_per_tick_fixed = static_cast<uint64_t>(
+            static_cast<double>(uint64_t{1} << FIXED_POINT_SHIFT) /
+                sTicks_per_nano +
+            0.5);
+        sBase_ticks = end.ticks;
+        sBase_nanos = end.nanos;
+    }
+
+    /// \brief Returns the number of ticks per nanosecond, 1 until calibrate()
+    /// has been called.
+    static auto ticksPerNano() noexcept { return sTicks_per_nano; }
+
+    /// \brief Converts a tick count into nanoseconds, for reporting.
+    /// \param ticks Tick count, usually the difference between two readings.
+    /// \return Nanoseconds, with the fraction.
+    static auto ticksToNanos(uint64_t ticks) noexcept -> double {
+        return ticks / sTicks_per_nano;
+    }
+
+    /// \brief Converts a tick count into whole nanoseconds with a single
+    /// multiply and shift, cheap enough for the hot path.
+    /// \param ticks Tick count, usually the difference between two readings.
+    /// \return Nanoseconds.
+    static auto toNanos(uint64_t ticks) noexcept -> uint64_t {
+        return static_cast<uint64_t>(
+            (static_cast<unsigned __int128>(ticks) * sNanos_per_tick_fixed) >>
+            FIXED_POINT_SHIFT);
+    }
+
+    /// \brief Returns the current CLOCK_MONOTONIC time derived from the time
+    /// stamp counter, without a system call.
+    /// \return Nanoseconds on the CLOCK_MONOTONIC time line.
+    static auto nanos() noexcept -> uint64_t {
+        return sBase_nanos + toNanos(now() - sBase_ticks);
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    TscClock() = delete;
+    TscClock(const TscClock &) = delete;
+    TscClock(const TscClock &&) = delete;
+    TscClock &operator=(const TscClock &) = delete;
+    TscClock &operator=(const TscClock &&) = delete;
+
+   private:
+    /// \brief Fraction bits of the fixed-point nanoseconds per tick.
+    static constexpr unsigned FIXED_POINT_SHIFT = 32;
+
+    /// \struct Sample
+    /// \brief A tick count and the monotonic time read at the same moment.
+    struct Sample {
+        uint64_t ticks = 0;
+        uint64_t nanos = 0;
+    };
+
+    /// \brief Reads the monotonic clock between two tick counts, keeping the
+    /// tightest of a few attempts so that a preemption or a slow clock call
+    /// does not skew the calibration.
+    static auto sample() noexcept -> Sample {
+        Sample best;
+        auto best_window = UINT64_MAX;
+        for (int attempt = 0; attempt < 16; ++attempt) {
+            const auto before = nowSerialized();
+            const auto nanos = monotonicNanos();
+            const auto after = nowSerialized();
+            if (after - before < best_window) {
+                best_window = after - before;
+                best = {before + (after - before) / 2, nanos};
+            }
+        }
+        return best;
+    }
+
+    /// \brief Measured ticks per nanosecond.
+    static inline double sTicks_per_nano = 1.0;
+    /// \brief Nanoseconds per tick in FIXED_POINT_SHIFT fixed-point.
+    static inline uint64_t sNanos_per_tick_fixed = uint64_t{1}
+                                                   << FIXED_POINT_SHIFT;
+    /// \brief Tick count and monotonic time of the calibration anchor.
+    static inline uint64_t sBase_ticks = 0;
+    static inline uint64_t sBase_nanos = 0;
+};
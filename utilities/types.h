@@ -6,11 +6,15 @@
 #include <sstream>
 
 #include "macros.h"
+#include "tochars.h"
 
 /// \brief Maximum number of trading instruments/tickers.
 /// TickerIds range from [0, ME_MAX_TICKERS].
 constexpr size_t ME_MAX_TICKERS = 8;
 
+/// \brief Maximum number of venues an instrument is traded on.
+constexpr size_t ME_MAX_VENUES = 8;
+
 /// \brief Maximum size of lock-free queues for client updates.
 constexpr size_t ME_MAX_CLIENT_UPDATES = 256 * 1024;
 
@@ -43,6 +47,20 @@ inline auto orderIdToString(OrderId order_id) -> std::string {
     return std::to_string(order_id);
 }
 
+/// \brief Renders a OrderId into a caller provided buffer, without allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param order_id The OrderId to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto orderIdToChars(char *first, char *last, OrderId order_id) noexcept
+    -> size_t {
+    if (order_id == OrderId_INVALID) [[unlikely]] {
+        return copyChars(first, last, "INVALID");
+    }
+
+    return integerToChars(first, last, order_id);
+}
+
 /// \brief Type alias for TickerId.
 typedef uint32_t TickerId;
 
@@ -60,6 +78,20 @@ inline auto tickerIdToString(TickerId ticker_id) -> std::string {
     return std::to_string(ticker_id);
 }
 
+/// \brief Renders a TickerId into a caller provided buffer, without allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param ticker_id The TickerId to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto tickerIdToChars(char *first, char *last,
+                            TickerId ticker_id) noexcept -> size_t {
+    if (ticker_id == TickerId_INVALID) [[unlikely]] {
+        return copyChars(first, last, "INVALID");
+    }
+
+    return integerToChars(first, last, ticker_id);
+}
+
 /// \brief Type alias for ClientId.
 typedef uint32_t ClientId;
 
@@ -77,6 +109,51 @@ inline auto clientIdToString(ClientId client_id) -> std::string {
     return std::to_string(client_id);
 }
 
+/// \brief Renders a ClientId into a caller provided buffer, without allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param client_id The ClientId to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto clientIdToChars(char *first, char *last,
+                            ClientId client_id) noexcept -> size_t {
+    if (client_id == ClientId_INVALID) [[unlikely]] {
+        return copyChars(first, last, "INVALID");
+    }
+
+    return integerToChars(first, last, client_id);
+}
+
+/// \brief Type alias for VenueId.
+typedef uint32_t VenueId;
+
+/// \brief Invalid value for VenueId.
+constexpr auto VenueId_INVALID = std::numeric_limits<VenueId>::max();
+
+/// \brief Converts a VenueId to a string.
+/// \param venue_id The VenueId to convert.
+/// \return String representation of the VenueId, or "INVALID" if invalid.
+inline auto venueIdToString(VenueId venue_id) -> std::string {
+    if (venue_id == VenueId_INVALID) [[unlikely]] {
+        return "INVALID";
+    }
+
+    return std::to_string(venue_id);
+}
+
+/// \brief Renders a VenueId into a caller provided buffer, without allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param venue_id The VenueId to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto venueIdToChars(char *first, char *last, VenueId venue_id) noexcept
+    -> size_t {
+    if (venue_id == VenueId_INVALID) [[unlikely]] {
+        return copyChars(first, last, "INVALID");
+    }
+
+    return integerToChars(first, last, venue_id);
+}
+
 /// \brief Type alias for Price.
 /// \note The Price is a signed integer as a negative price is possible.
 typedef int64_t Price;
@@ -95,6 +172,55 @@ inline auto priceToString(Price price) -> std::string {
     return std::to_string(price);
 }
 
+/// \brief Renders a Price into a caller provided buffer, without allocating.
+///
+/// Prices are integers with a number of implied decimals, which are rendered
+/// as a fixed-point number, so 1234567 with 4 decimals is "123.4567". With the
+/// default of no decimals the rendering matches priceToString().
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param price The Price to render.
+/// \param decimals Number of implied decimals, at most 18.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto priceToChars(char *first, char *last, Price price,
+                         unsigned decimals = 0) noexcept -> size_t {
+    if (price == Price_INVALID) [[unlikely]] {
+        return copyChars(first, last, "INVALID");
+    }
+    if (!decimals) return integerToChars(first, last, price);
+
+    if (decimals > 18) [[unlikely]] return 0;
+    uint64_t scale = 1;
+    for (unsigned digit = 0; digit < decimals; ++digit) scale *= 10;
+
+    // Work on the magnitude in unsigned arithmetic, which also covers the
+    // most negative price.
+    const auto negative = price < 0;
+    const auto magnitude = negative ? 0 - static_cast<uint64_t>(price)
+                                    : static_cast<uint64_t>(price);
+    const auto whole = magnitude / scale;
+    auto fraction = magnitude % scale;
+
+    auto out = first;
+    if (negative) {
+        if (out == last) [[unlikely]] return 0;
+        *out++ = '-';
+    }
+    const auto whole_length = integerToChars(out, last, whole);
+    if (!whole_length) [[unlikely]] return 0;
+    out += whole_length;
+
+    if (static_cast<unsigned>(last - out) < decimals + 1) [[unlikely]] {
+        return 0;
+    }
+    *out = '.';
+    for (auto digit = decimals; digit > 0; --digit) {
+        out[digit] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    return static_cast<size_t>(out + decimals + 1 - first);
+}
+
 /// \brief Type alias for Qty (quantity).
 typedef uint32_t Qty;
 
@@ -112,6 +238,20 @@ inline auto qtyToString(Qty qty) -> std::string {
     return std::to_string(qty);
 }
 
+/// \brief Renders a Qty into a caller provided buffer, without allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param qty The Qty to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto qtyToChars(char *first, char *last, Qty qty) noexcept
+    -> size_t {
+    if (qty == Qty_INVALID) [[unlikely]] {
+        return copyChars(first, last, "INVALID");
+    }
+
+    return integerToChars(first, last, qty);
+}
+
 /// \brief Priority represents position in the FIFO queue for all orders with
 /// the same side and price attributes.
 typedef uint64_t Priority;
@@ -130,6 +270,20 @@ inline auto priorityToString(Priority priority) -> std::string {
     return std::to_string(priority);
 }
 
+/// \brief Renders a Priority into a caller provided buffer, without allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param priority The Priority to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto priorityToChars(char *first, char *last, Priority priority) noexcept
+    -> size_t {
+    if (priority == Priority_INVALID) [[unlikely]] {
+        return copyChars(first, last, "INVALID");
+    }
+
+    return integerToChars(first, last, priority);
+}
+
 /// \brief Enum representing the side of an order (buy/sell).
 enum class Side : int8_t { INVALID = 0, BUY = 1, SELL = -1, MAX = 2 };
 
@@ -151,6 +305,22 @@ inline auto sideToString(Side side) -> std::string {
     return "UNKNOWN";
 }
 
+/// \brief Names of the Side values, indexed by sideToIndex().
+constexpr std::string_view SIDE_NAMES[] = {"SELL", "INVALID", "BUY", "MAX"};
+
+/// \brief Renders a Side into a caller provided buffer, without allocating.
+/// \param first Start of the buffer.
+/// \param last One past the end of the buffer.
+/// \param side The Side to render.
+/// \return Number of characters written, 0 if the buffer is too small.
+inline auto sideToChars(char *first, char *last, Side side) noexcept
+    -> size_t {
+    const auto index = static_cast<size_t>(static_cast<int>(side) + 1);
+    return copyChars(first, last,
+                     index < std::size(SIDE_NAMES) ? SIDE_NAMES[index]
+                                                   : "UNKNOWN");
+}
+
 /// \brief Converts Side to an index for use in arrays.
 /// \param side The Side to convert.
 /// \return Index value corresponding to the Side.
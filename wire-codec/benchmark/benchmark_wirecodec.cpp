@@ -0,0 +1,220 @@
+/// \file benchmark_wirecodec.cpp
+/// \brief Encode/decode throughput of the wire codec against the raw packed
+/// MDPMarketUpdate structures.
+/// \details Both formats are packed into MTU sized packets, decoded back and
+/// summed field by field so that neither side can be optimised away.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "wire-codec/wirecodec.h"
+
+/// \brief Payload size of a single packet, a typical Ethernet MTU minus the
+/// IP/UDP headers.
+constexpr size_t PACKET_SIZE = 1472;
+
+/// \brief Number of market updates per repetition.
+constexpr size_t NUM_UPDATES = 1'000'000;
+
+/// \brief Number of timed repetitions, the fastest one is reported.
+constexpr size_t NUM_REPETITIONS = 5;
+
+/// \struct PacketBuffer
+/// \brief Encoded packets laid out back to back in one contiguous buffer.
+struct PacketBuffer {
+    std::vector<char> data;
+    std::vector<size_t> offsets;
+    std::vector<size_t> lengths;
+};
+
+/// \brief Generates a stream of market updates that resembles an L3 feed.
+/// \param count Number of updates to generate.
+/// \return The generated updates.
+auto generateUpdates(size_t count) -> std::vector<MEMarketUpdate> {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> type_dist(0, 9);
+    std::uniform_int_distribution<int> price_dist(-20, 20);
+    std::uniform_int_distribution<Qty> qty_dist(1, 1000);
+    std::uniform_int_distribution<TickerId> ticker_dist(0, ME_MAX_TICKERS - 1);
+
+    std::vector<MEMarketUpdate> updates(count);
+    OrderId next_order_id = 1'000'000;
+    for (auto &update : updates) {
+        const auto roll = type_dist(rng);
+        update.type = roll < 5   ? MarketUpdateType::ADD
+                      : roll < 8 ? MarketUpdateType::CANCEL
+                      : roll < 9 ? MarketUpdateType::MODIFY
+                                 : MarketUpdateType::TRADE;
+        // Adds use fresh ids, everything else refers back to a recent order.
+        update.order_id = update.type == MarketUpdateType::ADD
+                              ? next_order_id++
+                              : next_order_id - 1 - (rng() % 64);
+        update.ticker_id = ticker_dist(rng);
+        update.side = (rng() & 1) ? Side::BUY : Side::SELL;
+        update.price = 100'000 + price_dist(rng);
+        update.qty = qty_dist(rng);
+        update.priority = rng() % 128;
+    }
+
+    return updates;
+}
+
+/// \brief Packs the raw MDPMarketUpdate structures into packets.
+auto encodeRaw(const std::vector<MEMarketUpdate> &updates,
+               PacketBuffer &packets) {
+    constexpr auto per_packet = PACKET_SIZE / sizeof(MDPMarketUpdate);
+
+    packets.offsets.clear();
+    packets.lengths.clear();
+    size_t offset = 0;
+    size_t seq_num = 0;
+    for (size_t i = 0; i < updates.size(); i += per_packet) {
+        const auto count = std::min(per_packet, updates.size() - i);
+        auto out = packets.data.data() + offset;
+        for (size_t j = 0; j < count; ++j) {
+            MDPMarketUpdate mdp_update;
+            mdp_update.seq_num_ = seq_num++;
+            mdp_update.me_market_update_ = updates[i + j];
+            std::memcpy(out + j * sizeof(MDPMarketUpdate), &mdp_update,
+                        sizeof(MDPMarketUpdate));
+        }
+        packets.offsets.push_back(offset);
+        packets.lengths.push_back(count * sizeof(MDPMarketUpdate));
+        offset += PACKET_SIZE;
+    }
+}
+
+/// \brief Reads the raw MDPMarketUpdate structures back out of the packets.
+auto decodeRaw(const PacketBuffer &packets) {
+    uint64_t checksum = 0;
+    for (size_t p = 0; p < packets.offsets.size(); ++p) {
+        const auto in = packets.data.data() + packets.offsets[p];
+        const auto count = packets.lengths[p] / sizeof(MDPMarketUpdate);
+        for (size_t j = 0; j < count; ++j) {
+            MDPMarketUpdate mdp_update;
+            std::memcpy(&mdp_update, in + j * sizeof(MDPMarketUpdate),
+                        sizeof(MDPMarketUpdate));
+            const auto &update = mdp_update.me_market_update_;
+            checksum += update.order_id + update.price + update.qty +
+                        update.ticker_id + update.priority +
+                        static_cast<uint64_t>(update.type) +
+                        static_cast<uint64_t>(update.side) +
+                        mdp_update.seq_num_;
+        }
+    }
+    return checksum;
+}
+
+/// \brief Encodes the updates with the wire codec.
+auto encodeWire(const std::vector<MEMarketUpdate> &updates,
+                PacketBuffer &packets) {
+    packets.offsets.clear();
+    packets.lengths.clear();
+    size_t offset = 0;
+    size_t seq_num = 0;
+    size_t i = 0;
+    while (i < updates.size()) {
+        WirePacketEncoder encoder(packets.data.data() + offset, PACKET_SIZE);
+        encoder.begin(seq_num);
+        while (i < updates.size() && encoder.append(updates[i])) ++i;
+        seq_num = encoder.nextSeqNum();
+        packets.offsets.push_back(offset);
+        packets.lengths.push_back(encoder.finish());
+        offset += PACKET_SIZE;
+    }
+}
+
+/// \brief Decodes the wire packets in place.
+auto decodeWire(const PacketBuffer &packets) {
+    uint64_t checksum = 0;
+    for (size_t p = 0; p < packets.offsets.size(); ++p) {
+        WirePacketDecoder decoder(packets.data.data() + packets.offsets[p],
+                                  packets.lengths[p]);
+        while (auto message = decoder.next()) {
+            checksum += message->orderId() + message->price() +
+                        message->qty() + message->tickerId() +
+                        message->priority() +
+                        static_cast<uint64_t>(message->type()) +
+                        static_cast<uint64_t>(message->side()) +
+                        message->seqNum();
+        }
+    }
+    return checksum;
+}
+
+/// \brief Runs a function NUM_REPETITIONS times and returns the fastest run in
+/// nanoseconds per update.
+template <typename Func>
+auto timeBest(Func &&func) {
+    auto best = std::numeric_limits<double>::max();
+    for (size_t rep = 0; rep < NUM_REPETITIONS; ++rep) {
+        const auto start = std::chrono::steady_clock::now();
+        func();
+        const auto end = std::chrono::steady_clock::now();
+        const auto ns = std::chrono::duration<double, std::nano>(end - start);
+        best = std::min(best, ns.count() / NUM_UPDATES);
+    }
+    return best;
+}
+
+/// \brief Prints a single result line.
+auto report(const char *name, double ns_per_update, double bytes_per_update) {
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed
+              << std::setprecision(2) << std::setw(10) << ns_per_update
+              << " ns/msg" << std::setw(10) << 1e3 / ns_per_update
+              << " Mmsg/s" << std::setw(10) << bytes_per_update << " B/msg"
+              << std::endl;
+}
+
+/// \brief Main function running the codec benchmarks.
+/// \return Exit status code (0 for success)
+int main(int, char **) {
+    const auto updates = generateUpdates(NUM_UPDATES);
+
+    PacketBuffer raw;
+    PacketBuffer wire;
+    raw.data.resize(
+        (NUM_UPDATES / (PACKET_SIZE / sizeof(MDPMarketUpdate)) + 1) *
+        PACKET_SIZE);
+    wire.data.resize((NUM_UPDATES / ((PACKET_SIZE - WirePacketHeader::SIZE) /
+                                     WireMessageBlock::SIZE) +
+                      NUM_UPDATES / 64 + 1) *
+                     PACKET_SIZE);
+
+    const auto raw_encode = timeBest([&] { encodeRaw(updates, raw); });
+    const auto wire_encode = timeBest([&] { encodeWire(updates, wire); });
+
+    uint64_t raw_checksum = 0;
+    uint64_t wire_checksum = 0;
+    const auto raw_decode = timeBest([&] { raw_checksum = decodeRaw(raw); });
+    const auto wire_decode =
+        timeBest([&] { wire_checksum = decodeWire(wire); });
+
+    ASSERT(raw_checksum == wire_checksum,
+           "Wire codec round trip does not match the raw structures.");
+
+    size_t raw_bytes = 0;
+    size_t wire_bytes = 0;
+    for (auto length : raw.lengths) raw_bytes += length;
+    for (auto length : wire.lengths) wire_bytes += length;
+
+    std::cout << NUM_UPDATES << " updates, " << PACKET_SIZE
+              << " byte packets, best of " << NUM_REPETITIONS << std::endl;
+    report("raw encode", raw_encode,
+           static_cast<double>(raw_bytes) / NUM_UPDATES);
+    report("wire encode", wire_encode,
+           static_cast<double>(wire_bytes) / NUM_UPDATES);
+    report("raw decode", raw_decode,
+           static_cast<double>(raw_bytes) / NUM_UPDATES);
+    report("wire decode", wire_decode,
+           static_cast<double>(wire_bytes) / NUM_UPDATES);
+    std::cout << "packets raw:" << raw.offsets.size()
+              << " wire:" << wire.offsets.size() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,449 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "market-orders/marketupdate.h"
+#include "utilities/byteorder.h"
+#include "utilities/macros.h"
+#include "utilities/types.h"
+
+/// \brief Identifies the market data schema carried by a wire packet ("MD").
+constexpr uint16_t WIRE_SCHEMA_ID = 0x4D44;
+
+/// \brief Version of the wire schema written by the encoder.
+///
+/// Decoders accept any version whose message block is at least as long as the
+/// version 1 block, newer fields are appended to the end of the block and are
+/// skipped using the block length carried in the packet header.
+constexpr uint16_t WIRE_SCHEMA_VERSION = 1;
+
+/// \brief Delta value reserved to encode an INVALID OrderId or Price.
+constexpr int32_t WIRE_DELTA_INVALID = std::numeric_limits<int32_t>::min();
+
+/// \brief Ticker value reserved to encode TickerId_INVALID.
+constexpr uint16_t WIRE_TICKER_INVALID = std::numeric_limits<uint16_t>::max();
+
+/// \struct WirePacketHeader
+/// \brief Byte offsets of the little-endian packet header fields.
+///
+/// The header is written once per packet and carries the sequence number of
+/// the first message, the message count and the base values that the first
+/// order id and price deltas are relative to.
+struct WirePacketHeader {
+    /// uint16_t schema identifier, always WIRE_SCHEMA_ID.
+    static constexpr size_t SCHEMA_ID = 0;
+    /// uint16_t schema version the packet was written with.
+    static constexpr size_t VERSION = 2;
+    /// uint16_t size of every message block in the packet.
+    static constexpr size_t BLOCK_LENGTH = 4;
+    /// uint16_t number of message blocks following the header.
+    static constexpr size_t MESSAGE_COUNT = 6;
+    /// uint64_t sequence number of the first message in the packet.
+    static constexpr size_t SEQ_NUM = 8;
+    /// uint64_t order id the first order id delta is relative to.
+    static constexpr size_t BASE_ORDER_ID = 16;
+    /// int64_t price the first price delta is relative to.
+    static constexpr size_t BASE_PRICE = 24;
+    /// Total size of the header in bytes.
+    static constexpr size_t SIZE = 32;
+};
+
+/// \struct WireMessageBlock
+/// \brief Byte offsets of the little-endian fields of a version 1 message.
+///
+/// Order ids and prices are sent as 32 bit deltas against the previous valid
+/// value in the same packet, which cuts a 42 byte MDPMarketUpdate down to a 24
+/// byte block.
+struct WireMessageBlock {
+    /// uint8_t MarketUpdateType.
+    static constexpr size_t TYPE = 0;
+    /// int8_t Side.
+    static constexpr size_t SIDE = 1;
+    /// uint16_t TickerId, WIRE_TICKER_INVALID for TickerId_INVALID.
+    static constexpr size_t TICKER_ID = 2;
+    /// uint32_t Qty.
+    static constexpr size_t QTY = 4;
+    /// int32_t OrderId delta, WIRE_DELTA_INVALID for OrderId_INVALID.
+    static constexpr size_t ORDER_ID_DELTA = 8;
+    /// int32_t Price delta, WIRE_DELTA_INVALID for Price_INVALID.
+    static constexpr size_t PRICE_DELTA = 12;
+    /// uint64_t Priority.
+    static constexpr size_t PRIORITY = 16;
+    /// Total size of a version 1 message block in bytes.
+    static constexpr size_t SIZE = 24;
+};
+
+/// \brief Computes a 32 bit delta between two 64 bit values.
+/// \param value The value to encode.
+/// \param previous The value the delta is relative to.
+/// \param delta Output delta, only written if it fits.
+/// \return true if the delta fits into 32 bits without using the reserved
+/// WIRE_DELTA_INVALID value.
+template <typename T>
+inline auto wireDelta(T value, T previous, int32_t &delta) noexcept -> bool {
+    // Subtract in unsigned arithmetic so that wrap-around is well defined.
+    const auto wide = static_cast<int64_t>(static_cast<uint64_t>(value) -
+                                           static_cast<uint64_t>(previous));
+    if (wide <= WIRE_DELTA_INVALID ||
+        wide > std::numeric_limits<int32_t>::max()) [[unlikely]] {
+        return false;
+    }
+    delta = static_cast<int32_t>(wide);
+    return true;
+}
+
+/// \brief Encodes MEMarketUpdates into a caller provided packet buffer.
+///
+/// Usage is begin(), append() until it returns false, then finish() to seal the
+/// header and obtain the packet length. append() returns false when the buffer
+/// is full or a delta does not fit into 32 bits, the caller is then expected
+/// to send the packet and start a new one with the same update.
+class WirePacketEncoder final {
+   public:
+    /// \brief Constructs an encoder writing into the given buffer.
+    /// \param buffer Destination buffer, must outlive the encoder.
+    /// \param capacity Size of the destination buffer in bytes.
+    WirePacketEncoder(char *buffer, size_t capacity) noexcept
+        : mBuffer(buffer), mCapacity(capacity) {
+        ASSERT(capacity >= WirePacketHeader::SIZE + WireMessageBlock::SIZE,
+               "Wire packet buffer too small for a single message.");
+    }
+
+    /// \brief Starts a new packet, discarding any unfinished one.
+    /// \param seq_num Sequence number of the first message in the packet.
+    auto begin(size_t seq_num) noexcept -> void {
+        mSeq_num = seq_num;
+        mMessage_count = 0;
+        mLength = WirePacketHeader::SIZE;
+        mPrev_order_id = OrderId_INVALID;
+        mPrev_price = Price_INVALID;
+    }
+
+    /// \brief Appends a market update to the current packet.
+    /// \param update The update to encode.
+    /// \return true if the update was written, false if the packet must be
+    /// flushed first.
+    auto append(const MEMarketUpdate &update) noexcept -> bool {
+        if (mLength + WireMessageBlock::SIZE > mCapacity ||
+            mMessage_count == std::numeric_limits<uint16_t>::max())
+            [[unlikely]] {
+            return false;
+        }
+
+        int32_t order_id_delta = WIRE_DELTA_INVALID;
+        auto next_order_id = mPrev_order_id;
+        if (update.order_id != OrderId_INVALID) [[likely]] {
+            if (mPrev_order_id == OrderId_INVALID) {
+                // First valid order id in the packet becomes the base value.
+                order_id_delta = 0;
+            } else if (!wireDelta(update.order_id, mPrev_order_id,
+                                  order_id_delta)) {
+                return false;
+            }
+            next_order_id = update.order_id;
+        }
+
+        int32_t price_delta = WIRE_DELTA_INVALID;
+        auto next_price = mPrev_price;
+        if (update.price != Price_INVALID) [[likely]] {
+            if (mPrev_price == Price_INVALID) {
+                price_delta = 0;
+            } else if (!wireDelta(update.price, mPrev_price, price_delta)) {
+                return false;
+            }
+            next_price = update.price;
+        }
+
+        if (update.ticker_id >= WIRE_TICKER_INVALID &&
+            update.ticker_id != TickerId_INVALID) [[unlikely]] {
+            FATAL("TickerId does not fit the wire schema:" +
+                  tickerIdToString(update.ticker_id));
+        }
+
+        if (mPrev_order_id == OrderId_INVALID &&
+            next_order_id != OrderId_INVALID) {
+            storeLittleEndian<uint64_t>(
+                mBuffer + WirePacketHeader::BASE_ORDER_ID, next_order_id);
+        }
+        if (mPrev_price == Price_INVALID && next_price != Price_INVALID) {
+            storeLittleEndian<int64_t>(mBuffer + WirePacketHeader::BASE_PRICE,
+                                       next_price);
+        }
+        mPrev_order_id = next_order_id;
+        mPrev_price = next_price;
+
+        auto block = mBuffer + mLength;
+        storeLittleEndian<uint8_t>(block + WireMessageBlock::TYPE,
+                                   static_cast<uint8_t>(update.type));
+        storeLittleEndian<int8_t>(block + WireMessageBlock::SIDE,
+                                  static_cast<int8_t>(update.side));
+        storeLittleEndian<uint16_t>(
+            block + WireMessageBlock::TICKER_ID,
+            update.ticker_id == TickerId_INVALID
+                ? WIRE_TICKER_INVALID
+                : static_cast<uint16_t>(update.ticker_id));
+        storeLittleEndian<uint32_t>(block + WireMessageBlock::QTY, update.qty);
+        storeLittleEndian<int32_t>(block + WireMessageBlock::ORDER_ID_DELTA,
+                                   order_id_delta);
+        storeLittleEndian<int32_t>(block + WireMessageBlock::PRICE_DELTA,
+                                   price_delta);
+        storeLittleEndian<uint64_t>(block + WireMessageBlock::PRIORITY,
+                                    update.priority);
+
+        mLength += WireMessageBlock::SIZE;
+        ++mMessage_count;
+
+        return true;
+    }
+
+    /// \brief Seals the packet header.
+    /// \return Length of the finished packet in bytes.
+    auto finish() noexcept -> size_t {
+        storeLittleEndian<uint16_t>(mBuffer + WirePacketHeader::SCHEMA_ID,
+                                    WIRE_SCHEMA_ID);
+        storeLittleEndian<uint16_t>(mBuffer + WirePacketHeader::VERSION,
+                                    WIRE_SCHEMA_VERSION);
+        storeLittleEndian<uint16_t>(mBuffer + WirePacketHeader::BLOCK_LENGTH,
+                                    WireMessageBlock::SIZE);
+        storeLittleEndian<uint16_t>(mBuffer + WirePacketHeader::MESSAGE_COUNT,
+                                    mMessage_count);
+        storeLittleEndian<uint64_t>(mBuffer + WirePacketHeader::SEQ_NUM,
+                                    mSeq_num);
+        if (mPrev_order_id == OrderId_INVALID) {
+            storeLittleEndian<uint64_t>(
+                mBuffer + WirePacketHeader::BASE_ORDER_ID, OrderId_INVALID);
+        }
+        if (mPrev_price == Price_INVALID) {
+            storeLittleEndian<int64_t>(mBuffer + WirePacketHeader::BASE_PRICE,
+                                       Price_INVALID);
+        }
+
+        return mLength;
+    }
+
+    /// \brief Returns the number of messages appended to the current packet.
+    auto messageCount() const noexcept { return mMessage_count; }
+
+    /// \brief Returns the sequence number the next appended message will get.
+    auto nextSeqNum() const noexcept { return mSeq_num + mMessage_count; }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    WirePacketEncoder() = delete;
+    WirePacketEncoder(const WirePacketEncoder &) = delete;
+    WirePacketEncoder(const WirePacketEncoder &&) = delete;
+    WirePacketEncoder &operator=(const WirePacketEncoder &) = delete;
+    WirePacketEncoder &operator=(const WirePacketEncoder &&) = delete;
+
+   private:
+    /// \brief Destination buffer.
+    char *mBuffer = nullptr;
+    /// \brief Size of the destination buffer in bytes.
+    size_t mCapacity = 0;
+    /// \brief Bytes written to the current packet, including the header.
+    size_t mLength = WirePacketHeader::SIZE;
+    /// \brief Sequence number of the first message in the current packet.
+    size_t mSeq_num = 0;
+    /// \brief Number of messages in the current packet.
+    uint16_t mMessage_count = 0;
+    /// \brief Last valid order id written, the next delta is relative to it.
+    OrderId mPrev_order_id = OrderId_INVALID;
+    /// \brief Last valid price written, the next delta is relative to it.
+    Price mPrev_price = Price_INVALID;
+};
+
+/// \brief Flyweight over a single message block inside a received packet.
+///
+/// Fixed-width fields are read in place from the receive buffer on every
+/// access. The absolute order id and price are resolved by the packet decoder
+/// while stepping, since they depend on the preceding deltas.
+class WireMessageDecoder final {
+   public:
+    /// \brief Returns the type of the update.
+    auto type() const noexcept {
+        return static_cast<MarketUpdateType>(
+            loadLittleEndian<uint8_t>(mBlock + WireMessageBlock::TYPE));
+    }
+
+    /// \brief Returns the side of the update.
+    auto side() const noexcept {
+        return static_cast<Side>(
+            loadLittleEndian<int8_t>(mBlock + WireMessageBlock::SIDE));
+    }
+
+    /// \brief Returns the ticker id of the update.
+    auto tickerId() const noexcept -> TickerId {
+        const auto ticker_id =
+            loadLittleEndian<uint16_t>(mBlock + WireMessageBlock::TICKER_ID);
+        return ticker_id == WIRE_TICKER_INVALID ? TickerId_INVALID : ticker_id;
+    }
+
+    /// \brief Returns the quantity of the update.
+    auto qty() const noexcept -> Qty {
+        return loadLittleEndian<uint32_t>(mBlock + WireMessageBlock::QTY);
+    }
+
+    /// \brief Returns the priority of the update.
+    auto priority() const noexcept -> Priority {
+        return loadLittleEndian<uint64_t>(mBlock + WireMessageBlock::PRIORITY);
+    }
+
+    /// \brief Returns the absolute order id of the update.
+    auto orderId() const noexcept -> OrderId { return mOrder_id; }
+
+    /// \brief Returns the absolute price of the update.
+    auto price() const noexcept -> Price { return mPrice; }
+
+    /// \brief Returns the sequence number of the update.
+    auto seqNum() const noexcept -> size_t { return mSeq_num; }
+
+    /// \brief Copies the message into an MEMarketUpdate, for consumers that
+    /// need an owned copy.
+    /// \return The decoded market update.
+    auto toMEMarketUpdate() const noexcept -> MEMarketUpdate {
+        MEMarketUpdate update;
+        update.type = type();
+        update.order_id = orderId();
+        update.ticker_id = tickerId();
+        update.side = side();
+        update.price = price();
+        update.qty = qty();
+        update.priority = priority();
+        return update;
+    }
+
+   private:
+    friend class WirePacketDecoder;
+
+    /// \brief Start of the message block in the receive buffer.
+    const char *mBlock = nullptr;
+    /// \brief Resolved order id of the message.
+    OrderId mOrder_id = OrderId_INVALID;
+    /// \brief Resolved price of the message.
+    Price mPrice = Price_INVALID;
+    /// \brief Sequence number of the message.
+    size_t mSeq_num = 0;
+};
+
+/// \brief Validates a received packet and steps through its messages without
+/// copying them out of the receive buffer.
+class WirePacketDecoder final {
+   public:
+    /// \brief Constructs a decoder over a received packet.
+    /// \param buffer Start of the packet, must outlive the decoder.
+    /// \param length Number of valid bytes in the buffer.
+    WirePacketDecoder(const char *buffer, size_t length) noexcept
+        : mBuffer(buffer) {
+        if (length < WirePacketHeader::SIZE) [[unlikely]] {
+            return;
+        }
+
+        mVersion =
+            loadLittleEndian<uint16_t>(buffer + WirePacketHeader::VERSION);
+        mSeq_num =
+            loadLittleEndian<uint64_t>(buffer + WirePacketHeader::SEQ_NUM);
+        mBlock_length = loadLittleEndian<uint16_t>(
+            buffer + WirePacketHeader::BLOCK_LENGTH);
+        mMessage_count = loadLittleEndian<uint16_t>(
+            buffer + WirePacketHeader::MESSAGE_COUNT);
+
+        mValid =
+            loadLittleEndian<uint16_t>(buffer + WirePacketHeader::SCHEMA_ID) ==
+                WIRE_SCHEMA_ID &&
+            version() != 0 && mBlock_length >= WireMessageBlock::SIZE &&
+            WirePacketHeader::SIZE + mMessage_count * mBlock_length <= length;
+
+        mBase_order_id = loadLittleEndian<uint64_t>(
+            buffer + WirePacketHeader::BASE_ORDER_ID);
+        mBase_price =
+            loadLittleEndian<int64_t>(buffer + WirePacketHeader::BASE_PRICE);
+    }
+
+    /// \brief Returns whether the packet passed header validation.
+    auto isValid() const noexcept { return mValid; }
+
+    /// \brief Returns the schema version the packet was written with, 0 if
+    /// the packet is shorter than its header.
+    auto version() const noexcept -> uint16_t { return mVersion; }
+
+    /// \brief Returns the sequence number of the first message, 0 if the
+    /// packet is shorter than its header.
+    auto seqNum() const noexcept -> size_t { return mSeq_num; }
+
+    /// \brief Returns the number of messages in the packet.
+    auto messageCount() const noexcept -> size_t {
+        return mValid ? mMessage_count : 0;
+    }
+
+    /// \brief Steps to the next message in the packet.
+    /// \return Pointer to the message flyweight, or nullptr once all messages
+    /// have been visited or if the packet is invalid. The flyweight is reused
+    /// and only valid until the next call.
+    auto next() noexcept -> const WireMessageDecoder * {
+        if (!mValid || mNext_index == mMessage_count) [[unlikely]] {
+            return nullptr;
+        }
+
+        const auto block =
+            mBuffer + WirePacketHeader::SIZE + mNext_index * mBlock_length;
+        const auto order_id_delta =
+            loadLittleEndian<int32_t>(block + WireMessageBlock::ORDER_ID_DELTA);
+        const auto price_delta =
+            loadLittleEndian<int32_t>(block + WireMessageBlock::PRICE_DELTA);
+
+        // Running values only advance on valid fields, mirroring the encoder.
+        // Sums are kept unsigned so that wrap-around is well defined.
+        mMessage.mBlock = block;
+        if (order_id_delta != WIRE_DELTA_INVALID) [[likely]] {
+            mOrder_id_running += static_cast<uint64_t>(order_id_delta);
+            mMessage.mOrder_id = mBase_order_id + mOrder_id_running;
+        } else {
+            mMessage.mOrder_id = OrderId_INVALID;
+        }
+        if (price_delta != WIRE_DELTA_INVALID) [[likely]] {
+            mPrice_running += static_cast<uint64_t>(price_delta);
+            mMessage.mPrice = static_cast<Price>(
+                static_cast<uint64_t>(mBase_price) + mPrice_running);
+        } else {
+            mMessage.mPrice = Price_INVALID;
+        }
+        mMessage.mSeq_num = mSeq_num + mNext_index;
+        ++mNext_index;
+
+        return &mMessage;
+    }
+
+    // Deleted default, copy & move constructors and assignment-operators.
+    WirePacketDecoder() = delete;
+    WirePacketDecoder(const WirePacketDecoder &) = delete;
+    WirePacketDecoder(const WirePacketDecoder &&) = delete;
+    WirePacketDecoder &operator=(const WirePacketDecoder &) = delete;
+    WirePacketDecoder &operator=(const WirePacketDecoder &&) = delete;
+
+   private:
+    /// \brief Start of the packet in the receive buffer.
+    const char *mBuffer = nullptr;
+    /// \brief Whether the header passed validation.
+    bool mValid = false;
+    /// \brief Schema version of the packet.
+    uint16_t mVersion = 0;
+    /// \brief Size of each message block as declared by the sender.
+    size_t mBlock_length = 0;
+    /// \brief Number of messages in the packet.
+    size_t mMessage_count = 0;
+    /// \brief Index of the next message to visit.
+    size_t mNext_index = 0;
+    /// \brief Sequence number of the first message.
+    size_t mSeq_num = 0;
+    /// \brief Order id the first order id delta is relative to.
+    OrderId mBase_order_id = OrderId_INVALID;
+    /// \brief Price the first price delta is relative to.
+    Price mBase_price = Price_INVALID;
+    /// \brief Sum of the order id deltas seen so far.
+    uint64_t mOrder_id_running = 0;
+    /// \brief Sum of the price deltas seen so far.
+    uint64_t mPrice_running = 0;
+    /// \brief Flyweight handed out by next().
+    WireMessageDecoder mMessage;
+};